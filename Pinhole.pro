@@ -15,6 +15,7 @@ SUBDIRS += libSigar/libSigar.pro \
     PinholeServer/PinholeServer.pro \
     PinholeHelper/PinholeHelper.pro \
     PinholeClient/PinholeClient.pro \
-    PinholeBackend/PinholeBackend.pro
+    PinholeBackend/PinholeBackend.pro \
+    tests/tests.pro
 
     
@@ -15,7 +15,8 @@ HEADERS += ../common/PinholeCommon.h \
     ../common/MultiplexSocket.h \
     ../common/HostClient.h \
     ./UdpInterface.h \
-    ./WebInterface.h
+    ./WebInterface.h \
+    ../common/DiscoveryPacket.h
 SOURCES += ../common/HostClient.cpp \
     ../common/MultiplexSocket.cpp \
     ../common/Utilities.cpp \
@@ -25,4 +26,5 @@ SOURCES += ../common/HostClient.cpp \
     ./main.cpp \
     ./ProxyServer.cpp \
     ./UdpInterface.cpp \
-    ./WebInterface.cpp
+    ./WebInterface.cpp \
+    ../common/DiscoveryPacket.cpp
@@ -3,6 +3,7 @@
 #include "../common/Utilities.h"
 #include "../common/MultiplexSocket.h"
 #include "../common/PinholeCommon.h"
+#include "../common/DiscoveryPacket.h"
 
 #include <QFile>
 #include <QtEndian>
@@ -12,8 +13,6 @@
 #include <QUdpSocket>
 #include <QDebug>
 #include <QCoreApplication>
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QTimer>
 #include <QNetworkDatagram>
 
@@ -21,10 +20,14 @@
 #define FILENAME_CERTFILE	"backend.pem"
 
 #define FREQ_SERVERQUERY	10000
+#define MAX_REMOVEDSERVERS	256		// Number of server removals remembered for delta redirect responses
 
 ProxyServer::ProxyServer(Settings* settings, QObject *parent)
 	: QTcpServer(parent), m_settings(settings)
 {
+	m_changeSequence = QDateTime::currentMSecsSinceEpoch();
+	m_removedFloor = m_changeSequence;
+
 	QFile keyFile(settings->dataDir() + FILENAME_KEYFILE);
 	QFile certFile(settings->dataDir() + FILENAME_CERTFILE);
 
@@ -106,12 +109,11 @@ ProxyServer::ProxyServer(Settings* settings, QObject *parent)
 		QCoreApplication::exit();
 	}
 
-	// Create query packet
-	QJsonObject jsonObject;
-	jsonObject[TAG_COMMAND] = UDPCOMMAND_QUERY;
-	QJsonDocument jsonDoc;
-	jsonDoc.setObject(jsonObject);
-	m_queryPacket = jsonDoc.toJson();
+	// Create query packet, JSON so older servers understand it
+	QVariantMap queryValues;
+	queryValues[TAG_COMMAND] = UDPCOMMAND_QUERY;
+	queryValues[TAG_ENCODING] = DISCOVERY_ENCODING_LATEST;
+	m_queryPacket = EncodeDiscoveryPacket(queryValues, DISCOVERY_ENCODING_JSON);
 
 	// Query servers on a timer
 	QTimer* queryTimer = new QTimer(this);
@@ -142,6 +144,28 @@ void ProxyServer::start()
 }
 
 
+// Returns true if changes since the sequence token can be described as a delta
+bool ProxyServer::isDeltaAvailable(qint64 since) const
+{
+	return since >= m_removedFloor && since <= m_changeSequence;
+}
+
+
+// Returns the IDs of servers that have disconnected since the sequence token
+QStringList ProxyServer::removedServersSince(qint64 since) const
+{
+	QStringList ret;
+	for (const auto& removed : m_removedServers)
+	{
+		if (removed.second > since)
+		{
+			ret.append(removed.first);
+		}
+	}
+	return ret;
+}
+
+
 void ProxyServer::serverAcceptError(QAbstractSocket::SocketError socketError)
 {
 #ifdef QT_DEBUG
@@ -164,29 +188,33 @@ void ProxyServer::acceptConnection()
 		{
 			Q_UNUSED(id);
 
-			// Parse the data as JSON
-			QJsonDocument jsonDoc = QJsonDocument::fromJson(datagram.data());
+			// Parse the data as JSON or binary
+			QVariantMap values = DecodeDiscoveryPacket(datagram);
 			// Validate the data
-			if (!jsonDoc.isNull())
+			if (!values.isEmpty())
 			{
-				// Parse the json data
-				QJsonObject jsonObject = jsonDoc.object();
-				QString command = jsonObject[TAG_COMMAND].toString();
+				QString command = values[TAG_COMMAND].toString();
 				if (UDPCOMMAND_ANNOUNCE == command)
 				{
 					QString address = serverAddress;
-					QString serverId = jsonObject[TAG_ID].toString();
-					QString name = jsonObject[TAG_NAME].toString();
-					QString role = jsonObject[TAG_ROLE].toString();
-					QString version = jsonObject[TAG_VERSION].toString();
-					QString platform = jsonObject[TAG_PLATFORM].toString();
-					QString status = jsonObject[TAG_STATUS].toString();
-					QString os = jsonObject[TAG_OS].toString();
-					server->setData(serverId, address, name, role, version, platform, status, os);
+					QString serverId = values[TAG_ID].toString();
+					QString name = values[TAG_NAME].toString();
+					QString role = values[TAG_ROLE].toString();
+					QString version = values[TAG_VERSION].toString();
+					QString platform = values[TAG_PLATFORM].toString();
+					QString status = values[TAG_STATUS].toString();
+					QString os = values[TAG_OS].toString();
+					if (server->setData(serverId, address, name, role, version, platform, status, os))
+					{
+						server->setChangeSequence(++m_changeSequence);
+					}
 				}
 				else if (UDPCOMMAND_STATUS == command)
 				{
-					server->setStatus(jsonObject[TAG_STATUS].toString());
+					if (server->setStatus(values[TAG_STATUS].toString()))
+					{
+						server->setChangeSequence(++m_changeSequence);
+					}
 				}
 			}
 		});
@@ -195,6 +223,16 @@ void ProxyServer::acceptConnection()
 	{
 		qInfo() << "Server disconnected:" << serverAddress;
 		m_serverList.removeAll(server);
+
+		// Remember the removal so delta redirect responses can report it
+		if (server->isIdentified())
+		{
+			m_removedServers.append(QPair<QString, qint64>(server->id(), ++m_changeSequence));
+			while (m_removedServers.size() > MAX_REMOVEDSERVERS)
+			{
+				m_removedFloor = m_removedServers.takeFirst().second;
+			}
+		}
 	});
 
 	m_serverList.append(server);
@@ -4,6 +4,11 @@
 #include <QTcpServer>
 #include <QMap>
 #include <QDateTime>
+#include <QStringList>
+#include <QVariantMap>
+
+#include "../common/PinholeCommon.h"
+#include "../common/DiscoveryPacket.h"
 
 class QTcpSocket;
 class QSslError;
@@ -33,18 +38,59 @@ class ProxyServer : public QTcpServer
 		QString status() const { return m_status; }
 		QString os() const { return m_os; }
 		bool isIdentified() const { return m_identified; }
-		void setData(const QString& id, const QString& address, const QString& name,
+		qint64 changeSequence() const { return m_changeSequence; }
+		void setChangeSequence(qint64 sequence) { m_changeSequence = sequence; }
+		// Returns true if any of the values changed
+		bool setData(const QString& id, const QString& address, const QString& name,
 			const QString& role, const QString& version, const QString& platform,
 			const QString& status, const QString& os)
 		{
+			m_lastHeard = QDateTime::currentDateTime();
+			if (m_identified && m_id == id && m_address == address && m_name == name &&
+				m_role == role && m_version == version && m_platform == platform &&
+				m_status == status && m_os == os)
+				return false;
 			m_id = id; m_address = address; m_name = name; m_role = role;
 			m_version = version; m_platform = platform; m_status = status;
-			m_os = os; m_lastHeard = QDateTime::currentDateTime(); m_identified = true;
+			m_os = os; m_identified = true;
+			clearRedirectRecord();
+			return true;
 		}
-		void setStatus(const QString& status)
+		// Returns true if the status changed
+		bool setStatus(const QString& status)
 		{
-			m_status = status;
 			m_lastHeard = QDateTime::currentDateTime();
+			if (m_status == status)
+				return false;
+			m_status = status;
+			clearRedirectRecord();
+			return true;
+		}
+		void clearRedirectRecord()
+		{
+			m_redirectRecord[0].clear();
+			m_redirectRecord[1].clear();
+		}
+		// Returns the serialized redirect packet for this server, built only when the data changes
+		const QByteArray& redirectRecord(int encoding)
+		{
+			QByteArray& record = m_redirectRecord[encoding == DISCOVERY_ENCODING_JSON ? 0 : 1];
+			if (record.isEmpty())
+			{
+				QVariantMap values;
+				values[TAG_COMMAND] = UDPCOMMAND_REDIRECT;
+				values[TAG_ID] = m_id;
+				values[TAG_ADDRESS] = m_address;
+				values[TAG_NAME] = m_name;
+				values[TAG_ROLE] = m_role;
+				values[TAG_VERSION] = m_version;
+				values[TAG_STATUS] = m_status;
+				values[TAG_PLATFORM] = m_platform;
+				values[TAG_OS] = m_os;
+				values[TAG_PORT] = m_port;
+				record = EncodeDiscoveryPacket(values, encoding);
+			}
+			return record;
 		}
 
 	private:
@@ -61,12 +107,18 @@ class ProxyServer : public QTcpServer
 		QString m_os;
 		QDateTime m_lastHeard;
 		bool m_identified = false;
+		qint64 m_changeSequence = 0;
+		// Cached JSON and binary redirect packets
+		QByteArray m_redirectRecord[2];
 	};
 
 public:
 	ProxyServer(Settings* settings, QObject *parent);
 	~ProxyServer();
 	QList<QSharedPointer<Server>>& serverList() { return m_serverList; }
+	qint64 changeSequence() const { return m_changeSequence; }
+	bool isDeltaAvailable(qint64 since) const;
+	QStringList removedServersSince(qint64 since) const;
 
 public slots:
 	void start();
@@ -84,4 +136,11 @@ private:
 	QSslCertificate* m_cert = nullptr;
 	QList<QSharedPointer<Server>> m_serverList;
 	Settings* m_settings = nullptr;
+	// Incremented on every server change, seeded with the start time so tokens
+	// handed out by a previous instance are always older than the current ones
+	qint64 m_changeSequence = 0;
+	// Sequence at or below which removals are no longer tracked
+	qint64 m_removedFloor = 0;
+	// List of removed server ID, change sequence
+	QList<QPair<QString, qint64>> m_removedServers;
 };
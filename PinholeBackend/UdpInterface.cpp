@@ -2,11 +2,10 @@
 #include "Settings.h"
 #include "ProxyServer.h"
 #include "../common/PinholeCommon.h"
+#include "../common/DiscoveryPacket.h"
 
 #include <QUdpSocket>
 #include <QNetworkDatagram>
-#include <QJsonDocument>
-#include <QJsonObject>
 
 UdpInterface::UdpInterface(Settings* settings, ProxyServer* proxyServer, QObject *parent)
 	: QObject(parent), m_settings(settings), m_proxyServer(proxyServer)
@@ -33,31 +32,33 @@ void UdpInterface::pinholeDatagram()
 		// Read entire datagram
 		QNetworkDatagram datagram = m_udpSocket->receiveDatagram();
 
-		// Parse the data as JSON
-		QJsonDocument jsonDoc = QJsonDocument::fromJson(datagram.data());
+		// Parse the data as JSON or binary
+		int encoding = DISCOVERY_ENCODING_JSON;
+		QVariantMap values = DecodeDiscoveryPacket(datagram.data(), &encoding);
 		// Validate the data
-		if (!jsonDoc.isNull())
+		if (!values.isEmpty())
 		{
-			QJsonObject jsonObject = jsonDoc.object();
-			QString command = jsonObject[QString(TAG_COMMAND)].toString();
+			QString command = values[TAG_COMMAND].toString();
 			if (command == UDPCOMMAND_QUERY)
 			{
-				for (const auto& server : m_proxyServer->serverList())
+				// Answer in the newest encoding both sides understand
+				encoding = qMin(qMax(encoding, values[TAG_ENCODING].toInt()), DISCOVERY_ENCODING_LATEST);
+
+				if (values[TAG_BATCH].toBool())
+				{
+					// Sender understands batched responses, pack as many records per datagram as fit
+					qint64 since = values[TAG_SINCE].toLongLong();
+					sendRedirectBatch(datagram.senderAddress(), datagram.senderPort(), since, encoding);
+				}
+				else
 				{
-					if (server->isIdentified())
+					// Legacy query, one datagram per server
+					for (const auto& server : m_proxyServer->serverList())
 					{
-						QJsonObject jsonResponse;
-						jsonResponse[TAG_COMMAND] = UDPCOMMAND_REDIRECT;
-						jsonResponse[TAG_ID] = server->id();
-						jsonResponse[TAG_ADDRESS] = server->addresss();
-						jsonResponse[TAG_NAME] = server->name();
-						jsonResponse[TAG_ROLE] = server->role();
-						jsonResponse[TAG_VERSION] = server->version();
-						jsonResponse[TAG_STATUS] = server->status();
-						jsonResponse[TAG_PLATFORM] = server->platform();
-						jsonResponse[TAG_OS] = server->os();
-						jsonResponse[TAG_PORT] = server->port();
-						m_udpSocket->writeDatagram(QJsonDocument(jsonResponse).toJson(), datagram.senderAddress(), datagram.senderPort());
+						if (server->isIdentified())
+						{
+							m_udpSocket->writeDatagram(server->redirectRecord(encoding), datagram.senderAddress(), datagram.senderPort());
+						}
 					}
 				}
 			}
@@ -65,3 +66,101 @@ void UdpInterface::pinholeDatagram()
 	}
 }
 
+
+// Splits removed server IDs into lists that each fit in a datagram with the header,
+// false if an ID doesn't fit even on its own
+static bool splitRemoved(const QVariantMap& header, const QStringList& removed, int encoding, QList<QStringList>* parts)
+{
+	// Slack for the part number and array size, each ID adds its quotes and separator or type and length
+	int headerSize = EncodeRedirectBatch(header, {}, encoding).size() + 16;
+	int packetSize = headerSize;
+	QStringList part;
+	for (const auto& id : removed)
+	{
+		int idSize = id.toUtf8().size() + 4;
+		if (headerSize + idSize > UDP_SAFEPAYLOAD)
+			return false;
+
+		if (!part.isEmpty() && packetSize + idSize > UDP_SAFEPAYLOAD)
+		{
+			parts->append(part);
+			part.clear();
+			packetSize = headerSize;
+		}
+		part.append(id);
+		packetSize += idSize;
+	}
+	if (!part.isEmpty())
+		parts->append(part);
+	return true;
+}
+
+
+// Sends the redirect records of every server changed since the sequence token 
+// (or every server if the token is 0 or too old) packed into as few datagrams as possible
+void UdpInterface::sendRedirectBatch(const QHostAddress& address, quint16 port, qint64 since, int encoding)
+{
+	bool full = since <= 0 || !m_proxyServer->isDeltaAvailable(since);
+
+	QVariantMap header;
+	header[TAG_SEQUENCE] = QString::number(m_proxyServer->changeSequence());
+	header[TAG_FULL] = full;
+	header[TAG_PART] = 0;
+
+	// Removals are spread over the first datagrams, each kept under the payload limit
+	QList<QStringList> removedParts;
+	if (!full && !splitRemoved(header, m_proxyServer->removedServersSince(since), encoding, &removedParts))
+	{
+		// A full response leaves out removed servers without listing them
+		full = true;
+		header[TAG_FULL] = full;
+		removedParts.clear();
+	}
+
+	int part = 0;
+	QVariantMap partHeader;
+	int packetSize = 0;
+	QList<QByteArray> records;
+	auto startPart = [&]()
+	{
+		partHeader = header;
+		partHeader[TAG_PART] = part;
+		if (part < removedParts.size())
+			partHeader[TAG_REMOVED] = removedParts[part];
+		// Size of the datagram without records, with some slack for the part number and array size
+		packetSize = EncodeRedirectBatch(partHeader, {}, encoding).size() + 8;
+	};
+	auto sendPart = [&]()
+	{
+		m_udpSocket->writeDatagram(EncodeRedirectBatch(partHeader, records, encoding), address, port);
+		part++;
+		records.clear();
+		startPart();
+	};
+
+	startPart();
+	for (const auto& server : m_proxyServer->serverList())
+	{
+		if (!server->isIdentified() || (!full && server->changeSequence() <= since))
+			continue;
+
+		// A record too large for any datagram still goes on its own
+		const QByteArray& record = server->redirectRecord(encoding);
+		while (packetSize + record.size() + 1 > UDP_SAFEPAYLOAD && (!records.isEmpty() || part < removedParts.size()))
+		{
+			sendPart();
+		}
+
+		records.append(record);
+		packetSize += record.size() + 1;
+	}
+
+	// Removals left once the records ran out get datagrams of their own
+	while (part < removedParts.size() - 1)
+	{
+		sendPart();
+	}
+
+	// Always send the last datagram, even if empty, so the sender gets the current sequence token
+	m_udpSocket->writeDatagram(EncodeRedirectBatch(partHeader, records, encoding), address, port);
+}
@@ -4,6 +4,7 @@
 
 class Settings;
 class QUdpSocket;
+class QHostAddress;
 class ProxyServer;
 
 class UdpInterface : public QObject
@@ -18,6 +19,8 @@ private slots:
 	void pinholeDatagram();
 
 private:
+	void sendRedirectBatch(const QHostAddress& address, quint16 port, qint64 since, int encoding);
+
 	QUdpSocket* m_udpSocket = nullptr;
 	Settings* m_settings = nullptr;
 	ProxyServer* m_proxyServer = nullptr;
@@ -97,6 +97,7 @@ private:
 		{ PROP_GLOBAL_HEARTBEATTIMEOUT, QMetaType::Int },
 		{ PROP_GLOBAL_CRASHPERIOD, QMetaType::Int },
 		{ PROP_GLOBAL_CRASHCOUNT, QMetaType::Int },
+		{ PROP_GLOBAL_MAXLAUNCHES, QMetaType::Int },
 		{ PROP_GLOBAL_TRAYLAUNCH, QMetaType::Bool },
 		{ PROP_GLOBAL_TRAYCONTROL, QMetaType::Bool },
 		{ PROP_GLOBAL_HTTPENABLED, QMetaType::Bool },
@@ -137,6 +138,7 @@ private:
 		{ PROP_APP_TCPLOOPBACKPORT, QMetaType::Int },
 		{ PROP_APP_HEARTBEATS, QMetaType::Bool },
 		{ PROP_APP_ENVIRONMENT, QMetaType::QStringList },
+		{ PROP_APP_DEPENDENCIES, QMetaType::QStringList },
 		{ PROP_APP_LASTSTARTED, QMetaType::Void },
 		{ PROP_APP_LASTEXITED, QMetaType::Void },
 		{ PROP_APP_RESTARTS, QMetaType::Void },
@@ -160,7 +162,8 @@ private:
 		{ PROP_SCHED_FREQUENCY, QMetaType::QString },
 		{ PROP_SCHED_ARGUMENTS, QMetaType::QString },
 		{ PROP_SCHED_OFFSET, QMetaType::Int },
-		{ PROP_SCHED_LASTTRIGGERED, QMetaType::Void }
+		{ PROP_SCHED_LASTTRIGGERED, QMetaType::Void },
+		{ PROP_SCHED_CRON, QMetaType::QString }
 	};
 
 	const QMap<QString, int> m_propListAlert = 
@@ -171,6 +174,7 @@ private:
 		{ PROP_ALERT_SMTPPASS, QMetaType::QString },
 		{ PROP_ALERT_SMTPEMAIL, QMetaType::QString },
 		{ PROP_ALERT_SMTPNAME, QMetaType::QString },
+		{ PROP_ALERT_SMTPIDLE, QMetaType::Int },
 		{ PROP_ALERT_SLOTLIST, QMetaType::Void },
 		//{ PROP_ALERT_SLOTNAME, QMetaType::Void },
 		{ PROP_ALERT_SLOTENABLED, QMetaType::Bool },
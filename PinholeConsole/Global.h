@@ -15,6 +15,9 @@
 #define FREQ_HOSTBROADCAST		5025				// The frequency that queries are broadcast at
 #define FREQ_HOSTQUERY			3025				// The frequency the host list is queried at
 #define FREQ_NOTICEUPDATE		10000				// How soon the notice text is reset after a non-id message
+#define ROUNDS_BACKENDRESYNC	20					// Every this many host list queries backends are asked for a full redirect list
+#define SECS_PRESENCEQUIET		75					// Hosts that haven't pushed a presence packet for this long are queried again
+#define ROUNDS_PRESENCEBROADCAST	12				// Subnets where every known host pushes presence are only broadcast to every this many rounds
 
 #define SECS_MINHIGHLIGHTHOST	60
 
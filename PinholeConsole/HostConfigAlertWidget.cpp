@@ -83,6 +83,11 @@ HostConfigAlertWidget::HostConfigAlertWidget(QWidget *parent)
 	detailsLayout->addRow(new QLabel(tr("SMTP server password")), m_smtpPass);
 	m_smtpEmail = new QLineEdit;
 	detailsLayout->addRow(new QLabel(tr("SMTP sender email")), m_smtpEmail);
+	m_smtpIdle = new QSpinBox;
+	m_smtpIdle->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_smtpIdle->setMinimum(0);
+	m_smtpIdle->setMaximum(MAX_SMTPIDLE);
+	detailsLayout->addRow(new QLabel(tr("SMTP connection idle time")), m_smtpIdle);
 	m_smtpName = new QLineEdit;
 	//detailsLayout->addRow(new QLabel(tr("SMTP sender name")), m_smtpName);
 
@@ -101,6 +106,7 @@ HostConfigAlertWidget::HostConfigAlertWidget(QWidget *parent)
 		{ PROP_ALERT_SMTPPASS, m_smtpPass },
 		{ PROP_ALERT_SMTPEMAIL, m_smtpEmail },
 		{ PROP_ALERT_SMTPNAME, m_smtpName },
+		{ PROP_ALERT_SMTPIDLE, m_smtpIdle },
 	};
 
 	// Set the property names for the widgets
@@ -149,6 +155,10 @@ HostConfigAlertWidget::HostConfigAlertWidget(QWidget *parent)
 		"during authentication.") + alertsHtml);
 	m_smtpEmail->setToolTip(tr("The return email address used to in emails"));
 	m_smtpEmail->setToolTip(tr("This string will show in the 'From' field of sent alert emails.") + alertsHtml);
+	m_smtpIdle->setToolTip(tr("Seconds to keep the SMTP connection open after sending alert emails"));
+	m_smtpIdle->setWhatsThis(tr("The connection to the SMTP server is kept open for this many seconds "
+		"after the last alert email so bursts of alerts are sent without logging in again for each one.  "
+		"Zero closes the connection as soon as the queued emails are sent.") + alertsHtml);
 	m_smtpName->setToolTip(tr("Unused"));
 }
 
@@ -204,6 +214,7 @@ void HostConfigAlertWidget::enableWidgets(bool enable)
 	m_smtpPass->setEnabled(enable && m_editable);
 	m_smtpEmail->setEnabled(enable && m_editable);
 	m_smtpName->setEnabled(enable && m_editable);
+	m_smtpIdle->setEnabled(enable && m_editable);
 
 	bool itemSelected = !m_alertSlotList->selectionModel()->selectedRows().isEmpty();
 	bool oneSelected = m_alertSlotList->selectionModel()->selectedRows().size() == 1;
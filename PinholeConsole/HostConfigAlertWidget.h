@@ -38,6 +38,7 @@ public:
 	QLineEdit * m_smtpPass = nullptr;
 	QLineEdit * m_smtpEmail = nullptr;
 	QLineEdit * m_smtpName = nullptr;
+	QSpinBox * m_smtpIdle = nullptr;
 
 private slots:
 	void alertSlotList_itemSelectionChanged();
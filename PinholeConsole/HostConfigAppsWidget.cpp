@@ -54,6 +54,9 @@ HostConfigAppsWidget::HostConfigAppsWidget(QWidget *parent)
 	m_getConsoleOutput = new QPushButton(tr("Get console output"));
 	m_getConsoleOutput->setSizePolicy(QSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed));
 	buttonLayout->addWidget(m_getConsoleOutput);
+	m_followConsoleOutput = new QPushButton(tr("Follow console output"));
+	m_followConsoleOutput->setSizePolicy(QSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed));
+	buttonLayout->addWidget(m_followConsoleOutput);
 	m_appList = new QListWidget;
 	m_appList->setSelectionMode(QAbstractItemView::SelectionMode::SingleSelection);
 	m_appList->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -113,6 +116,77 @@ HostConfigAppsWidget::HostConfigAppsWidget(QWidget *parent)
 	detailsLayout->addRow(nullptr, m_consoleCapture);
 	m_appendCapture = new QCheckBox(tr("Append console output"));
 	detailsLayout->addRow(nullptr, m_appendCapture);
+	m_captureRotateSize = new QSpinBox;
+	m_captureRotateSize->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_captureRotateSize->setMinimum(0);
+	m_captureRotateSize->setMaximum(MAX_CAPTUREROTATESIZE);
+	detailsLayout->addRow(new QLabel(tr("Rotate console output MB")), m_captureRotateSize);
+	m_captureRotateHours = new QSpinBox;
+	m_captureRotateHours->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_captureRotateHours->setMinimum(0);
+	m_captureRotateHours->setMaximum(MAX_CAPTUREROTATEHOURS);
+	detailsLayout->addRow(new QLabel(tr("Rotate console output hours")), m_captureRotateHours);
+	m_captureCompress = new QCheckBox(tr("Compress rotated console output"));
+	detailsLayout->addRow(nullptr, m_captureCompress);
+	m_cgroup = new QCheckBox(tr("Contain application in a cgroup"));
+	detailsLayout->addRow(nullptr, m_cgroup);
+	m_cpuWeight = new QSpinBox;
+	m_cpuWeight->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_cpuWeight->setMinimum(0);
+	m_cpuWeight->setMaximum(MAX_CGROUPWEIGHT);
+	detailsLayout->addRow(new QLabel(tr("CPU weight")), m_cpuWeight);
+	m_cpuQuota = new QSpinBox;
+	m_cpuQuota->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_cpuQuota->setMinimum(0);
+	m_cpuQuota->setMaximum(MAX_CPUQUOTA);
+	detailsLayout->addRow(new QLabel(tr("CPU quota percent")), m_cpuQuota);
+	m_memoryHigh = new QSpinBox;
+	m_memoryHigh->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_memoryHigh->setMinimum(0);
+	m_memoryHigh->setMaximum(MAX_APPMEMORY);
+	detailsLayout->addRow(new QLabel(tr("Memory high MB")), m_memoryHigh);
+	m_memoryMax = new QSpinBox;
+	m_memoryMax->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_memoryMax->setMinimum(0);
+	m_memoryMax->setMaximum(MAX_APPMEMORY);
+	detailsLayout->addRow(new QLabel(tr("Memory max MB")), m_memoryMax);
+	m_ioWeight = new QSpinBox;
+	m_ioWeight->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_ioWeight->setMinimum(0);
+	m_ioWeight->setMaximum(MAX_CGROUPWEIGHT);
+	detailsLayout->addRow(new QLabel(tr("IO weight")), m_ioWeight);
+	m_cpuAffinity = new QLineEdit;
+	detailsLayout->addRow(new QLabel(tr("CPU affinity")), m_cpuAffinity);
+	m_nice = new QSpinBox;
+	m_nice->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_nice->setMinimum(MIN_NICE);
+	m_nice->setMaximum(MAX_NICE);
+	detailsLayout->addRow(new QLabel(tr("Nice")), m_nice);
+	m_schedPolicy = new QComboBox;
+	m_schedPolicy->addItem(tr("Normal"), SCHEDPOLICY_NORMAL);
+	m_schedPolicy->addItem(tr("Batch"), SCHEDPOLICY_BATCH);
+	m_schedPolicy->addItem(tr("Idle"), SCHEDPOLICY_IDLE);
+	m_schedPolicy->addItem(tr("Realtime FIFO"), SCHEDPOLICY_FIFO);
+	m_schedPolicy->addItem(tr("Realtime round robin"), SCHEDPOLICY_RR);
+	m_schedPolicy->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Minimum);
+	detailsLayout->addRow(tr("Scheduling policy"), m_schedPolicy);
+	m_schedPriority = new QSpinBox;
+	m_schedPriority->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_schedPriority->setMinimum(0);
+	m_schedPriority->setMaximum(MAX_SCHEDPRIORITY);
+	detailsLayout->addRow(new QLabel(tr("Realtime priority")), m_schedPriority);
+	m_ioClass = new QComboBox;
+	m_ioClass->addItem(tr("Default"), IOCLASS_NONE);
+	m_ioClass->addItem(tr("Realtime"), IOCLASS_REALTIME);
+	m_ioClass->addItem(tr("Best effort"), IOCLASS_BESTEFFORT);
+	m_ioClass->addItem(tr("Idle"), IOCLASS_IDLE);
+	m_ioClass->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Minimum);
+	detailsLayout->addRow(tr("IO class"), m_ioClass);
+	m_ioPriority = new QSpinBox;
+	m_ioPriority->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_ioPriority->setMinimum(0);
+	m_ioPriority->setMaximum(MAX_IOPRIORITY);
+	detailsLayout->addRow(new QLabel(tr("IO priority")), m_ioPriority);
 	m_heartbeats = new QCheckBox(tr("Enforce timeout heartbeats"));
 	detailsLayout->addRow(nullptr, m_heartbeats);
 	m_tcpLoopback = new QCheckBox(tr("Enable application TCP loopback"));
@@ -126,6 +200,10 @@ HostConfigAppsWidget::HostConfigAppsWidget(QWidget *parent)
 	connect(m_environmentList, &ListWidgetEx::valueChanged,
 		this, [this]() { emit widgetValueChanged(m_environmentList); });
 	detailsLayout->addRow(new QLabel(tr("Environment")), m_environmentList);
+	m_dependencyList = new ListWidgetEx(tr("dependency"), "APPNAME");
+	connect(m_dependencyList, &ListWidgetEx::valueChanged,
+		this, [this]() { emit widgetValueChanged(m_dependencyList); });
+	detailsLayout->addRow(new QLabel(tr("Depends on")), m_dependencyList);
 
 	detailsScrollArea->setWidget(detailsScrollAreaWidgetContents);
 	detailsScrollArea->show();
@@ -149,10 +227,26 @@ HostConfigAppsWidget::HostConfigAppsWidget(QWidget *parent)
 		{ PROP_APP_LOCKUPSCREENSHOT, m_lockupScreenshot },
 		{ PROP_APP_CONSOLECAPTURE, m_consoleCapture },
 		{ PROP_APP_APPENDCAPTURE, m_appendCapture },
+		{ PROP_APP_CAPTUREROTATESIZE, m_captureRotateSize },
+		{ PROP_APP_CAPTUREROTATEHOURS, m_captureRotateHours },
+		{ PROP_APP_CAPTURECOMPRESS, m_captureCompress },
+		{ PROP_APP_CGROUP, m_cgroup },
+		{ PROP_APP_CPUWEIGHT, m_cpuWeight },
+		{ PROP_APP_CPUQUOTA, m_cpuQuota },
+		{ PROP_APP_MEMORYHIGH, m_memoryHigh },
+		{ PROP_APP_MEMORYMAX, m_memoryMax },
+		{ PROP_APP_IOWEIGHT, m_ioWeight },
+		{ PROP_APP_CPUAFFINITY, m_cpuAffinity },
+		{ PROP_APP_NICE, m_nice },
+		{ PROP_APP_SCHEDPOLICY, m_schedPolicy },
+		{ PROP_APP_SCHEDPRIORITY, m_schedPriority },
+		{ PROP_APP_IOCLASS, m_ioClass },
+		{ PROP_APP_IOPRIORITY, m_ioPriority },
 		{ PROP_APP_TCPLOOPBACK, m_tcpLoopback },
 		{ PROP_APP_TCPLOOPBACKPORT, m_tcpLoopbackPort },
 		{ PROP_APP_HEARTBEATS, m_heartbeats },
-		{ PROP_APP_ENVIRONMENT, m_environmentList}
+		{ PROP_APP_ENVIRONMENT, m_environmentList},
+		{ PROP_APP_DEPENDENCIES, m_dependencyList }
 	};
 
 	m_appList->setProperty(PROPERTY_GROUPNAME, GROUP_APP);
@@ -189,6 +283,12 @@ HostConfigAppsWidget::HostConfigAppsWidget(QWidget *parent)
 	m_getConsoleOutput->setWhatsThis(tr("Retrieves the console output log from the last time the application was"
 		"run.  If the program is not a console application or the program was not run (the file doesn't exist)"
 		"this operation will fail."));
+	m_followConsoleOutput->setToolTip(tr("Watch the console output of this application as it is written"));
+	m_followConsoleOutput->setWhatsThis(tr("Opens a window showing the last %1 lines of the application's console "
+		"output, new output is added to the window as the application writes it until the window is closed.  "
+		"Output is sent a few times a second, if the application writes too much to keep up some of it is "
+		"skipped and the window shows how much was left out.  Use Get console output to see all of it.")
+		.arg(DEFAULT_CONSOLEFOLLOWLINES));
 	m_appList->setToolTip(tr("The list of applications"));
 	m_appList->setWhatsThis(tr("This is the current list of applications.  Click one of these to select it."));
 	m_appState->setToolTip(tr("The running state of the application"));
@@ -259,13 +359,70 @@ HostConfigAppsWidget::HostConfigAppsWidget(QWidget *parent)
 		"when remotely debugging console applications.  The file is overwritten every time the application "
 		"is restarted unless <b>append capture</b> is enabled.  If this is checked console applications"
 		"will be run hidden.<br>"
-		"While this option can be toggled while the application is running, on Windows it will only have an "
-		"effect if the program was set to running as 'hidden' when it was started.  Toggling this option while "
-		"an application is running will clear the contents of the log if <b>append capture</b> is not enabled."));
+		"On Linux this option can be toggled while the application is running, toggling it on will clear the "
+		"contents of the log if <b>append capture</b> is not enabled.  On other platforms the change takes "
+		"effect the next time the application is started, and on Windows only if the program is set to "
+		"run as 'hidden'."));
 	m_appendCapture->setToolTip(tr("Append console output"));
 	m_appendCapture->setWhatsThis(tr("When console output is started, either when an application is started "
 		"or if capturing is toggled while an application is running, the contents of the previous capture log "
 		"is cleared unless this settings is enabled."));
+	m_captureRotateSize->setToolTip(tr("Size in megabytes the console output file is rotated at, 0 to not rotate by size"));
+	m_captureRotateSize->setWhatsThis(tr("Once the console output file reaches this many megabytes it is renamed "
+		"with the date and time added to its name and a new file is started.  Only the newest rotated files "
+		"are kept.  On Linux files are rotated while the application runs, on other platforms a file that is too "
+		"big is rotated the next time the application is started with <b>append capture</b> enabled.  "
+		"Set to 0 to not rotate by size."));
+	m_captureRotateHours->setToolTip(tr("Hours between console output file rotations, 0 to not rotate by time"));
+	m_captureRotateHours->setWhatsThis(tr("A new console output file is started every this many hours, counted "
+		"from midnight, so 24 rotates the file daily at midnight.  The previous file is renamed with the date and "
+		"time added to its name.  On platforms other than Linux this happens the next time the application is "
+		"started.  Set to 0 to not rotate by time."));
+	m_captureCompress->setToolTip(tr("Gzip rotated console output files"));
+	m_captureCompress->setWhatsThis(tr("When checked, rotated console output files are compressed with gzip in "
+		"the background and saved with a <b>.gz</b> extension."));
+	m_cgroup->setToolTip(tr("Run the application and everything it starts in its own cgroup (Linux)"));
+	m_cgroup->setWhatsThis(tr("On Linux with cgroup v2 the application is started in a cgroup of its own, so "
+		"every process it starts stays in it.  Stopping the application kills all of them, as does the application "
+		"exiting, so helpers it started don't keep running.  The limits below only apply to applications in a "
+		"cgroup, their CPU time and memory use are also in the HTTP server's <b>/metrics</b>.  Pinhole has to run as root, "
+		"as the service, which under systemd needs <b>Delegate=yes</b> as in the unit Pinhole installs.  Turning this on or off takes effect the next time the "
+		"application is started, on other platforms it does nothing."));
+	m_cpuWeight->setToolTip(tr("Share of the CPU when it is busy, 0 for the default of 100"));
+	m_cpuWeight->setWhatsThis(tr("When the CPU is busy applications in cgroups get time in proportion to their "
+		"weight, an application with weight 200 gets twice the time of one with 100.  Set to 0 for the default "
+		"weight of 100.  Limits change straight away while the application runs."));
+	m_cpuQuota->setToolTip(tr("Most CPU the application may use in percent of one CPU, 0 for no limit"));
+	m_cpuQuota->setWhatsThis(tr("The application is held back once it uses this percentage of one CPU, 200 "
+		"allows two whole CPUs.  Set to 0 for no limit."));
+	m_memoryHigh->setToolTip(tr("Megabytes of memory above which the application is slowed down, 0 for no limit"));
+	m_memoryHigh->setWhatsThis(tr("Above this much memory the application is throttled and its memory reclaimed "
+		"hard, it is not killed.  Set to 0 for no limit."));
+	m_memoryMax->setToolTip(tr("Megabytes of memory above which the application is killed, 0 for no limit"));
+	m_memoryMax->setWhatsThis(tr("If the application can't be kept below this much memory the kernel kills its processes, "
+		"Pinhole then restarts it if it is kept running.  Set to 0 for no limit."));
+	m_ioWeight->setToolTip(tr("Share of disk time when disks are busy, 0 for the default of 100"));
+	m_cpuAffinity->setToolTip(tr("CPUs the application may run on, like 0-3,6, empty for every CPU (Linux)"));
+	m_cpuAffinity->setWhatsThis(tr("A comma separated list of CPU numbers and ranges the application is pinned "
+		"to, counted from 0, for example <b>2-3</b> to keep a media player on two CPUs of its own.  Only CPUs "
+		"Pinhole itself may run on can be used.  Leave it empty to run on every CPU.<br>"
+		"This and the other scheduling settings below are set each time the application is started, changes "
+		"take effect from the next start.  Only nice is supported on platforms other than Linux."));
+	m_nice->setToolTip(tr("Scheduling priority from -20, the highest, to 19, the lowest"));
+	m_nice->setWhatsThis(tr("Applications with a higher nice value get less CPU time when the CPU is busy, "
+		"for example 10 for background uploads.  Values below 0 need Pinhole to run as root.  Set to 0 to run "
+		"at the same priority as Pinhole."));
+	m_schedPolicy->setToolTip(tr("How the application is scheduled (Linux)"));
+	m_schedPolicy->setWhatsThis(tr("<b>Batch</b> suits CPU heavy background work and <b>Idle</b> only runs when "
+		"nothing else wants the CPU.  The realtime policies always run before normal applications, in order of "
+		"their priority, and need Pinhole to run as root or a realtime priority limit.  Use them with care, a "
+		"realtime application that never waits can stall the whole computer."));
+	m_schedPriority->setToolTip(tr("Priority from 1 to 99 of the realtime scheduling policies"));
+	m_ioClass->setToolTip(tr("How the application's disk access is scheduled (Linux)"));
+	m_ioClass->setWhatsThis(tr("<b>Realtime</b> disk access goes first and needs Pinhole to run as root, "
+		"<b>Idle</b> only gets the disk when nothing else uses it.  <b>Default</b> leaves it as Pinhole's.  This "
+		"depends on the disk's IO scheduler supporting priorities."));
+	m_ioPriority->setToolTip(tr("Priority from 0, the highest, to 7 of the realtime and best effort IO classes"));
 	m_tcpLoopback->setToolTip(tr("Listen for TCP loopback connections from the application"));
 	m_tcpLoopback->setWhatsThis(tr("Checking this will cause Pinhole to create a listening TCP port for the "
 		"application to connect to.  This connection can be used for sending heartbeats and reporting errors.") + loopbackHtml);
@@ -285,6 +442,14 @@ HostConfigAppsWidget::HostConfigAppsWidget(QWidget *parent)
 		"<b>NAME=VALUE</b>.  You can select multiple entries using the <b>shift</b> and <b>control</b> keys "
 		"and mouse in order to delete multiple entries at once.  Right click anywhere on the list to "
 		"bring up the menu to add a new entry or remove the selected entries.") + environmentHtml);
+	m_dependencyList->setToolTip(tr("Applications that must be ready before this application is launched"));
+	m_dependencyList->setWhatsThis(tr("This is a list of the names of applications this application depends on.  "
+		"When this application is launched at startup or as part of a group, the applications it depends on "
+		"are launched first and this application waits until they are ready.  An application is ready once it "
+		"is running or, if it has <b>Enforce timeout heartbeats</b> checked, once it has sent its first "
+		"heartbeat or log message.  Applications that aren't ready after a minute no longer hold up the "
+		"applications depending on them.  Right click anywhere on the list to bring up the menu to add a new "
+		"entry or remove the selected entries."));
 }
 
 
@@ -322,6 +487,7 @@ void HostConfigAppsWidget::enableWidgets(bool enable)
 	m_startAppButton->setEnabled(enable && itemSelected);
 	m_stopAppButton->setEnabled(enable && itemSelected);
 	m_getConsoleOutput->setEnabled(enable && itemSelected);
+	m_followConsoleOutput->setEnabled(enable && itemSelected);
 	m_deleteAppButton->setEnabled(enable && itemSelected && m_editable);
 	m_renameAppButton->setEnabled(enable && itemSelected && m_editable);
 
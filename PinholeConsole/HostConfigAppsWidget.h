@@ -32,6 +32,7 @@ public:
 	QPushButton * m_startAppButton = nullptr;
 	QPushButton * m_stopAppButton = nullptr;
 	QPushButton * m_getConsoleOutput = nullptr;
+	QPushButton * m_followConsoleOutput = nullptr;
 	QListWidget * m_appList = nullptr;
 	QLabel * m_appState = nullptr;
 	QLabel * m_lastStarted = nullptr;
@@ -50,10 +51,26 @@ public:
 	QCheckBox * m_lockupScreenshot = nullptr;
 	QCheckBox * m_consoleCapture = nullptr;
 	QCheckBox * m_appendCapture = nullptr;
+	QSpinBox * m_captureRotateSize = nullptr;
+	QSpinBox * m_captureRotateHours = nullptr;
+	QCheckBox * m_captureCompress = nullptr;
+	QCheckBox * m_cgroup = nullptr;
+	QSpinBox * m_cpuWeight = nullptr;
+	QSpinBox * m_cpuQuota = nullptr;
+	QSpinBox * m_memoryHigh = nullptr;
+	QSpinBox * m_memoryMax = nullptr;
+	QSpinBox * m_ioWeight = nullptr;
+	QLineEdit * m_cpuAffinity = nullptr;
+	QSpinBox * m_nice = nullptr;
+	QComboBox * m_schedPolicy = nullptr;
+	QSpinBox * m_schedPriority = nullptr;
+	QComboBox * m_ioClass = nullptr;
+	QSpinBox * m_ioPriority = nullptr;
 	QCheckBox * m_tcpLoopback = nullptr;
 	QSpinBox * m_tcpLoopbackPort = nullptr;
 	QCheckBox * m_heartbeats = nullptr;
 	ListWidgetEx * m_environmentList = nullptr;
+	ListWidgetEx * m_dependencyList = nullptr;
 
 signals:
 	void widgetValueChanged(QWidget* widget);
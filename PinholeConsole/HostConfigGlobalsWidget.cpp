@@ -75,6 +75,11 @@ HostConfigGlobalsWidget::HostConfigGlobalsWidget(QWidget *parent)
 	m_appCrashCount->setMaximum(MAX_CRASHCOUNT);
 	m_appCrashCount->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
 	detailsLayout->addRow(tr("Crash throttle max count"), m_appCrashCount);
+	m_maxLaunches = new QSpinBox;
+	m_maxLaunches->setMinimum(MIN_MAXLAUNCHES);
+	m_maxLaunches->setMaximum(MAX_MAXLAUNCHES);
+	m_maxLaunches->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	detailsLayout->addRow(tr("Maximum simultaneous launches"), m_maxLaunches);
 	m_trayLaunch = new QCheckBox(tr("Automatically launch tray application"));
 	detailsLayout->addRow(nullptr, m_trayLaunch);
 	m_trayControl = new QCheckBox(tr("Allow server control from system tray icon"));
@@ -143,6 +148,7 @@ HostConfigGlobalsWidget::HostConfigGlobalsWidget(QWidget *parent)
 		{ PROP_GLOBAL_HEARTBEATTIMEOUT, m_appHeartbeatTimeout },
 		{ PROP_GLOBAL_CRASHPERIOD, m_appCrashPeriod },
 		{ PROP_GLOBAL_CRASHCOUNT, m_appCrashCount },
+		{ PROP_GLOBAL_MAXLAUNCHES, m_maxLaunches },
 		{ PROP_GLOBAL_TRAYLAUNCH, m_trayLaunch },
 		{ PROP_GLOBAL_TRAYCONTROL, m_trayControl },
 		{ PROP_GLOBAL_HTTPENABLED, m_httpEnabled },
@@ -209,6 +215,10 @@ HostConfigGlobalsWidget::HostConfigGlobalsWidget(QWidget *parent)
 	m_appCrashCount->setToolTip(tr("Restart throttle crash count"));
 	m_appCrashCount->setWhatsThis(tr("Stop restarting an applciation if it crashes this number "
 		"times in <b>Crash throttle period</b> seconds."));
+	m_maxLaunches->setToolTip(tr("Number of applications that can be launching at the same time"));
+	m_maxLaunches->setWhatsThis(tr("When applications are launched at startup or as part of a group, at most "
+		"this many are started and not yet ready at the same time.  The rest wait for a launch slot to free "
+		"up, after the applications they depend on are ready."));
 	m_trayLaunch->setToolTip(tr("PinholeServer will automatically start and stop PinholeHelper"));
 	m_trayLaunch->setWhatsThis(tr("If checked, PinholeServer will launch PinholeHelper when it "
 		"starts and terminate it when it stops.  PinholeHelper is the user interface portion of "
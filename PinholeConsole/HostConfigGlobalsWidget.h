@@ -32,6 +32,7 @@ public:
 	QSpinBox * m_appHeartbeatTimeout = nullptr;
 	QSpinBox * m_appCrashPeriod = nullptr;
 	QSpinBox * m_appCrashCount = nullptr;
+	QSpinBox * m_maxLaunches = nullptr;
 	QCheckBox * m_trayLaunch = nullptr;
 	QCheckBox * m_trayControl = nullptr;
 	QCheckBox * m_httpEnabled = nullptr;
@@ -23,6 +23,7 @@
 #include <QLabel>
 #include <QCheckBox>
 #include <QCoreApplication>
+#include <QDateTime>
 
 
 HostConfigWidget::HostConfigWidget(QWidget *parent)
@@ -134,6 +135,9 @@ HostConfigWidget::HostConfigWidget(QWidget *parent)
 	// Get app console output button
 	connect(m_hostConfigAppsWidget->m_getConsoleOutput, &QPushButton::clicked,
 		this, &HostConfigWidget::getAppConsoleOutput);
+	// Follow app console output button
+	connect(m_hostConfigAppsWidget->m_followConsoleOutput, &QPushButton::clicked,
+		this, &HostConfigWidget::followAppConsoleOutput);
 	// Notifications from HostConfigGroupsWidget of widget values changing
 	connect(m_hostConfigGroupsWidget, &HostConfigGroupsWidget::widgetValueChanged,
 		this, &HostConfigWidget::setWidgetPropValue);
@@ -197,6 +201,7 @@ void HostConfigWidget::hostChanged(const QString& newHost, int port, const QStri
 	m_hostClient.clear();
 	m_currentApp.clear();
 	m_currentGroup.clear();
+	m_consoleViewers.clear();
 
 	if (!newHost.isEmpty())
 	{
@@ -213,6 +218,8 @@ void HostConfigWidget::hostChanged(const QString& newHost, int port, const QStri
 			this, &HostConfigWidget::HostConfigWidget::hostCommandMissing);
 		connect(m_hostClient.data(), &HostClient::commandData,
 			this, &HostConfigWidget::hostCommandData);
+		connect(m_hostClient.data(), &HostClient::consoleOutput,
+			this, &HostConfigWidget::hostConsoleOutput);
 		connect(m_hostClient.data(), &HostClient::connected,
 			this, &HostConfigWidget::hostConnected);
 		connect(m_hostClient.data(), &HostClient::disconnected,
@@ -360,6 +367,27 @@ void HostConfigWidget::getAppConsoleOutput()
 }
 
 
+void HostConfigWidget::followAppConsoleOutput()
+{
+	QModelIndexList selection = m_hostConfigAppsWidget->m_appList->selectionModel()->selectedRows();
+
+	if (1 == selection.size())
+	{
+		QString appName = selection[0].data().toString();
+		TextViewerDialog* textViewer = m_consoleViewers.value(appName);
+		if (textViewer)
+		{
+			textViewer->show();
+			textViewer->raise();
+			textViewer->activateWindow();
+			return;
+		}
+
+		m_hostClient->followApplicationConsole(appName, DEFAULT_CONSOLEFOLLOWLINES);
+	}
+}
+
+
 void HostConfigWidget::addGroup()
 {
 	bool ok;
@@ -551,7 +579,7 @@ void HostConfigWidget::resetAlertCount()
 
 void HostConfigWidget::retrieveAlerts()
 {
-	m_hostClient->retrieveAlertList();
+	m_hostClient->queryAlerts(0, 0, ALERT_PAGESIZE);
 }
 
 
@@ -844,6 +872,20 @@ void HostConfigWidget::hostCommandError(const QString& group, const QString& com
 
 void HostConfigWidget::hostCommandMissing(const QString& group, const QString& command)
 {
+	// Older hosts only send the whole alert list
+	if (GROUP_ALERT == group && CMD_ALERT_QUERY == command)
+	{
+		m_hostClient->retrieveAlertList();
+		return;
+	}
+
+	// Older hosts can only send the whole console output file
+	if (GROUP_APP == group && CMD_APP_FOLLOWCONSOLE == command)
+	{
+		getAppConsoleOutput();
+		return;
+	}
+
 	QMessageBox messageBox(this);
 	messageBox.setText(tr("The host does not recognize the command '%1:%2'")
 		.arg(group)
@@ -866,6 +908,38 @@ void HostConfigWidget::hostCommandData(const QString& group, const QString& comm
 				m_hostClient->getHostAddress(), m_hostClient->getHostName(), data.toByteArray(), this);
 			textViewer->show();
 		}
+		else if (CMD_APP_FOLLOWCONSOLE == command)
+		{
+			QVariantList vlist = data.toList();
+			QString appName = vlist.value(0).toString();
+			QByteArray compressedText = vlist.value(1).toByteArray();
+
+			// Following again after reconnecting carries on in the same window
+			TextViewerDialog* textViewer = m_consoleViewers.value(appName);
+			if (textViewer)
+			{
+				textViewer->appendText(qUncompress(compressedText));
+				return;
+			}
+
+			textViewer = new TextViewerDialog(tr("ConsoleOutput-%1").arg(appName),
+				m_hostClient->getHostAddress(), m_hostClient->getHostName(), compressedText, this);
+			textViewer->setFollowing(true);
+			m_consoleViewers[appName] = textViewer;
+
+			// The host stops sending once the window is closed
+			QWeakPointer<HostClient> hostClient = m_hostClient;
+			connect(textViewer, &QDialog::finished,
+				this, [this, hostClient, appName, textViewer]()
+			{
+				if (m_consoleViewers.value(appName) == textViewer)
+					m_consoleViewers.remove(appName);
+				QSharedPointer<HostClient> client = hostClient.toStrongRef();
+				if (!client.isNull())
+					client->unfollowApplicationConsole(appName);
+			});
+			textViewer->show();
+		}
 	}
 	else if (GROUP_ALERT == group)
 	{
@@ -875,6 +949,33 @@ void HostConfigWidget::hostCommandData(const QString& group, const QString& comm
 				m_hostClient->getHostAddress(), m_hostClient->getHostName(), data.toByteArray(), this);
 			textViewer->show();
 		}
+		else if (CMD_ALERT_QUERY == command)
+		{
+			QVariantList vlist = data.toList();
+			qint64 first = vlist.value(0).toLongLong();
+			qint64 last = vlist.value(1).toLongLong();
+			QVariantList alerts = vlist.value(2).toList();
+
+			QString text;
+			if (alerts.isEmpty())
+			{
+				text = tr("(No alerts logged)");
+			}
+			else if (alerts.size() < last - first + 1)
+			{
+				text = tr("(Showing the newest %1 of %2 alerts)\n").arg(alerts.size()).arg(last - first + 1);
+			}
+			for (const auto& alert : alerts)
+			{
+				QVariantList valert = alert.toList();
+				text += QDateTime::fromMSecsSinceEpoch(valert.value(1).toLongLong()).toString("yyyy-MM-dd HH:mm:ss ddd: ") +
+					valert.value(2).toString() + "\n";
+			}
+
+			TextViewerDialog* textViewer = new TextViewerDialog(tr("Alerts"),
+				m_hostClient->getHostAddress(), m_hostClient->getHostName(), qCompress(text.toUtf8()), this);
+			textViewer->show();
+		}
 	}
 }
 
@@ -914,10 +1015,25 @@ void HostConfigWidget::hostConnected()
 		m_hostClient->getVariant(group, item, prop);
 	}
 
+	// Keep following console output in the windows still open, without sending the last lines again
+	for (auto textViewer = m_consoleViewers.begin(); textViewer != m_consoleViewers.end(); ++textViewer)
+	{
+		if (!textViewer->isNull())
+			m_hostClient->followApplicationConsole(textViewer.key(), 0);
+	}
+
 	enableWidgets(true);
 }
 
 
+void HostConfigWidget::hostConsoleOutput(const QString& appName, const QByteArray& data)
+{
+	TextViewerDialog* textViewer = m_consoleViewers.value(appName);
+	if (textViewer)
+		textViewer->appendText(data);
+}
+
+
 void HostConfigWidget::hostDisconnected()
 {
 	if (!m_hostClient.isNull())
@@ -1207,6 +1323,7 @@ void HostConfigWidget::setScheduleValue(const QString& item, const QString& prop
 						comboBox->addItem(tr("Daily"), SCHED_FREQ_DAILY);
 						comboBox->addItem(tr("Hourly"), SCHED_FREQ_HOURLY);
 						comboBox->addItem(tr("Once"), SCHED_FREQ_ONCE);
+						comboBox->addItem(tr("Cron"), SCHED_FREQ_CRON);
 						comboBox->setToolTip(tr("The frequency at which the event will occur"));
 						m_hostConfigScheduleWidget->m_scheduleList->setCellWidget(row, column, comboBox);
 						connect(comboBox, (void (QComboBox::*)(int))&QComboBox::activated,
@@ -1220,6 +1337,17 @@ void HostConfigWidget::setScheduleValue(const QString& item, const QString& prop
 						offsetWidget->setToolTip(tr("The time at which the event will be triggered"));
 						m_hostConfigScheduleWidget->m_scheduleList->setCellWidget(row, column, offsetWidget);
 					}
+					else if (PROP_SCHED_CRON == scheduleProperties[column])
+					{
+						QLineEdit* lineEdit = new QLineEdit(m_hostConfigScheduleWidget->m_scheduleList);
+						lineEdit->setFrame(false);
+						lineEdit->setToolTip(tr("When the event will be triggered if the frequency is Cron.\n"
+							"Cron format: minute hour day-of-month month day-of-week, with an optional\n"
+							"leading seconds field, e.g. \"30 */5 * * * *\" or \"0 8 * * mon-fri\""));
+						connect(lineEdit, &QLineEdit::editingFinished,
+							this, &HostConfigWidget::lineEditValueChanged);
+						m_hostConfigScheduleWidget->m_scheduleList->setCellWidget(row, column, lineEdit);
+					}
 					else
 					{
 						QLineEdit* lineEdit = new QLineEdit(m_hostConfigScheduleWidget->m_scheduleList);
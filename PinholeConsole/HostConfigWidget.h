@@ -4,6 +4,8 @@
 
 #include <QWidget>
 #include <QTimer>
+#include <QMap>
+#include <QPointer>
 
 class QCheckBox;
 class QListWidget;
@@ -16,6 +18,7 @@ class HostConfigScheduleWidget;
 class HostConfigAlertWidget;
 class HostConfigWidgetTab;
 class HostClient;
+class TextViewerDialog;
 
 class HostConfigWidget : public QWidget
 {
@@ -33,6 +36,7 @@ public slots:
 	void deleteApp();
 	void renameApp();
 	void getAppConsoleOutput();
+	void followAppConsoleOutput();
 	void addGroup();
 	void deleteGroup();
 	void renameGroup();
@@ -56,6 +60,7 @@ public slots:
 	void hostCommandError(const QString&, const QString&);
 	void hostCommandMissing(const QString&, const QString&);
 	void hostCommandData(const QString&, const QString&, const QVariant&);
+	void hostConsoleOutput(const QString& appName, const QByteArray& data);
 	void hostConnected();
 	void hostDisconnected();
 	void setWidgetPropValue(QWidget* widget);
@@ -77,6 +82,7 @@ private:
 		PROP_SCHED_FREQUENCY,
 		PROP_SCHED_ARGUMENTS,
 		PROP_SCHED_OFFSET,
+		PROP_SCHED_CRON,
 		PROP_SCHED_LASTTRIGGERED
 	};
 	QStringList scheduleHeaders =
@@ -85,6 +91,7 @@ private:
 		tr("Frequency"),
 		tr("Arguments"),
 		tr("When"),
+		tr("Cron"),
 		tr("Last Triggered")
 	};
 
@@ -119,6 +126,7 @@ private:
 	QString m_currentApp;
 	QString m_currentGroup;
 	QSharedPointer<HostClient> m_hostClient;
+	QMap<QString, QPointer<TextViewerDialog>> m_consoleViewers;	// Windows following app console output
 
 	QTabWidget* m_tabWidget = nullptr;
 	QCheckBox* m_makeChangesCheck = nullptr;
@@ -3,6 +3,7 @@
 #include "HostItem.h"
 #include "../common/PinholeCommon.h"
 #include "../common/Utilities.h"
+#include "../common/DiscoveryPacket.h"
 
 #include <QNetworkDatagram>
 #include <QNetworkInterface>
@@ -10,6 +11,7 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QSet>
 #include <QSettings>
 #include <QMessageBox>
 #include <QGuiApplication>
@@ -43,15 +45,22 @@ HostFinder::HostFinder(QObject* parent) :
 	m_hashBrush->setColor(QColor(170, 64, 64));
 
 	// Create query packet
-	QJsonObject jsonObject;
-	jsonObject[TAG_COMMAND] = UDPCOMMAND_QUERY;
-	QJsonDocument jsonDoc;
-	jsonDoc.setObject(jsonObject);
-	m_queryPacket = jsonDoc.toJson();
+	m_queryPacket = queryPacket(0, DISCOVERY_ENCODING_JSON);
 
 	connect(m_sock, &QUdpSocket::readyRead,
 		this, &HostFinder::readyRead);
 
+	// Listen for announces servers push when their state changes, hosts that
+	//  push don't need to be queried. If the port can't be bound we just keep querying.
+	m_presenceSock = new QUdpSocket(this);
+	if (m_presenceSock->bind(QHostAddress::Any, PRESENCE_UDPPORT,
+		QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
+	{
+		m_presenceSock->joinMulticastGroup(QHostAddress(IPV6_MULTICAST));
+		connect(m_presenceSock, &QUdpSocket::readyRead,
+			this, &HostFinder::presenceReadyRead);
+	}
+
 	m_broadcastTimer.setInterval(FREQ_HOSTBROADCAST);
 	m_broadcastTimer.setSingleShot(false);
 	connect(&m_broadcastTimer, &QTimer::timeout,
@@ -122,6 +131,10 @@ bool HostFinder::eraseEntry(const QString& id)
 
 void HostFinder::queryLoopback()
 {
+	// A local server pushes its presence to loopback
+	if (isPushing(QHostAddress(QHostAddress::LocalHost).toString()))
+		return;
+
 	// Unicast queries to local loopback
 	m_sock->writeDatagram(m_queryPacket, QHostAddress(QHostAddress::LocalHost), HOST_UDPPORT);
 	m_sock->writeDatagram(m_queryPacket, QHostAddress(QHostAddress::LocalHostIPv6), HOST_UDPPORT);
@@ -145,9 +158,16 @@ void HostFinder::expireCheck()
 }
 
 
-// Broadcasts a host query packet on each network interface
+// Broadcasts a host query packet on each network interface. Subnets where
+// presence is being pushed and every known host is pushing are only broadcast
+// to every ROUNDS_PRESENCEBROADCAST rounds, to find consoles' blind spots such
+// as hosts that came up while the presence port couldn't be bound. Once a known
+// host there goes quiet for SECS_PRESENCEQUIET, or nothing there pushes at all
+// as with older servers, the subnet is broadcast to every round again.
 void HostFinder::broadcastHostQuery()
 {
+	bool slowRound = 0 == (m_broadcastRound++ % ROUNDS_PRESENCEBROADCAST);
+
 	// Send to broadcast address on each interface
 	for (const auto& iface : m_interfaces)
 	{
@@ -159,6 +179,9 @@ void HostFinder::broadcastHostQuery()
 		{
 			for (const auto& address : iface.addressEntries())
 			{
+				if (!slowRound && isSubnetPushing(address))
+					continue;
+
 				if (address.ip().protocol() == QAbstractSocket::IPv4Protocol)
 				{
 					m_sock->writeDatagram(m_queryPacket, address.broadcast(), HOST_UDPPORT);
@@ -178,17 +201,62 @@ void HostFinder::broadcastHostQuery()
 }
 
 
+// Builds a query packet, since is the sequence token of the last batched
+// redirect response from the destination or 0 for a full response.
+// Queries are JSON unless the destination is known to understand binary.
+QByteArray HostFinder::queryPacket(qint64 since, int encoding) const
+{
+	QVariantMap values;
+	values[TAG_COMMAND] = UDPCOMMAND_QUERY;
+	values[TAG_BATCH] = true;
+	if (0 != since)
+	{
+		values[TAG_SINCE] = QString::number(since);
+	}
+	values[TAG_ENCODING] = DISCOVERY_ENCODING_LATEST;
+	return EncodeDiscoveryPacket(values, encoding);
+}
+
+
 // Sends host query packets to each host in the host list not on a local subnet
 void HostFinder::queryHostList()
 {
+	// Periodically ask backends for everything in case a delta datagram was lost
+	bool resync = 0 == (m_hostQueryRound++ % ROUNDS_BACKENDRESYNC);
+
+	// Hosts redirected through a backend share its address, only query each address once
+	QSet<QString> queried;
 	for (const auto& host : m_hostList)
 	{
-		QHostAddress addr(host->getAddress());
+		QString address = host->getAddress();
+		if (queried.contains(address))
+			continue;
+		queried.insert(address);
+
+		// Only hosts that have gone quiet need to be asked
+		if (isPushing(address))
+			continue;
+
+		QHostAddress addr(address);
 		// Don't send query if broadcast query would send anyway
 		// JEBNOTE: Always query just in case targets can't receive broadcast packets for some reason
 		//if (!m_broadcastTimer.isActive() || !isAddressBroadcastable(addr))
 		{
-			m_sock->writeDatagram(m_queryPacket, addr, HOST_UDPPORT);
+			qint64 since = 0;
+			if (!resync && m_backendSequences.contains(address))
+			{
+				since = m_backendSequences[address];
+			}
+
+			int encoding = m_addressEncodings.value(address, DISCOVERY_ENCODING_JSON);
+			if (0 == since && DISCOVERY_ENCODING_JSON == encoding)
+			{
+				m_sock->writeDatagram(m_queryPacket, addr, HOST_UDPPORT);
+			}
+			else
+			{
+				m_sock->writeDatagram(queryPacket(since, encoding), addr, HOST_UDPPORT);
+			}
 		}
 	}
 }
@@ -216,126 +284,243 @@ void HostFinder::readyRead()
 			return;
 		}
 
-#if 1
-		// Don't process datagrams that come from auto-configured or other local interface addresses
-		if (isAutoConfiguredAddress(datagram.senderAddress()))
-			return;
-#else
-		// Only process datagram if source is not from a local address (not including loopback)
-		if (isLocalAddress(datagram.senderAddress()))
+		processDatagram(datagram, false);
+	}
+}
+
+
+// Reads announce and status packets pushed by servers
+void HostFinder::presenceReadyRead()
+{
+	while (m_presenceSock->hasPendingDatagrams())
+	{
+		QNetworkDatagram datagram = m_presenceSock->receiveDatagram();
+		if (!datagram.isValid())
 			return;
-#endif
 
-		// Parse the data as JSON
-#if defined(QT_DEBUG)
-		QByteArray jsonData = datagram.data();
-		QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData);
+		processDatagram(datagram, true);
+	}
+}
+
+
+// Updates the host list from a query response or pushed presence packet
+void HostFinder::processDatagram(const QNetworkDatagram& datagram, bool presence)
+{
+#if 1
+	// Don't process datagrams that come from auto-configured or other local interface addresses
+	if (isAutoConfiguredAddress(datagram.senderAddress()))
+		return;
 #else
-		QJsonDocument jsonDoc = QJsonDocument::fromJson(datagram.data());
+	// Only process datagram if source is not from a local address (not including loopback)
+	if (isLocalAddress(datagram.senderAddress()))
+		return;
 #endif
-		// Validate the data
-		if (!jsonDoc.isNull())
+
+	// Parse the data as JSON or binary
+	int encoding = DISCOVERY_ENCODING_JSON;
+	QVariantMap values = DecodeDiscoveryPacket(datagram.data(), &encoding);
+	// Validate the data
+	if (values.isEmpty())
+		return;
+
+	// Format the address string
+	bool preferredAddress = false;
+	QString addrStr;
+	switch (datagram.senderAddress().protocol())
+	{
+	case QAbstractSocket::IPv4Protocol:
+		addrStr = datagram.senderAddress().toString();
+		preferredAddress = true;
+		break;
+
+	case QAbstractSocket::IPv6Protocol:
+		addrStr = HostAddressToString(datagram.senderAddress(), &preferredAddress);
+		break;
+
+	default:
+		break;
+	}
+
+	// Remember the address talks binary so we can query it that way
+	if (DISCOVERY_ENCODING_JSON != encoding)
+	{
+		m_addressEncodings[addrStr] = encoding;
+	}
+
+	if (UDPCOMMAND_REDIRECTBATCH == values[TAG_COMMAND].toString())
+	{
+		processRedirectBatch(values, addrStr, preferredAddress);
+	}
+	else if (processHostObject(values, addrStr, preferredAddress))
+	{
+		if (presence)
 		{
-			// Format the address string
-			bool preferredAddress = false;
-			QString addrStr;
-			switch (datagram.senderAddress().protocol())
-			{
-			case QAbstractSocket::IPv4Protocol:
-				addrStr = datagram.senderAddress().toString();
-				preferredAddress = true;
-				break;
+			m_presenceHeard[addrStr] = QDateTime::currentMSecsSinceEpoch();
+		}
+	}
+}
 
-			case QAbstractSocket::IPv6Protocol:
-				addrStr = HostAddressToString(datagram.senderAddress(), &preferredAddress);
-				break;
 
-			default:
-				break;
-			}
+// Returns true if the address has pushed a presence packet recently enough that it doesn't need querying
+bool HostFinder::isPushing(const QString& address) const
+{
+	auto heard = m_presenceHeard.constFind(address);
+	if (heard == m_presenceHeard.constEnd())
+		return false;
 
-			// Parse the json data
-			QJsonObject jsonObject = jsonDoc.object();
-			QString command = jsonObject[TAG_COMMAND].toString();
-			QString id, hostAddress, name, role, version, platform, status, os, MAC;
-			int port = HOST_TCPPORT;	// Default port unless overridden by redirect
-			bool statusOnly = false;
-			if (UDPCOMMAND_ANNOUNCE == command)
-			{
-				id = jsonObject[TAG_ID].toString();
-				name = jsonObject[TAG_NAME].toString();
-				role = jsonObject[TAG_ROLE].toString();
-				version = jsonObject[TAG_VERSION].toString();
-				platform = jsonObject[TAG_PLATFORM].toString();
-				status = jsonObject[TAG_STATUS].toString();
-				os = jsonObject[TAG_OS].toString();
-				MAC = jsonObject[TAG_MAC].toString();
-			}
-			else if (UDPCOMMAND_STATUS == command)
-			{
-				id = jsonObject[TAG_ID].toString();
-				status = jsonObject[TAG_STATUS].toString();
-				statusOnly = true;
-			}
-			else if (UDPCOMMAND_REDIRECT == command)
-			{
-				id = jsonObject[TAG_ID].toString();
-				hostAddress = jsonObject[TAG_ADDRESS].toString();
-				port = jsonObject[TAG_PORT].toInt();
-				name = jsonObject[TAG_NAME].toString();
-				role = jsonObject[TAG_ROLE].toString();
-				version = jsonObject[TAG_VERSION].toString();
-				platform = jsonObject[TAG_PLATFORM].toString();
-				status = jsonObject[TAG_STATUS].toString();
-				os = jsonObject[TAG_OS].toString();
-			}
-			else
-			{
-				// Unknown command
-				return;
-			}
+	return QDateTime::currentMSecsSinceEpoch() - heard.value() < SECS_PRESENCEQUIET * 1000;
+}
 
-			// For compatibility with older servers that don't send ID
-			if (id.isEmpty())
-			{
-				id = addrStr;
-			}
 
-			// Find host in list
-			QSharedPointer<HostItem> host;
-			if (m_hostList.contains(id))
-				host = m_hostList[id];
-			int hostRow = hostIndex(id);
+// Returns true if presence has been pushed from the interface address's subnet
+// recently and every known host on the subnet is still pushing
+bool HostFinder::isSubnetPushing(const QNetworkAddressEntry& entry) const
+{
+	QPair<QHostAddress, int> subnet(entry.ip(), entry.prefixLength());
 
-			if (statusOnly)
-			{
-				if (!host.isNull())
-				{
-					host->setStatus(status);
-					emit dataChanged(index(hostRow, COL_STATUS), index(hostRow, COL_STATUS), { Qt::DisplayRole });
-				}
-			}
-			else
-			{
-				if (host.isNull())
-				{
-					// Host not in list yet
-					emit beginInsertRows(QModelIndex(), hostRow, hostRow);
-					m_hostList[id] = QSharedPointer<HostItem>::create(name, role, version, platform, status, os, MAC);
-					host = m_hostList[id];
-					emit endInsertRows();
-				}
-				else
-				{
-					// Update host in list
-					QPair<int, int> cols = host->update(name, role, version, platform, status, os, MAC);
-					emit dataChanged(index(hostRow, cols.first), index(hostRow, cols.second), { Qt::DisplayRole, Qt::BackgroundRole });
-				}
-				host->addAddress(QPair<QString, int>(addrStr, port), preferredAddress);
-				if (!hostAddress.isEmpty())
-					host->setHostAddress(hostAddress);
-			}
+	bool heard = false;
+	for (auto presence = m_presenceHeard.constBegin(); !heard && presence != m_presenceHeard.constEnd(); presence++)
+	{
+		heard = QHostAddress(presence.key()).isInSubnet(subnet) && isPushing(presence.key());
+	}
+	if (!heard)
+		return false;
+
+	for (const auto& host : m_hostList)
+	{
+		QString address = host->getAddress();
+		if (QHostAddress(address).isInSubnet(subnet) && !isPushing(address))
+			return false;
+	}
+	return true;
+}
+
+
+// Updates the host list from a single announce, status or redirect object,
+// returns false if the command is unknown
+bool HostFinder::processHostObject(const QVariantMap& values, const QString& addrStr, bool preferredAddress)
+{
+	QString command = values[TAG_COMMAND].toString();
+	QString id, hostAddress, name, role, version, platform, status, os, MAC;
+	int port = HOST_TCPPORT;	// Default port unless overridden by redirect
+	bool statusOnly = false;
+	if (UDPCOMMAND_ANNOUNCE == command)
+	{
+		id = values[TAG_ID].toString();
+		name = values[TAG_NAME].toString();
+		role = values[TAG_ROLE].toString();
+		version = values[TAG_VERSION].toString();
+		platform = values[TAG_PLATFORM].toString();
+		status = values[TAG_STATUS].toString();
+		os = values[TAG_OS].toString();
+		MAC = values[TAG_MAC].toString();
+	}
+	else if (UDPCOMMAND_STATUS == command)
+	{
+		id = values[TAG_ID].toString();
+		status = values[TAG_STATUS].toString();
+		statusOnly = true;
+	}
+	else if (UDPCOMMAND_REDIRECT == command)
+	{
+		id = values[TAG_ID].toString();
+		hostAddress = values[TAG_ADDRESS].toString();
+		port = values[TAG_PORT].toInt();
+		name = values[TAG_NAME].toString();
+		role = values[TAG_ROLE].toString();
+		version = values[TAG_VERSION].toString();
+		platform = values[TAG_PLATFORM].toString();
+		status = values[TAG_STATUS].toString();
+		os = values[TAG_OS].toString();
+	}
+	else
+	{
+		return false;
+	}
+
+	// For compatibility with older servers that don't send ID
+	if (id.isEmpty())
+	{
+		id = addrStr;
+	}
+
+	// Find host in list
+	QSharedPointer<HostItem> host;
+	if (m_hostList.contains(id))
+		host = m_hostList[id];
+	int hostRow = hostIndex(id);
+
+	if (statusOnly)
+	{
+		if (!host.isNull())
+		{
+			host->setStatus(status);
+			emit dataChanged(index(hostRow, COL_STATUS), index(hostRow, COL_STATUS), { Qt::DisplayRole });
+		}
+	}
+	else
+	{
+		if (host.isNull())
+		{
+			// Host not in list yet
+			emit beginInsertRows(QModelIndex(), hostRow, hostRow);
+			m_hostList[id] = QSharedPointer<HostItem>::create(name, role, version, platform, status, os, MAC);
+			host = m_hostList[id];
+			emit endInsertRows();
+		}
+		else
+		{
+			// Update host in list
+			QPair<int, int> cols = host->update(name, role, version, platform, status, os, MAC);
+			emit dataChanged(index(hostRow, cols.first), index(hostRow, cols.second), { Qt::DisplayRole, Qt::BackgroundRole });
 		}
+		host->addAddress(QPair<QString, int>(addrStr, port), preferredAddress);
+		if (!hostAddress.isEmpty())
+			host->setHostAddress(hostAddress);
+	}
+
+	return true;
+}
+
+
+// Updates the host list from a batched redirect response sent by a backend,
+// which may only contain the servers that changed since our last query
+void HostFinder::processRedirectBatch(const QVariantMap& values, const QString& addrStr, bool preferredAddress)
+{
+	QSet<QString>& backendHosts = m_backendHosts[addrStr];
+	if (values[TAG_FULL].toBool() && 0 == values[TAG_PART].toInt())
+	{
+		// First datagram of a full response, forget what we knew about this backend
+		backendHosts.clear();
+	}
+
+	for (const auto& removed : values[TAG_REMOVED].toStringList())
+	{
+		backendHosts.remove(removed);
+	}
+
+	for (const auto& server : values[TAG_SERVERS].toList())
+	{
+		QVariantMap serverValues = server.toMap();
+		if (processHostObject(serverValues, addrStr, preferredAddress))
+		{
+			backendHosts.insert(serverValues[TAG_ID].toString());
+		}
+	}
+
+	m_backendSequences[addrStr] = values[TAG_SEQUENCE].toLongLong();
+
+	// Unchanged servers are not resent, but the backend still has them
+	for (const auto& id : backendHosts)
+	{
+		if (m_hostList.contains(id))
+		{
+			m_hostList[id]->touch();
+		}
+	}
+	if (!m_hostList.isEmpty())
+	{
+		emit dataChanged(index(0, COL_LASTHEARD), index(m_hostList.size() - 1, COL_LASTHEARD), { Qt::DisplayRole, Qt::BackgroundRole });
 	}
 }
 
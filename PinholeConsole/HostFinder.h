@@ -2,13 +2,18 @@
 
 #include <QAbstractTableModel>
 #include <QMap>
+#include <QSet>
 #include <QThread>
 #include <QTimer>
+#include <QVariantMap>
 
 class QNetworkConfigurationManager;
 class QNetworkInterface;
+class QNetworkAddressEntry;
 class QUdpSocket;
+class QNetworkDatagram;
 class QHostAddress;
+class QJsonObject;
 class HostItem;
 
 class HostFinder : public QAbstractTableModel
@@ -37,6 +42,7 @@ public:
 
 public slots:
 	void readyRead();
+	void presenceReadyRead();
 
 private slots:
 	void expireCheck();
@@ -60,11 +66,18 @@ private:
 	};
 
 	int hostIndex(const QString& id) const;
+	void processDatagram(const QNetworkDatagram& datagram, bool presence);
+	bool isPushing(const QString& address) const;
+	bool isSubnetPushing(const QNetworkAddressEntry& entry) const;
+	bool processHostObject(const QVariantMap& values, const QString& addrStr, bool preferredAddress);
+	void processRedirectBatch(const QVariantMap& values, const QString& addrStr, bool preferredAddress);
+	QByteArray queryPacket(qint64 since, int encoding) const;
 	bool isAddressBroadcastable(const QHostAddress& addr) const;
 	bool isLocalAddress(const QHostAddress& addr) const;
 	bool isAutoConfiguredAddress(const QHostAddress& addr) const;
 
 	QUdpSocket* m_sock;
+	QUdpSocket* m_presenceSock = nullptr;
 	QTimer m_broadcastTimer;
 	QByteArray m_queryPacket;
 	QNetworkConfigurationManager* m_networkConfigurationManager = nullptr;
@@ -73,5 +86,15 @@ private:
 	// List of Addresses, prefix length
 	QList<QPair<QHostAddress, int>> m_localAddresses;
 	QList<QNetworkInterface> m_interfaces;
+	// Backend address, last batched redirect sequence token received
+	QMap<QString, qint64> m_backendSequences;
+	// Backend address, IDs of the hosts it is currently redirecting
+	QMap<QString, QSet<QString>> m_backendHosts;
+	// Address, discovery packet encoding it has answered with
+	QMap<QString, int> m_addressEncodings;
+	// Address, time in ms since epoch a presence packet was last pushed from it
+	QMap<QString, qint64> m_presenceHeard;
+	int m_hostQueryRound = 0;
+	int m_broadcastRound = 0;
 };
 
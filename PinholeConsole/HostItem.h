@@ -22,6 +22,7 @@ public:
 	void setStatus(const QString& status) { m_status = status; }
 	QString getStatus() const { return m_status; }
 	QDateTime getLastHeard() const { return m_lastHeard; }
+	void touch() { m_lastHeard = QDateTime::currentDateTime(); m_needExpiredNotification = true; }
 	QString getOs() const { return m_os; }
 	void setMAC(const QString& MAC) { m_mac = MAC; }
 	QString getMAC() const { return m_mac; }
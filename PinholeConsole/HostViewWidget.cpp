@@ -9,6 +9,8 @@
 #include "RemoteExecuteDialog.h"
 #include "ImportFilterDialog.h"
 #include "StartAppVarsDialog.h"
+#include "SearchLogsDialog.h"
+#include "LogSearchResults.h"
 #include "../common/HostClient.h"
 #include "../common/Utilities.h"
 
@@ -72,6 +74,10 @@ HostViewWidget::HostViewWidget(QWidget *parent)
 	connect(m_retrieveLogButton, &QPushButton::clicked,
 		this, &HostViewWidget::retrieveLogButton_clicked);
 	m_pushButtons.append(m_retrieveLogButton);
+	m_searchLogsButton = new QPushButton(tr("Search logs"));
+	connect(m_searchLogsButton, &QPushButton::clicked,
+		this, &HostViewWidget::searchLogsButton_clicked);
+	m_pushButtons.append(m_searchLogsButton);
 	m_showScreenIdsButton = new QPushButton(tr("Show screen IDs"));
 	connect(m_showScreenIdsButton, &QPushButton::clicked,
 		this, [this]() { execServerCommandOnEachSelectedHost(tr("show screen IDs"),
@@ -172,6 +178,10 @@ HostViewWidget::HostViewWidget(QWidget *parent)
 	m_retrieveLogButton->setToolTip(tr("Retrieve Pinhole log from remote hosts"));
 	m_retrieveLogButton->setWhatsThis(tr("This button retrieves the Pinhole log file from the remote hosts and opens them in "
 		"a text viewer window."));
+	m_searchLogsButton->setToolTip(tr("Search the Pinhole log or app console output on the selected hosts"));
+	m_searchLogsButton->setWhatsThis(tr("This button searches the Pinhole log or the captured console output of an "
+		"application on each of the selected hosts.  The search is done by the hosts and only the matching lines are "
+		"sent back, the results from all of the hosts are merged in time order in one text viewer window."));
 	m_showScreenIdsButton->setToolTip(tr("Identify screens onselected  hosts"));
 	m_showScreenIdsButton->setWhatsThis(tr("This button will tell the selected hosts to display identifying information on "
 		"each display monitor.  The information displayed will include the host name, monitor name, monitor virtual position, "
@@ -476,6 +486,54 @@ void HostViewWidget::retrieveLogButton_clicked()
 }
 
 
+void HostViewWidget::searchLogsButton_clicked()
+{
+	QModelIndexList indexList = m_hostList->selectionModel()->selectedIndexes();
+
+	if (indexList.isEmpty())
+	{
+		return;
+	}
+
+	SearchLogsDialog dialog(this);
+
+	if (QDialog::Accepted != dialog.exec())
+	{
+		return;
+	}
+
+	QString appName = dialog.appName();
+	QString pattern = dialog.pattern();
+	bool regularExpression = dialog.regularExpression();
+	bool caseSensitive = dialog.caseSensitive();
+	QString startDate = dialog.startDate().toString(DATETIME_STRINGFORMAT);
+	QString endDate = dialog.endDate().toString(DATETIME_STRINGFORMAT);
+	int level = dialog.level();
+	int maxResults = dialog.maxResults();
+	int context = dialog.context();
+
+	LogSearchResults* results = new LogSearchResults(tr("Search"), this);
+
+	for (const auto& index : indexList)
+	{
+		if (COL_NAME == index.column())
+		{
+			QString hostName = index.data().toString();
+			QString addr = index.data(HOSTROLE_ADDRESS).toString();
+			int port = index.data(HOSTROLE_PORT).toInt();
+			QString id = index.data(HOSTROLE_ID).toString();
+			HostClient* client = execServerCommand(addr, port, id, hostName, tr("search logs"),
+				[=](HostClient* hostClient)
+			{
+				hostClient->searchLogs(appName, pattern, regularExpression, caseSensitive,
+					startDate, endDate, level, maxResults, context);
+			});
+			results->addHost(client, hostName);
+		}
+	}
+}
+
+
 void HostViewWidget::executeCommand_clicked()
 {
 	QModelIndexList indexList = m_hostList->selectionModel()->selectedIndexes();
@@ -595,7 +653,7 @@ void HostViewWidget::hostList_doubleClicked(const QModelIndex& index)
 
 
 // Executes a command on a server, sets notification message and clears it when response is received
-void HostViewWidget::execServerCommand(const QString& hostAddress, int port, const QString& hostId,
+HostClient* HostViewWidget::execServerCommand(const QString& hostAddress, int port, const QString& hostId,
 	const QString& hostName, const QString& commandDescription, std::function<void(HostClient*)> func)
 {
 	unsigned int nid = NoticeId();
@@ -735,6 +793,8 @@ void HostViewWidget::execServerCommand(const QString& hostAddress, int port, con
 			hostClient->deleteLater();
 			emit clearNoticeText(nid);
 		});
+
+	return hostClient;
 }
 
 
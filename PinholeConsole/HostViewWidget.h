@@ -25,6 +25,7 @@ public slots:
 	void importSettingsButton_clicked();
 	void wakeOnLanButton_clicked();
 	void retrieveLogButton_clicked();
+	void searchLogsButton_clicked();
 	void hostList_doubleClicked(const QModelIndex&);
 	void enableButtons(bool enable);
 	void addCustomButtonClicked();
@@ -41,7 +42,7 @@ public:
 private:
 	void resizeEvent(QResizeEvent* event) override;
 	bool event(QEvent* ev) override;
-	void execServerCommand(const QString& hostAddress, int port, const QString& hostId,
+	HostClient* execServerCommand(const QString& hostAddress, int port, const QString& hostId,
 		const QString& hostName, const QString& failureMessage, std::function<void(HostClient*)> lambda);
 	void execServerCommandOnEachSelectedHost(const QString& failureMessage, 
 		std::function<void(HostClient*)> lambda);
@@ -57,6 +58,7 @@ private:
 	QPushButton * m_startStartupAppsButton = nullptr;
 	QPushButton * m_stopAllAppsButton = nullptr;
 	QPushButton * m_retrieveLogButton = nullptr;
+	QPushButton * m_searchLogsButton = nullptr;
 	QPushButton * m_showScreenIdsButton = nullptr;
 	QPushButton * m_screenshotButton = nullptr;
 	QPushButton * m_sysinfoButton = nullptr;
@@ -0,0 +1,104 @@
+#include "LogSearchResults.h"
+#include "TextViewerDialog.h"
+#include "../common/HostClient.h"
+#include "../common/PinholeCommon.h"
+#include "../qmsgpack/msgpack.h"
+
+#include <algorithm>
+
+LogSearchResults::LogSearchResults(const QString& description, QWidget *parent)
+	: QObject(parent), m_description(description), m_parentWidget(parent)
+{
+}
+
+
+LogSearchResults::~LogSearchResults()
+{
+}
+
+
+void LogSearchResults::addHost(HostClient* hostClient, const QString& hostName)
+{
+	m_waitingHosts[hostClient] = tr("%1 (%2)")
+		.arg(hostName)
+		.arg(hostClient->getHostAddress());
+	m_hostCount++;
+
+	connect(hostClient, &HostClient::commandData,
+		this, [this, hostClient](const QString& group, const QString& subCommand, const QVariant& data)
+	{
+		if (GROUP_NONE == group && CMD_NONE_SEARCHLOGS == subCommand)
+			addResults(hostClient, data);
+	});
+
+	// However the command ends the client is deleted
+	connect(hostClient, &QObject::destroyed,
+		this, [this, hostClient]()
+	{
+		hostFinished(hostClient);
+	});
+}
+
+
+void LogSearchResults::addResults(HostClient* hostClient, const QVariant& data)
+{
+	QString host = m_waitingHosts.take(hostClient);
+	QVariantList vlist = data.toList();
+
+	m_matches += vlist.value(0).toInt();
+	if (vlist.value(1).toBool())
+		m_limitedHosts.append(host);
+
+	for (const auto& groupVariant : MsgPack::unpack(qUncompress(vlist.value(2).toByteArray())).toList())
+	{
+		QVariantList vgroup = groupVariant.toList();
+		Group group;
+		group.key = vgroup.value(0).toString();
+		group.host = host;
+		group.file = vgroup.value(1).toString();
+		group.text = vgroup.value(2).toByteArray();
+		m_groups.append(group);
+	}
+}
+
+
+void LogSearchResults::hostFinished(HostClient* hostClient)
+{
+	// Hosts that went without sending results failed or don't know the command
+	if (m_waitingHosts.contains(hostClient))
+		m_failedHosts.append(m_waitingHosts.take(hostClient));
+
+	if (++m_finishedHosts == m_hostCount)
+		showResults();
+}
+
+
+void LogSearchResults::showResults()
+{
+	// Log entries from every host in time order, console output stays in host order
+	std::stable_sort(m_groups.begin(), m_groups.end(),
+		[](const Group& a, const Group& b) { return a.key < b.key; });
+
+	QString header = tr("(%1 match%2 found on %3 host%4)\n")
+		.arg(m_matches)
+		.arg(m_matches == 1 ? "" : "es")
+		.arg(m_hostCount - m_failedHosts.size())
+		.arg(m_hostCount - m_failedHosts.size() == 1 ? "" : "s");
+	if (!m_limitedHosts.isEmpty())
+		header += tr("(Stopped at the most matches on %1)\n").arg(m_limitedHosts.join(", "));
+	if (!m_failedHosts.isEmpty())
+		header += tr("(No results from %1)\n").arg(m_failedHosts.join(", "));
+
+	QByteArray text = header.toUtf8();
+	for (const auto& group : m_groups)
+	{
+		text += "\n--- " + group.host.toUtf8() + "  " + group.file.toUtf8() + "\n";
+		text += group.text;
+	}
+
+	TextViewerDialog* textViewer = new TextViewerDialog(m_description, tr("merged"),
+		tr("%1 host%2").arg(m_hostCount).arg(m_hostCount == 1 ? "" : "s"), qCompress(text), m_parentWidget);
+	textViewer->show();
+
+	deleteLater();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QObject>
+#include <QMap>
+#include <QStringList>
+
+class HostClient;
+class QWidget;
+
+// Collects the results of a log search from each host it was sent to and
+// shows them merged in one text viewer, in log time order, once every host
+// has answered or gone away
+class LogSearchResults : public QObject
+{
+	Q_OBJECT
+
+public:
+	LogSearchResults(const QString& description, QWidget *parent);
+	~LogSearchResults();
+
+	void addHost(HostClient* hostClient, const QString& hostName);
+
+private:
+	// One match with its context lines from one host
+	struct Group
+	{
+		QString key;		// Log time of the match, empty for console output
+		QString host;
+		QString file;
+		QByteArray text;
+	};
+
+	void addResults(HostClient* hostClient, const QVariant& data);
+	void hostFinished(HostClient* hostClient);
+	void showResults();
+
+	QString m_description;
+	QWidget* m_parentWidget = nullptr;
+	QMap<HostClient*, QString> m_waitingHosts;
+	QList<Group> m_groups;
+	int m_hostCount = 0;
+	int m_finishedHosts = 0;
+	int m_matches = 0;
+	QStringList m_limitedHosts;
+	QStringList m_failedHosts;
+};
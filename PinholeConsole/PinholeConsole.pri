@@ -40,7 +40,10 @@ HEADERS += ../common/Version.h \
     ./HostConfigWidget.h \
     ./HostConfigGlobalsWidget.h \
     ./HostConfigAppsWidget.h \
-    ./StartAppVarsDialog.h
+    ./StartAppVarsDialog.h \
+    ../common/DiscoveryPacket.h \
+    ./SearchLogsDialog.h \
+    ./LogSearchResults.h
 SOURCES += ../common/HostClient.cpp \
     ../common/Utilities.cpp \
     ../common/Utilities_Mac.cpp \
@@ -73,5 +76,8 @@ SOURCES += ../common/HostClient.cpp \
     ./ScreenviewDialog.cpp \
     ./TextViewerDialog.cpp \
     ./WindowManager.cpp \
-    ./StartAppVarsDialog.cpp
+    ./StartAppVarsDialog.cpp \
+    ../common/DiscoveryPacket.cpp \
+    ./SearchLogsDialog.cpp \
+    ./LogSearchResults.cpp
 RESOURCES += PinholeConsole.qrc
@@ -71,7 +71,7 @@ void ScheduleEventOffsetWidget::setType(const QString& type)
 
 	m_type = type;
 
-	if (SCHED_FREQ_DISABLED == m_type)
+	if (SCHED_FREQ_DISABLED == m_type || SCHED_FREQ_CRON == m_type)
 	{
 		m_comboBox->hide();
 		m_timeEdit->hide();
@@ -0,0 +1,192 @@
+#include "SearchLogsDialog.h"
+#include "../common/PinholeCommon.h"
+
+#include <QGuiApplication>
+#include <QFormLayout>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QDateTimeEdit>
+#include <QLabel>
+#include <QDialogButtonBox>
+#include <QMessageBox>
+#include <QRegularExpression>
+
+SearchLogsDialog::SearchLogsDialog(QWidget *parent)
+	: QDialog(parent)
+{
+	setWindowTitle(tr("Search logs"));
+
+	QFormLayout* mainLayout = new QFormLayout(this);
+	m_source = new QComboBox;
+	m_source->addItem(tr("Pinhole log"));
+	m_source->addItem(tr("Application console output"));
+	mainLayout->addRow(new QLabel(tr("Search")), m_source);
+	m_appName = new QLineEdit;
+	m_appName->setEnabled(false);
+	mainLayout->addRow(new QLabel(tr("Application name")), m_appName);
+	m_pattern = new QLineEdit;
+	mainLayout->addRow(new QLabel(tr("Find")), m_pattern);
+	m_regularExpression = new QCheckBox(tr("Regular expression"));
+	mainLayout->addRow(nullptr, m_regularExpression);
+	m_caseSensitive = new QCheckBox(tr("Case sensitive"));
+	mainLayout->addRow(nullptr, m_caseSensitive);
+	m_startDate = new QDateTimeEdit;
+	mainLayout->addRow(new QLabel(tr("Start time")), m_startDate);
+	m_endDate = new QDateTimeEdit;
+	mainLayout->addRow(new QLabel(tr("End time")), m_endDate);
+	m_level = new QComboBox;
+	m_level->addItem(tr("Debug"), LOG_DEBUG);
+	m_level->addItem(tr("Extra"), LOG_EXTRA);
+	m_level->addItem(tr("Normal"), LOG_NORMAL);
+	m_level->addItem(tr("Warning"), LOG_WARNING);
+	m_level->addItem(tr("Error"), LOG_ERROR);
+	m_level->setCurrentIndex(0);
+	mainLayout->addRow(new QLabel(tr("Lowest log level")), m_level);
+	m_maxResults = new QSpinBox;
+	m_maxResults->setRange(1, MAX_SEARCHRESULTS);
+	m_maxResults->setValue(DEFAULT_SEARCHRESULTS);
+	mainLayout->addRow(new QLabel(tr("Most matches per host")), m_maxResults);
+	m_context = new QSpinBox;
+	m_context->setRange(0, MAX_SEARCHCONTEXT);
+	m_context->setValue(DEFAULT_SEARCHCONTEXT);
+	mainLayout->addRow(new QLabel(tr("Lines of context")), m_context);
+	QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+	mainLayout->addRow(nullptr, buttons);
+
+	QDateTime current = QDateTime::currentDateTime();
+	m_startDate->setDateTime(current.addDays(-1));
+	m_endDate->setDateTime(current);
+	m_endDate->setMinimumDateTime(m_startDate->dateTime());
+
+	// Prevent end date from being less than start date
+	connect(m_startDate, &QDateTimeEdit::dateTimeChanged,
+		this, [this](const QDateTime& datetime)
+	{
+		m_endDate->setMinimumDateTime(datetime);
+	});
+
+	// Console output has no log levels
+	connect(m_source, QOverload<int>::of(&QComboBox::currentIndexChanged),
+		this, [this](int index)
+	{
+		m_appName->setEnabled(1 == index);
+		m_level->setEnabled(0 == index);
+	});
+
+	connect(buttons, &QDialogButtonBox::rejected,
+		this, &SearchLogsDialog::reject);
+	connect(buttons, &QDialogButtonBox::accepted,
+		[this]()
+		{
+			if (m_appName->isEnabled() && m_appName->text().isEmpty())
+			{
+				QMessageBox::warning(this, QGuiApplication::applicationDisplayName(),
+					tr("Enter the application name whose console output to search"));
+				return;
+			}
+
+			QRegularExpression regExp(m_pattern->text());
+			if (m_regularExpression->isChecked() && !regExp.isValid())
+			{
+				QMessageBox::warning(this, QGuiApplication::applicationDisplayName(),
+					tr("The regular expression is not valid: %1").arg(regExp.errorString()));
+				return;
+			}
+
+			done(QDialog::Accepted);
+		});
+
+	m_source->setToolTip(tr("What to search"));
+	m_source->setWhatsThis(tr("Search either the Pinhole log or the captured console output of an application.  "
+		"Console output is only searched if the application has <b>Capture console output to file</b> enabled, rotated "
+		"console output files that have been compressed are not searched."));
+	m_appName->setToolTip(tr("Application whose console output to search"));
+	m_appName->setWhatsThis(tr("This is the name of the application whose console output to search, it must exist "
+		"on the hosts being searched.  This is case sensitive."));
+	m_pattern->setToolTip(tr("Text to find"));
+	m_pattern->setWhatsThis(tr("Lines containing this text are found.  Leave it empty to find every line, for "
+		"example to see all of the errors in a period."));
+	m_regularExpression->setToolTip(tr("Find text as a regular expression"));
+	m_regularExpression->setWhatsThis(tr("When checked the text to find is a Perl compatible regular expression "
+		"that has to match part of a line."));
+	m_caseSensitive->setToolTip(tr("Match upper and lower case exactly"));
+	m_startDate->setToolTip(tr("Earliest time to search"));
+	m_startDate->setWhatsThis(tr("Log entries before this time are not searched.  Console output lines have "
+		"no time so only whole console output files written before this time are skipped."));
+	m_endDate->setToolTip(tr("Latest time to search"));
+	m_endDate->setWhatsThis(tr("Log entries after this time are not searched.  Console output lines have no "
+		"time so only whole console output files started after this time are skipped."));
+	m_level->setToolTip(tr("Only search log entries of this level and above"));
+	m_level->setWhatsThis(tr("Log entries of this level and above are searched.  Entries the server always "
+		"logs, such as termination requests and password changes, have no level in the log file and are searched as Normal, so "
+		"the Warning and Error levels leave them out."));
+	m_maxResults->setToolTip(tr("The most matching lines each host sends back"));
+	m_maxResults->setWhatsThis(tr("Each host stops searching once it has found this many matching lines, the "
+		"results say which hosts stopped early."));
+	m_context->setToolTip(tr("Lines shown before and after each matching line"));
+
+	setWindowFlag(Qt::MSWindowsFixedSizeDialogHint);
+	layout()->setSizeConstraint(QLayout::SetFixedSize);
+}
+
+
+SearchLogsDialog::~SearchLogsDialog()
+{
+}
+
+
+// Empty to search the Pinhole log
+QString SearchLogsDialog::appName() const
+{
+	return m_appName->isEnabled() ? m_appName->text() : QString();
+}
+
+
+QString SearchLogsDialog::pattern() const
+{
+	return m_pattern->text();
+}
+
+
+bool SearchLogsDialog::regularExpression() const
+{
+	return m_regularExpression->isChecked();
+}
+
+
+bool SearchLogsDialog::caseSensitive() const
+{
+	return m_caseSensitive->isChecked();
+}
+
+
+QDateTime SearchLogsDialog::startDate() const
+{
+	return m_startDate->dateTime();
+}
+
+
+QDateTime SearchLogsDialog::endDate() const
+{
+	return m_endDate->dateTime();
+}
+
+
+int SearchLogsDialog::level() const
+{
+	return m_level->currentData().toInt();
+}
+
+
+int SearchLogsDialog::maxResults() const
+{
+	return m_maxResults->value();
+}
+
+
+int SearchLogsDialog::context() const
+{
+	return m_context->value();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QDialog>
+#include <QDateTime>
+
+class QLineEdit;
+class QCheckBox;
+class QComboBox;
+class QSpinBox;
+class QDateTimeEdit;
+
+class SearchLogsDialog : public QDialog
+{
+	Q_OBJECT
+
+public:
+	SearchLogsDialog(QWidget *parent);
+	~SearchLogsDialog();
+	QString appName() const;
+	QString pattern() const;
+	bool regularExpression() const;
+	bool caseSensitive() const;
+	QDateTime startDate() const;
+	QDateTime endDate() const;
+	int level() const;
+	int maxResults() const;
+	int context() const;
+
+private:
+	QComboBox* m_source = nullptr;
+	QLineEdit* m_appName = nullptr;
+	QLineEdit* m_pattern = nullptr;
+	QCheckBox* m_regularExpression = nullptr;
+	QCheckBox* m_caseSensitive = nullptr;
+	QDateTimeEdit* m_startDate = nullptr;
+	QDateTimeEdit* m_endDate = nullptr;
+	QComboBox* m_level = nullptr;
+	QSpinBox* m_maxResults = nullptr;
+	QSpinBox* m_context = nullptr;
+};
@@ -17,14 +17,18 @@
 #include <QShortcut>
 #include <QDesktopServices>
 #include <QSettings>
+#include <QScrollBar>
+#include <QTextCursor>
 
 #define VALUE_LASTDIRCHOSEN		"lastTextViewerDirectoryChosen"
+#define MAX_FOLLOWLINES			100000		// Lines kept when following, older lines are dropped
+#define SIZE_FOLLOWTEXT			16777216	// Bytes kept for saving when following
 
 
 TextViewerDialog::TextViewerDialog(const QString& description, const QString& hostAddress, 
 	const QString& hostName, const QByteArray& compressedText, QWidget *parent)
 	: QDialog(parent), m_description(description), m_hostAddress(hostAddress), 
-	m_hostName(hostName), m_text(qUncompress(compressedText))
+	m_hostName(hostName), m_text(qUncompress(compressedText)), m_decoder(QTextCodec::codecForName("UTF-8"))
 {
 	QSettings settings;
 	g_lastDirectoryChosen = settings.value(VALUE_LASTDIRCHOSEN).toString();
@@ -41,7 +45,7 @@ TextViewerDialog::TextViewerDialog(const QString& description, const QString& ho
 	QGridLayout* mainLayout = new QGridLayout(this);
 	mainLayout->setMargin(0);
 
-	m_textEdit = new QPlainTextEdit(QString::fromUtf8(m_text));
+	m_textEdit = new QPlainTextEdit(m_decoder.toUnicode(m_text));
 	m_textEdit->setReadOnly(true);
 	m_textEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
 	mainLayout->addWidget(m_textEdit);
@@ -78,6 +82,17 @@ TextViewerDialog::TextViewerDialog(const QString& description, const QString& ho
 	{
 		m_textEdit->setLineWrapMode(checked ? QPlainTextEdit::WidgetWidth : QPlainTextEdit::NoWrap);
 	});
+	m_followAction = viewMenu->addAction(tr("&Follow"));
+	m_followAction->setShortcut(QKeySequence(tr("Ctrl+L")));
+	m_followAction->setCheckable(true);
+	m_followAction->setChecked(true);
+	m_followAction->setVisible(false);
+	connect(m_followAction, &QAction::triggered,
+		this, [this](bool checked)
+	{
+		if (checked)
+			m_textEdit->verticalScrollBar()->setValue(m_textEdit->verticalScrollBar()->maximum());
+	});
 	viewMenu->addAction(tr("Zoom &In"), [this] 
 		{ m_textEdit->zoomIn(); })->setShortcut(QKeySequence::ZoomIn);
 	viewMenu->addAction(tr("Zoom &Out"), [this] 
@@ -113,6 +128,38 @@ TextViewerDialog::~TextViewerDialog()
 }
 
 
+// Following text has more appended as it arrives and scrolls to the end while Follow is checked
+void TextViewerDialog::setFollowing(bool following)
+{
+	m_followAction->setVisible(following);
+	m_textEdit->setMaximumBlockCount(following ? MAX_FOLLOWLINES : 0);
+	if (following)
+		m_textEdit->verticalScrollBar()->setValue(m_textEdit->verticalScrollBar()->maximum());
+}
+
+
+void TextViewerDialog::appendText(const QByteArray& text)
+{
+	if (text.isEmpty())
+		return;
+
+	// Drop whole lines from the start of what gets saved once it's too big
+	m_text.append(text);
+	if (m_text.size() > SIZE_FOLLOWTEXT)
+	{
+		int start = m_text.indexOf('\n', m_text.size() - SIZE_FOLLOWTEXT);
+		m_text.remove(0, start < 0 ? m_text.size() - SIZE_FOLLOWTEXT : start + 1);
+	}
+
+	QTextCursor cursor(m_textEdit->document());
+	cursor.movePosition(QTextCursor::End);
+	cursor.insertText(m_decoder.toUnicode(text));
+
+	if (m_followAction->isChecked())
+		m_textEdit->verticalScrollBar()->setValue(m_textEdit->verticalScrollBar()->maximum());
+}
+
+
 void TextViewerDialog::saveAction_triggered()
 {
 	QFileDialog dialog(this, tr("Save %1 file from %2 As")
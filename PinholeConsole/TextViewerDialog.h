@@ -1,9 +1,11 @@
 #pragma once
 
 #include <QDialog>
+#include <QTextCodec>
 
 class FindTextDialog;
 class QPlainTextEdit;
+class QAction;
 
 class TextViewerDialog : public QDialog
 {
@@ -14,9 +16,12 @@ public:
 		const QString& hostName, const QByteArray& compressedText, QWidget *parent);
 	~TextViewerDialog();
 
+	void setFollowing(bool following);
+
 public slots:
 	void saveAction_triggered();
 	void findText();
+	void appendText(const QByteArray& text);
 
 private:
 	void changeEvent(QEvent* event) override;
@@ -24,8 +29,10 @@ private:
 	QString m_hostAddress;
 	QString m_hostName;
 	QByteArray m_text;
+	QTextDecoder m_decoder;			// Keeps partial characters between appended chunks
 	QPlainTextEdit * m_textEdit = nullptr;
 	FindTextDialog * m_findDialog = nullptr;
+	QAction * m_followAction = nullptr;
 	QString g_lastDirectoryChosen;
 };
 
@@ -0,0 +1,590 @@
+#include "AlertDispatcher.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "Values.h"
+#include "../common/PinholeCommon.h"
+#include "SmtpSession.h"
+
+#include <QFile>
+#include <QHostInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QProcess>
+#include <QRegExp>
+#include <QSaveFile>
+#include <QThread>
+#include <QUrl>
+
+
+AlertSender::AlertSender(QObject *parent)
+	: QObject(parent)
+{
+}
+
+
+AlertSender::~AlertSender()
+{
+}
+
+
+void AlertSender::send(const AlertDelivery& delivery, const AlertSmtpConfig& smtpConfig)
+{
+	// Created here so it belongs to the worker thread
+	if (!m_networkAccessManager)
+		m_networkAccessManager = new QNetworkAccessManager(this);
+
+	if (ALERTSLOT_TYPE_SMPTEMAIL == delivery.type)
+	{
+		sendSmtpEmail(delivery, smtpConfig);
+	}
+	else if (ALERTSLOT_TYPE_HTTPGET == delivery.type)
+	{
+		sendHttpGet(delivery);
+	}
+	else if (ALERTSLOT_TYPE_HTTPPOST == delivery.type)
+	{
+		sendHttpPost(delivery);
+	}
+	else if (ALERTSLOT_TYPE_SLACK == delivery.type)
+	{
+		sendSlack(delivery);
+	}
+	else if (ALERTSLOT_TYPE_EXTERNAL == delivery.type)
+	{
+		executeExternal(delivery);
+	}
+	else
+	{
+		Logger(LOG_ERROR) << tr("Alert %1: Unknown alert slot type '%2'")
+			.arg(delivery.slotName)
+			.arg(delivery.type);
+		emit finished(delivery.id, false, false);
+	}
+}
+
+
+void AlertSender::sendSmtpEmail(const AlertDelivery& delivery, const AlertSmtpConfig& smtpConfig)
+{
+	// Settings changed, the old session finishes what it has queued and closes
+	if (m_smtpSession && m_smtpSession->config() != smtpConfig)
+	{
+		m_smtpSession->closeWhenIdle();
+		m_smtpSession.clear();
+	}
+	if (!m_smtpSession)
+	{
+		m_smtpSession = new SmtpSession(smtpConfig, this);
+		connect(m_smtpSession.data(), &SmtpSession::finished,
+			this, [this](quint64 id, bool success, const QString& error)
+		{
+			if (!success)
+				Logger(LOG_ERROR) << tr("SMTP alert email failure: ") << error;
+			emit finished(id, success, true);
+		});
+	}
+
+	// Several addresses can be given separated by commas
+	QStringList recipients = delivery.argument.split(QRegExp("[,;\\s]+"), QString::SkipEmptyParts);
+	Logger() << tr("Sending alert smtp email to '%1'").arg(recipients.join(", "));
+	QString subject = tr("Pinhole alert from %1").arg(QHostInfo::localHostName());
+	m_smtpSession->sendMail(delivery.id, recipients, subject, delivery.text);
+}
+
+
+void AlertSender::sendHttpGet(const AlertDelivery& delivery)
+{
+	// Encode the alert text into the URL
+	QUrl url(delivery.argument.toLocal8Bit().replace(ALERT_REPLACE_TEXT, QUrl::toPercentEncoding(delivery.text)));
+	if (!url.isValid())
+	{
+		Logger(LOG_ERROR) << tr("Invalid HTTP GET URL: '%1'").arg(delivery.argument);
+		emit finished(delivery.id, false, false);
+		return;
+	}
+
+	QNetworkRequest request(url);
+	replyFinished(m_networkAccessManager->get(request), delivery, tr("HTTP GET"));
+}
+
+
+void AlertSender::sendHttpPost(const AlertDelivery& delivery)
+{
+	QUrl url(delivery.argument);
+	if (!url.isValid())
+	{
+		Logger(LOG_ERROR) << tr("Invalid HTTP POST URL: '%1'").arg(delivery.argument);
+		emit finished(delivery.id, false, false);
+		return;
+	}
+
+	QNetworkRequest request(url);
+	request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+	replyFinished(m_networkAccessManager->post(request, delivery.text.toLocal8Bit()), delivery, tr("HTTP POST"));
+}
+
+
+void AlertSender::sendSlack(const AlertDelivery& delivery)
+{
+	QUrl url(delivery.argument);
+	if (!url.isValid())
+	{
+		Logger(LOG_ERROR) << tr("Invalid Slack Webhook URL: '%1'").arg(delivery.argument);
+		emit finished(delivery.id, false, false);
+		return;
+	}
+
+	QNetworkRequest request(url);
+	request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+	QJsonObject jsonObject;
+	jsonObject["text"] = delivery.text;
+	QJsonDocument jsonDoc;
+	jsonDoc.setObject(jsonObject);
+	replyFinished(m_networkAccessManager->post(request, jsonDoc.toJson()), delivery, tr("Slack"));
+}
+
+
+void AlertSender::executeExternal(const AlertDelivery& delivery)
+{
+	// Replace the alert text in the command line
+	QString commandLine(delivery.argument);
+	QString escapedText(delivery.text);
+	escapedText.replace("\"", "\"\"\"");	// Replace quotes with tripple quotes
+	commandLine.replace(QString(ALERT_REPLACE_TEXT), escapedText);
+
+	if (!QProcess::startDetached(commandLine))
+	{
+		Logger(LOG_ERROR) << tr("Error executing exeternal command '%1'").arg(delivery.argument);
+		emit finished(delivery.id, false, true);
+	}
+	else
+	{
+		Logger() << tr("Executed external alert command '%1'").arg(delivery.argument);
+		emit finished(delivery.id, true, true);
+	}
+}
+
+
+void AlertSender::replyFinished(QNetworkReply* reply, const AlertDelivery& delivery, const QString& description)
+{
+	quint64 id = delivery.id;
+	QString arg = delivery.argument;
+	connect(reply, &QNetworkReply::finished,
+		this, [this, reply, id, arg, description]()
+	{
+		bool success = QNetworkReply::NoError == reply->error();
+		if (!success)
+		{
+			Logger(LOG_ERROR) << tr("Error '%1' sending %2 alert to '%3'")
+				.arg(reply->errorString())
+				.arg(description)
+				.arg(arg);
+		}
+		else
+		{
+			Logger() << tr("%1 alert sent to '%2'")
+				.arg(description)
+				.arg(arg);
+		}
+		emit finished(id, success, true);
+
+		reply->deleteLater();
+	});
+}
+
+
+
+AlertDispatcher::AlertDispatcher(const QString& queueFilename, const std::function<AlertSmtpConfig()>& smtpConfig, QObject *parent)
+	: QObject(parent), m_queueFilename(queueFilename), m_smtpConfig(smtpConfig)
+{
+	qRegisterMetaType<AlertDelivery>();
+	qRegisterMetaType<AlertSmtpConfig>();
+
+	// Sending runs on a secondary thread so slow servers never hold up the main thread
+	m_thread = new QThread(this);
+	AlertSender* sender = new AlertSender(nullptr);	// Must be nullptr
+	sender->moveToThread(m_thread);
+	connect(this, &AlertDispatcher::send,
+		sender, &AlertSender::send);
+	connect(sender, &AlertSender::finished,
+		this, &AlertDispatcher::sendFinished);
+	connect(m_thread, &QThread::finished,
+		sender, &AlertSender::deleteLater);
+	m_thread->start();
+
+	m_checkTimer.setInterval(INTERVAL_ALERTDISPATCHCHECK);
+	connect(&m_checkTimer, &QTimer::timeout,
+		this, &AlertDispatcher::check);
+	m_checkTimer.start();
+
+	readRetryQueue();
+}
+
+
+AlertDispatcher::~AlertDispatcher()
+{
+	m_thread->quit();
+	m_thread->wait();
+}
+
+
+// Sends an alert to each target slot, the targets have no id or text yet
+void AlertDispatcher::dispatch(const QString& text, const QList<AlertDelivery>& targets)
+{
+	auto duplicate = m_duplicates.find(text);
+	if (duplicate != m_duplicates.end())
+	{
+		duplicate->repeats++;
+		return;
+	}
+
+	Duplicate& entry = m_duplicates[text];
+	entry.first = MonotonicTime::now();
+	entry.targets = targets;
+
+	for (const auto& target : targets)
+	{
+		queue(target, text);
+	}
+}
+
+
+void AlertDispatcher::queue(const AlertDelivery& target, const QString& text)
+{
+	SlotLimit& limit = m_slotLimits[target.slotName];
+	limit.target = target;
+
+	if (limit.digest.size() < MAX_ALERTDIGEST)
+		limit.digest.append(qMakePair(QDateTime::currentDateTime(), text));
+	else
+		limit.dropped++;
+
+	if (1 == limit.digest.size() && !underRateLimit(limit))
+	{
+		Logger(LOG_WARNING) << tr("Alert %1: More than %2 alerts in %3 minutes, sending the rest as a digest")
+			.arg(target.slotName)
+			.arg(ALERT_RATELIMIT_COUNT)
+			.arg(INTERVAL_ALERTRATEPERIOD / 60000);
+	}
+
+	flushDigest(limit);
+}
+
+
+// Sends the alerts waiting for a slot as one message if the rate limit allows
+void AlertDispatcher::flushDigest(SlotLimit& limit)
+{
+	if (limit.digest.isEmpty() || !underRateLimit(limit))
+		return;
+
+	QString text;
+	if (1 == limit.digest.size() && 0 == limit.dropped)
+	{
+		text = limit.digest.first().second;
+	}
+	else
+	{
+		text = tr("%1 alerts:").arg(limit.digest.size() + limit.dropped);
+		for (const auto& alert : limit.digest)
+		{
+			text += "\n" + alert.first.toString("yyyy-MM-dd HH:mm:ss ") + alert.second;
+		}
+		if (limit.dropped > 0)
+			text += "\n" + tr("(%1 more not shown)").arg(limit.dropped);
+	}
+	limit.digest.clear();
+	limit.dropped = 0;
+	limit.sent.append(MonotonicTime::now());
+
+	AlertDelivery delivery = limit.target;
+	delivery.text = QString("[%1] %2").arg(QHostInfo::localHostName()).arg(text);
+	startDelivery(delivery);
+}
+
+
+bool AlertDispatcher::underRateLimit(SlotLimit& limit) const
+{
+	while (!limit.sent.isEmpty() && limit.sent.first().elapsed() >= INTERVAL_ALERTRATEPERIOD)
+	{
+		limit.sent.removeFirst();
+	}
+	return limit.sent.size() < ALERT_RATELIMIT_COUNT;
+}
+
+
+void AlertDispatcher::startDelivery(AlertDelivery delivery)
+{
+	delivery.id = m_nextId++;
+	if (0 == delivery.firstId)
+		delivery.firstId = delivery.id;
+	delivery.attempts++;
+
+	Sending& sending = m_sending[delivery.id];
+	sending.delivery = delivery;
+	sending.started = MonotonicTime::now();
+
+	typeMetrics(delivery.type).sends->increment();
+	emit send(delivery, m_smtpConfig());
+}
+
+
+void AlertDispatcher::sendFinished(quint64 id, bool success, bool retry)
+{
+	auto sending = m_sending.find(id);
+	if (sending == m_sending.end())
+	{
+		// Already given up waiting for it, but a late success makes its retry unneeded
+		quint64 firstId = m_abandoned.take(id);
+		if (0 != firstId && success)
+			dropRetries(firstId);
+		return;
+	}
+
+	AlertDelivery delivery = sending->delivery;
+	m_sending.erase(sending);
+
+	if (success)
+	{
+		dropRetries(delivery.firstId);
+		if (delivery.attempts > 1)
+			writeRetryQueue();
+		return;
+	}
+
+	typeMetrics(delivery.type).failures->increment();
+	if (retry)
+	{
+		retryLater(delivery);
+	}
+	else if (delivery.attempts > 1)
+	{
+		writeRetryQueue();
+	}
+}
+
+
+void AlertDispatcher::retryLater(AlertDelivery delivery)
+{
+	if (delivery.attempts >= ALERT_MAXATTEMPTS)
+	{
+		Logger(LOG_ERROR) << tr("Alert %1: Giving up sending alert after %2 attempts")
+			.arg(delivery.slotName)
+			.arg(delivery.attempts);
+		writeRetryQueue();
+		return;
+	}
+
+	// Back off exponentially
+	qint64 delay = qMin(static_cast<qint64>(INTERVAL_ALERTRETRY) << qMin(delivery.attempts - 1, 16),
+		static_cast<qint64>(INTERVAL_ALERTMAXRETRY));
+	delivery.nextAttempt = MonotonicTime::fromMSecs(MonotonicTime::now().toMSecs() + delay);
+	m_retryQueue.append(delivery);
+
+	Logger(LOG_WARNING) << tr("Alert %1: Retrying in %2 seconds")
+		.arg(delivery.slotName)
+		.arg(delay / 1000);
+	writeRetryQueue();
+}
+
+
+// Forgets the retries of a delivery once one of its attempts got through. A retry
+// already handed to the worker can't be called back, its result is ignored.
+void AlertDispatcher::dropRetries(quint64 firstId)
+{
+	bool dropped = false;
+	for (int n = 0; n < m_retryQueue.size(); )
+	{
+		if (firstId == m_retryQueue[n].firstId)
+		{
+			Logger(LOG_WARNING) << tr("Alert %1: Sent after giving up waiting for it, not retrying")
+				.arg(m_retryQueue[n].slotName);
+			m_retryQueue.removeAt(n);
+			dropped = true;
+		}
+		else
+		{
+			n++;
+		}
+	}
+	for (auto it = m_sending.begin(); it != m_sending.end(); )
+	{
+		if (firstId == it->delivery.firstId)
+			it = m_sending.erase(it);
+		else
+			it++;
+	}
+	for (auto it = m_abandoned.begin(); it != m_abandoned.end(); )
+	{
+		if (firstId == it.value())
+			it = m_abandoned.erase(it);
+		else
+			it++;
+	}
+
+	if (dropped)
+		writeRetryQueue();
+}
+
+
+void AlertDispatcher::check()
+{
+	// Summarize repeats once the deduplication window ends
+	for (auto it = m_duplicates.begin(); it != m_duplicates.end(); )
+	{
+		if (it->first.elapsed() < INTERVAL_ALERTDEDUP)
+		{
+			it++;
+			continue;
+		}
+
+		if (it->repeats > 0)
+		{
+			QString text = tr("%1 (repeated %2 more times in %3 minutes)")
+				.arg(it.key())
+				.arg(it->repeats)
+				.arg(INTERVAL_ALERTDEDUP / 60000);
+			for (const auto& target : it->targets)
+			{
+				queue(target, text);
+			}
+		}
+		it = m_duplicates.erase(it);
+	}
+
+	for (auto it = m_slotLimits.begin(); it != m_slotLimits.end(); )
+	{
+		flushDigest(*it);
+		if (it->digest.isEmpty() && underRateLimit(*it) && it->sent.isEmpty())
+			it = m_slotLimits.erase(it);
+		else
+			it++;
+	}
+
+	// Deliveries the worker never answered for are treated as failed
+	QList<AlertDelivery> timedOut;
+	for (auto it = m_sending.begin(); it != m_sending.end(); )
+	{
+		if (it->started.elapsed() > INTERVAL_ALERTSENDTIMEOUT)
+		{
+			Logger(LOG_ERROR) << tr("Alert %1: No response sending alert after %2 seconds")
+				.arg(it->delivery.slotName)
+				.arg(INTERVAL_ALERTSENDTIMEOUT / 1000);
+			typeMetrics(it->delivery.type).failures->increment();
+			m_abandoned.insert(it.key(), it->delivery.firstId);
+			timedOut.append(it->delivery);
+			it = m_sending.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+	for (const auto& delivery : timedOut)
+	{
+		retryLater(delivery);
+	}
+
+	MonotonicTime now = MonotonicTime::now();
+	for (int n = 0; n < m_retryQueue.size(); )
+	{
+		if (now < m_retryQueue[n].nextAttempt)
+		{
+			n++;
+			continue;
+		}
+
+		startDelivery(m_retryQueue.takeAt(n));
+	}
+}
+
+
+// Failed deliveries left from the last run are retried straight away
+void AlertDispatcher::readRetryQueue()
+{
+	QFile file(m_queueFilename);
+	if (!file.exists())
+		return;
+
+	if (!file.open(QFile::ReadOnly))
+	{
+		Logger(LOG_ERROR) << tr("Error '%1' opening alert retry queue for read: '%2'")
+			.arg(file.errorString())
+			.arg(m_queueFilename);
+		return;
+	}
+
+	QJsonArray deliveries = QJsonDocument::fromJson(file.readAll()).array();
+	for (const auto& value : deliveries)
+	{
+		QJsonObject jdelivery = value.toObject();
+		AlertDelivery delivery;
+		delivery.slotName = jdelivery[PROP_ALERT_SLOTNAME].toString();
+		delivery.type = jdelivery[PROP_ALERT_SLOTTYPE].toString();
+		delivery.argument = jdelivery[PROP_ALERT_SLOTARG].toString();
+		delivery.text = jdelivery["text"].toString();
+		delivery.attempts = jdelivery["attempts"].toInt();
+		delivery.nextAttempt = MonotonicTime::now();
+		m_retryQueue.append(delivery);
+	}
+
+	if (!m_retryQueue.isEmpty())
+	{
+		Logger() << tr("Retrying %1 alerts that failed to send before the restart").arg(m_retryQueue.size());
+	}
+}
+
+
+// Writes the deliveries that have failed at least once and haven't succeeded or been given up on yet
+void AlertDispatcher::writeRetryQueue() const
+{
+	QList<AlertDelivery> deliveries = m_retryQueue;
+	for (const auto& sending : m_sending)
+	{
+		if (sending.delivery.attempts > 1)
+			deliveries.append(sending.delivery);
+	}
+
+	if (deliveries.isEmpty())
+	{
+		QFile::remove(m_queueFilename);
+		return;
+	}
+
+	QJsonArray jdeliveries;
+	for (const auto& delivery : deliveries)
+	{
+		QJsonObject jdelivery;
+		jdelivery[PROP_ALERT_SLOTNAME] = delivery.slotName;
+		jdelivery[PROP_ALERT_SLOTTYPE] = delivery.type;
+		jdelivery[PROP_ALERT_SLOTARG] = delivery.argument;
+		jdelivery["text"] = delivery.text;
+		jdelivery["attempts"] = delivery.attempts;
+		jdeliveries.append(jdelivery);
+	}
+
+	QSaveFile file(m_queueFilename);
+	if (!file.open(QFile::WriteOnly) ||
+		file.write(QJsonDocument(jdeliveries).toJson(QJsonDocument::Compact)) < 0 ||
+		!file.commit())
+	{
+		Logger(LOG_ERROR) << tr("Error '%1' writing alert retry queue: '%2'")
+			.arg(file.errorString())
+			.arg(m_queueFilename);
+	}
+}
+
+
+const AlertDispatcher::TypeMetrics& AlertDispatcher::typeMetrics(const QString& type)
+{
+	TypeMetrics& metrics = m_typeMetrics[type];
+	if (nullptr == metrics.sends)
+	{
+		QString labels = Metrics::label("type", type);
+		metrics.sends = Metrics::counter(METRIC_ALERT_SENDS, labels);
+		metrics.failures = Metrics::counter(METRIC_ALERT_FAILURES, labels);
+	}
+	return metrics;
+}
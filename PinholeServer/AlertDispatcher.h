@@ -0,0 +1,164 @@
+#pragma once
+
+/* AlertDispatcher.h - Delivers alerts to the alert slots on a worker thread, with deduplication, rate limits and retries */
+
+#include "MonotonicTime.h"
+
+#include <QObject>
+#include <QDateTime>
+#include <QPointer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QTimer>
+
+#include <functional>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QThread;
+class MetricCounter;
+class SmtpSession;
+
+// One alert message on its way to one alert slot
+struct AlertDelivery
+{
+	quint64 id = 0;
+	quint64 firstId = 0;			// id of the first attempt, kept by the retries
+	QString slotName;
+	QString type;
+	QString argument;
+	QString text;
+	int attempts = 0;
+	MonotonicTime nextAttempt;		// When a failed delivery is retried
+};
+Q_DECLARE_METATYPE(AlertDelivery)
+
+// Copy of the SMTP settings for the worker thread
+struct AlertSmtpConfig
+{
+	QString server;
+	int port = 0;
+	bool ssl = false;
+	bool tls = false;
+	QString user;
+	QString pass;
+	QString email;
+	int idle = 0;					// Seconds to keep the connection open after the last message
+
+	bool operator==(const AlertSmtpConfig& other) const
+	{
+		return server == other.server && port == other.port && ssl == other.ssl && tls == other.tls &&
+			user == other.user && pass == other.pass && email == other.email && idle == other.idle;
+	}
+	bool operator!=(const AlertSmtpConfig& other) const { return !(*this == other); }
+};
+Q_DECLARE_METATYPE(AlertSmtpConfig)
+
+
+// Does the network and process work of sending alerts, lives on the dispatcher's worker thread
+class AlertSender : public QObject
+{
+	Q_OBJECT
+
+public:
+	AlertSender(QObject *parent = nullptr);
+	~AlertSender();
+
+public slots:
+	void send(const AlertDelivery& delivery, const AlertSmtpConfig& smtpConfig);
+
+signals:
+	// retry is false when trying again can't help, like an invalid URL
+	void finished(quint64 id, bool success, bool retry);
+
+private:
+	void sendSmtpEmail(const AlertDelivery& delivery, const AlertSmtpConfig& smtpConfig);
+	void sendHttpGet(const AlertDelivery& delivery);
+	void sendHttpPost(const AlertDelivery& delivery);
+	void sendSlack(const AlertDelivery& delivery);
+	void executeExternal(const AlertDelivery& delivery);
+	void replyFinished(QNetworkReply* reply, const AlertDelivery& delivery, const QString& description);
+
+	QNetworkAccessManager* m_networkAccessManager = nullptr;
+	QPointer<SmtpSession> m_smtpSession;
+};
+
+
+// Sends each alert to the alert slots. Identical alerts within INTERVAL_ALERTDEDUP
+// are sent once and the repeats summarized at the end of the window. Each slot
+// sends at most ALERT_RATELIMIT_COUNT messages per INTERVAL_ALERTRATEPERIOD, alerts
+// over the limit are batched into a digest. Failed deliveries are retried with
+// backoff and kept in a file so they survive a restart.
+class AlertDispatcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	AlertDispatcher(const QString& queueFilename, const std::function<AlertSmtpConfig()>& smtpConfig, QObject *parent = nullptr);
+	~AlertDispatcher();
+
+	void dispatch(const QString& text, const QList<AlertDelivery>& targets);
+
+signals:
+	void send(const AlertDelivery& delivery, const AlertSmtpConfig& smtpConfig);
+
+private slots:
+	void sendFinished(quint64 id, bool success, bool retry);
+	void check();
+
+private:
+	// Alert text seen in the current deduplication window
+	struct Duplicate
+	{
+		MonotonicTime first;
+		int repeats = 0;
+		QList<AlertDelivery> targets;
+	};
+
+	// Rate limit and held back alerts for one alert slot
+	struct SlotLimit
+	{
+		AlertDelivery target;
+		QList<MonotonicTime> sent;					// Messages sent in the rate limit period
+		QList<QPair<QDateTime, QString>> digest;	// Alerts waiting to be sent
+		int dropped = 0;							// Alerts not kept because the digest was full
+	};
+
+	// A delivery handed to the worker thread
+	struct Sending
+	{
+		AlertDelivery delivery;
+		MonotonicTime started;
+	};
+
+	// Metrics of one alert slot type
+	struct TypeMetrics
+	{
+		MetricCounter* sends = nullptr;
+		MetricCounter* failures = nullptr;
+	};
+
+	void queue(const AlertDelivery& target, const QString& text);
+	void flushDigest(SlotLimit& limit);
+	bool underRateLimit(SlotLimit& limit) const;
+	void startDelivery(AlertDelivery delivery);
+	void retryLater(AlertDelivery delivery);
+	void dropRetries(quint64 firstId);
+	void readRetryQueue();
+	void writeRetryQueue() const;
+	const TypeMetrics& typeMetrics(const QString& type);
+
+	QString m_queueFilename;
+	std::function<AlertSmtpConfig()> m_smtpConfig;
+	QHash<QString, Duplicate> m_duplicates;
+	QMap<QString, SlotLimit> m_slotLimits;
+	QMap<quint64, Sending> m_sending;
+	QHash<quint64, quint64> m_abandoned;		// Attempts given up waiting for, to the first attempt's id
+	QList<AlertDelivery> m_retryQueue;
+	QHash<QString, TypeMetrics> m_typeMetrics;	// Looked up the first time a type is sent
+	quint64 m_nextId = 1;
+	QThread* m_thread = nullptr;
+	QTimer m_checkTimer;
+};
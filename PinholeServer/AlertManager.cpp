@@ -1,27 +1,35 @@
 #include "AlertManager.h"
 #include "Settings.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include "Values.h"
 #include "../common/Utilities.h"
-#include "smtp.h"
 
 #include <QSettings>
-#include <QUrl>
-#include <QNetworkAccessManager>
-#include <QNetworkRequest>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QFile>
-#include <QHostInfo>
-#include <QNetworkReply>
-#include <QJsonDocument>
-#include <QProcess>
 
 
 AlertManager::AlertManager(Settings* settings, QObject *parent)
 	: QObject(parent), m_settings(settings)
 {
-	m_networkAccessManager = new QNetworkAccessManager(this);
+	m_alertStore = new AlertStore(m_settings->dataDir() + SUBDIR_ALERTS, this);
+	m_alertStore->importLegacyLog(m_settings->dataDir() + FILENAME_ALERTLOG);
+
+	m_alertDispatcher = new AlertDispatcher(m_settings->dataDir() + FILENAME_ALERTQUEUE,
+		[this]()
+	{
+		AlertSmtpConfig smtpConfig;
+		smtpConfig.server = m_smtpServer;
+		smtpConfig.port = m_smtpPort;
+		smtpConfig.ssl = m_smtpSSL;
+		smtpConfig.tls = m_smtpTLS;
+		smtpConfig.user = m_smtpUser;
+		smtpConfig.pass = m_smtpPass;
+		smtpConfig.email = m_smtpEmail;
+		smtpConfig.idle = m_smtpIdle;
+		return smtpConfig;
+	}, this);
 
 	readAlertSettings();
 }
@@ -34,33 +42,32 @@ AlertManager::~AlertManager()
 
 bool AlertManager::readAlertSettings()
 {
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
-	setSmtpServer(settings->value(PROP_ALERT_SMTPSERVER).toString());
-	setSmtpPort(settings->value(PROP_ALERT_SMTPPORT, DEFAULT_SMTPPORT).toInt());
-	setSmtpSSL(settings->value(PROP_ALERT_SMTPSSL, false).toBool());
-	setSmtpTLS(settings->value(PROP_ALERT_SMTPTLS, false).toBool());
-	setSmtpUser(settings->value(PROP_ALERT_SMTPUSER, DEFAULT_SMTPUSER).toString());
-	setSmtpPass(settings->value(PROP_ALERT_SMTPPASS).toString());
-	setSmtpEmail(settings->value(PROP_ALERT_SMTPEMAIL).toString());
-	setSmtpName(settings->value(PROP_ALERT_SMTPNAME).toString());
-
-	QStringList alertSlotList = settings->value(SETTINGS_ALERTSLOTLIST).toStringList();
+	setSmtpServer(m_settings->value(PROP_ALERT_SMTPSERVER).toString());
+	setSmtpPort(m_settings->value(PROP_ALERT_SMTPPORT, DEFAULT_SMTPPORT).toInt());
+	setSmtpSSL(m_settings->value(PROP_ALERT_SMTPSSL, false).toBool());
+	setSmtpTLS(m_settings->value(PROP_ALERT_SMTPTLS, false).toBool());
+	setSmtpUser(m_settings->value(PROP_ALERT_SMTPUSER, DEFAULT_SMTPUSER).toString());
+	setSmtpPass(m_settings->value(PROP_ALERT_SMTPPASS).toString());
+	setSmtpEmail(m_settings->value(PROP_ALERT_SMTPEMAIL).toString());
+	setSmtpName(m_settings->value(PROP_ALERT_SMTPNAME).toString());
+	setSmtpIdle(m_settings->value(PROP_ALERT_SMTPIDLE, DEFAULT_SMTPIDLE).toInt());
+
+	QStringList alertSlotList = m_settings->value(SETTINGS_ALERTSLOTLIST).toStringList();
 	for (const auto& alertSlotName : alertSlotList)
 	{
-		settings->beginGroup(SETTINGS_ALERTSLOTPREFIX + alertSlotName);
+		m_settings->beginGroup(SETTINGS_ALERTSLOTPREFIX + alertSlotName);
 
 		QSharedPointer<AlertSlot> newAlertSlot = QSharedPointer<AlertSlot>::create(alertSlotName);
-		newAlertSlot->setEnabled(settings->value(PROP_ALERT_SLOTENABLED).toBool());
-		newAlertSlot->setType(settings->value(PROP_ALERT_SLOTTYPE, ALERTSLOT_TYPE_SMPTEMAIL).toString());
-		newAlertSlot->setArguments(settings->value(PROP_ALERT_SLOTARG).toString());
+		newAlertSlot->setEnabled(m_settings->value(PROP_ALERT_SLOTENABLED).toBool());
+		newAlertSlot->setType(m_settings->value(PROP_ALERT_SLOTTYPE, ALERTSLOT_TYPE_SMPTEMAIL).toString());
+		newAlertSlot->setArguments(m_settings->value(PROP_ALERT_SLOTARG).toString());
 
 		connect(newAlertSlot.data(), &AlertSlot::valueChanged,
 			this, &AlertManager::alertSlotValueChanged);
 
 		m_alertSlotList[alertSlotName] = newAlertSlot;
 
-		settings->endGroup();
+		m_settings->endGroup();
 	}
 
 	return true;
@@ -69,36 +76,36 @@ bool AlertManager::readAlertSettings()
 
 bool AlertManager::writeAlertSettings() const
 {
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
-	settings->setValue(PROP_ALERT_SMTPSERVER, getSmtpServer());
-	settings->setValue(PROP_ALERT_SMTPPORT, getSmtpPort());
-	settings->setValue(PROP_ALERT_SMTPSSL, getSmtpSSL());
-	settings->setValue(PROP_ALERT_SMTPTLS, getSmtpTLS());
-	settings->setValue(PROP_ALERT_SMTPUSER, getSmtpUser());
-	settings->setValue(PROP_ALERT_SMTPPASS, getSmtpPass());
-	settings->setValue(PROP_ALERT_SMTPEMAIL, getSmtpEmail());
-	settings->setValue(PROP_ALERT_SMTPNAME, getSmtpName());
-
-	// Delete old entries
-	QStringList alertSlotList = settings->value(SETTINGS_ALERTSLOTLIST).toStringList();
+	m_settings->setValue(PROP_ALERT_SMTPSERVER, getSmtpServer());
+	m_settings->setValue(PROP_ALERT_SMTPPORT, getSmtpPort());
+	m_settings->setValue(PROP_ALERT_SMTPSSL, getSmtpSSL());
+	m_settings->setValue(PROP_ALERT_SMTPTLS, getSmtpTLS());
+	m_settings->setValue(PROP_ALERT_SMTPUSER, getSmtpUser());
+	m_settings->setValue(PROP_ALERT_SMTPPASS, getSmtpPass());
+	m_settings->setValue(PROP_ALERT_SMTPEMAIL, getSmtpEmail());
+	m_settings->setValue(PROP_ALERT_SMTPNAME, getSmtpName());
+	m_settings->setValue(PROP_ALERT_SMTPIDLE, getSmtpIdle());
+
+	// Delete entries that no longer exist
+	QStringList alertSlotList = m_settings->value(SETTINGS_ALERTSLOTLIST).toStringList();
 	for (const auto& alertSlotName : alertSlotList)
 	{
-		settings->remove(SETTINGS_ALERTSLOTPREFIX + alertSlotName);
+		if (!m_alertSlotList.contains(alertSlotName))
+			m_settings->remove(SETTINGS_ALERTSLOTPREFIX + alertSlotName);
 	}
 
 	for (const auto& alertSlot : m_alertSlotList)
 	{
 		QString alertSlotName = alertSlot->getName();
-		settings->beginGroup(SETTINGS_ALERTSLOTPREFIX + alertSlotName);
-		settings->setValue(PROP_ALERT_SLOTNAME, alertSlotName);
-		settings->setValue(PROP_ALERT_SLOTENABLED, alertSlot->getEnabled());
-		settings->setValue(PROP_ALERT_SLOTTYPE, alertSlot->getType());
-		settings->setValue(PROP_ALERT_SLOTARG, alertSlot->getArguments());
-		settings->endGroup();
+		m_settings->beginGroup(SETTINGS_ALERTSLOTPREFIX + alertSlotName);
+		m_settings->setValue(PROP_ALERT_SLOTNAME, alertSlotName);
+		m_settings->setValue(PROP_ALERT_SLOTENABLED, alertSlot->getEnabled());
+		m_settings->setValue(PROP_ALERT_SLOTTYPE, alertSlot->getType());
+		m_settings->setValue(PROP_ALERT_SLOTARG, alertSlot->getArguments());
+		m_settings->endGroup();
 	}
 
-	settings->setValue(SETTINGS_ALERTSLOTLIST, QStringList(m_alertSlotList.keys()));
+	m_settings->setValue(SETTINGS_ALERTSLOTLIST, QStringList(m_alertSlotList.keys()));
 
 	return true;
 }
@@ -114,6 +121,7 @@ bool AlertManager::importSettings(const QJsonObject& root)
 	setSmtpPass(ReadJsonValueWithDefault(root, PROP_ALERT_SMTPPASS, getSmtpPass()).toString());
 	setSmtpEmail(ReadJsonValueWithDefault(root, PROP_ALERT_SMTPEMAIL, getSmtpEmail()).toString());
 	setSmtpName(ReadJsonValueWithDefault(root, PROP_ALERT_SMTPNAME, getSmtpName()).toString());
+	setSmtpIdle(ReadJsonValueWithDefault(root, PROP_ALERT_SMTPIDLE, getSmtpIdle()).toInt());
 
 	if (!root.contains(JSONTAG_ALERTSLOTS))
 	{
@@ -202,6 +210,7 @@ QJsonObject AlertManager::exportSettings() const
 	root[PROP_ALERT_SMTPPASS] = getSmtpPass();
 	root[PROP_ALERT_SMTPEMAIL] = getSmtpEmail();
 	root[PROP_ALERT_SMTPNAME] = getSmtpName();
+	root[PROP_ALERT_SMTPIDLE] = getSmtpIdle();
 
 	QJsonArray jslotList;
 
@@ -414,6 +423,29 @@ bool AlertManager::setSmtpName(const QString& str)
 }
 
 
+int AlertManager::getSmtpIdle() const
+{
+	return m_smtpIdle;
+}
+
+
+bool AlertManager::setSmtpIdle(int val)
+{
+	if (m_smtpIdle != val)
+	{
+		if (val < 0 || val > MAX_SMTPIDLE)
+		{
+			Logger(LOG_EXTRA) << tr("Invalid alert SMTP idle time value '%1'").arg(val);
+			emit valueChanged(GROUP_ALERT, "", PROP_ALERT_SMTPIDLE, QVariant(m_smtpIdle));
+			return false;
+		}
+		m_smtpIdle = val;
+		emit valueChanged(GROUP_ALERT, "", PROP_ALERT_SMTPIDLE, QVariant(m_smtpIdle));
+	}
+	return true;
+}
+
+
 QVariant AlertManager::getAlertVariant(const QString& itemName, const QString& propName) const
 {
 	if (itemName.isEmpty())
@@ -458,6 +490,10 @@ QVariant AlertManager::getAlertVariant(const QString& itemName, const QString& p
 		{
 			return getSmtpName();
 		}
+		else if (PROP_ALERT_SMTPIDLE == propName)
+		{
+			return getSmtpIdle();
+		}
 	}
 	else
 	{
@@ -521,6 +557,10 @@ bool AlertManager::setAlertVariant(const QString& itemName, const QString& propN
 		{
 			return setSmtpName(value.toString());
 		}
+		else if (PROP_ALERT_SMTPIDLE == propName)
+		{
+			return setSmtpIdle(value.toInt());
+		}
 		else
 		{
 			Logger(LOG_WARNING) << tr("Missing property for alert slot value set: '%1'")
@@ -577,97 +617,42 @@ void AlertManager::generateAlert(const QString& text)
 	m_settings->resetIdle();
 
 	m_activeAlerts++;
-	m_alertList.append(QSharedPointer<Alert>::create(text, QDateTime::currentDateTime()));
+	Metrics::counter(METRIC_ALERTS)->increment();
+	m_alertStore->append(text, QDateTime::currentDateTime());
 	emit valueChanged(GROUP_ALERT, "", PROP_ALERT_ALERTCOUNT, QVariant(m_activeAlerts));
 
-	// Write alert to a log file
-	QString logFilename = m_settings->dataDir() + FILENAME_ALERTLOG;
-	QFile alertLog(logFilename);
-	if (!alertLog.open(QFile::WriteOnly | QFile::Append))
-	{
-		Logger(LOG_ERROR) << tr("Error '%1' opening alert log file for write: '%2'")
-			.arg(alertLog.errorString())
-			.arg(logFilename);
-	}
-	else
-	{
-		QString header = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss ddd: ");
-		alertLog.write(header.toLocal8Bit());
-		alertLog.write(text.toLocal8Bit());
-		alertLog.write(QByteArray("\r\n"));
-		alertLog.close();
-	}
-
-	QString fullText = QString("[%1] %2").arg(QHostInfo::localHostName()).arg(text);
-
+	// Delivery, deduplication and rate limiting happen in the dispatcher
+	QList<AlertDelivery> targets;
 	for (const auto& alertSlot : m_alertSlotList)
 	{
 		if (alertSlot->getEnabled())
 		{
 			QString type = alertSlot->getType();
+			QString arg = alertSlot->getArguments();
 
-			if (ALERTSLOT_TYPE_SMPTEMAIL == type)
+			if (arg.isEmpty())
 			{
-				QString destEmail = alertSlot->getArguments();
-				if (destEmail.isEmpty())
-				{
+				if (ALERTSLOT_TYPE_SMPTEMAIL == type)
 					Logger(LOG_ERROR) << tr("Alert %1: Empty destination email argument").arg(alertSlot->getName());
-				}
-				else
-				{
-					sendSmtpEmailAlert(fullText, destEmail);
-				}
-			}
-			else if (ALERTSLOT_TYPE_HTTPGET == type)
-			{
-				QString url = alertSlot->getArguments();
-				if (url.isEmpty())
-				{
-					Logger(LOG_ERROR) << tr("Alert %1: Empty URL argument").arg(alertSlot->getName());
-				}
-				else
-				{
-					sendHttpGetAlert(fullText, url);
-				}
-			}
-			else if (ALERTSLOT_TYPE_HTTPPOST == type)
-			{
-				QString url = alertSlot->getArguments();
-				if (url.isEmpty())
-				{
-					Logger(LOG_ERROR) << tr("Alert %1: Empty URL argument").arg(alertSlot->getName());
-				}
-				else
-				{
-					sendHttpPostAlert(fullText, url);
-				}
-			}
-			else if (ALERTSLOT_TYPE_SLACK == type)
-			{
-				QString url = alertSlot->getArguments();
-				if (url.isEmpty())
-				{
+				else if (ALERTSLOT_TYPE_SLACK == type)
 					Logger(LOG_ERROR) << tr("Alert %1: Empty Webhook URL").arg(alertSlot->getName());
-				}
+				else if (ALERTSLOT_TYPE_EXTERNAL == type)
+					Logger(LOG_ERROR) << tr("Alert %1: Empty command line").arg(alertSlot->getName());
 				else
-				{
-					sendSlackAlert(fullText, url);
-				}
+					Logger(LOG_ERROR) << tr("Alert %1: Empty URL argument").arg(alertSlot->getName());
 			}
-			else if (ALERTSLOT_TYPE_EXTERNAL == type)
+			else
 			{
-				QString commandLine = alertSlot->getArguments();
-				if (commandLine.isEmpty())
-				{
-					Logger(LOG_ERROR) << tr("Alert %1: Empty command line").arg(alertSlot->getName());
-				}
-				else
-				{
-					executeExternalAlert(fullText, commandLine);
-				}
+				AlertDelivery target;
+				target.slotName = alertSlot->getName();
+				target.type = type;
+				target.argument = arg;
+				targets.append(target);
 			}
 		}
 	}
+
+	m_alertDispatcher->dispatch(text, targets);
 }
 
 
@@ -687,168 +672,35 @@ void AlertManager::alertSlotValueChanged(const QString& property, const QVariant
 }
 
 
-void AlertManager::sendSmtpEmailAlert(const QString& text, const QString& arg) const
-{
-	Logger() << tr("Sending alert smtp email to '%1'").arg(arg);
-	Smtp* smtp = new Smtp(m_smtpUser, m_smtpPass, m_smtpServer, m_smtpSSL, m_smtpTLS, m_smtpPort);
-	connect(smtp, &Smtp::status,
-		this, [smtp, arg](QString status)
-	{
-		if (status.isEmpty())
-		{
-			Logger() << tr("SMTP alert email sent to %1").arg(arg);
-		}
-		else
-		{
-			Logger(LOG_ERROR) << tr("SMTP alert email failure: ") << status;
-		}
-
-		// object SHOULD delete itself but just in case
-		smtp->deleteLater();
-	});
-
-	QString subject = tr("Pinhole alert from %1").arg(QHostInfo::localHostName());
-	smtp->sendMail(m_smtpEmail, arg, subject, text);
-}
-
-
-void AlertManager::sendHttpGetAlert(const QString& text, const QString& arg) const
-{
-	// Encode the alert text into the URL
-	QUrl url(arg.toLocal8Bit().replace(ALERT_REPLACE_TEXT, QUrl::toPercentEncoding(text)));
-	if (!url.isValid())
-	{
-		Logger(LOG_ERROR) << tr("Invalid HTTP GET URL: '%1'").arg(arg);
-		return;
-	}
-
-	QNetworkRequest request(url);
-	QNetworkReply* reply = m_networkAccessManager->get(request);
-
-	connect(reply, &QNetworkReply::finished,
-		this, [reply, arg]()
-	{
-		if (QNetworkReply::NoError != reply->error())
-		{
-			Logger(LOG_ERROR) << tr("Error '%1' sending HTTP GET alert to '%2'")
-				.arg(reply->errorString())
-				.arg(arg);
-		}
-		else
-		{
-			Logger() << tr("HTTP GET alert sent to '%1'").arg(arg);
-		}
-
-		reply->deleteLater();
-	});
-
-}
-
-
-void AlertManager::sendHttpPostAlert(const QString& text, const QString& arg) const
+// Returns the newest alerts as text for consoles that don't query alerts
+QByteArray AlertManager::retrieveAlertList() const
 {
-	QUrl url(arg);
-	if (!url.isValid())
-	{
-		Logger(LOG_ERROR) << tr("Invalid HTTP POST URL: '%1'").arg(arg);
-		return;
-	}
-	
-	QNetworkRequest request(url);
-	request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-	QNetworkReply* reply = m_networkAccessManager->post(request, text.toLocal8Bit().data());
-
-	connect(reply, &QNetworkReply::finished, 
-		this, [reply, arg]()
-	{
-		if (QNetworkReply::NoError != reply->error())
-		{
-			Logger(LOG_ERROR) << tr("Error '%1' sending HTTP POST alert to '%2'")
-				.arg(reply->errorString())
-				.arg(arg);
-		}
-		else
-		{
-			Logger() << tr("HTTP POST alert sent to '%1'").arg(arg);
-		}
-
-		reply->deleteLater();
-	});
-}
-
+	QList<Alert> alerts = m_alertStore->alertsBefore(0, MAX_ALERTQUERY);
+	if (alerts.isEmpty())
+		return tr("(No alerts logged)").toUtf8();
 
-void AlertManager::sendSlackAlert(const QString& text, const QString& arg) const
-{
-	QUrl url(arg);
-	if (!url.isValid())
+	QByteArray text;
+	for (const auto& alert : alerts)
 	{
-		Logger(LOG_ERROR) << tr("Invalid Slack Webhook URL: '%1'").arg(arg);
-		return;
+		text += alert.GetTime().toString("yyyy-MM-dd HH:mm:ss ddd: ").toUtf8() + alert.GetText().toUtf8() + "\r\n";
 	}
-
-	QNetworkRequest request(url);
-	request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-	QJsonObject jsonObject;
-	jsonObject["text"] = text;
-	QJsonDocument jsonDoc;
-	jsonDoc.setObject(jsonObject);
-	QNetworkReply* reply = m_networkAccessManager->post(request, jsonDoc.toJson());
-
-	connect(reply, &QNetworkReply::finished,
-		this, [reply, arg]()
-	{
-		if (QNetworkReply::NoError != reply->error())
-		{
-			Logger(LOG_ERROR) << tr("Error '%1' sending Slack alert to '%2'")
-				.arg(reply->errorString())
-				.arg(arg);
-		}
-		else
-		{
-			Logger() << tr("Slack alert sent to '%1'").arg(arg);
-		}
-
-		reply->deleteLater();
-	});
+	return text;
 }
 
 
-void AlertManager::executeExternalAlert(const QString& text, const QString& arg) const
+// Returns alerts after sinceSequence if it's set, otherwise the page before
+// beforeSequence, or the newest alerts if that's zero too
+QVariantList AlertManager::queryAlerts(qint64 sinceSequence, qint64 beforeSequence, int limit) const
 {
-	// Replace the alert text in the command line
-	QString commandLine(arg); 
-	QString escapedText(text);
-	escapedText.replace("\"", "\"\"\"");	// Replace quotes with tripple quotes
-	commandLine.replace(QString(ALERT_REPLACE_TEXT), escapedText);
-
-	if (!QProcess::startDetached(commandLine))
-	{
-		Logger(LOG_ERROR) << tr("Error executing exeternal command '%1'").arg(arg);
-	}
-	else
-	{
-		Logger() << tr("Executed external alert command '%1'").arg(arg);
-	}
-}
-
+	limit = qBound(1, limit, MAX_ALERTQUERY);
+	QList<Alert> alerts = sinceSequence > 0 ? m_alertStore->alertsSince(sinceSequence, limit) :
+		m_alertStore->alertsBefore(beforeSequence, limit);
 
-QByteArray AlertManager::retrieveAlertList() const
-{
-	// Reads the alert log
-	QString logFilename = m_settings->dataDir() + FILENAME_ALERTLOG;
-	QFile alertLog(logFilename);
-	if (!alertLog.exists())
+	QVariantList valerts;
+	for (const auto& alert : alerts)
 	{
-		return tr("(No alerts logged)").toUtf8();
-	}
-	else if (!alertLog.open(QFile::ReadOnly))
-	{
-		Logger(LOG_ERROR) << tr("Error '%1' opening alert log file for read: '%2'")
-			.arg(alertLog.errorString())
-			.arg(logFilename);
-		return tr("(An error occured reading the alert list)").toUtf8();
+		valerts.append(QVariant(QVariantList() << alert.GetSequence() << alert.GetTime().toMSecsSinceEpoch() << alert.GetText()));
 	}
 
-	return alertLog.readAll();
+	return QVariantList() << m_alertStore->firstSequence() << m_alertStore->lastSequence() << QVariant(valerts);
 }
-
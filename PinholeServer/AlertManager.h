@@ -1,6 +1,8 @@
 #pragma once
 
+#include "AlertDispatcher.h"
 #include "AlertSlot.h"
+#include "AlertStore.h"
 #include "../common/PinholeCommon.h"
 
 #include <QObject>
@@ -9,34 +11,8 @@
 
 #include <functional>
 
-class QNetworkAccessManager;
 class Settings;
 
-class Alert
-{
-public:
-	Alert(const QString& text, const QDateTime& time) 
-		: m_text(text), m_time(time)
-	{
-	}
-
-	QString GetText() const
-	{
-		return m_text;
-	}
-
-	QDateTime GetTime() const
-	{
-		return m_time;
-	}
-
-private:
-	QString m_text;
-	QDateTime m_time;
-};
-
-
-
 class AlertManager : public QObject
 {
 	Q_OBJECT
@@ -69,17 +45,15 @@ public:
 	bool setSmtpEmail(const QString& str);
 	QString getSmtpName() const;
 	bool setSmtpName(const QString& str);
+	int getSmtpIdle() const;
+	bool setSmtpIdle(int val);
 
 	QVariant getAlertVariant(const QString& itemName, const QString& propName) const;
 	bool setAlertVariant(const QString& itemName, const QString& propName, const QVariant& value);
 
 	bool resetActiveAlertCount();
-	void sendSmtpEmailAlert(const QString& text, const QString& arg) const;
-	void sendHttpGetAlert(const QString& text, const QString& arg) const;
-	void sendHttpPostAlert(const QString& text, const QString& arg) const;
-	void sendSlackAlert(const QString& text, const QString& arg) const;
-	void executeExternalAlert(const QString& text, const QString& arg) const;
 	QByteArray retrieveAlertList() const;
+	QVariantList queryAlerts(qint64 sinceSequence, qint64 beforeSequence, int limit) const;
 
 signals:
 	void valueChanged(const QString&, const QString&, const QString&, const QVariant&) const;
@@ -110,10 +84,11 @@ private:
 	QString m_smtpPass = "";
 	QString m_smtpEmail = "";
 	QString m_smtpName = "";
+	int m_smtpIdle = DEFAULT_SMTPIDLE;
 
 	int m_activeAlerts = 0;
-	QList<QSharedPointer<Alert>> m_alertList;
+	AlertStore* m_alertStore = nullptr;
 	QMap<QString, QSharedPointer<AlertSlot>> m_alertSlotList;
-	QNetworkAccessManager* m_networkAccessManager = nullptr;
+	AlertDispatcher* m_alertDispatcher = nullptr;
 	Settings* m_settings = nullptr;
 };
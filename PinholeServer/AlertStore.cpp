@@ -0,0 +1,398 @@
+#include "AlertStore.h"
+#include "Logger.h"
+#include "Values.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QPair>
+#include <QtEndian>
+
+// Each index record is the alert time in milliseconds since the epoch then its offset in the data file
+static const int s_indexRecordSize = 16;
+static const char* s_headerFormat = "yyyy-MM-dd HH:mm:ss ddd: ";
+
+
+static bool writeIndexRecord(QFile& index, const QDateTime& time, qint64 offset)
+{
+	uchar record[s_indexRecordSize];
+	qToLittleEndian<qint64>(time.toMSecsSinceEpoch(), record);
+	qToLittleEndian<qint64>(offset, record + 8);
+	return index.write(reinterpret_cast<const char*>(record), s_indexRecordSize) == s_indexRecordSize;
+}
+
+
+// Alerts are stored one per line
+static QString escapeText(const QString& text)
+{
+	QString escaped(text);
+	escaped.replace("\\", "\\\\").replace("\r", "\\r").replace("\n", "\\n");
+	return escaped;
+}
+
+
+static QString unescapeText(const QString& text)
+{
+	QString unescaped;
+	unescaped.reserve(text.size());
+	for (int n = 0; n < text.size(); n++)
+	{
+		if ('\\' == text[n] && n + 1 < text.size())
+		{
+			n++;
+			if ('n' == text[n])
+				unescaped += '\n';
+			else if ('r' == text[n])
+				unescaped += '\r';
+			else
+				unescaped += text[n];
+		}
+		else
+		{
+			unescaped += text[n];
+		}
+	}
+	return unescaped;
+}
+
+
+AlertStore::AlertStore(const QString& directory, QObject *parent)
+	: QObject(parent), m_directory(directory), m_recent(MAX_ALERTRECENT)
+{
+	open();
+}
+
+
+AlertStore::~AlertStore()
+{
+}
+
+
+void AlertStore::open()
+{
+	QDir dir(m_directory);
+	if (!dir.exists() && !QDir().mkpath(m_directory))
+	{
+		Logger(LOG_ERROR) << tr("Failed to create alert store directory '%1'").arg(m_directory);
+		return;
+	}
+
+	QStringList dataFiles = dir.entryList(QStringList() << "*.alerts", QDir::Files, QDir::Name);
+	for (const auto& dataFile : dataFiles)
+	{
+		bool ok = false;
+		Segment segment;
+		segment.first = dataFile.section('.', 0, 0).toLongLong(&ok);
+		if (!ok)
+			continue;
+
+		// The newest segment may have been cut short by a crash, older ones are trusted
+		QFileInfo indexInfo(indexFilename(segment.first));
+		if (dataFile == dataFiles.last() || !indexInfo.exists())
+		{
+			if (!rebuildIndex(segment))
+				continue;
+		}
+		else
+		{
+			segment.count = indexInfo.size() / s_indexRecordSize;
+		}
+
+		m_segments.append(segment);
+	}
+
+	if (m_segments.isEmpty())
+		return;
+
+	const Segment& newest = m_segments.last();
+	m_nextSequence = newest.first + newest.count;
+
+	for (const auto& alert : read(qMax(m_segments.first().first, m_nextSequence - MAX_ALERTRECENT), m_nextSequence - 1))
+	{
+		addRecent(alert);
+	}
+
+	m_dataFile.setFileName(dataFilename(newest.first));
+	m_indexFile.setFileName(indexFilename(newest.first));
+	if (!m_dataFile.open(QFile::WriteOnly | QFile::Append) || !m_indexFile.open(QFile::WriteOnly | QFile::Append))
+	{
+		Logger(LOG_ERROR) << tr("Error '%1' opening alert store file for write: '%2'")
+			.arg(m_dataFile.errorString())
+			.arg(m_dataFile.fileName());
+		m_dataFile.close();
+		m_indexFile.close();
+	}
+}
+
+
+// Rewrites the index of a segment from its data file, dropping a partly written last line
+bool AlertStore::rebuildIndex(Segment& segment) const
+{
+	QFile data(dataFilename(segment.first));
+	QFile index(indexFilename(segment.first));
+	if (!data.open(QFile::ReadWrite) || !index.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		Logger(LOG_ERROR) << tr("Error '%1' rebuilding alert store index: '%2'")
+			.arg(data.isOpen() ? index.errorString() : data.errorString())
+			.arg(data.isOpen() ? index.fileName() : data.fileName());
+		return false;
+	}
+
+	qint64 offset = 0;
+	segment.count = 0;
+	while (!data.atEnd())
+	{
+		QByteArray line = data.readLine();
+		if (!line.endsWith('\n'))
+			break;
+
+		QDateTime time = QDateTime::fromString(QString::fromUtf8(line.left(19)), "yyyy-MM-dd HH:mm:ss");
+		writeIndexRecord(index, time, offset);
+		offset += line.size();
+		segment.count++;
+	}
+
+	if (offset < data.size())
+		data.resize(offset);
+
+	return true;
+}
+
+
+// Imports the alert log written before there was an alert store
+void AlertStore::importLegacyLog(const QString& filename)
+{
+	QFile legacyLog(filename);
+	if (!legacyLog.exists() || m_nextSequence > 1)
+		return;
+
+	if (!legacyLog.open(QFile::ReadOnly))
+	{
+		Logger(LOG_ERROR) << tr("Error '%1' opening alert log file for read: '%2'")
+			.arg(legacyLog.errorString())
+			.arg(filename);
+		return;
+	}
+
+	// Lines without a date are a continuation of the alert before
+	QList<QPair<QDateTime, QString>> alerts;
+	while (!legacyLog.atEnd())
+	{
+		QString line = QString::fromLocal8Bit(legacyLog.readLine());
+		while (line.endsWith('\n') || line.endsWith('\r'))
+			line.chop(1);
+
+		QDateTime time = QDateTime::fromString(line.left(19), "yyyy-MM-dd HH:mm:ss");
+		int textPos = line.indexOf(": ");
+		if (time.isValid() && textPos >= 0)
+			alerts.append(qMakePair(time, line.mid(textPos + 2)));
+		else if (!alerts.isEmpty())
+			alerts.last().second += "\n" + line;
+	}
+	legacyLog.close();
+
+	for (const auto& alert : alerts)
+	{
+		append(alert.second, alert.first);
+	}
+
+	Logger() << tr("Imported %1 alerts from the old alert log '%2'")
+		.arg(alerts.size())
+		.arg(filename);
+	QFile::rename(filename, filename + ".imported");
+}
+
+
+// Stores an alert and returns its sequence number
+qint64 AlertStore::append(const QString& text, const QDateTime& time)
+{
+	qint64 sequence = m_nextSequence++;
+	addRecent(Alert(sequence, text, time));
+
+	if (!m_dataFile.isOpen() || m_dataFile.size() >= SIZE_ALERTSEGMENT)
+	{
+		if (!startSegment(sequence))
+			return sequence;
+	}
+
+	QByteArray line = time.toString(s_headerFormat).toUtf8() + escapeText(text).toUtf8() + "\r\n";
+	qint64 offset = m_dataFile.size();
+	if (m_dataFile.write(line) != line.size() || !m_dataFile.flush() ||
+		!writeIndexRecord(m_indexFile, time, offset) || !m_indexFile.flush())
+	{
+		Logger(LOG_ERROR) << tr("Error '%1' writing alert store file: '%2'")
+			.arg(m_dataFile.error() != QFile::NoError ? m_dataFile.errorString() : m_indexFile.errorString())
+			.arg(m_dataFile.fileName());
+
+		// Alerts in a segment are numbered consecutively, so carry on in a new one
+		m_dataFile.close();
+		m_indexFile.close();
+		return sequence;
+	}
+
+	m_segments.last().count++;
+	return sequence;
+}
+
+
+bool AlertStore::startSegment(qint64 first)
+{
+	m_dataFile.close();
+	m_indexFile.close();
+
+	// Replaces a segment that failed before anything was written to it
+	if (!m_segments.isEmpty() && m_segments.last().first == first)
+		m_segments.removeLast();
+
+	m_dataFile.setFileName(dataFilename(first));
+	m_indexFile.setFileName(indexFilename(first));
+	if (!m_dataFile.open(QFile::WriteOnly | QFile::Truncate) || !m_indexFile.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		Logger(LOG_ERROR) << tr("Error '%1' creating alert store file: '%2'")
+			.arg(m_dataFile.isOpen() ? m_indexFile.errorString() : m_dataFile.errorString())
+			.arg(m_dataFile.isOpen() ? m_indexFile.fileName() : m_dataFile.fileName());
+		m_dataFile.close();
+		m_indexFile.close();
+		return false;
+	}
+
+	Segment segment;
+	segment.first = first;
+	m_segments.append(segment);
+
+	removeOldSegments();
+	return true;
+}
+
+
+void AlertStore::removeOldSegments()
+{
+	while (m_segments.size() > MAX_ALERTSEGMENTS)
+	{
+		qint64 first = m_segments.takeFirst().first;
+		QFile::remove(dataFilename(first));
+		QFile::remove(indexFilename(first));
+	}
+}
+
+
+void AlertStore::addRecent(const Alert& alert)
+{
+	if (m_recentCount == m_recent.size())
+	{
+		m_recentFirst = (m_recentFirst + 1) % m_recent.size();
+		m_recentCount--;
+	}
+
+	m_recent[(m_recentFirst + m_recentCount) % m_recent.size()] = alert;
+	m_recentCount++;
+}
+
+
+qint64 AlertStore::firstSequence() const
+{
+	if (!m_segments.isEmpty())
+		return m_segments.first().first;
+	if (m_recentCount > 0)
+		return m_recent[m_recentFirst].GetSequence();
+	return m_nextSequence;
+}
+
+
+qint64 AlertStore::lastSequence() const
+{
+	return m_nextSequence - 1;
+}
+
+
+// Returns up to limit alerts after the given sequence number, oldest first
+QList<Alert> AlertStore::alertsSince(qint64 sequence, int limit) const
+{
+	qint64 first = qMax(sequence + 1, firstSequence());
+	qint64 last = qMin(first + limit - 1, lastSequence());
+	return read(first, last);
+}
+
+
+// Returns up to limit alerts before the given sequence number, or the newest
+// alerts for zero, oldest first
+QList<Alert> AlertStore::alertsBefore(qint64 sequence, int limit) const
+{
+	qint64 last = sequence > 0 ? qMin(sequence - 1, lastSequence()) : lastSequence();
+	qint64 first = qMax(last - limit + 1, firstSequence());
+	return read(first, last);
+}
+
+
+QList<Alert> AlertStore::read(qint64 first, qint64 last) const
+{
+	QList<Alert> alerts;
+	if (first > last)
+		return alerts;
+
+	// Recent alerts don't need the disk
+	if (m_recentCount > 0 && first >= m_recent[m_recentFirst].GetSequence())
+	{
+		qint64 oldest = m_recent[m_recentFirst].GetSequence();
+		for (qint64 sequence = first; sequence <= last && sequence - oldest < m_recentCount; sequence++)
+		{
+			alerts.append(m_recent[(m_recentFirst + sequence - oldest) % m_recent.size()]);
+		}
+		return alerts;
+	}
+
+	for (const auto& segment : m_segments)
+	{
+		qint64 segmentLast = segment.first + segment.count - 1;
+		if (segmentLast < first || segment.first > last)
+			continue;
+
+		alerts += readSegment(segment, qMax(first, segment.first), qMin(last, segmentLast));
+	}
+	return alerts;
+}
+
+
+QList<Alert> AlertStore::readSegment(const Segment& segment, qint64 first, qint64 last) const
+{
+	QList<Alert> alerts;
+
+	QFile index(indexFilename(segment.first));
+	QFile data(dataFilename(segment.first));
+	if (!index.open(QFile::ReadOnly) || !data.open(QFile::ReadOnly))
+	{
+		Logger(LOG_ERROR) << tr("Error '%1' opening alert store file for read: '%2'")
+			.arg(index.isOpen() ? data.errorString() : index.errorString())
+			.arg(index.isOpen() ? data.fileName() : index.fileName());
+		return alerts;
+	}
+
+	// Alerts are numbered consecutively so the index records are found by position
+	index.seek((first - segment.first) * s_indexRecordSize);
+	QByteArray records = index.read((last - first + 1) * s_indexRecordSize);
+	for (int n = 0; (n + 1) * s_indexRecordSize <= records.size(); n++)
+	{
+		const uchar* record = reinterpret_cast<const uchar*>(records.constData()) + n * s_indexRecordSize;
+		QDateTime time = QDateTime::fromMSecsSinceEpoch(qFromLittleEndian<qint64>(record));
+		if (!data.seek(qFromLittleEndian<qint64>(record + 8)))
+			break;
+
+		QString line = QString::fromUtf8(data.readLine());
+		while (line.endsWith('\n') || line.endsWith('\r'))
+			line.chop(1);
+		alerts.append(Alert(first + n, unescapeText(line.mid(line.indexOf(": ") + 2)), time));
+	}
+
+	return alerts;
+}
+
+
+QString AlertStore::dataFilename(qint64 first) const
+{
+	return m_directory + QString("%1.alerts").arg(first, 12, 10, QChar('0'));
+}
+
+
+QString AlertStore::indexFilename(qint64 first) const
+{
+	return m_directory + QString("%1.index").arg(first, 12, 10, QChar('0'));
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+/* AlertStore.h - Alert history kept in numbered segment files with a sequence and time index */
+
+#include <QObject>
+#include <QDateTime>
+#include <QFile>
+#include <QList>
+#include <QVector>
+
+class Alert
+{
+public:
+	Alert()
+	{
+	}
+
+	Alert(qint64 sequence, const QString& text, const QDateTime& time)
+		: m_sequence(sequence), m_text(text), m_time(time)
+	{
+	}
+
+	qint64 GetSequence() const
+	{
+		return m_sequence;
+	}
+
+	QString GetText() const
+	{
+		return m_text;
+	}
+
+	QDateTime GetTime() const
+	{
+		return m_time;
+	}
+
+private:
+	qint64 m_sequence = 0;
+	QString m_text;
+	QDateTime m_time;
+};
+
+
+// Every alert gets the next sequence number. Alerts are appended to segment
+// files named after their first sequence number, one line each in the same
+// format as the old alert log, and each segment has an index file of the time
+// and file offset of every alert so any range can be read without scanning.
+// The newest alerts are also kept in memory. Old segments are deleted once
+// there are more than MAX_ALERTSEGMENTS.
+class AlertStore : public QObject
+{
+	Q_OBJECT
+
+public:
+	AlertStore(const QString& directory, QObject *parent = nullptr);
+	~AlertStore();
+
+	void importLegacyLog(const QString& filename);
+	qint64 append(const QString& text, const QDateTime& time);
+	qint64 firstSequence() const;
+	qint64 lastSequence() const;
+	QList<Alert> alertsSince(qint64 sequence, int limit) const;
+	QList<Alert> alertsBefore(qint64 sequence, int limit) const;
+
+private:
+	// One data file and its index, the alerts in it are numbered consecutively
+	struct Segment
+	{
+		qint64 first = 0;
+		qint64 count = 0;
+	};
+
+	void open();
+	bool rebuildIndex(Segment& segment) const;
+	bool startSegment(qint64 first);
+	void removeOldSegments();
+	void addRecent(const Alert& alert);
+	QList<Alert> read(qint64 first, qint64 last) const;
+	QList<Alert> readSegment(const Segment& segment, qint64 first, qint64 last) const;
+	QString dataFilename(qint64 first) const;
+	QString indexFilename(qint64 first) const;
+
+	QString m_directory;
+	QList<Segment> m_segments;		// Oldest first
+	QFile m_dataFile;				// Files of the newest segment, kept open for appending
+	QFile m_indexFile;
+	qint64 m_nextSequence = 1;
+	QVector<Alert> m_recent;		// Ring of the newest alerts
+	int m_recentFirst = 0;
+	int m_recentCount = 0;
+};
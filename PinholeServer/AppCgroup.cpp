@@ -0,0 +1,419 @@
+#include "AppCgroup.h"
+#include "Logger.h"
+#include "Values.h"
+
+#include <QObject>
+
+#if defined(Q_OS_LINUX)
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <QUrl>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+static bool s_delegated = false;		// The server's cgroup is its own to reorganise
+static bool s_parentChecked = false;
+static QString s_parentPath;		// Where app cgroups are made, empty if apps can't be contained
+
+
+// cgroup files take each value in a single write
+static bool writeCgroupFile(const QString& filename, const QByteArray& value)
+{
+	int fd = ::open(QFile::encodeName(filename).constData(), O_WRONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	bool written = ::write(fd, value.constData(), value.size()) == value.size();
+	::close(fd);
+	return written;
+}
+
+
+static QList<quint32> readProcs(const QString& filename)
+{
+	QList<quint32> pids;
+	QFile file(filename);
+	if (file.open(QIODevice::ReadOnly))
+	{
+		for (const auto& line : file.readAll().split('\n'))
+		{
+			quint32 pid = line.toUInt();
+			if (0 != pid)
+				pids.append(pid);
+		}
+	}
+	return pids;
+}
+
+
+// Finds the cgroup the app cgroups are made in and hands the CPU, memory and IO
+// controllers down to it, the first time an app asks
+static QString parentPath()
+{
+	if (s_parentChecked)
+		return s_parentPath;
+	s_parentChecked = true;
+
+	// The cgroup v2 line is "0::/system.slice/pinhole.service"
+	QString ownGroup;
+	QFile selfCgroup("/proc/self/cgroup");
+	if (selfCgroup.open(QIODevice::ReadOnly))
+	{
+		for (const auto& line : selfCgroup.readAll().split('\n'))
+		{
+			if (line.startsWith("0::"))
+				ownGroup = QString::fromUtf8(line.mid(3));
+		}
+	}
+	if (ownGroup.isEmpty() || !QFile::exists(CGROUP_ROOT "/cgroup.controllers"))
+	{
+		Logger(LOG_WARNING) << QObject::tr("cgroup v2 is not mounted at %1, applications will run without cgroups")
+			.arg(CGROUP_ROOT);
+		return QString();
+	}
+
+	QString parent;
+	QStringList delegating;			// cgroups the controllers are enabled under, from the top
+	if ("/" == ownGroup)
+	{
+		// The root cgroup hands out resources even with processes in it, the apps get a cgroup of their own under it
+		parent = CGROUP_ROOT "/" CGROUP_PINHOLE;
+		delegating << CGROUP_ROOT << parent;
+	}
+	else if (!s_delegated)
+	{
+		// Moving processes out of a cgroup that isn't ours would move the user's shell and session with them
+		Logger(LOG_WARNING) << QObject::tr("cgroup %1 was not delegated to Pinhole, applications will run without cgroups")
+			.arg(ownGroup);
+		return QString();
+	}
+	else
+	{
+		// Any other cgroup only hands out resources without processes of its own,
+		// so the server's processes move to a leaf next to the app cgroups
+		parent = CGROUP_ROOT + ownGroup;
+		QString serverPath = parent + "/" CGROUP_SERVER;
+		QDir().mkpath(serverPath);
+		for (auto pid : readProcs(parent + "/cgroup.procs"))
+		{
+			writeCgroupFile(serverPath + "/cgroup.procs", QByteArray::number(pid));
+		}
+		if (!readProcs(parent + "/cgroup.procs").isEmpty())
+		{
+			Logger(LOG_WARNING) << QObject::tr("Can't move Pinhole out of cgroup %1, applications will run without cgroups")
+				.arg(parent);
+			return QString();
+		}
+		delegating << parent;
+	}
+
+	if (!QDir().mkpath(parent))
+	{
+		Logger(LOG_WARNING) << QObject::tr("Can't create cgroup %1, applications will run without cgroups")
+			.arg(parent);
+		return QString();
+	}
+
+	for (const auto& path : delegating)
+	{
+		// One at a time, the write fails as a whole if any controller is missing
+		for (const char* controller : { "+cpu", "+memory", "+io" })
+		{
+			if (!writeCgroupFile(path + "/cgroup.subtree_control", controller))
+			{
+				Logger(LOG_DEBUG) << QObject::tr("Can't enable cgroup controller %1 under %2")
+					.arg(QString::fromLatin1(controller + 1))
+					.arg(path);
+			}
+		}
+	}
+
+	Logger(LOG_EXTRA) << QObject::tr("Application cgroups are created in %1").arg(parent);
+	s_parentPath = parent;
+	return s_parentPath;
+}
+
+
+AppCgroup::AppCgroup(const QString& appName)
+	: m_appName(appName)
+{
+}
+
+
+// The cgroup can only be removed once nothing is left in it, otherwise it is reused next time
+AppCgroup::~AppCgroup()
+{
+	if (!m_path.isEmpty())
+	{
+		::rmdir(QFile::encodeName(m_path).constData());
+	}
+}
+
+
+// Set before any app asks for a cgroup
+void AppCgroup::setDelegated(bool delegated)
+{
+	s_delegated = delegated;
+}
+
+
+bool AppCgroup::available()
+{
+	return !parentPath().isEmpty();
+}
+
+
+bool AppCgroup::create(const CgroupLimits& limits)
+{
+	QString parent = parentPath();
+	if (parent.isEmpty())
+		return false;
+
+	QString path = parent + "/" CGROUP_APPPREFIX + QString::fromLatin1(QUrl::toPercentEncoding(m_appName));
+	if (!QDir().mkpath(path))
+	{
+		Logger(LOG_WARNING) << QObject::tr("App %1: Failed to create cgroup %2")
+			.arg(m_appName)
+			.arg(path);
+		return false;
+	}
+	m_path = path;
+
+	// Missing limits are logged, the app is still contained
+	applyLimits(limits);
+	return true;
+}
+
+
+// Limits can change while the app runs
+bool AppCgroup::applyLimits(const CgroupLimits& limits)
+{
+	if (m_path.isEmpty())
+		return false;
+
+	bool applied = true;
+	if (hasController("cpu"))
+	{
+		applied &= writeFile("cpu.weight", QByteArray::number(limits.cpuWeight > 0 ? limits.cpuWeight : CGROUP_DEFAULTWEIGHT));
+		QByteArray quota = limits.cpuQuota > 0 ? QByteArray::number(static_cast<qint64>(limits.cpuQuota) * CGROUP_PERIOD / 100) : QByteArray("max");
+		applied &= writeFile("cpu.max", quota + " " + QByteArray::number(CGROUP_PERIOD));
+	}
+	else
+	{
+		applied &= 0 == limits.cpuWeight && 0 == limits.cpuQuota;
+	}
+
+	if (hasController("memory"))
+	{
+		applied &= writeFile("memory.high", limits.memoryHigh > 0 ? QByteArray::number(static_cast<qint64>(limits.memoryHigh) * 1048576) : QByteArray("max"));
+		applied &= writeFile("memory.max", limits.memoryMax > 0 ? QByteArray::number(static_cast<qint64>(limits.memoryMax) * 1048576) : QByteArray("max"));
+	}
+	else
+	{
+		applied &= 0 == limits.memoryHigh && 0 == limits.memoryMax;
+	}
+
+	if (hasController("io"))
+	{
+		applied &= writeFile("io.weight", "default " + QByteArray::number(limits.ioWeight > 0 ? limits.ioWeight : CGROUP_DEFAULTWEIGHT));
+	}
+	else
+	{
+		applied &= 0 == limits.ioWeight;
+	}
+
+	if (!applied)
+	{
+		Logger(LOG_WARNING) << QObject::tr("App %1: Not every resource limit could be set on cgroup %2")
+			.arg(m_appName)
+			.arg(m_path);
+	}
+	return applied;
+}
+
+
+// For the child to write 0 to between fork and exec, which moves it into the cgroup. Closed on exec.
+int AppCgroup::openProcs() const
+{
+	if (m_path.isEmpty())
+		return -1;
+
+	return ::open(QFile::encodeName(m_path + "/cgroup.procs").constData(), O_WRONLY | O_CLOEXEC);
+}
+
+
+// Kills every process in the cgroup, true once they've all been sent SIGKILL
+bool AppCgroup::kill()
+{
+	if (m_path.isEmpty())
+		return false;
+
+	// Linux 5.14 and later kill the whole cgroup at once, including processes forked meanwhile
+	if (writeFile("cgroup.kill", "1"))
+		return true;
+
+	// Before that processes are killed one by one until none are left
+	for (int pass = 0; pass < MAX_CGROUPKILLPASSES; pass++)
+	{
+		QList<quint32> pids = processes();
+		if (pids.isEmpty())
+			return true;
+
+		for (auto pid : pids)
+		{
+			::kill(static_cast<pid_t>(pid), SIGKILL);
+		}
+		QThread::msleep(INTERVAL_CGROUPKILLPASS);
+	}
+
+	bool killed = processes().isEmpty();
+	if (!killed)
+	{
+		Logger(LOG_WARNING) << QObject::tr("App %1: Processes are still running in cgroup %2 after killing them")
+			.arg(m_appName)
+			.arg(m_path);
+	}
+	return killed;
+}
+
+
+QList<quint32> AppCgroup::processes() const
+{
+	if (m_path.isEmpty())
+		return QList<quint32>();
+
+	return readProcs(m_path + "/cgroup.procs");
+}
+
+
+// Microseconds of CPU used by everything that has run in the cgroup
+qint64 AppCgroup::cpuUsage() const
+{
+	for (const auto& line : readFile("cpu.stat").split('\n'))
+	{
+		if (line.startsWith("usage_usec "))
+			return line.mid(11).toLongLong();
+	}
+	return 0;
+}
+
+
+// Bytes of memory used by the cgroup, including page cache
+qint64 AppCgroup::memoryCurrent() const
+{
+	return readFile("memory.current").trimmed().toLongLong();
+}
+
+
+bool AppCgroup::writeFile(const char* name, const QByteArray& value) const
+{
+	return writeCgroupFile(m_path + "/" + name, value);
+}
+
+
+QByteArray AppCgroup::readFile(const char* name) const
+{
+	if (m_path.isEmpty())
+		return QByteArray();
+
+	QFile file(m_path + "/" + name);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+	return file.readAll();
+}
+
+
+bool AppCgroup::hasController(const QByteArray& controller) const
+{
+	return readFile("cgroup.controllers").simplified().split(' ').contains(controller);
+}
+
+#else
+
+// Only Linux has cgroups, apps run as plain processes
+
+AppCgroup::AppCgroup(const QString& appName)
+	: m_appName(appName)
+{
+}
+
+
+AppCgroup::~AppCgroup()
+{
+}
+
+
+void AppCgroup::setDelegated(bool)
+{
+}
+
+
+bool AppCgroup::available()
+{
+	return false;
+}
+
+
+bool AppCgroup::create(const CgroupLimits&)
+{
+	return false;
+}
+
+
+bool AppCgroup::applyLimits(const CgroupLimits&)
+{
+	return false;
+}
+
+
+int AppCgroup::openProcs() const
+{
+	return -1;
+}
+
+
+bool AppCgroup::kill()
+{
+	return false;
+}
+
+
+QList<quint32> AppCgroup::processes() const
+{
+	return QList<quint32>();
+}
+
+
+qint64 AppCgroup::cpuUsage() const
+{
+	return 0;
+}
+
+
+qint64 AppCgroup::memoryCurrent() const
+{
+	return 0;
+}
+
+
+bool AppCgroup::writeFile(const char*, const QByteArray&) const
+{
+	return false;
+}
+
+
+QByteArray AppCgroup::readFile(const char*) const
+{
+	return QByteArray();
+}
+
+
+bool AppCgroup::hasController(const QByteArray&) const
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+/* AppCgroup.h - cgroup v2 group an app's process tree runs in, for resource limits, killing and accounting */
+
+#include <QString>
+#include <QList>
+
+// Resource limits of an app's cgroup, 0 leaves a limit at the kernel default
+struct CgroupLimits
+{
+	int cpuWeight = 0;		// 1 to MAX_CGROUPWEIGHT, the kernel default is 100
+	int cpuQuota = 0;		// Percent of one CPU
+	int memoryHigh = 0;		// Megabytes, the app is throttled and reclaimed above this
+	int memoryMax = 0;		// Megabytes, the app is killed by the OOM killer above this
+	int ioWeight = 0;		// 1 to MAX_CGROUPWEIGHT, the kernel default is 100
+};
+
+
+// The app's process is moved into its cgroup between fork and exec, so
+// everything it starts is in the group too. Stopping the app kills the whole
+// group instead of only the direct child, and the group's cpu.stat and
+// memory.current are read for the app's CPU time and memory use. Only Linux
+// with cgroup v2 mounted and a server that may write to its own cgroup can
+// contain apps, elsewhere available() is false and apps run as before. The
+// server's own cgroup is only reorganised when it was delegated to it, which
+// the shipped systemd unit does for the service, a server run by a user shares
+// its cgroup with the user's session.
+class AppCgroup
+{
+public:
+	AppCgroup(const QString& appName);
+	~AppCgroup();
+
+	static void setDelegated(bool delegated);
+	static bool available();
+
+	QString appName() const { return m_appName; }
+	bool create(const CgroupLimits& limits);
+	bool applyLimits(const CgroupLimits& limits);
+	int openProcs() const;
+	bool kill();
+	QList<quint32> processes() const;
+	qint64 cpuUsage() const;
+	qint64 memoryCurrent() const;
+
+private:
+	bool writeFile(const char* name, const QByteArray& value) const;
+	QByteArray readFile(const char* name) const;
+	bool hasController(const QByteArray& controller) const;
+
+	QString m_appName;
+	QString m_path;
+};
@@ -1,6 +1,8 @@
 #include "AppManager.h"
 #include "Settings.h"
 #include "GlobalManager.h"
+#include "LaunchScheduler.h"
+#include "ConsoleCapture.h"
 #include "Logger.h"
 #include "Values.h"
 #include "UserProcess.h"
@@ -26,7 +28,23 @@ AppManager::AppManager(Settings* settings, GlobalManager* globalManager, QObject
 	: QObject(parent), m_settings(settings), 
 	m_globalManager(globalManager)
 {
+	m_launchScheduler = new LaunchScheduler(m_globalManager, this);
+	m_timingWheel = new TimingWheel(this);
+	m_consoleCapture = new ConsoleCapture(this);
+	connect(m_consoleCapture, &ConsoleCapture::output,
+		this, &AppManager::consoleOutput);
+
 	readApplicationSettings();
+
+	// Only apps that change need writing to settings
+	connect(this, &AppManager::valueChanged,
+		this, [this](const QString&, const QString& appName, const QString&, const QVariant&)
+	{
+		if (appName.isEmpty())
+			m_appListDirty = true;
+		else
+			m_dirtyApps.insert(appName);
+	});
 }
 
 
@@ -47,39 +65,53 @@ void AppManager::start()
 
 bool AppManager::readApplicationSettings()
 {
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
-	QStringList appList = settings->value(SETTINGS_APPLIST).toStringList();
+	QStringList appList = m_settings->value(SETTINGS_APPLIST).toStringList();
 	for (const auto& appName : appList)
 	{
-		settings->beginGroup(SETTINGS_APPPREFIX + appName);
+		m_settings->beginGroup(SETTINGS_APPPREFIX + appName);
 		QSharedPointer<Application> newApp = newApplication(appName);
-		newApp->setExecutable(settings->value(PROP_APP_EXECUTABLE, "").toString());
-		newApp->setArguments(settings->value(PROP_APP_ARGUMENTS, "").toString());
-		newApp->setDirectory(settings->value(PROP_APP_DIRECTORY, "").toString());
-		newApp->setLaunchAtStart(settings->value(PROP_APP_LAUNCHATSTART, false).toBool());
-		newApp->setKeepAppRunning(settings->value(PROP_APP_KEEPAPPRUNNING, false).toBool());
-		newApp->setTerminatePrev(settings->value(PROP_APP_TERMINATEPREV, false).toBool());
-		newApp->setSoftTerminate(settings->value(PROP_APP_SOFTTERMINATE, false).toBool());
-		newApp->setNoCrashThrottle(settings->value(PROP_APP_NOCRASHTHROTTLE, false).toBool());
-		newApp->setLockupScreenshot(settings->value(PROP_APP_LOCKUPSCREENSHOT, false).toBool());
-		newApp->setConsoleCapture(settings->value(PROP_APP_CONSOLECAPTURE, false).toBool());
-		newApp->setAppendCapture(settings->value(PROP_APP_APPENDCAPTURE, false).toBool());
-		newApp->setLaunchDisplay(settings->value(PROP_APP_LAUNCHDISPLAY, false).toString());
-		newApp->setLaunchDelay(settings->value(PROP_APP_LAUNCHDELAY, false).toInt());
-		newApp->setTcpLoopback(settings->value(PROP_APP_TCPLOOPBACK, false).toBool());
-		newApp->setTcpLoopbackPort(settings->value(PROP_APP_TCPLOOPBACKPORT, DEFAULT_APPLOOPBACKPORT).toInt());
-		newApp->setHeartbeats(settings->value(PROP_APP_HEARTBEATS, false).toBool());
-		newApp->setEnvironment(settings->value(PROP_APP_ENVIRONMENT).toStringList());
-
-		if (settings->contains(PROP_APP_LASTSTARTED))
-			newApp->setLastStartedString(settings->value(PROP_APP_LASTSTARTED).toString());
-		if (settings->contains(PROP_APP_LASTEXITED))
-			newApp->setLastExitedString(settings->value(PROP_APP_LASTEXITED).toString());
+		newApp->setExecutable(m_settings->value(PROP_APP_EXECUTABLE, "").toString());
+		newApp->setArguments(m_settings->value(PROP_APP_ARGUMENTS, "").toString());
+		newApp->setDirectory(m_settings->value(PROP_APP_DIRECTORY, "").toString());
+		newApp->setLaunchAtStart(m_settings->value(PROP_APP_LAUNCHATSTART, false).toBool());
+		newApp->setKeepAppRunning(m_settings->value(PROP_APP_KEEPAPPRUNNING, false).toBool());
+		newApp->setTerminatePrev(m_settings->value(PROP_APP_TERMINATEPREV, false).toBool());
+		newApp->setSoftTerminate(m_settings->value(PROP_APP_SOFTTERMINATE, false).toBool());
+		newApp->setNoCrashThrottle(m_settings->value(PROP_APP_NOCRASHTHROTTLE, false).toBool());
+		newApp->setLockupScreenshot(m_settings->value(PROP_APP_LOCKUPSCREENSHOT, false).toBool());
+		newApp->setConsoleCapture(m_settings->value(PROP_APP_CONSOLECAPTURE, false).toBool());
+		newApp->setAppendCapture(m_settings->value(PROP_APP_APPENDCAPTURE, false).toBool());
+		newApp->setCaptureRotateSize(m_settings->value(PROP_APP_CAPTUREROTATESIZE, 0).toInt());
+		newApp->setCaptureRotateHours(m_settings->value(PROP_APP_CAPTUREROTATEHOURS, 0).toInt());
+		newApp->setCaptureCompress(m_settings->value(PROP_APP_CAPTURECOMPRESS, false).toBool());
+		newApp->setCgroup(m_settings->value(PROP_APP_CGROUP, false).toBool());
+		newApp->setCpuWeight(m_settings->value(PROP_APP_CPUWEIGHT, 0).toInt());
+		newApp->setCpuQuota(m_settings->value(PROP_APP_CPUQUOTA, 0).toInt());
+		newApp->setMemoryHigh(m_settings->value(PROP_APP_MEMORYHIGH, 0).toInt());
+		newApp->setMemoryMax(m_settings->value(PROP_APP_MEMORYMAX, 0).toInt());
+		newApp->setIoWeight(m_settings->value(PROP_APP_IOWEIGHT, 0).toInt());
+		newApp->setCpuAffinity(m_settings->value(PROP_APP_CPUAFFINITY, "").toString());
+		newApp->setNice(m_settings->value(PROP_APP_NICE, 0).toInt());
+		newApp->setScheduling(m_settings->value(PROP_APP_SCHEDPOLICY, SCHEDPOLICY_NORMAL).toString(),
+			m_settings->value(PROP_APP_SCHEDPRIORITY, 0).toInt());
+		newApp->setIoClass(m_settings->value(PROP_APP_IOCLASS, IOCLASS_NONE).toString());
+		newApp->setIoPriority(m_settings->value(PROP_APP_IOPRIORITY, DEFAULT_IOPRIORITY).toInt());
+		newApp->setLaunchDisplay(m_settings->value(PROP_APP_LAUNCHDISPLAY, false).toString());
+		newApp->setLaunchDelay(m_settings->value(PROP_APP_LAUNCHDELAY, false).toInt());
+		newApp->setTcpLoopback(m_settings->value(PROP_APP_TCPLOOPBACK, false).toBool());
+		newApp->setTcpLoopbackPort(m_settings->value(PROP_APP_TCPLOOPBACKPORT, DEFAULT_APPLOOPBACKPORT).toInt());
+		newApp->setHeartbeats(m_settings->value(PROP_APP_HEARTBEATS, false).toBool());
+		newApp->setEnvironment(m_settings->value(PROP_APP_ENVIRONMENT).toStringList());
+		newApp->setDependencies(m_settings->value(PROP_APP_DEPENDENCIES).toStringList());
+
+		if (m_settings->contains(PROP_APP_LASTSTARTED))
+			newApp->setLastStartedString(m_settings->value(PROP_APP_LASTSTARTED).toString());
+		if (m_settings->contains(PROP_APP_LASTEXITED))
+			newApp->setLastExitedString(m_settings->value(PROP_APP_LASTEXITED).toString());
 
 		m_appList[appName] = newApp;
 
-		settings->endGroup();
+		m_settings->endGroup();
 	}
 
 	return true;
@@ -88,54 +120,74 @@ bool AppManager::readApplicationSettings()
 
 bool AppManager::writeApplicationSettings() const
 {
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
 #ifdef QT_DEBUG
 	//qDebug() << "Writing application settings to " << settings->fileName() << settings->isWritable();
 #endif
 
-	// Delete old entries
-	QStringList appList = settings->value(SETTINGS_APPLIST).toStringList();
+	// Delete entries that no longer exist
+	QStringList appList = m_settings->value(SETTINGS_APPLIST).toStringList();
 	for (const auto& appName : appList)
 	{
-		settings->remove(SETTINGS_APPPREFIX + appName);
+		if (!m_appList.contains(appName))
+			m_settings->remove(SETTINGS_APPPREFIX + appName);
 	}
 
 	for (const auto& app : m_appList)
 	{
 		QString appName = app->getName();
-		settings->beginGroup(SETTINGS_APPPREFIX + appName);
-		settings->setValue(PROP_APP_NAME, appName);
-		settings->setValue(PROP_APP_EXECUTABLE, app->getExecutable());
-		settings->setValue(PROP_APP_ARGUMENTS, app->getArguments());
-		settings->setValue(PROP_APP_DIRECTORY, app->getDirectory());
-		settings->setValue(PROP_APP_LAUNCHATSTART, app->getLaunchAtStart());
-		settings->setValue(PROP_APP_KEEPAPPRUNNING, app->getKeepAppRunning());
-		settings->setValue(PROP_APP_TERMINATEPREV, app->getTerminatePrev());
-		settings->setValue(PROP_APP_SOFTTERMINATE, app->getSoftTerminate());
-		settings->setValue(PROP_APP_NOCRASHTHROTTLE, app->getNoCrashThrottle());
-		settings->setValue(PROP_APP_LOCKUPSCREENSHOT, app->getLockupScreenshot());
-		settings->setValue(PROP_APP_CONSOLECAPTURE, app->getConsoleCapture());
-		settings->setValue(PROP_APP_APPENDCAPTURE, app->getAppendCapture());
-		settings->setValue(PROP_APP_LAUNCHDISPLAY, app->getLaunchDisplay());
-		settings->setValue(PROP_APP_LAUNCHDELAY, app->getLaunchDelay());
-		settings->setValue(PROP_APP_TCPLOOPBACK, app->getTcpLoopback());
-		settings->setValue(PROP_APP_TCPLOOPBACKPORT, app->getTcpLoopbackPort());
-		settings->setValue(PROP_APP_HEARTBEATS, app->getHeartbeats());
-		settings->setValue(PROP_APP_ENVIRONMENT, app->getEnvironment());
+		if (!m_appListDirty && !m_dirtyApps.contains(appName))
+			continue;
+
+		m_settings->beginGroup(SETTINGS_APPPREFIX + appName);
+		m_settings->setValue(PROP_APP_NAME, appName);
+		m_settings->setValue(PROP_APP_EXECUTABLE, app->getExecutable());
+		m_settings->setValue(PROP_APP_ARGUMENTS, app->getArguments());
+		m_settings->setValue(PROP_APP_DIRECTORY, app->getDirectory());
+		m_settings->setValue(PROP_APP_LAUNCHATSTART, app->getLaunchAtStart());
+		m_settings->setValue(PROP_APP_KEEPAPPRUNNING, app->getKeepAppRunning());
+		m_settings->setValue(PROP_APP_TERMINATEPREV, app->getTerminatePrev());
+		m_settings->setValue(PROP_APP_SOFTTERMINATE, app->getSoftTerminate());
+		m_settings->setValue(PROP_APP_NOCRASHTHROTTLE, app->getNoCrashThrottle());
+		m_settings->setValue(PROP_APP_LOCKUPSCREENSHOT, app->getLockupScreenshot());
+		m_settings->setValue(PROP_APP_CONSOLECAPTURE, app->getConsoleCapture());
+		m_settings->setValue(PROP_APP_APPENDCAPTURE, app->getAppendCapture());
+		m_settings->setValue(PROP_APP_CAPTUREROTATESIZE, app->getCaptureRotateSize());
+		m_settings->setValue(PROP_APP_CAPTUREROTATEHOURS, app->getCaptureRotateHours());
+		m_settings->setValue(PROP_APP_CAPTURECOMPRESS, app->getCaptureCompress());
+		m_settings->setValue(PROP_APP_CGROUP, app->getCgroup());
+		m_settings->setValue(PROP_APP_CPUWEIGHT, app->getCpuWeight());
+		m_settings->setValue(PROP_APP_CPUQUOTA, app->getCpuQuota());
+		m_settings->setValue(PROP_APP_MEMORYHIGH, app->getMemoryHigh());
+		m_settings->setValue(PROP_APP_MEMORYMAX, app->getMemoryMax());
+		m_settings->setValue(PROP_APP_IOWEIGHT, app->getIoWeight());
+		m_settings->setValue(PROP_APP_CPUAFFINITY, app->getCpuAffinity());
+		m_settings->setValue(PROP_APP_NICE, app->getNice());
+		m_settings->setValue(PROP_APP_SCHEDPOLICY, app->getSchedPolicy());
+		m_settings->setValue(PROP_APP_SCHEDPRIORITY, app->getSchedPriority());
+		m_settings->setValue(PROP_APP_IOCLASS, app->getIoClass());
+		m_settings->setValue(PROP_APP_IOPRIORITY, app->getIoPriority());
+		m_settings->setValue(PROP_APP_LAUNCHDISPLAY, app->getLaunchDisplay());
+		m_settings->setValue(PROP_APP_LAUNCHDELAY, app->getLaunchDelay());
+		m_settings->setValue(PROP_APP_TCPLOOPBACK, app->getTcpLoopback());
+		m_settings->setValue(PROP_APP_TCPLOOPBACKPORT, app->getTcpLoopbackPort());
+		m_settings->setValue(PROP_APP_HEARTBEATS, app->getHeartbeats());
+		m_settings->setValue(PROP_APP_ENVIRONMENT, app->getEnvironment());
+		m_settings->setValue(PROP_APP_DEPENDENCIES, app->getDependencies());
 
 		QDateTime time;
 		time = app->getLastStarted();
 		if (!time.isNull())
-			settings->setValue(PROP_APP_LASTSTARTED, time.toString());
+			m_settings->setValue(PROP_APP_LASTSTARTED, time.toString());
 		
 		time = app->getLastExited();
 		if (!time.isNull())
-			settings->setValue(PROP_APP_LASTEXITED, time.toString());
-		settings->endGroup();
+			m_settings->setValue(PROP_APP_LASTEXITED, time.toString());
+		m_settings->endGroup();
 	}
 
-	settings->setValue(SETTINGS_APPLIST, QStringList(m_appList.keys()));
+	m_settings->setValue(SETTINGS_APPLIST, QStringList(m_appList.keys()));
+	m_dirtyApps.clear();
+	m_appListDirty = false;
 
 	return true;
 }
@@ -205,12 +257,28 @@ bool AppManager::importSettings(const QJsonObject& root)
 				newApp->setLockupScreenshot(ReadJsonValueWithDefault(japp, PROP_APP_LOCKUPSCREENSHOT, newApp->getLockupScreenshot()).toBool());
 				newApp->setConsoleCapture(ReadJsonValueWithDefault(japp, PROP_APP_CONSOLECAPTURE, newApp->getConsoleCapture()).toBool());
 				newApp->setAppendCapture(ReadJsonValueWithDefault(japp, PROP_APP_APPENDCAPTURE, newApp->getAppendCapture()).toBool());
+				newApp->setCaptureRotateSize(ReadJsonValueWithDefault(japp, PROP_APP_CAPTUREROTATESIZE, newApp->getCaptureRotateSize()).toInt());
+				newApp->setCaptureRotateHours(ReadJsonValueWithDefault(japp, PROP_APP_CAPTUREROTATEHOURS, newApp->getCaptureRotateHours()).toInt());
+				newApp->setCaptureCompress(ReadJsonValueWithDefault(japp, PROP_APP_CAPTURECOMPRESS, newApp->getCaptureCompress()).toBool());
+				newApp->setCgroup(ReadJsonValueWithDefault(japp, PROP_APP_CGROUP, newApp->getCgroup()).toBool());
+				newApp->setCpuWeight(ReadJsonValueWithDefault(japp, PROP_APP_CPUWEIGHT, newApp->getCpuWeight()).toInt());
+				newApp->setCpuQuota(ReadJsonValueWithDefault(japp, PROP_APP_CPUQUOTA, newApp->getCpuQuota()).toInt());
+				newApp->setMemoryHigh(ReadJsonValueWithDefault(japp, PROP_APP_MEMORYHIGH, newApp->getMemoryHigh()).toInt());
+				newApp->setMemoryMax(ReadJsonValueWithDefault(japp, PROP_APP_MEMORYMAX, newApp->getMemoryMax()).toInt());
+				newApp->setIoWeight(ReadJsonValueWithDefault(japp, PROP_APP_IOWEIGHT, newApp->getIoWeight()).toInt());
+				newApp->setCpuAffinity(ReadJsonValueWithDefault(japp, PROP_APP_CPUAFFINITY, newApp->getCpuAffinity()).toString());
+				newApp->setNice(ReadJsonValueWithDefault(japp, PROP_APP_NICE, newApp->getNice()).toInt());
+				newApp->setScheduling(ReadJsonValueWithDefault(japp, PROP_APP_SCHEDPOLICY, newApp->getSchedPolicy()).toString(),
+					ReadJsonValueWithDefault(japp, PROP_APP_SCHEDPRIORITY, newApp->getSchedPriority()).toInt());
+				newApp->setIoClass(ReadJsonValueWithDefault(japp, PROP_APP_IOCLASS, newApp->getIoClass()).toString());
+				newApp->setIoPriority(ReadJsonValueWithDefault(japp, PROP_APP_IOPRIORITY, newApp->getIoPriority()).toInt());
 				newApp->setLaunchDisplay(ReadJsonValueWithDefault(japp, PROP_APP_LAUNCHDISPLAY, newApp->getLaunchDisplay()).toString());
 				newApp->setLaunchDelay(ReadJsonValueWithDefault(japp, PROP_APP_LAUNCHDELAY, newApp->getLaunchDelay()).toInt());
 				newApp->setTcpLoopback(ReadJsonValueWithDefault(japp, PROP_APP_TCPLOOPBACK, newApp->getTcpLoopback()).toBool());
 				newApp->setTcpLoopbackPort(ReadJsonValueWithDefault(japp, PROP_APP_TCPLOOPBACKPORT, newApp->getTcpLoopbackPort()).toInt());
 				newApp->setHeartbeats(ReadJsonValueWithDefault(japp, PROP_APP_HEARTBEATS, newApp->getHeartbeats()).toBool());
 				newApp->setEnvironment(ReadJsonValueWithDefault(japp, PROP_APP_ENVIRONMENT, newApp->getEnvironment()).toStringList());
+				newApp->setDependencies(ReadJsonValueWithDefault(japp, PROP_APP_DEPENDENCIES, newApp->getDependencies()).toStringList());
 
 				if (japp.contains(PROP_APP_LASTSTARTED))
 					newApp->setLastStartedString(japp[PROP_APP_LASTSTARTED].toString());
@@ -259,12 +327,28 @@ QJsonObject AppManager::exportSettings() const
 		japp[PROP_APP_LOCKUPSCREENSHOT] = app->getLockupScreenshot();
 		japp[PROP_APP_CONSOLECAPTURE] = app->getConsoleCapture();
 		japp[PROP_APP_APPENDCAPTURE] = app->getAppendCapture();
+		japp[PROP_APP_CAPTUREROTATESIZE] = app->getCaptureRotateSize();
+		japp[PROP_APP_CAPTUREROTATEHOURS] = app->getCaptureRotateHours();
+		japp[PROP_APP_CAPTURECOMPRESS] = app->getCaptureCompress();
+		japp[PROP_APP_CGROUP] = app->getCgroup();
+		japp[PROP_APP_CPUWEIGHT] = app->getCpuWeight();
+		japp[PROP_APP_CPUQUOTA] = app->getCpuQuota();
+		japp[PROP_APP_MEMORYHIGH] = app->getMemoryHigh();
+		japp[PROP_APP_MEMORYMAX] = app->getMemoryMax();
+		japp[PROP_APP_IOWEIGHT] = app->getIoWeight();
+		japp[PROP_APP_CPUAFFINITY] = app->getCpuAffinity();
+		japp[PROP_APP_NICE] = app->getNice();
+		japp[PROP_APP_SCHEDPOLICY] = app->getSchedPolicy();
+		japp[PROP_APP_SCHEDPRIORITY] = app->getSchedPriority();
+		japp[PROP_APP_IOCLASS] = app->getIoClass();
+		japp[PROP_APP_IOPRIORITY] = app->getIoPriority();
 		japp[PROP_APP_LAUNCHDISPLAY] = app->getLaunchDisplay();
 		japp[PROP_APP_LAUNCHDELAY] = app->getLaunchDelay();
 		japp[PROP_APP_TCPLOOPBACK] = app->getTcpLoopback();
 		japp[PROP_APP_TCPLOOPBACKPORT] = app->getTcpLoopbackPort();
 		japp[PROP_APP_HEARTBEATS] = app->getHeartbeats();
 		japp[PROP_APP_ENVIRONMENT] = QJsonArray::fromStringList(app->getEnvironment());
+		japp[PROP_APP_DEPENDENCIES] = QJsonArray::fromStringList(app->getDependencies());
 
 		QDateTime time;
 		time = app->getLastStarted();
@@ -316,6 +400,15 @@ bool AppManager::deleteApplication(const QString& appName)
 		m_appList[appName]->stop();
 
 	m_appList.remove(appName);
+	m_consoleCapture->forgetRecent(appName);
+
+	// Nothing can depend on it any more
+	for (const auto& app : m_appList)
+	{
+		QStringList dependencies = app->getDependencies();
+		if (dependencies.removeAll(appName) > 0)
+			app->setDependencies(dependencies);
+	}
 
 	emit valueChanged(GROUP_APP, "", PROP_APP_LIST, QVariant(m_appList.keys()));
 
@@ -333,6 +426,19 @@ bool AppManager::renameApplication(const QString& appName, const QString& newApp
 	m_appList.remove(appName);
 	app->setName(newAppName);
 	m_appList[newAppName] = app;
+	m_consoleCapture->forgetRecent(appName);
+
+	// Keep apps depending on it pointing at it
+	for (const auto& otherApp : m_appList)
+	{
+		QStringList dependencies = otherApp->getDependencies();
+		int index = dependencies.indexOf(appName);
+		if (index >= 0)
+		{
+			dependencies[index] = newAppName;
+			otherApp->setDependencies(dependencies);
+		}
+	}
 
 	emit valueChanged(GROUP_APP, "", PROP_APP_LIST, QVariant(m_appList.keys()));
 
@@ -456,6 +562,46 @@ bool AppManager::startApps(const QStringList& appNames)
 }
 
 
+// Launches apps along with the apps they depend on, each one once the apps it
+// depends on are ready. Returns false if any errors occur queuing the launches.
+bool AppManager::launchApps(const QString& description, const QStringList& appNames)
+{
+	bool ret = true;
+
+	QMap<QString, QSharedPointer<Application>> apps;
+	for (const auto& name : appNames)
+	{
+		if (!m_appList.contains(name))
+			ret = false;
+		else
+			apps[name] = m_appList[name];
+	}
+
+	// Dependencies have to be launched too, the scheduler skips ones already running
+	QStringList pending = appNames;
+	while (!pending.isEmpty())
+	{
+		QString name = pending.takeFirst();
+		if (!m_appList.contains(name))
+			continue;
+
+		for (const auto& dependency : m_appList[name]->getDependencies())
+		{
+			if (!apps.contains(dependency) && m_appList.contains(dependency))
+			{
+				apps[dependency] = m_appList[dependency];
+				pending.append(dependency);
+			}
+		}
+	}
+
+	if (!m_launchScheduler->launch(description, apps))
+		ret = false;
+
+	return ret;
+}
+
+
 // Returns false if any errors occur
 bool AppManager::stopApps(const QStringList& appNames)
 {
@@ -547,18 +693,15 @@ bool AppManager::startAppVariables(const QString & appName, const QStringList &
 
 bool AppManager::startStartupApps()
 {
-	bool ret = true;
+	QStringList appNames;
 
 	for (const auto& app : m_appList)
 	{
 		if (app->getLaunchAtStart() && !app->getRunning())
-		{
-			if (!app->start())
-				ret = false;
-		}
+			appNames.append(app->getName());
 	}
 
-	return ret;
+	return launchApps(tr("startup applications"), appNames);
 }
 
 
@@ -597,9 +740,18 @@ bool AppManager::heartbeatApp(const QString& appName) const
 }
 
 
+void AppManager::updateResourceMetrics() const
+{
+	for (const auto& app : m_appList)
+	{
+		app->updateResourceMetrics();
+	}
+}
+
+
 QSharedPointer<Application> AppManager::newApplication(const QString& name)
 {
-	QSharedPointer<Application> newApp = QSharedPointer<Application>::create(m_settings, m_globalManager, name);
+	QSharedPointer<Application> newApp = QSharedPointer<Application>::create(m_settings, m_globalManager, m_timingWheel, m_consoleCapture, name);
 	connect(newApp.data(), &Application::valueChanged,
 		this, &AppManager::appValueChanged);
 	connect(newApp.data(), &Application::requestTriggerEvents,
@@ -634,8 +786,7 @@ QByteArray AppManager::getConsoleOutputFile(const QString& appName) const
 	if (!m_appList.contains(appName))
 		return tr("No such app: '%1'").arg(appName).toUtf8();
 
-	QString outFilename = m_settings->dataDir() + SUBDIR_APPOUTPUT + appName + ".output";
-	QFile consoleOutput(outFilename);
+	QFile consoleOutput(consoleOutputFilename(appName));
 	if (!consoleOutput.open(QIODevice::ReadOnly))
 		return tr("Error opening console output file: %1").arg(consoleOutput.errorString()).toUtf8();
 
@@ -643,6 +794,39 @@ QByteArray AppManager::getConsoleOutputFile(const QString& appName) const
 }
 
 
+QByteArray AppManager::getRecentConsoleOutput(const QString& appName, int lines) const
+{
+	return m_consoleCapture->recentOutput(appName, consoleOutputFilename(appName), qMin(lines, MAX_CONSOLEFOLLOWLINES));
+}
+
+
+// New output of followed apps is sent with consoleOutput
+void AppManager::setConsoleFollowed(const QString& appName, bool followed)
+{
+	m_consoleCapture->setFollowed(appName, consoleOutputFilename(appName), followed);
+}
+
+
+// The capture file and its rotated files that aren't compressed, oldest first
+QStringList AppManager::getConsoleOutputFilenames(const QString& appName) const
+{
+	QStringList filenames;
+	for (const auto& segment : ConsoleCapture::segmentFilenames(consoleOutputFilename(appName)))
+	{
+		if (!segment.endsWith(".gz"))
+			filenames.append(segment);
+	}
+	filenames.append(consoleOutputFilename(appName));
+	return filenames;
+}
+
+
+QString AppManager::consoleOutputFilename(const QString& appName) const
+{
+	return m_settings->dataDir() + SUBDIR_APPOUTPUT + appName + ".output";
+}
+
+
 bool AppManager::executeCommand(const QByteArray& file, const QString& command, const QString& args, const QString& directory, bool capture, bool elevated, QVariant& data)
 {
 	// Can't execute elevated unless running as service
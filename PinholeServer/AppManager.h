@@ -5,10 +5,13 @@
 
 #include <QObject>
 #include <QMap>
+#include <QSet>
 #include <QTimer>
 
 class Settings;
 class GlobalManager;
+class LaunchScheduler;
+class ConsoleCapture;
 
 class AppManager : public QObject
 {
@@ -29,6 +32,7 @@ public:
 	QVariant getAppVariant(const QString& appName, const QString& propName) const;
 	bool setAppVariant(const QString& appName, const QString& propName, const QVariant& value) const;
 	bool startApps(const QStringList& appNames);
+	bool launchApps(const QString& description, const QStringList& appNames);
 	bool stopApps(const QStringList& appNames);
 	bool restartApps(const QStringList& appNames);
 	bool startAllApps();
@@ -37,7 +41,11 @@ public:
 	bool startAppVariables(const QString& appName, const QStringList& vars);
 	int runningAppCount() const;
 	bool heartbeatApp(const QString& appName) const;
+	void updateResourceMetrics() const;
 	QByteArray getConsoleOutputFile(const QString& appName) const;
+	QByteArray getRecentConsoleOutput(const QString& appName, int lines) const;
+	void setConsoleFollowed(const QString& appName, bool followed);
+	QStringList getConsoleOutputFilenames(const QString& appName) const;
 	bool executeCommand(const QByteArray& file, const QString& command, const QString& args, const QString& directory, bool capture, bool elevated, QVariant& data);
 
 signals:
@@ -45,6 +53,7 @@ signals:
 	void requestTriggerEvents(const QStringList& eventNames);
 	void requestControlWindow(int pid, const QString& display, const QString& command);
 	void generateAlert(const QString& text);
+	void consoleOutput(const QString& appName, const QByteArray& data);
 
 public slots:
 	void appValueChanged(const QString&, const QVariant&) const;
@@ -60,6 +69,9 @@ private:
 		{ PROP_APP_LASTSTARTED, { &Application::getLastStartedString, &Application::setLastStartedString } },
 		{ PROP_APP_LASTEXITED, { &Application::getLastExitedString, &Application::setLastExitedString } },
 		{ PROP_APP_STATE, { &Application::getState, &Application::setState } },
+		{ PROP_APP_CPUAFFINITY, { &Application::getCpuAffinity, &Application::setCpuAffinity } },
+		{ PROP_APP_SCHEDPOLICY, { &Application::getSchedPolicy, &Application::setSchedPolicy } },
+		{ PROP_APP_IOCLASS, { &Application::getIoClass, &Application::setIoClass } },
 	};
 
 	const std::map<QString, std::pair<std::function<bool(Application*)>, std::function<bool(Application*, bool)>>> m_appBoolCallMap =
@@ -73,6 +85,8 @@ private:
 		{ PROP_APP_LOCKUPSCREENSHOT, { &Application::getLockupScreenshot, &Application::setLockupScreenshot } },
 		{ PROP_APP_CONSOLECAPTURE, { &Application::getConsoleCapture, &Application::setConsoleCapture } },
 		{ PROP_APP_APPENDCAPTURE, { &Application::getAppendCapture, &Application::setAppendCapture } },
+		{ PROP_APP_CAPTURECOMPRESS, { &Application::getCaptureCompress, &Application::setCaptureCompress } },
+		{ PROP_APP_CGROUP, { &Application::getCgroup, &Application::setCgroup } },
 		{ PROP_APP_TCPLOOPBACK, { &Application::getTcpLoopback, &Application::setTcpLoopback } },
 		{ PROP_APP_HEARTBEATS, { &Application::getHeartbeats, &Application::setHeartbeats } },
 	};
@@ -81,19 +95,38 @@ private:
 	{
 		{ PROP_APP_LAUNCHDELAY, { &Application::getLaunchDelay, &Application::setLaunchDelay } },
 		{ PROP_APP_TCPLOOPBACKPORT, { &Application::getTcpLoopbackPort, &Application::setTcpLoopbackPort } },
+		{ PROP_APP_CAPTUREROTATESIZE, { &Application::getCaptureRotateSize, &Application::setCaptureRotateSize } },
+		{ PROP_APP_CAPTUREROTATEHOURS, { &Application::getCaptureRotateHours, &Application::setCaptureRotateHours } },
+		{ PROP_APP_CPUWEIGHT, { &Application::getCpuWeight, &Application::setCpuWeight } },
+		{ PROP_APP_CPUQUOTA, { &Application::getCpuQuota, &Application::setCpuQuota } },
+		{ PROP_APP_MEMORYHIGH, { &Application::getMemoryHigh, &Application::setMemoryHigh } },
+		{ PROP_APP_MEMORYMAX, { &Application::getMemoryMax, &Application::setMemoryMax } },
+		{ PROP_APP_IOWEIGHT, { &Application::getIoWeight, &Application::setIoWeight } },
+		{ PROP_APP_NICE, { &Application::getNice, &Application::setNice } },
+		{ PROP_APP_SCHEDPRIORITY, { &Application::getSchedPriority, &Application::setSchedPriority } },
+		{ PROP_APP_IOPRIORITY, { &Application::getIoPriority, &Application::setIoPriority } },
 		{ PROP_APP_RESTARTS, { &Application::getRestarts, nullptr } },
+		{ PROP_APP_CPUSECONDS, { &Application::getCpuSeconds, nullptr } },
+		{ PROP_APP_MEMORYUSAGE, { &Application::getMemoryUsage, nullptr } },
 	};
 
 	const std::map<QString, std::pair<std::function<QStringList(Application*)>, std::function<bool(Application*, const QStringList&)>>> m_appStringListCallMap =
 	{
 		{ PROP_APP_ENVIRONMENT, { &Application::getEnvironment, &Application::setEnvironment } },
+		{ PROP_APP_DEPENDENCIES, { &Application::getDependencies, &Application::setDependencies } },
 	};
 
 	QSharedPointer<Application> newApplication(const QString& name);
+	QString consoleOutputFilename(const QString& appName) const;
 	
 	Settings* m_settings = nullptr;
 	GlobalManager* m_globalManager = nullptr;
+	LaunchScheduler* m_launchScheduler = nullptr;
+	TimingWheel* m_timingWheel = nullptr;	// Shared by the apps' heartbeat and terminate timeouts
+	ConsoleCapture* m_consoleCapture = nullptr;	// Writes the apps' console output files
 	QMap<QString, QSharedPointer<Application>> m_appList;
+	mutable QSet<QString> m_dirtyApps;		// Apps changed since settings were last written
+	mutable bool m_appListDirty = true;		// Apps added, removed or renamed since settings were last written
 #if defined(Q_OS_LINUX)
 	bool m_rootAddedToXhost = false;
 #endif
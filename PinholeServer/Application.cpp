@@ -2,7 +2,11 @@
 #include "Settings.h"
 #include "GlobalManager.h"
 #include "UserProcess.h"
+#include "ConsoleCapture.h"
+#include "AppCgroup.h"
+#include "ProcessScheduling.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include "Values.h"
 #include "qnamedpipe.h"
 #include "../common/Utilities.h"
@@ -11,7 +15,6 @@
 #include "LinuxUtil.h"
 #endif
 
-#include <QFile>
 #include <QTcpSocket>
 #include <QTcpServer>
 
@@ -26,10 +29,13 @@ QString Application::m_display;
 #endif
 
 
-Application::Application(Settings* settings, GlobalManager* globalManager, const QString& _name)
-	: m_name(_name), m_settings(settings), m_globalManager(globalManager)
+Application::Application(Settings* settings, GlobalManager* globalManager, TimingWheel* timingWheel, ConsoleCapture* consoleCapture, const QString& _name)
+	: m_name(_name), m_settings(settings), m_globalManager(globalManager), m_outputCapture(consoleCapture),
+	m_heartbeatTimer(timingWheel, METRIC_TIMER_HEARTBEAT, [this]() { heartbeatTimeout(); }),
+	m_terminateTimer(timingWheel, METRIC_TIMER_TERMINATE, [this]() { terminateTimeout(); })
 {
 	m_process = new UserProcess(m_settings, this);
+	lookupMetrics();
 
 	setProperty(PROP_APP_NAME, m_name);
 	m_process->setProperty(PROP_APP_NAME, m_name);
@@ -45,21 +51,19 @@ Application::Application(Settings* settings, GlobalManager* globalManager, const
 		this, &Application::startProcessSlot);
 	connect(this, &Application::killProcessSignal,
 		this, &Application::killProcessSlot);
-	connect(m_process, &QProcess::readyReadStandardOutput,
-		this, &Application::readConsoleStandardOutput);
-	connect(m_process, &QProcess::readyReadStandardError,
-		this, &Application::readConsoleStandardError);
-
-	m_heartbeatTimer.setInterval(50);
-	m_heartbeatTimer.setSingleShot(false);
-	connect(&m_heartbeatTimer, &QTimer::timeout,
-		this, &Application::heartbeatTimeout);
 }
 
 
 Application::~Application()
 {
 	delete m_process;
+
+	// Anything the app started goes with it
+	if (nullptr != m_appCgroup)
+	{
+		m_appCgroup->kill();
+		delete m_appCgroup;
+	}
 }
 
 
@@ -76,6 +80,8 @@ bool Application::setName(const QString& _name)
 	m_name = _name;
 	setProperty(PROP_APP_NAME, m_name);
 	m_process->setProperty(PROP_APP_NAME, m_name);
+	updateConsoleCapture();
+	lookupMetrics();
 	return true;
 }
 
@@ -245,35 +251,447 @@ bool Application::setConsoleCapture(bool set)
 	{
 		m_consoleCapture = set;
 		emit valueChanged(PROP_APP_CONSOLECAPTURE, QVariant(m_consoleCapture));
+		updateConsoleCapture();
+	}
+	return true;
+}
+
+
+bool Application::getAppendCapture() const
+{
+	return m_appendCapture;
+}
+
+
+bool Application::setAppendCapture(bool set)
+{
+	if (m_appendCapture != set)
+	{
+		m_appendCapture = set;
+		emit valueChanged(PROP_APP_APPENDCAPTURE, QVariant(m_appendCapture));
+		updateConsoleCapture();
 	}
+	return true;
+}
+
 
-	if (getRunning())
+int Application::getCaptureRotateSize() const
+{
+	return m_captureRotateSize;
+}
+
+
+bool Application::setCaptureRotateSize(int val)
+{
+	if (m_captureRotateSize != val)
 	{
-		if (set)
+		if (val < 0 || val > MAX_CAPTUREROTATESIZE)
 		{
-			openConsoleOutputFile();
+			Logger(LOG_EXTRA) << tr("Invalid capture rotate size value '%1'").arg(val);
+			emit valueChanged(PROP_APP_CAPTUREROTATESIZE, QVariant(m_captureRotateSize));
+			return false;
 		}
-		else
+		m_captureRotateSize = val;
+		emit valueChanged(PROP_APP_CAPTUREROTATESIZE, QVariant(m_captureRotateSize));
+		updateConsoleCapture();
+	}
+	return true;
+}
+
+
+int Application::getCaptureRotateHours() const
+{
+	return m_captureRotateHours;
+}
+
+
+bool Application::setCaptureRotateHours(int val)
+{
+	if (m_captureRotateHours != val)
+	{
+		if (val < 0 || val > MAX_CAPTUREROTATEHOURS)
 		{
-			closeConsoleOutputFile();
+			Logger(LOG_EXTRA) << tr("Invalid capture rotate hours value '%1'").arg(val);
+			emit valueChanged(PROP_APP_CAPTUREROTATEHOURS, QVariant(m_captureRotateHours));
+			return false;
 		}
+		m_captureRotateHours = val;
+		emit valueChanged(PROP_APP_CAPTUREROTATEHOURS, QVariant(m_captureRotateHours));
+		updateConsoleCapture();
 	}
 	return true;
 }
 
 
-bool Application::getAppendCapture() const
+bool Application::getCaptureCompress() const
 {
-	return m_appendCapture;
+	return m_captureCompress;
 }
 
 
-bool Application::setAppendCapture(bool set)
+bool Application::setCaptureCompress(bool set)
 {
-	if (m_appendCapture != set)
+	if (m_captureCompress != set)
 	{
-		m_appendCapture = set;
-		emit valueChanged(PROP_APP_APPENDCAPTURE, QVariant(m_appendCapture));
+		m_captureCompress = set;
+		emit valueChanged(PROP_APP_CAPTURECOMPRESS, QVariant(m_captureCompress));
+		updateConsoleCapture();
+	}
+	return true;
+}
+
+
+bool Application::getCgroup() const
+{
+	return m_cgroup;
+}
+
+
+bool Application::setCgroup(bool set)
+{
+	if (m_cgroup != set)
+	{
+		m_cgroup = set;
+		emit valueChanged(PROP_APP_CGROUP, QVariant(m_cgroup));
+	}
+	return true;
+}
+
+
+int Application::getCpuWeight() const
+{
+	return m_cpuWeight;
+}
+
+
+bool Application::setCpuWeight(int val)
+{
+	if (m_cpuWeight != val)
+	{
+		if (val < 0 || val > MAX_CGROUPWEIGHT)
+		{
+			Logger(LOG_EXTRA) << tr("Invalid CPU weight value '%1'").arg(val);
+			emit valueChanged(PROP_APP_CPUWEIGHT, QVariant(m_cpuWeight));
+			return false;
+		}
+		m_cpuWeight = val;
+		emit valueChanged(PROP_APP_CPUWEIGHT, QVariant(m_cpuWeight));
+		updateCgroupLimits();
+	}
+	return true;
+}
+
+
+int Application::getCpuQuota() const
+{
+	return m_cpuQuota;
+}
+
+
+bool Application::setCpuQuota(int val)
+{
+	if (m_cpuQuota != val)
+	{
+		if (val < 0 || val > MAX_CPUQUOTA)
+		{
+			Logger(LOG_EXTRA) << tr("Invalid CPU quota value '%1'").arg(val);
+			emit valueChanged(PROP_APP_CPUQUOTA, QVariant(m_cpuQuota));
+			return false;
+		}
+		m_cpuQuota = val;
+		emit valueChanged(PROP_APP_CPUQUOTA, QVariant(m_cpuQuota));
+		updateCgroupLimits();
+	}
+	return true;
+}
+
+
+int Application::getMemoryHigh() const
+{
+	return m_memoryHigh;
+}
+
+
+bool Application::setMemoryHigh(int val)
+{
+	if (m_memoryHigh != val)
+	{
+		if (val < 0 || val > MAX_APPMEMORY)
+		{
+			Logger(LOG_EXTRA) << tr("Invalid memory high value '%1'").arg(val);
+			emit valueChanged(PROP_APP_MEMORYHIGH, QVariant(m_memoryHigh));
+			return false;
+		}
+		m_memoryHigh = val;
+		emit valueChanged(PROP_APP_MEMORYHIGH, QVariant(m_memoryHigh));
+		updateCgroupLimits();
+	}
+	return true;
+}
+
+
+int Application::getMemoryMax() const
+{
+	return m_memoryMax;
+}
+
+
+bool Application::setMemoryMax(int val)
+{
+	if (m_memoryMax != val)
+	{
+		if (val < 0 || val > MAX_APPMEMORY)
+		{
+			Logger(LOG_EXTRA) << tr("Invalid memory max value '%1'").arg(val);
+			emit valueChanged(PROP_APP_MEMORYMAX, QVariant(m_memoryMax));
+			return false;
+		}
+		m_memoryMax = val;
+		emit valueChanged(PROP_APP_MEMORYMAX, QVariant(m_memoryMax));
+		updateCgroupLimits();
+	}
+	return true;
+}
+
+
+int Application::getIoWeight() const
+{
+	return m_ioWeight;
+}
+
+
+bool Application::setIoWeight(int val)
+{
+	if (m_ioWeight != val)
+	{
+		if (val < 0 || val > MAX_CGROUPWEIGHT)
+		{
+			Logger(LOG_EXTRA) << tr("Invalid IO weight value '%1'").arg(val);
+			emit valueChanged(PROP_APP_IOWEIGHT, QVariant(m_ioWeight));
+			return false;
+		}
+		m_ioWeight = val;
+		emit valueChanged(PROP_APP_IOWEIGHT, QVariant(m_ioWeight));
+		updateCgroupLimits();
+	}
+	return true;
+}
+
+
+QString Application::getCpuAffinity() const
+{
+	return m_cpuAffinity;
+}
+
+
+bool Application::setCpuAffinity(const QString& str)
+{
+	if (m_cpuAffinity != str)
+	{
+		QList<int> cpus;
+		if (!ProcessScheduling::parseCpuList(str, &cpus))
+		{
+			Logger(LOG_EXTRA) << tr("Invalid CPU affinity value '%1'").arg(str);
+			emit valueChanged(PROP_APP_CPUAFFINITY, QVariant(m_cpuAffinity));
+			return false;
+		}
+		if (!ProcessScheduling::permittedCpus(cpus))
+		{
+			Logger(LOG_WARNING) << tr("App %1: CPU affinity '%2' has CPUs Pinhole may not run on")
+				.arg(m_name)
+				.arg(str);
+			emit valueChanged(PROP_APP_CPUAFFINITY, QVariant(m_cpuAffinity));
+			return false;
+		}
+		m_cpuAffinity = str;
+		emit valueChanged(PROP_APP_CPUAFFINITY, QVariant(m_cpuAffinity));
+	}
+	return true;
+}
+
+
+int Application::getNice() const
+{
+	return m_nice;
+}
+
+
+bool Application::setNice(int val)
+{
+	if (m_nice != val)
+	{
+		if (val < MIN_NICE || val > MAX_NICE)
+		{
+			Logger(LOG_EXTRA) << tr("Invalid nice value '%1'").arg(val);
+			emit valueChanged(PROP_APP_NICE, QVariant(m_nice));
+			return false;
+		}
+		if (!ProcessScheduling::permittedNice(val))
+		{
+			Logger(LOG_WARNING) << tr("App %1: Pinhole is not permitted to set nice value %2")
+				.arg(m_name)
+				.arg(val);
+			emit valueChanged(PROP_APP_NICE, QVariant(m_nice));
+			return false;
+		}
+		m_nice = val;
+		emit valueChanged(PROP_APP_NICE, QVariant(m_nice));
+	}
+	return true;
+}
+
+
+QString Application::getSchedPolicy() const
+{
+	return m_schedPolicy;
+}
+
+
+bool Application::setSchedPolicy(const QString& str)
+{
+	if (m_schedPolicy != str)
+	{
+		if (!validSchedPolicy.contains(str))
+		{
+			Logger(LOG_EXTRA) << tr("Invalid scheduling policy value '%1'").arg(str);
+			emit valueChanged(PROP_APP_SCHEDPOLICY, QVariant(m_schedPolicy));
+			return false;
+		}
+		if (!ProcessScheduling::permittedPolicy(str, m_schedPriority))
+		{
+			Logger(LOG_WARNING) << tr("App %1: Pinhole is not permitted to set scheduling policy %2 with priority %3")
+				.arg(m_name)
+				.arg(str)
+				.arg(m_schedPriority);
+			emit valueChanged(PROP_APP_SCHEDPOLICY, QVariant(m_schedPolicy));
+			return false;
+		}
+		m_schedPolicy = str;
+		emit valueChanged(PROP_APP_SCHEDPOLICY, QVariant(m_schedPolicy));
+	}
+	return true;
+}
+
+
+int Application::getSchedPriority() const
+{
+	return m_schedPriority;
+}
+
+
+bool Application::setSchedPriority(int val)
+{
+	if (m_schedPriority != val)
+	{
+		if (val < 0 || val > MAX_SCHEDPRIORITY)
+		{
+			Logger(LOG_EXTRA) << tr("Invalid scheduling priority value '%1'").arg(val);
+			emit valueChanged(PROP_APP_SCHEDPRIORITY, QVariant(m_schedPriority));
+			return false;
+		}
+		if (!ProcessScheduling::permittedPolicy(m_schedPolicy, val))
+		{
+			Logger(LOG_WARNING) << tr("App %1: Pinhole is not permitted to set scheduling policy %2 with priority %3")
+				.arg(m_name)
+				.arg(m_schedPolicy)
+				.arg(val);
+			emit valueChanged(PROP_APP_SCHEDPRIORITY, QVariant(m_schedPriority));
+			return false;
+		}
+		m_schedPriority = val;
+		emit valueChanged(PROP_APP_SCHEDPRIORITY, QVariant(m_schedPriority));
+	}
+	return true;
+}
+
+
+// Policy and priority together, for loading saved settings where checking each
+// against the other's previous value would let a realtime policy through with
+// a priority it isn't permitted
+bool Application::setScheduling(const QString& policy, int priority)
+{
+	if (!validSchedPolicy.contains(policy))
+	{
+		Logger(LOG_EXTRA) << tr("Invalid scheduling policy value '%1'").arg(policy);
+		return false;
+	}
+	if (priority < 0 || priority > MAX_SCHEDPRIORITY)
+	{
+		Logger(LOG_EXTRA) << tr("Invalid scheduling priority value '%1'").arg(priority);
+		return false;
+	}
+	if (!ProcessScheduling::permittedPolicy(policy, priority))
+	{
+		Logger(LOG_WARNING) << tr("App %1: Pinhole is not permitted to set scheduling policy %2 with priority %3")
+			.arg(m_name)
+			.arg(policy)
+			.arg(priority);
+		return false;
+	}
+
+	if (m_schedPolicy != policy)
+	{
+		m_schedPolicy = policy;
+		emit valueChanged(PROP_APP_SCHEDPOLICY, QVariant(m_schedPolicy));
+	}
+	if (m_schedPriority != priority)
+	{
+		m_schedPriority = priority;
+		emit valueChanged(PROP_APP_SCHEDPRIORITY, QVariant(m_schedPriority));
+	}
+	return true;
+}
+
+
+QString Application::getIoClass() const
+{
+	return m_ioClass;
+}
+
+
+bool Application::setIoClass(const QString& str)
+{
+	if (m_ioClass != str)
+	{
+		if (!validIoClass.contains(str))
+		{
+			Logger(LOG_EXTRA) << tr("Invalid IO class value '%1'").arg(str);
+			emit valueChanged(PROP_APP_IOCLASS, QVariant(m_ioClass));
+			return false;
+		}
+		if (!ProcessScheduling::permittedIoClass(str))
+		{
+			Logger(LOG_WARNING) << tr("App %1: Pinhole is not permitted to set IO class %2")
+				.arg(m_name)
+				.arg(str);
+			emit valueChanged(PROP_APP_IOCLASS, QVariant(m_ioClass));
+			return false;
+		}
+		m_ioClass = str;
+		emit valueChanged(PROP_APP_IOCLASS, QVariant(m_ioClass));
+	}
+	return true;
+}
+
+
+int Application::getIoPriority() const
+{
+	return m_ioPriority;
+}
+
+
+bool Application::setIoPriority(int val)
+{
+	if (m_ioPriority != val)
+	{
+		if (val < 0 || val > MAX_IOPRIORITY)
+		{
+			Logger(LOG_EXTRA) << tr("Invalid IO priority value '%1'").arg(val);
+			emit valueChanged(PROP_APP_IOPRIORITY, QVariant(m_ioPriority));
+			return false;
+		}
+		m_ioPriority = val;
+		emit valueChanged(PROP_APP_IOPRIORITY, QVariant(m_ioPriority));
 	}
 	return true;
 }
@@ -395,7 +813,7 @@ bool Application::setHeartbeats(bool b)
 	{
 		m_heartbeats = b;
 		emit valueChanged(PROP_APP_HEARTBEATS, QVariant(m_heartbeats));
-		m_lastHeartbeat = QDateTime::currentDateTime();
+		m_lastHeartbeat = MonotonicTime::now();
 	}
 	return true;
 }
@@ -418,6 +836,29 @@ bool Application::setEnvironment(const QStringList& list)
 }
 
 
+QStringList Application::getDependencies() const
+{
+	return m_dependencies;
+}
+
+
+bool Application::setDependencies(const QStringList& list)
+{
+	if (m_dependencies != list)
+	{
+		if (list.contains(m_name))
+		{
+			Logger(LOG_EXTRA) << tr("App %1: Application can't depend on itself").arg(m_name);
+			emit valueChanged(PROP_APP_DEPENDENCIES, QVariant(m_dependencies));
+			return false;
+		}
+		m_dependencies = list;
+		emit valueChanged(PROP_APP_DEPENDENCIES, QVariant(m_dependencies));
+	}
+	return true;
+}
+
+
 QDateTime Application::getLastStarted() const
 { 
 	return m_lastStarted;
@@ -497,11 +938,19 @@ bool Application::getRunning() const
 bool Application::setRunning(bool b)
 {
 	m_running = b;
+	if (!m_running)
+		m_ready = false;
 	emit valueChanged(PROP_APP_RUNNING, QVariant(m_running));
 	return true;
 }
 
 
+bool Application::getReady() const
+{
+	return m_ready;
+}
+
+
 int Application::getRestarts() const
 { 
 	return m_restarts;
@@ -512,6 +961,7 @@ void Application::incrementRestarts()
 {
 	m_restarts++;
 	emit valueChanged(PROP_APP_RESTARTS, QVariant(m_restarts));
+	m_restartsMetric->increment();
 }
 
 
@@ -521,6 +971,37 @@ int Application::getLastExitCode() const
 }
 
 
+// CPU time used by the app and everything it started since it was last started, 0 if it wasn't contained
+int Application::getCpuSeconds() const
+{
+	if (nullptr == m_appCgroup)
+		return 0;
+
+	return static_cast<int>((m_appCgroup->cpuUsage() - m_cpuUsageAtStart) / 1000000);
+}
+
+
+// Megabytes of memory used by the app and everything it started, 0 if it isn't contained
+int Application::getMemoryUsage() const
+{
+	if (nullptr == m_appCgroup)
+		return 0;
+
+	return static_cast<int>(m_appCgroup->memoryCurrent() / 1048576);
+}
+
+
+// The cgroup's accounting is read when metrics are exported rather than polled
+void Application::updateResourceMetrics() const
+{
+	if (nullptr == m_appCgroup)
+		return;
+
+	m_cpuMetric->set((m_appCgroup->cpuUsage() - m_cpuUsageAtStart) / 1000000);
+	m_memoryMetric->set(m_appCgroup->memoryCurrent());
+}
+
+
 bool Application::start(const QStringList& replacementVars)
 {
 	Logger() << tr("App %1: Starting application").arg(m_name);
@@ -676,14 +1157,6 @@ bool Application::start(const QStringList& replacementVars)
 	replaceEnvironmentStrings(tmpArguments, procEnv);
 	m_process->setArguments(SplitCommandLine(tmpArguments));
 
-	if (m_consoleCapture)
-	{
-		Logger(LOG_DEBUG) << tr("App %1: Opening console output file")
-			.arg(m_name);
-
-		openConsoleOutputFile();
-	}
-
 #if defined(Q_OS_WIN)
 
 	m_process->setCreateProcessArgumentsModifier([this](QProcess::CreateProcessArguments *args)
@@ -766,9 +1239,34 @@ void Application::processStarted()
 	Logger(LOG_EXTRA) << tr("App %1: Application started")
 		.arg(m_name);
 
+	if (nullptr != m_appCgroup && !m_appCgroup->processes().contains(static_cast<quint32>(m_process->processId())))
+	{
+		Logger(LOG_WARNING) << tr("App %1: Application did not join its cgroup, it runs without resource limits")
+			.arg(m_name);
+		delete m_appCgroup;
+		m_appCgroup = nullptr;
+	}
+
+	QStringList notApplied = m_process->scheduling().notApplied(m_process->processId());
+	if (!notApplied.isEmpty())
+	{
+		Logger(LOG_WARNING) << tr("App %1: Application runs without the scheduling settings %2")
+			.arg(m_name)
+			.arg(notApplied.join(", "));
+	}
+
 	setLastStarted(QDateTime::currentDateTime());
+	m_startsMetric->increment();
+
+	m_lastHeartbeat = MonotonicTime::now();
 
-	m_lastHeartbeat = QDateTime::currentDateTime();
+	// Apps that send heartbeats are ready once they send the first one,
+	// there's nothing else to wait for with the rest
+	if (!m_heartbeats)
+	{
+		m_ready = true;
+		emit applicationReady();
+	}
 
 	Logger(LOG_DEBUG) << tr("App %1: Starting logging pipe %2")
 		.arg(m_name)
@@ -862,8 +1360,22 @@ void Application::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
 	QDateTime now = QDateTime::currentDateTime();
 	setLastExited(now);
 
-	// Close console output file
-	closeConsoleOutputFile();
+#if defined(Q_OS_LINUX)
+	// Anything the app wrote last is written out before the capture channel closes
+	if (0 != m_captureChannel)
+	{
+		m_outputCapture->closeChannel(m_captureChannel);
+		m_captureChannel = 0;
+	}
+#endif
+
+	// Processes the app started don't outlive it when it runs in a cgroup
+	if (nullptr != m_appCgroup && !m_appCgroup->processes().isEmpty())
+	{
+		Logger(LOG_EXTRA) << tr("App %1: Killing processes left in the application's cgroup")
+			.arg(m_name);
+		m_appCgroup->kill();
+	}
 
 	QString runtimeString = MillisecondsToString(getLastStarted().msecsTo(now));
 
@@ -892,6 +1404,7 @@ void Application::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
 			.arg(exitCode)
 			.arg(QtEnumToString(exitStatus))
 			.arg(runtimeString);
+		m_crashesMetric->increment();
 
 		if (m_keepAppRunning)
 		{
@@ -928,7 +1441,28 @@ void Application::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
 
 void Application::processError(QProcess::ProcessError error)
 {
-	if (!m_exitExpected)
+	if (QProcess::FailedToStart == error)
+	{
+		// processFinished never runs for a process that didn't start, so this is the app's exit
+		Logger(LOG_WARNING) << tr("App %1: Application failed to start: %2")
+			.arg(m_name)
+			.arg(m_process->errorString());
+
+#if defined(Q_OS_LINUX)
+		if (0 != m_captureChannel)
+		{
+			m_outputCapture->closeChannel(m_captureChannel);
+			m_captureChannel = 0;
+		}
+#endif
+		m_exitExpected = false;
+		m_terminateTimer.stop();
+		m_heartbeatTimer.stop();
+		m_tcpServer.clear();
+		setRunning(false);
+		emit applicationExited();
+	}
+	else if (!m_exitExpected)
 	{
 		Logger(LOG_WARNING) << tr("App %1: Application process error %2")
 			.arg(m_name)
@@ -943,7 +1477,19 @@ void Application::startProcessSlot()
 		.arg(m_name)
 		.arg(m_process->program());
 
+	setupConsoleCapture();
+	setupCgroup();
+
+	// Set again at every start, so restarts pick up changes too
+	ProcessScheduling scheduling;
+	scheduling.set(m_cpuAffinity, m_nice, m_schedPolicy, m_schedPriority, m_ioClass, m_ioPriority);
+	m_process->setScheduling(scheduling);
+
 	m_process->start();
+#if defined(Q_OS_LINUX)
+	m_process->closeCaptureFd();
+	m_process->closeCgroupFd();
+#endif
 }
 
 
@@ -957,26 +1503,26 @@ void Application::killProcessSlot(bool restart)
 		Logger(LOG_DEBUG) << tr("App %1: Process soft kill application").arg(m_name);
 
 		m_process->terminate();
-		int timeout = m_globalManager->getAppTerminateTimeout();
-		m_terminateTimer.setInterval(timeout);
-		m_terminateTimer.setSingleShot(true);
-		connect(&m_terminateTimer, &QTimer::timeout,
-			this, [this, timeout]()
-		{
-			Logger(LOG_EXTRA) << tr("App %1: Process did not terminate gracefully after waiting %2 ms, forcing termination").arg(m_name).arg(timeout);
-			m_process->kill();
-		});
-		m_terminateTimer.start();
+		m_terminateTimer.start(m_globalManager->getAppTerminateTimeout());
 	}
 	else
 	{
 		Logger(LOG_DEBUG) << tr("App %1: Process kill application").arg(m_name);
 
-		m_process->kill();
+		killProcessTree();
 	}
 }
 
 
+void Application::terminateTimeout()
+{
+	Logger(LOG_EXTRA) << tr("App %1: Process did not terminate gracefully after waiting %2 ms, forcing termination")
+		.arg(m_name)
+		.arg(m_globalManager->getAppTerminateTimeout());
+	killProcessTree();
+}
+
+
 void Application::processStateChanged(QProcess::ProcessState newState)
 {
 	Logger(LOG_DEBUG) << tr("App %1: Process state change: %2")
@@ -1095,20 +1641,29 @@ void Application::setupLoopback()
 			Logger(LOG_WARNING) << tr("Global app heartbeat timer value set to ") << m_globalManager->getAppHeartbeatTimeout();
 		}
 
-		m_heartbeatTimer.start();
+		startHeartbeatTimer();
 	}
 }
 
 
+void Application::startHeartbeatTimer()
+{
+	// Give a full timeout if it has already passed, such as after a timeout was handled
+	qint64 timeout = m_globalManager->getAppHeartbeatTimeout();
+	qint64 remaining = timeout - m_lastHeartbeat.elapsed();
+	m_heartbeatTimer.start(remaining > 0 ? remaining : timeout);
+}
+
+
 void Application::heartbeatTimeout()
 {
-	QDateTime now = QDateTime::currentDateTime();
 	if (m_running && m_heartbeats &&
-		m_lastHeartbeat.msecsTo(now) > m_globalManager->getAppHeartbeatTimeout())
+		m_lastHeartbeat.elapsed() > m_globalManager->getAppHeartbeatTimeout())
 	{
 		// heartbeat timeout
 		Logger(LOG_WARNING) << tr("App %1: heartbeat timeout ").arg(m_name) <<
 			m_globalManager->getAppHeartbeatTimeout() << " ms";
+		m_heartbeatTimeoutsMetric->increment();
 
 		bool restartApp = m_keepAppRunning;
 
@@ -1135,6 +1690,7 @@ void Application::heartbeatTimeout()
 		{
 			// Stop or restart app
 			stop(restartApp);
+			startHeartbeatTimer();
 		}
 		else
 		{
@@ -1162,7 +1718,7 @@ void Application::heartbeatTimeout()
 					.arg(reason);
 				stop(restartApp);
 				hostClient->deleteLater();
-				m_heartbeatTimer.start();
+				startHeartbeatTimer();
 			});
 
 			connect(hostClient, &HostClient::commandError,
@@ -1171,7 +1727,7 @@ void Application::heartbeatTimeout()
 				Logger(LOG_WARNING) << tr("App %1: Failed to aquire screenshot (command error, helper not running?)").arg(m_name);
 				stop(restartApp);
 				hostClient->deleteLater();
-				m_heartbeatTimer.start();
+				startHeartbeatTimer();
 			});
 
 			connect(hostClient, &HostClient::commandData,
@@ -1202,17 +1758,31 @@ void Application::heartbeatTimeout()
 
 				stop(restartApp);
 				hostClient->deleteLater();
-				m_heartbeatTimer.start();
+				startHeartbeatTimer();
 			});
 		}
 	}
+	else
+	{
+		// Not timed out, such as the timeout setting was made longer
+		startHeartbeatTimer();
+	}
 }
 
 
 void Application::heartbeat()
 {
-	m_lastHeartbeat = QDateTime::currentDateTime();
+	m_lastHeartbeat = MonotonicTime::now();
+	if (m_heartbeatTimer.isActive())
+		startHeartbeatTimer();
 	Logger(LOG_DEBUG) << tr("App %1: heartbeat received").arg(m_name);
+
+	if (!m_ready && m_running)
+	{
+		Logger(LOG_EXTRA) << tr("App %1: Application ready").arg(m_name);
+		m_ready = true;
+		emit applicationReady();
+	}
 }
 
 
@@ -1292,54 +1862,143 @@ void Application::replaceVariableStrings(QString & str, const QMap<QString, QStr
 }
 
 
-void Application::readConsoleStandardOutput()
+CaptureConfig Application::captureConfig() const
+{
+	CaptureConfig config;
+	config.name = m_name;
+	config.filename = m_settings->dataDir() + SUBDIR_APPOUTPUT + m_name + ".output";
+	config.enabled = m_consoleCapture;
+	config.append = m_appendCapture;
+	config.rotateSize = static_cast<qint64>(m_captureRotateSize) * 1048576;
+	config.rotatePeriod = static_cast<qint64>(m_captureRotateHours) * 3600000;
+	config.compress = m_captureCompress;
+	return config;
+}
+
+
+// The app's stdout and stderr go straight to its capture file, or nowhere when
+// not capturing, so the output is never read into the server
+void Application::setupConsoleCapture()
 {
-	if (m_consoleCapture && m_consoleOutputFile != nullptr)
+#if defined(Q_OS_LINUX)
+	// The capture thread splices the pipe into the file and can start and stop
+	// capturing or rotate the file while the app runs
+	int childFd = -1;
+	m_captureChannel = m_outputCapture->openChannel(captureConfig(), childFd);
+	if (0 != m_captureChannel)
+	{
+		m_process->setProcessChannelMode(QProcess::ForwardedChannels);
+		m_process->setCaptureFd(childFd);
+		return;
+	}
+#endif
+
+	// Elsewhere the app writes the file itself so changes apply from the next start
+	m_process->setProcessChannelMode(QProcess::MergedChannels);
+	if (m_consoleCapture)
+	{
+		CaptureConfig config = captureConfig();
+		ConsoleCapture::prepareFile(config, m_appendCapture);
+		m_process->setStandardOutputFile(config.filename, QIODevice::Append);
+	}
+	else
 	{
-		m_consoleOutputFile->write(m_process->readAllStandardOutput());
-		m_consoleOutputFile->flush();
+		m_process->setStandardOutputFile(QProcess::nullDevice());
 	}
 }
 
 
-void Application::readConsoleStandardError()
+// Kept so counting an event doesn't look the metric up every time
+void Application::lookupMetrics()
+{
+	QString labels = Metrics::label("app", m_name);
+	m_startsMetric = Metrics::counter(METRIC_APP_STARTS, labels);
+	m_crashesMetric = Metrics::counter(METRIC_APP_CRASHES, labels);
+	m_restartsMetric = Metrics::counter(METRIC_APP_RESTARTS, labels);
+	m_heartbeatTimeoutsMetric = Metrics::counter(METRIC_APP_HEARTBEATTIMEOUTS, labels);
+	m_cpuMetric = Metrics::gauge(METRIC_APP_CPU, labels);
+	m_memoryMetric = Metrics::gauge(METRIC_APP_MEMORY, labels);
+}
+
+
+void Application::updateConsoleCapture()
 {
-	if (m_consoleCapture && m_consoleOutputFile != nullptr)
+#if defined(Q_OS_LINUX)
+	if (0 != m_captureChannel)
 	{
-		m_consoleOutputFile->write(m_process->readAllStandardError());
-		m_consoleOutputFile->flush();
+		m_outputCapture->configureChannel(m_captureChannel, captureConfig());
 	}
+#endif
+}
+
+
+CgroupLimits Application::cgroupLimits() const
+{
+	CgroupLimits limits;
+	limits.cpuWeight = m_cpuWeight;
+	limits.cpuQuota = m_cpuQuota;
+	limits.memoryHigh = m_memoryHigh;
+	limits.memoryMax = m_memoryMax;
+	limits.ioWeight = m_ioWeight;
+	return limits;
 }
 
 
-void Application::openConsoleOutputFile()
+// Gets the app's cgroup ready for the process about to start. Turning the
+// cgroup on or off and renaming the app take effect from the next start.
+void Application::setupCgroup()
 {
-	QString outFilename = m_settings->dataDir() + SUBDIR_APPOUTPUT + m_name + ".output";
-	m_consoleOutputFile = new QFile(outFilename, this);
-	QIODevice::OpenMode mode = QIODevice::WriteOnly;
-	if (m_appendCapture)
-		mode |= QIODevice::Append;
-	if (!m_consoleOutputFile->open(mode))
+	if (nullptr != m_appCgroup && (!m_cgroup || m_appCgroup->appName() != m_name))
 	{
-		Logger(LOG_ERROR) << tr("App %1: Error creating console output file '%2': '%3'")
-			.arg(m_name)
-			.arg(outFilename)
-			.arg(m_consoleOutputFile->errorString());
+		delete m_appCgroup;
+		m_appCgroup = nullptr;
+	}
+
+	if (!m_cgroup || !AppCgroup::available())
+		return;
+
+	if (nullptr == m_appCgroup)
+	{
+		m_appCgroup = new AppCgroup(m_name);
+		if (!m_appCgroup->create(cgroupLimits()))
+		{
+			delete m_appCgroup;
+			m_appCgroup = nullptr;
+			return;
+		}
+	}
+	else
+	{
+		m_appCgroup->applyLimits(cgroupLimits());
 	}
+
+	m_cpuUsageAtStart = m_appCgroup->cpuUsage();
+#if defined(Q_OS_LINUX)
+	m_process->setCgroupFd(m_appCgroup->openProcs());
+#endif
 }
 
 
-void Application::closeConsoleOutputFile()
+// Limits apply to the running app straight away
+void Application::updateCgroupLimits()
 {
-	if (nullptr != m_consoleOutputFile)
+	if (nullptr != m_appCgroup && m_running)
 	{
-		m_consoleOutputFile->close();
-		delete m_consoleOutputFile;
-		m_consoleOutputFile = nullptr;
+		m_appCgroup->applyLimits(cgroupLimits());
 	}
 }
 
 
+// Kills the app's process, and everything it started when it runs in a cgroup
+void Application::killProcessTree()
+{
+	if (nullptr != m_appCgroup && m_appCgroup->kill())
+		return;
+
+	m_process->kill();
+}
+
+
 void Application::setupUserProcessEnvironment(QProcessEnvironment& procEnv, bool noGui, bool elevated)
 {
 #if defined(Q_OS_WIN)
@@ -1,26 +1,33 @@
 #pragma once
 
 #include "TimePeriodCount.h"
+#include "TimingWheel.h"
 #include "../common/PinholeCommon.h"
 
 #include <QObject>
 #include <QSharedPointer>
 #include <QTimer>
 #include <QProcess>
+#include <QDateTime>
 
 class Settings;
 class GlobalManager;
 class UserProcess;
+class ConsoleCapture;
+struct CaptureConfig;
+class AppCgroup;
+struct CgroupLimits;
+class MetricCounter;
+class MetricGauge;
 class QTcpServer;
 class QNamedPipe;
-class QFile;
 
 class Application : public QObject
 {
 	Q_OBJECT
 
 public:
-	Application(Settings* settings, GlobalManager* globalManager, const QString& _name);
+	Application(Settings* settings, GlobalManager* globalManager, TimingWheel* timingWheel, ConsoleCapture* consoleCapture, const QString& _name);
 	~Application();
 
 	QString getName() const;
@@ -47,6 +54,37 @@ public:
 	bool setConsoleCapture(bool set);
 	bool getAppendCapture() const;
 	bool setAppendCapture(bool set);
+	int getCaptureRotateSize() const;
+	bool setCaptureRotateSize(int val);
+	int getCaptureRotateHours() const;
+	bool setCaptureRotateHours(int val);
+	bool getCaptureCompress() const;
+	bool setCaptureCompress(bool set);
+	bool getCgroup() const;
+	bool setCgroup(bool set);
+	int getCpuWeight() const;
+	bool setCpuWeight(int val);
+	int getCpuQuota() const;
+	bool setCpuQuota(int val);
+	int getMemoryHigh() const;
+	bool setMemoryHigh(int val);
+	int getMemoryMax() const;
+	bool setMemoryMax(int val);
+	int getIoWeight() const;
+	bool setIoWeight(int val);
+	QString getCpuAffinity() const;
+	bool setCpuAffinity(const QString& str);
+	int getNice() const;
+	bool setNice(int val);
+	QString getSchedPolicy() const;
+	bool setSchedPolicy(const QString& str);
+	int getSchedPriority() const;
+	bool setSchedPriority(int val);
+	bool setScheduling(const QString& policy, int priority);
+	QString getIoClass() const;
+	bool setIoClass(const QString& str);
+	int getIoPriority() const;
+	bool setIoPriority(int val);
 	QString getLaunchDisplay() const;
 	bool setLaunchDisplay(QString val);
 	int getLaunchDelay() const;
@@ -59,6 +97,8 @@ public:
 	bool setHeartbeats(bool b);
 	QStringList getEnvironment() const;
 	bool setEnvironment(const QStringList& _environment);
+	QStringList getDependencies() const;
+	bool setDependencies(const QStringList& _dependencies);
 
 	QDateTime getLastStarted() const;
 	bool setLastStarted(QDateTime time);
@@ -72,19 +112,21 @@ public:
 	bool setState(const QString& str);
 	bool getRunning() const;
 	bool setRunning(bool b);
+	bool getReady() const;
 
 	int getRestarts() const;
 	void incrementRestarts();
 	int getLastExitCode() const;
+	int getCpuSeconds() const;
+	int getMemoryUsage() const;
 
 	QString logPipeName(bool full) const;
 	
 	bool start(const QStringList& replacementVars = {});
 	bool stop(bool restart = false);
-	void openConsoleOutputFile();
-	void closeConsoleOutputFile();
 
 	void heartbeat();
+	void updateResourceMetrics() const;
 
 	static void setupUserProcessEnvironment(QProcessEnvironment& procEnv, bool noGui, bool elevated);
 
@@ -97,8 +139,6 @@ public slots:
 	void killProcessSlot(bool restart);
 	void applicationDataReceive();
 	void heartbeatTimeout();
-	void readConsoleStandardOutput();
-	void readConsoleStandardError();
 
 signals:
 	void startProcessSignal();
@@ -108,10 +148,21 @@ signals:
 	void requestControlWindow(int pid, const QString& display, const QString& command);
 	void generateAlert(const QString& text);
 	void applicationExited();
+	void applicationReady();
 
 private:
 	void setupLoopback();
 	void setupHeartbeats();
+	void startHeartbeatTimer();
+	void terminateTimeout();
+	CaptureConfig captureConfig() const;
+	void setupConsoleCapture();
+	void updateConsoleCapture();
+	CgroupLimits cgroupLimits() const;
+	void setupCgroup();
+	void updateCgroupLimits();
+	void killProcessTree();
+	void lookupMetrics();
 	void replaceEnvironmentStrings(QString& str, const QProcessEnvironment& env) const;
 	void replaceVariableStrings(QString& str, const QMap<QString, QString>& vars) const;
 
@@ -123,6 +174,23 @@ private:
 		DISPLAY_MAXIMIZE
 	};
 
+	const QStringList validSchedPolicy =
+	{
+		SCHEDPOLICY_NORMAL,
+		SCHEDPOLICY_BATCH,
+		SCHEDPOLICY_IDLE,
+		SCHEDPOLICY_FIFO,
+		SCHEDPOLICY_RR
+	};
+
+	const QStringList validIoClass =
+	{
+		IOCLASS_NONE,
+		IOCLASS_REALTIME,
+		IOCLASS_BESTEFFORT,
+		IOCLASS_IDLE
+	};
+
 	// Settable properties saved to file
 	QString m_name = "";
 	QString m_executable = "";
@@ -136,37 +204,63 @@ private:
 	bool m_lockupScreenshot = false;
 	bool m_consoleCapture = false;
 	bool m_appendCapture = false;
+	int m_captureRotateSize = 0;		// Megabytes
+	int m_captureRotateHours = 0;
+	bool m_captureCompress = false;
+	bool m_cgroup = false;
+	int m_cpuWeight = 0;				// 0 for the kernel default
+	int m_cpuQuota = 0;					// Percent of one CPU, 0 for no quota
+	int m_memoryHigh = 0;				// Megabytes, 0 for no limit
+	int m_memoryMax = 0;				// Megabytes, 0 for no limit
+	int m_ioWeight = 0;					// 0 for the kernel default
+	QString m_cpuAffinity;				// CPU list like "0-3,6", empty for every CPU
+	int m_nice = 0;
+	QString m_schedPolicy = SCHEDPOLICY_NORMAL;
+	int m_schedPriority = 0;			// Only used by the realtime policies
+	QString m_ioClass = IOCLASS_NONE;
+	int m_ioPriority = DEFAULT_IOPRIORITY;	// Only used by the realtime and best effort classes
 	QString m_launchDisplay = DISPLAY_NORMAL;
 	int m_launchDelay = 0;
 	bool m_tcpLoopback = false;
 	int m_tcpLoopbackPort = DEFAULT_APPLOOPBACKPORT;
 	bool m_heartbeats = false;
 	QStringList m_environment;
-
-	// File console output is saved to
-	QFile* m_consoleOutputFile = nullptr;
+	QStringList m_dependencies;
 
 	// Runtime properties saved to file
 	QDateTime m_lastStarted;
 	QDateTime m_lastExited;
 
 	// Runtime properties
-	TimePeriodCount m_crashInPeriod;
+	TimePeriodCount m_crashInPeriod{ MAX_CRASHCOUNT };
 	int m_restarts = 0;
 	int m_lastExitCode = 0;
 	QString m_state = tr("Not started yet");
 	bool m_running = false;
+	bool m_ready = false;				// Running and has sent its first heartbeat if it sends them
 
 	bool m_exitExpected = false;
 	bool m_restartAfterExit = false;
-	QDateTime m_lastHeartbeat;
+	MonotonicTime m_lastHeartbeat;
 	Settings* m_settings = nullptr;
 	GlobalManager* m_globalManager = nullptr;
 	UserProcess* m_process = nullptr;
+	ConsoleCapture* m_outputCapture = nullptr;
+	quint64 m_captureChannel = 0;		// Capture thread channel of the running process, 0 if none
+	AppCgroup* m_appCgroup = nullptr;	// cgroup of the last process started, null if it wasn't contained
+	qint64 m_cpuUsageAtStart = 0;		// Microseconds the cgroup had used when the process started
 	QSharedPointer<QTcpServer> m_tcpServer;
-	QTimer m_heartbeatTimer;
-	QTimer m_terminateTimer;
+	WheelTimer m_heartbeatTimer;		// Due when the heartbeat timeout passes since the last heartbeat
+	WheelTimer m_terminateTimer;
 	QSharedPointer<QNamedPipe> m_logPipe;
+
+	// Metrics labelled with the app's name, looked up again when it is renamed
+	MetricCounter* m_startsMetric = nullptr;
+	MetricCounter* m_crashesMetric = nullptr;
+	MetricCounter* m_restartsMetric = nullptr;
+	MetricCounter* m_heartbeatTimeoutsMetric = nullptr;
+	MetricGauge* m_cpuMetric = nullptr;
+	MetricGauge* m_memoryMetric = nullptr;
 #if !defined(Q_OS_WIN)
 	static QString m_display;		// Stores the X11 display name
 #endif
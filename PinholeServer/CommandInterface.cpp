@@ -6,6 +6,8 @@
 #include "GlobalManager.h"
 #include "ScheduleManager.h"
 #include "Logger.h"
+#include "LogSearch.h"
+#include "Metrics.h"
 #include "Values.h"
 #include "WinUtil.h"
 #include "../common/PinholeCommon.h"
@@ -21,6 +23,8 @@
 #include <QSettings>
 #include <QMetaObject>
 #include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QHash>
 
 #if defined(Q_OS_UNIX)
 #include <sys/stat.h>
@@ -33,6 +37,23 @@
 
 #define CRYPTOMETHOD			QCryptographicHash::Sha3_512
 
+// Duration histograms of the commands, looked up once. Anything else a client
+// sends is counted as unknown, so made up names can't create metric series.
+static MetricHistogram* commandDuration(const QString& command)
+{
+	static const QHash<QString, MetricHistogram*> histograms = []()
+	{
+		QHash<QString, MetricHistogram*> commandHistograms;
+		for (const char* name : { CMD_AUTH, CMD_TERMINATE, CMD_SUBSCRIBECMD, CMD_SUBSCRIBEGROUP,
+			CMD_QUERY, CMD_VALUE, CMD_COMMAND, CMD_SCREENSHOT, "unknown" })
+		{
+			commandHistograms[name] = Metrics::histogram(METRIC_COMMAND_DURATION, Metrics::label("command", name));
+		}
+		return commandHistograms;
+	}();
+	return histograms.value(command, histograms.value("unknown"));
+}
+
 CommandInterface::CommandInterface(Settings* settings, AlertManager* alertManager,
 	AppManager* appManager, GroupManager* groupManager, GlobalManager* globalManager,
 	ScheduleManager* scheduleManager, QObject *parent)
@@ -55,6 +76,12 @@ CommandInterface::CommandInterface(Settings* settings, AlertManager* alertManage
 		this, &CommandInterface::valueChanged);
 	connect(m_scheduleManager, &ScheduleManager::valueChanged,
 		this, &CommandInterface::valueChanged);
+	connect(m_appManager, &AppManager::consoleOutput,
+		this, &CommandInterface::consoleOutput);
+
+	m_logSearch = new LogSearch(this);
+	connect(m_logSearch, &LogSearch::finished,
+		this, &CommandInterface::searchFinished);
 
 }
 
@@ -66,6 +93,25 @@ CommandInterface::~CommandInterface()
 }
 
 
+// Asks the helper for a screenshot on behalf of another part of the server,
+// screenshotReady() is emitted when it arrives. Returns false if the helper isn't connected.
+bool CommandInterface::requestScreenshot() const
+{
+	QVariantList vlreq;
+	vlreq << CMD_SCREENSHOT;
+	return sendToHelper(vlreq);
+}
+
+
+// Asks the helper to show the screen IDs, returns false if the helper isn't connected
+bool CommandInterface::showScreenIds() const
+{
+	QVariantList vlreq;
+	vlreq << CMD_SHOWSCREENIDS;
+	return sendToHelper(vlreq);
+}
+
+
 void CommandInterface::addClient(const QString& clientId)
 {
 	if (m_clientMap.contains(clientId))
@@ -78,6 +124,7 @@ void CommandInterface::addClient(const QString& clientId)
 	client->host = sender();
 	client->clientId = clientId;
 	m_clientMap[clientId] = client;
+	Metrics::gauge(METRIC_CLIENTS)->set(m_clientMap.size());
 }
 
 
@@ -89,7 +136,14 @@ void CommandInterface::removeClient(const QString& clientId)
 		return;
 	}
 
+	// Stop following anything only this client was following
+	auto client = m_clientMap[clientId];
+	const QStringList followedApps = client->followedApps;
+	for (const auto& appName : followedApps)
+		unfollowConsole(client, appName);
+
 	m_clientMap.remove(clientId);
+	Metrics::gauge(METRIC_CLIENTS)->set(m_clientMap.size());
 }
 
 
@@ -102,6 +156,9 @@ void CommandInterface::processData(const QString& clientId, const QByteArray& da
 
 	auto client = m_clientMap[clientId];
 
+	// Time the command once we know what it is
+	MetricTimer commandTimer;
+
 	// Parse as msgpack data
 	QVariant var = MsgPack::unpack(data);
 
@@ -150,6 +207,12 @@ void CommandInterface::processData(const QString& clientId, const QByteArray& da
 		return;
 	}
 
+	// Unauthenticated clients are only timed authenticating
+	if (client->authenticated || CMD_AUTH == command)
+	{
+		commandTimer.setHistogram(commandDuration(command));
+	}
+
 	if (!client->authenticated)
 	{
 		if (CMD_AUTH != command || vlist.length() < 5)
@@ -169,8 +232,10 @@ void CommandInterface::processData(const QString& clientId, const QByteArray& da
 			QString hostName;
 			QString password;
 			bool helperClient;
+			QStringList compressions;
 			VariantParser parser(CMD_AUTH, clientId, 1, vlist);
-			if (!parser.arg(version) || !parser.arg(hostName) || !parser.arg(password) || !parser.arg(helperClient))
+			if (!parser.arg(version) || !parser.arg(hostName) || !parser.arg(password) || !parser.arg(helperClient) ||
+				(vlist.size() > 5 && !parser.arg(compressions)))
 			{
 				Logger(LOG_ERROR) << parser.errorString();
 				vlresp << CMD_AUTH << 0 << tr("Error");
@@ -194,10 +259,15 @@ void CommandInterface::processData(const QString& clientId, const QByteArray& da
 				client->hostName = hostName;
 				client->helperClient = helperClient; // This is a special local client, PinholeHelper
 				client->specialClient = m_passwordHash == QCryptographicHash::hash((m_passwordSalt + password).toUtf8(), CRYPTOMETHOD);
+				client->compression = compressions.contains(COMPRESSION_ZLIB);
 
 				Logger(LOG_DEBUG) << tr("Client connection: ") << clientId << " v" << version << " hostname:" << hostName;
 
-				vlresp << CMD_AUTH << 1 << QHostInfo::localHostName() << QCoreApplication::applicationVersion() << m_settings->serverId();
+				vlresp << CMD_AUTH << 1 << QHostInfo::localHostName() << QCoreApplication::applicationVersion() << m_settings->serverId()
+					<< (client->compression ? COMPRESSION_ZLIB : "");
+
+				if (helperClient)
+					emit helperAuthenticated();
 			}
 		}
 	}
@@ -279,6 +349,9 @@ void CommandInterface::processData(const QString& clientId, const QByteArray& da
 		QVariantList vlmsg;
 		vlmsg << CMD_CMDRESPONSE << GROUP_NONE << CMD_NONE_GETSCREENSHOT << CMD_RESPONSE_DATA << screenshot;
 		sendCmdResponseToWaitingClients(vlmsg);
+
+		// And to in-process requesters
+		emit screenshotReady(screenshot);
 	}
 	else
 	{
@@ -289,7 +362,7 @@ void CommandInterface::processData(const QString& clientId, const QByteArray& da
 
 	if (!vlresp.isEmpty())
 	{
-		response = variantListData(vlresp);
+		response = clientFrame(client, variantListData(vlresp));
 	}
 }
 
@@ -537,6 +610,65 @@ QVariantList CommandInterface::handleClientCommand(const QVariantList& vlist, co
 				commandData = QVariant(qCompress(logData));
 			}
 		}
+		else if (CMD_NONE_SEARCHLOGS == subCommand)
+		{
+			// Search the log, or an app's console output when an app is given.
+			// The response is sent when the search is done.
+			QString appName;
+			QString pattern;
+			bool regularExpression;
+			bool caseSensitive;
+			QString startDate;
+			QString endDate;
+			int level;
+			int maxResults;
+			int context;
+			VariantParser parser(CMD_NONE_SEARCHLOGS, clientId, 3, vlist);
+			if (!parser.arg(appName) || !parser.arg(pattern) || !parser.arg(regularExpression) ||
+				!parser.arg(caseSensitive) || !parser.arg(startDate) || !parser.arg(endDate) ||
+				!parser.arg(level) || !parser.arg(maxResults) || !parser.arg(context))
+			{
+				Logger(LOG_ERROR) << parser.errorString();
+				return QVariantList();
+			}
+
+			SearchQuery query;
+			query.pattern = pattern;
+			query.regularExpression = regularExpression;
+			query.caseSensitive = caseSensitive;
+			query.start = QDateTime::fromString(startDate, DATETIME_STRINGFORMAT);
+			query.end = QDateTime::fromString(endDate, DATETIME_STRINGFORMAT);
+			query.level = level;
+			query.maxResults = qBound(1, maxResults, MAX_SEARCHRESULTS);
+			query.context = qBound(0, context, MAX_SEARCHCONTEXT);
+			if (appName.isEmpty())
+			{
+				query.filenames = LogSearch::logFilenames(m_settings->dataDir());
+				query.timestamped = true;
+			}
+			else if (m_appManager->getAppNames().contains(appName))
+			{
+				query.filenames = m_appManager->getConsoleOutputFilenames(appName);
+			}
+			else
+			{
+				commandSuccess = false;
+			}
+
+			if (commandSuccess)
+			{
+				quint64 searchId = m_logSearch->start(query);
+				if (0 == searchId)
+				{
+					commandSuccess = false;
+				}
+				else
+				{
+					m_pendingSearches[searchId] = clientId;
+					commandPostpone = true;
+				}
+			}
+		}
 		else if (CMD_NONE_LOGMESSAGE == subCommand)
 		{
 			// Log packet from Helper or Console app
@@ -658,6 +790,48 @@ QVariantList CommandInterface::handleClientCommand(const QVariantList& vlist, co
 
 			commandData = QVariant(qCompress(m_appManager->getConsoleOutputFile(appName)));
 		}
+		else if (CMD_APP_FOLLOWCONSOLE == subCommand)
+		{
+			// Send the last lines of an app's console output now and new output as it's written
+			QString appName;
+			int lines = 0;
+			VariantParser parser(CMD_APP_FOLLOWCONSOLE, clientId, 3, vlist);
+			if (!parser.arg(appName) || !parser.arg(lines))
+			{
+				Logger(LOG_ERROR) << parser.errorString();
+				return QVariantList();
+			}
+
+			if (m_appManager->getAppNames().contains(appName))
+			{
+				if (!client->followedApps.contains(appName))
+				{
+					if (!consoleFollowed(appName))
+						m_appManager->setConsoleFollowed(appName, true);
+					client->followedApps.append(appName);
+				}
+
+				QVariantList data;
+				data << appName << qCompress(m_appManager->getRecentConsoleOutput(appName, lines));
+				commandData = data;
+			}
+			else
+			{
+				commandSuccess = false;
+			}
+		}
+		else if (CMD_APP_UNFOLLOWCONSOLE == subCommand)
+		{
+			QString appName;
+			VariantParser parser(CMD_APP_UNFOLLOWCONSOLE, clientId, 3, vlist);
+			if (!parser.arg(appName))
+			{
+				Logger(LOG_ERROR) << parser.errorString();
+				return QVariantList();
+			}
+
+			unfollowConsole(client, appName);
+		}
 		else if (CMD_APP_EXECUTE == subCommand)
 		{
 			// Execute a command on the server
@@ -840,6 +1014,10 @@ QVariantList CommandInterface::handleClientCommand(const QVariantList& vlist, co
 		{
 			commandData = QVariant(qCompress(m_globalManager->getSysInfoData()));
 		}
+		else if (CMD_GLOBAL_SYSINFOMAP == subCommand)
+		{
+			commandData = m_globalManager->getSysInfoMap();
+		}
 		else
 		{
 			commandUnfound = true;
@@ -892,6 +1070,21 @@ QVariantList CommandInterface::handleClientCommand(const QVariantList& vlist, co
 		{
 			commandData = QVariant(qCompress(m_alertManager->retrieveAlertList()));
 		}
+		else if (CMD_ALERT_QUERY == subCommand)
+		{
+			// Retrieve a page of alerts, or the alerts since the last ones the client has
+			qint64 sinceSequence;
+			qint64 beforeSequence;
+			int limit;
+			VariantParser parser(CMD_ALERT_QUERY, clientId, 3, vlist);
+			if (!parser.arg(sinceSequence) || !parser.arg(beforeSequence) || !parser.arg(limit))
+			{
+				Logger(LOG_ERROR) << parser.errorString();
+				return QVariantList();
+			}
+
+			commandData = QVariant(m_alertManager->queryAlerts(sinceSequence, beforeSequence, limit));
+		}
 		else
 		{
 			commandUnfound = true;
@@ -1015,9 +1208,10 @@ QByteArray CommandInterface::generateSettingsData() const
 }
 
 
-void CommandInterface::sendDataToClient(const QSharedPointer<ClientInfo> client, const QByteArray & data) const
+// Broadcasts pass the same compressed buffer for every client, so the frame is only compressed once
+void CommandInterface::sendDataToClient(const QSharedPointer<ClientInfo> client, const QByteArray & data, QByteArray* compressed) const
 {
-	if (!QMetaObject::invokeMethod(client->host, "sendDataToClient", Q_ARG(QString, client->clientId), Q_ARG(QByteArray, data)))
+	if (!QMetaObject::invokeMethod(client->host, "sendDataToClient", Q_ARG(QString, client->clientId), Q_ARG(QByteArray, clientFrame(client, data, compressed))))
 	{
 		Logger(LOG_ERROR) << tr("Failed to invoke sendDataToClient for clientId '%1'").arg(client->clientId);
 	}
@@ -1046,12 +1240,36 @@ QByteArray CommandInterface::variantListData(const QVariantList & vlist) const
 }
 
 
-bool CommandInterface::readServerSettings()
+// Compresses a frame for clients that accept it. Broadcasts are packed once and
+// compressed the first time a client accepts it, kept in compressed for the rest.
+QByteArray CommandInterface::clientFrame(const QSharedPointer<ClientInfo> client, const QByteArray& frame, QByteArray* compressed) const
 {
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
+	if (!client->compression || frame.size() - static_cast<int>(sizeof(uint32_t)) < FRAME_COMPRESSMIN)
+		return frame;
+	if (nullptr != compressed && !compressed->isEmpty())
+		return *compressed;
+
+	static MetricCounter* uncompressedBytes = Metrics::counter(METRIC_FRAME_UNCOMPRESSED);
+	static MetricCounter* compressedBytes = Metrics::counter(METRIC_FRAME_COMPRESSED);
+	static MetricHistogram* compressDuration = Metrics::histogram(METRIC_FRAME_COMPRESS_DURATION);
+
+	QElapsedTimer timer;
+	timer.start();
+	QByteArray compressedFrame = CompressFrame(frame);
+	compressDuration->observe(timer.nsecsElapsed() / 1000);
+	uncompressedBytes->increment(frame.size());
+	compressedBytes->increment(compressedFrame.size());
+
+	if (nullptr != compressed)
+		*compressed = compressedFrame;
+	return compressedFrame;
+}
+
 
-	m_passwordSalt = settings->value(PROP_SERVER_SALT).toString();
-	m_passwordHash = QByteArray::fromHex(settings->value(PROP_SERVER_HASH).toString().toUtf8());
+bool CommandInterface::readServerSettings()
+{
+	m_passwordSalt = m_settings->value(PROP_SERVER_SALT).toString();
+	m_passwordHash = QByteArray::fromHex(m_settings->value(PROP_SERVER_HASH).toString().toUtf8());
 
 	return true;
 }
@@ -1063,10 +1281,8 @@ bool CommandInterface::writeSettings() const
 	//qDebug() << "Writing encrypted TCP server settings";
 #endif
 
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
-	settings->setValue(PROP_SERVER_SALT, m_passwordSalt);
-	settings->setValue(PROP_SERVER_HASH, QString(m_passwordHash.toHex()));
+	m_settings->setValue(PROP_SERVER_SALT, m_passwordSalt);
+	m_settings->setValue(PROP_SERVER_HASH, QString(m_passwordHash.toHex()));
 
 	return true;
 }
@@ -1285,6 +1501,8 @@ bool CommandInterface::sendCmdResponseToWaitingClients(const QVariantList& vlist
 void CommandInterface::sendToAllClients(const QVariantList & vlist) const
 {
 	QString command = vlist[0].toString();
+	QByteArray vlistData;
+	QByteArray compressed;
 
 	for (const auto& client : m_clientMap)
 	{
@@ -1295,13 +1513,66 @@ void CommandInterface::sendToAllClients(const QVariantList & vlist) const
 #ifdef QT_DEBUG
 				qDebug() << "Sending to " << client->hostName << ": " << vlist[0].toString() << vlist[1].toString() << vlist[2].toString();
 #endif
-				sendDataToClient(client, variantListData(vlist));
+				if (vlistData.isEmpty())
+					vlistData = variantListData(vlist);
+				sendDataToClient(client, vlistData, &compressed);
 			}
 		}
 	}
 }
 
 
+void CommandInterface::searchFinished(quint64 id, const QVariant& results)
+{
+	// The client may have gone while searching
+	QString clientId = m_pendingSearches.take(id);
+	if (!m_clientMap.contains(clientId))
+		return;
+
+	QVariantList vlist;
+	vlist << CMD_CMDRESPONSE << GROUP_NONE << CMD_NONE_SEARCHLOGS << CMD_RESPONSE_DATA << results;
+	sendDataToClient(clientId, variantListData(vlist));
+}
+
+
+// New console output of an app, only clients following it get it
+void CommandInterface::consoleOutput(const QString& appName, const QByteArray& data) const
+{
+	QVariantList vlist;
+	vlist << CMD_CONSOLEOUTPUT << appName << data;
+	QByteArray vlistData;
+	QByteArray compressed;
+
+	for (const auto& client : m_clientMap)
+	{
+		if (client->followedApps.contains(appName))
+		{
+			if (vlistData.isEmpty())
+				vlistData = variantListData(vlist);
+			sendDataToClient(client, vlistData, &compressed);
+		}
+	}
+}
+
+
+void CommandInterface::unfollowConsole(QSharedPointer<ClientInfo> client, const QString& appName)
+{
+	if (client->followedApps.removeAll(appName) > 0 && !consoleFollowed(appName))
+		m_appManager->setConsoleFollowed(appName, false);
+}
+
+
+bool CommandInterface::consoleFollowed(const QString& appName) const
+{
+	for (const auto& client : m_clientMap)
+	{
+		if (client->followedApps.contains(appName))
+			return true;
+	}
+	return false;
+}
+
+
 void CommandInterface::sendControlWindow(int pid, const QString& display, const QString& command)
 {
 	QVariantList vlist;
@@ -1353,6 +1624,28 @@ bool CommandInterface::VariantParser::arg(int& a)
 }
 
 
+bool CommandInterface::VariantParser::arg(qint64& a)
+{
+	if (!checkSize())
+		return false;
+
+	if (!m_vlist[m_argPos].canConvert(QVariant::LongLong))
+	{
+		m_error = true;
+		m_errorString = QObject::tr("Wrong variant type in packet from client %1 subCommand:%2 position %3 should be int")
+			.arg(m_client)
+			.arg(m_command)
+			.arg(m_argPos);
+		return false;
+	}
+
+	a = m_vlist[m_argPos].toLongLong();
+	m_argPos++;
+
+	return true;
+}
+
+
 bool CommandInterface::VariantParser::arg(QString & a)
 {
 	if (!checkSize())
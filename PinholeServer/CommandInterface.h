@@ -11,6 +11,7 @@ class AlertManager;
 class GroupManager;
 class GlobalManager;
 class ScheduleManager;
+class LogSearch;
 
 class CommandInterface : public QObject
 {
@@ -31,6 +32,8 @@ class CommandInterface : public QObject
 		bool waitingForCommand = false;		// Client is waiting for a response (ie screenshot)
 		QString waitingCommandGroup;		// The group of the command the client is waiting on
 		QString waitingSubCommand;			// The sub command the client is waiting on
+		QStringList followedApps;			// Apps whose console output the client receives
+		bool compression = false;			// Client accepts compressed frames
 	};
 
 	class VariantParser
@@ -42,6 +45,7 @@ class CommandInterface : public QObject
 		};
 		bool arg(bool& a);
 		bool arg(int& a);
+		bool arg(qint64& a);
 		bool arg(QString& a);
 		bool arg(QStringList& a);
 		bool arg(QByteArray& a);
@@ -65,7 +69,12 @@ public:
 		AppManager* appManager, GroupManager* groupManager, GlobalManager* globalManager,
 		ScheduleManager* scheduleManager, QObject *parent = nullptr);
 	~CommandInterface();
+	bool requestScreenshot() const;
+	bool showScreenIds() const;
 
+signals:
+	void screenshotReady(const QByteArray& screenshot);
+	void helperAuthenticated();
 
 public slots:
 	void addClient(const QString& clientId);
@@ -74,11 +83,13 @@ public slots:
 	void logMessage(int level, const QString& message);
 	void valueChanged(const QString&, const QString&, const QString&, const QVariant&) const;
 	void sendControlWindow(int pid, const QString & display, const QString & command);
+	void consoleOutput(const QString& appName, const QByteArray& data) const;
 	void logMessage(int level, const QString & message) const;
 	bool writeSettings() const;
 
 private slots:
 	void sendToAllClients(const QVariantList& vlist) const;
+	void searchFinished(quint64 id, const QVariant& results);
 
 private:
 	bool readServerSettings();
@@ -86,15 +97,18 @@ private:
 	bool helperConnected() const;
 	bool sendToHelper(const QVariantList & vlist) const;
 	bool sendCmdResponseToWaitingClients(const QVariantList & vlist) const;
+	void unfollowConsole(QSharedPointer<ClientInfo> client, const QString& appName);
+	bool consoleFollowed(const QString& appName) const;
 	
 	QVariantList handleClientQuery(const QVariantList & vlist, const QString & clientId) const;
 	QVariantList handleClientValue(const QVariantList & vlist, const QString & clientId) const;
 	QVariantList handleClientCommand(const QVariantList & vlist, const QString & clientId, QSharedPointer<ClientInfo> client);
 	QByteArray generateSettingsData() const;
 	bool importSettingsData(const QByteArray & data, const QString & clientAddr, const QString & clientHostName) const;
-	void sendDataToClient(const QSharedPointer<ClientInfo> client, const QByteArray& data) const;
+	void sendDataToClient(const QSharedPointer<ClientInfo> client, const QByteArray& data, QByteArray* compressed = nullptr) const;
 	void sendDataToClient(const QString& clientId, const QByteArray& data) const;
 	QByteArray variantListData(const QVariantList& vlist) const;
+	QByteArray clientFrame(const QSharedPointer<ClientInfo> client, const QByteArray& frame, QByteArray* compressed = nullptr) const;
 
 
 	QString m_passwordSalt;
@@ -108,6 +122,8 @@ private:
 	GroupManager* m_groupManager = nullptr;
 	GlobalManager* m_globalManager = nullptr;
 	ScheduleManager* m_scheduleManager = nullptr;
+	LogSearch* m_logSearch = nullptr;
+	QMap<quint64, QString> m_pendingSearches;	// Client ids waiting for search results
 };
 
 
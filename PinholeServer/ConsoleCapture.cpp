@@ -0,0 +1,851 @@
+#include "ConsoleCapture.h"
+#include "Logger.h"
+#include "Values.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QSaveFile>
+#include <QThread>
+#include <QSocketNotifier>
+#include <QVector>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+// Rotated files are named after the capture file and the time they were rotated
+static const char* s_segmentTimeFormat = "yyyyMMdd-HHmmss";
+
+
+static QVector<quint32> makeCrcTable()
+{
+	QVector<quint32> table(256);
+	for (quint32 n = 0; n < 256; n++)
+	{
+		quint32 c = n;
+		for (int k = 0; k < 8; k++)
+			c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+		table[n] = c;
+	}
+	return table;
+}
+
+
+// The CRC-32 gzip uses
+static quint32 crc32(const QByteArray& data)
+{
+	static const QVector<quint32> table = makeCrcTable();
+	quint32 crc = 0xffffffff;
+	for (char byte : data)
+		crc = table[(crc ^ static_cast<uchar>(byte)) & 0xff] ^ (crc >> 8);
+	return crc ^ 0xffffffff;
+}
+
+
+// One gzip member holding data, a gzip file can be any number of members in a row
+static QByteArray gzipMember(const QByteArray& data)
+{
+	// qCompress output is a 4 byte length then a zlib stream, which is a 2 byte
+	// header, the same deflate data gzip uses and a 4 byte Adler-32 checksum
+	QByteArray compressed = qCompress(data);
+	if (data.isEmpty() || compressed.size() < 10)
+		return QByteArray();
+
+	static const char header[10] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff' };
+	uchar trailer[8];
+	qToLittleEndian<quint32>(crc32(data), trailer);
+	qToLittleEndian<quint32>(static_cast<quint32>(data.size()), trailer + 4);
+
+	QByteArray member(header, sizeof(header));
+	member.append(compressed.constData() + 6, compressed.size() - 10);
+	member.append(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+	return member;
+}
+
+
+// The last lines of data, a last line without a newline counts
+static QByteArray lastLines(const QByteArray& data, int lines)
+{
+	if (lines <= 0)
+		return QByteArray();
+
+	int start = data.size() - 1;
+	if (data.endsWith('\n'))
+		start--;
+	for (; start >= 0; start--)
+	{
+		if ('\n' == data[start] && 0 == --lines)
+			break;
+	}
+	return data.mid(start + 1);
+}
+
+
+#if defined(Q_OS_LINUX)
+// Plain copy for file systems that can't splice
+static ssize_t copyPipe(int pipeFd, int outFd, size_t length)
+{
+	char buffer[65536];
+	ssize_t count = read(pipeFd, buffer, qMin(length, sizeof(buffer)));
+	if (count <= 0)
+		return count;
+
+	ssize_t written = 0;
+	while (written < count)
+	{
+		ssize_t n = write(outFd, buffer + written, count - written);
+		if (n < 0)
+		{
+			if (EINTR == errno)
+				continue;
+			return -1;
+		}
+		written += n;
+	}
+	return count;
+}
+
+
+// Reads count bytes that are known to be in a pipe
+static bool readPipe(int pipeFd, char* data, ssize_t count)
+{
+	while (count > 0)
+	{
+		ssize_t n = read(pipeFd, data, count);
+		if (n < 0 && EINTR == errno)
+			continue;
+		if (n <= 0)
+			return false;
+		data += n;
+		count -= n;
+	}
+	return true;
+}
+
+
+// Throws away count bytes that are known to be in a pipe
+static bool skipPipe(int pipeFd, int nullFd, ssize_t count)
+{
+	while (count > 0)
+	{
+		ssize_t n = splice(pipeFd, nullptr, nullFd, nullptr, count, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if (n < 0 && EINTR == errno)
+			continue;
+		if (n <= 0)
+		{
+			char buffer[65536];
+			n = qMin<ssize_t>(count, sizeof(buffer));
+			if (!readPipe(pipeFd, buffer, n))
+				return false;
+		}
+		count -= n;
+	}
+	return true;
+}
+
+
+CaptureWriter::CaptureWriter(QObject *parent)
+	: QObject(parent), m_rotateTimer(this), m_followTimer(this)
+{
+	m_nullFd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+	m_rotateTimer.setInterval(INTERVAL_CAPTUREROTATECHECK);
+	connect(&m_rotateTimer, &QTimer::timeout,
+		this, &CaptureWriter::checkRotation);
+
+	// Followed output is collected for a moment so clients get fewer, bigger messages
+	m_followTimer.setInterval(INTERVAL_CONSOLEFOLLOW);
+	m_followTimer.setSingleShot(true);
+	connect(&m_followTimer, &QTimer::timeout,
+		this, &CaptureWriter::sendFollowed);
+}
+
+
+CaptureWriter::~CaptureWriter()
+{
+	for (const auto& id : m_channels.keys())
+		removeChannel(id);
+
+	if (m_nullFd >= 0)
+		close(m_nullFd);
+}
+
+
+// Called from the main thread
+QByteArray CaptureWriter::recentOutput(const QString& name) const
+{
+	QMutexLocker locker(&m_recentMutex);
+	return m_recent.value(name);
+}
+
+
+// Called from the main thread
+void CaptureWriter::forgetRecent(const QString& name)
+{
+	QMutexLocker locker(&m_recentMutex);
+	m_recent.remove(name);
+}
+
+
+void CaptureWriter::openChannel(quint64 id, int pipeFd, const CaptureConfig& config)
+{
+	Channel& channel = m_channels[id];
+	channel.pipeFd = pipeFd;
+	channel.config = config;
+	openTee(channel);
+	if (config.enabled)
+	{
+		ConsoleCapture::prepareFile(config, config.append);
+		openFile(channel);
+	}
+
+	// The activated signal's arguments changed in Qt 5.15, the string form connects to either
+	channel.notifier = new QSocketNotifier(pipeFd, QSocketNotifier::Read, this);
+	connect(channel.notifier, SIGNAL(activated(int)),
+		this, SLOT(pipeReadable(int)));
+
+	if (!m_rotateTimer.isActive())
+		m_rotateTimer.start();
+}
+
+
+// Capture settings changed while the app is running, it keeps its file name until it restarts
+void CaptureWriter::configureChannel(quint64 id, const CaptureConfig& config)
+{
+	auto channel = m_channels.find(id);
+	if (channel == m_channels.end())
+		return;
+
+	bool wasEnabled = channel->config.enabled;
+	QString filename = channel->config.filename;
+	channel->config = config;
+	channel->config.filename = filename;
+
+	if (config.enabled && !wasEnabled)
+	{
+		ConsoleCapture::prepareFile(channel->config, config.append);
+		openFile(*channel);
+	}
+	else if (!config.enabled && wasEnabled)
+	{
+		closeFile(*channel);
+	}
+}
+
+
+// The app exited, anything it wrote last is still in the pipe
+void CaptureWriter::closeChannel(quint64 id)
+{
+	auto channel = m_channels.find(id);
+	if (channel == m_channels.end())
+		return;
+
+	move(*channel);
+	removeChannel(id);
+}
+
+
+void CaptureWriter::setFollowed(const QString& name, bool followed)
+{
+	if (followed)
+	{
+		m_followed.insert(name);
+	}
+	else
+	{
+		m_followed.remove(name);
+		m_pending.remove(name);
+	}
+}
+
+
+void CaptureWriter::pipeReadable(int pipeFd)
+{
+	for (auto channel = m_channels.begin(); channel != m_channels.end(); ++channel)
+	{
+		if (channel->pipeFd == pipeFd)
+		{
+			if (!move(*channel))
+				removeChannel(channel.key());
+			return;
+		}
+	}
+}
+
+
+// Moves what's in the pipe to the file, or throws it away when not capturing.
+// Returns false once everything writing to the pipe has closed it.
+bool CaptureWriter::move(Channel& channel)
+{
+	// The output is duplicated into the second pipe first and then the same
+	// amount is moved to the file, so the recent output always matches the file
+	ssize_t count = SIZE_CAPTUREPIPE;
+	if (channel.teeWriteFd >= 0)
+	{
+		count = tee(channel.pipeFd, channel.teeWriteFd, SIZE_CAPTUREPIPE, SPLICE_F_NONBLOCK);
+		if (0 == count)
+			return false;
+
+		if (count < 0)
+		{
+			if (EAGAIN == errno || EINTR == errno)
+				return true;
+
+			Logger(LOG_WARNING) << tr("Error keeping recent console output of '%1': '%2'")
+				.arg(channel.config.name)
+				.arg(strerror(errno));
+			closeTee(channel);
+			count = SIZE_CAPTUREPIPE;
+		}
+	}
+
+	bool teed = channel.teeWriteFd >= 0;
+	ssize_t remaining = count;
+	while (remaining > 0)
+	{
+		ssize_t moved = transfer(channel, remaining);
+		if (moved > 0)
+		{
+			remaining -= moved;
+			if (channel.fileFd >= 0)
+				channel.size += moved;
+
+			// Without the copy whatever one move got is enough
+			if (!teed)
+				break;
+			continue;
+		}
+
+		if (0 == moved)
+			return false;
+		if (EINTR == errno)
+			continue;
+		if (EAGAIN == errno)
+			break;
+
+		// Stop writing the file on errors like a full disk, the app would block otherwise
+		Logger(LOG_ERROR) << tr("Error writing console output file '%1': '%2'")
+			.arg(channel.config.filename)
+			.arg(strerror(errno));
+		if (channel.fileFd < 0)
+			return false;
+		closeFile(channel);
+	}
+
+	if (teed)
+		readTee(channel, count);
+
+	if (channel.fileFd >= 0 && channel.config.rotateSize > 0 && channel.size >= channel.config.rotateSize)
+		rotate(channel);
+	return true;
+}
+
+
+// Moves up to length bytes from the pipe to the file, or to /dev/null when not capturing
+ssize_t CaptureWriter::transfer(Channel& channel, size_t length)
+{
+	int outFd = channel.fileFd >= 0 ? channel.fileFd : m_nullFd;
+	if (!channel.copy)
+	{
+		ssize_t moved = splice(channel.pipeFd, nullptr, outFd, nullptr, length, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if (moved >= 0 || EINVAL != errno)
+			return moved;
+		channel.copy = true;
+	}
+	return copyPipe(channel.pipeFd, outFd, length);
+}
+
+
+void CaptureWriter::openTee(Channel& channel)
+{
+	int fds[2];
+	if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0)
+	{
+		Logger(LOG_WARNING) << tr("Error creating recent console output pipe for '%1': '%2'")
+			.arg(channel.config.name)
+			.arg(strerror(errno));
+		return;
+	}
+
+	// As big as the app's pipe so everything in it can be duplicated at once
+	int size = fcntl(channel.pipeFd, F_GETPIPE_SZ);
+	if (size > 0)
+		fcntl(fds[1], F_SETPIPE_SZ, size);
+
+	channel.teeReadFd = fds[0];
+	channel.teeWriteFd = fds[1];
+}
+
+
+void CaptureWriter::closeTee(Channel& channel)
+{
+	if (channel.teeReadFd >= 0)
+	{
+		close(channel.teeReadFd);
+		close(channel.teeWriteFd);
+		channel.teeReadFd = -1;
+		channel.teeWriteFd = -1;
+	}
+}
+
+
+// Reads the duplicated output, only the newest is kept unless the app is followed
+void CaptureWriter::readTee(Channel& channel, ssize_t count)
+{
+	ssize_t skip = m_followed.contains(channel.config.name) ? 0 : qMax<ssize_t>(0, count - SIZE_CONSOLERECENT);
+	QByteArray data(static_cast<int>(count - skip), Qt::Uninitialized);
+	if (!skipPipe(channel.teeReadFd, m_nullFd, skip) || !readPipe(channel.teeReadFd, data.data(), data.size()))
+	{
+		Logger(LOG_WARNING) << tr("Error reading recent console output of '%1': '%2'")
+			.arg(channel.config.name)
+			.arg(strerror(errno));
+		closeTee(channel);
+		return;
+	}
+
+	addOutput(channel.config.name, data);
+}
+
+
+void CaptureWriter::addOutput(const QString& name, const QByteArray& data)
+{
+	{
+		QMutexLocker locker(&m_recentMutex);
+		QByteArray& recent = m_recent[name];
+		recent.append(data);
+
+		// Trimmed once it's twice the size so the start isn't moved on every write
+		if (recent.size() > 2 * SIZE_CONSOLERECENT)
+			recent.remove(0, recent.size() - SIZE_CONSOLERECENT);
+	}
+
+	if (!m_followed.contains(name))
+		return;
+
+	Pending& pending = m_pending[name];
+	pending.data.append(data);
+	if (pending.data.size() > SIZE_CONSOLEFOLLOW)
+	{
+		pending.skipped += pending.data.size() - SIZE_CONSOLEFOLLOW;
+		pending.data.remove(0, pending.data.size() - SIZE_CONSOLEFOLLOW);
+	}
+
+	if (!m_followTimer.isActive())
+		m_followTimer.start();
+}
+
+
+void CaptureWriter::sendFollowed()
+{
+	for (auto pending = m_pending.begin(); pending != m_pending.end(); ++pending)
+	{
+		QByteArray data = pending->data;
+		if (pending->skipped > 0)
+			data.prepend(ConsoleCapture::skippedOutput(pending->skipped));
+		emit output(pending.key(), data);
+	}
+	m_pending.clear();
+}
+
+
+void CaptureWriter::openFile(Channel& channel)
+{
+	channel.fileFd = open(QFile::encodeName(channel.config.filename).constData(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+	if (channel.fileFd < 0)
+	{
+		Logger(LOG_ERROR) << tr("Error creating console output file '%1': '%2'")
+			.arg(channel.config.filename)
+			.arg(strerror(errno));
+		return;
+	}
+
+	// Splice can't write files opened for appending so start at the end instead
+	channel.size = lseek(channel.fileFd, 0, SEEK_END);
+	channel.period = ConsoleCapture::rotationPeriod(channel.config, QDateTime::currentDateTime());
+}
+
+
+void CaptureWriter::closeFile(Channel& channel)
+{
+	if (channel.fileFd >= 0)
+	{
+		close(channel.fileFd);
+		channel.fileFd = -1;
+	}
+}
+
+
+void CaptureWriter::rotate(Channel& channel)
+{
+	closeFile(channel);
+	bool rotated = ConsoleCapture::rotateFile(channel.config);
+	openFile(channel);
+
+	// Carry on with the same file and try again after another rotate size
+	if (!rotated)
+		channel.size = 0;
+}
+
+
+void CaptureWriter::removeChannel(quint64 id)
+{
+	auto channel = m_channels.find(id);
+	if (channel == m_channels.end())
+		return;
+
+	// Usually called from the notifier's own signal
+	channel->notifier->setEnabled(false);
+	channel->notifier->deleteLater();
+	close(channel->pipeFd);
+	closeTee(*channel);
+	closeFile(*channel);
+	m_channels.erase(channel);
+
+	if (m_channels.isEmpty())
+		m_rotateTimer.stop();
+}
+
+
+void CaptureWriter::checkRotation()
+{
+	QDateTime now = QDateTime::currentDateTime();
+	for (auto& channel : m_channels)
+	{
+		if (channel.fileFd < 0 || channel.config.rotatePeriod <= 0)
+			continue;
+
+		qint64 period = ConsoleCapture::rotationPeriod(channel.config, now);
+		if (period == channel.period)
+			continue;
+
+		// Empty files aren't worth keeping, they just start the new period
+		if (channel.size > 0)
+			rotate(channel);
+		else
+			channel.period = period;
+	}
+}
+#endif
+
+
+ConsoleCapture::ConsoleCapture(QObject *parent)
+	: QObject(parent)
+{
+#if defined(Q_OS_LINUX)
+	qRegisterMetaType<CaptureConfig>();
+
+	// Output is moved on a secondary thread so busy apps and slow disks never hold up the main thread
+	m_thread = new QThread(this);
+	m_writer = new CaptureWriter(nullptr);	// Must be nullptr
+	m_writer->moveToThread(m_thread);
+	connect(this, &ConsoleCapture::writerOpenChannel,
+		m_writer, &CaptureWriter::openChannel);
+	connect(this, &ConsoleCapture::writerConfigureChannel,
+		m_writer, &CaptureWriter::configureChannel);
+	connect(this, &ConsoleCapture::writerCloseChannel,
+		m_writer, &CaptureWriter::closeChannel);
+	connect(this, &ConsoleCapture::writerSetFollowed,
+		m_writer, &CaptureWriter::setFollowed);
+	connect(m_writer, &CaptureWriter::output,
+		this, &ConsoleCapture::output);
+	connect(m_thread, &QThread::finished,
+		m_writer, &CaptureWriter::deleteLater);
+	m_thread->start();
+#else
+	m_followTimer.setInterval(INTERVAL_CONSOLEFOLLOW);
+	connect(&m_followTimer, &QTimer::timeout,
+		this, &ConsoleCapture::readFollowed);
+#endif
+}
+
+
+ConsoleCapture::~ConsoleCapture()
+{
+#if defined(Q_OS_LINUX)
+	m_thread->quit();
+	m_thread->wait();
+#endif
+}
+
+
+#if defined(Q_OS_LINUX)
+// Makes the pipe an app's stdout and stderr go to. childFd is the write end for
+// the child process, it must be closed once the process has started so the
+// channel sees the end of the output when the app exits.
+quint64 ConsoleCapture::openChannel(const CaptureConfig& config, int& childFd)
+{
+	int fds[2];
+	if (pipe2(fds, O_CLOEXEC) != 0)
+	{
+		Logger(LOG_ERROR) << tr("Error creating console output pipe: '%1'").arg(strerror(errno));
+		childFd = -1;
+		return 0;
+	}
+
+	// Only the capture thread's end is non-blocking, apps block while the pipe is full
+	fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+	// A bigger pipe lets busy apps write without waiting and moves more per splice, when allowed
+	fcntl(fds[0], F_SETPIPE_SZ, SIZE_CAPTUREPIPE);
+
+	quint64 id = m_nextId++;
+	emit writerOpenChannel(id, fds[0], config);
+	childFd = fds[1];
+	return id;
+}
+
+
+void ConsoleCapture::configureChannel(quint64 id, const CaptureConfig& config)
+{
+	emit writerConfigureChannel(id, config);
+}
+
+
+void ConsoleCapture::closeChannel(quint64 id)
+{
+	emit writerCloseChannel(id);
+}
+#endif
+
+
+// The last lines an app wrote. Apps that haven't written anything since the
+// server started only have what's at the end of their capture file.
+QByteArray ConsoleCapture::recentOutput(const QString& name, const QString& filename, int lines) const
+{
+	QByteArray data;
+#if defined(Q_OS_LINUX)
+	data = m_writer->recentOutput(name);
+#else
+	Q_UNUSED(name);
+#endif
+
+	if (data.isEmpty())
+	{
+		QFile file(filename);
+		if (file.open(QIODevice::ReadOnly))
+		{
+			file.seek(qMax<qint64>(0, file.size() - SIZE_CONSOLERECENT));
+			data = file.read(SIZE_CONSOLERECENT);
+		}
+	}
+
+	return lastLines(data, lines);
+}
+
+
+// New output of followed apps is sent with the output signal
+void ConsoleCapture::setFollowed(const QString& name, const QString& filename, bool followed)
+{
+#if defined(Q_OS_LINUX)
+	Q_UNUSED(filename);
+	emit writerSetFollowed(name, followed);
+#else
+	if (followed)
+	{
+		FollowedFile followedFile;
+		followedFile.filename = filename;
+		followedFile.offset = QFileInfo(filename).size();
+		m_followedFiles[name] = followedFile;
+		if (!m_followTimer.isActive())
+			m_followTimer.start();
+	}
+	else
+	{
+		m_followedFiles.remove(name);
+		if (m_followedFiles.isEmpty())
+			m_followTimer.stop();
+	}
+#endif
+}
+
+
+// The app was deleted or renamed
+void ConsoleCapture::forgetRecent(const QString& name)
+{
+#if defined(Q_OS_LINUX)
+	m_writer->forgetRecent(name);
+#else
+	Q_UNUSED(name);
+#endif
+}
+
+
+// Marks where followed output was too much to send and some was left out
+QByteArray ConsoleCapture::skippedOutput(qint64 skipped)
+{
+	return tr("\n[%1 bytes of output skipped]\n").arg(skipped).toUtf8();
+}
+
+
+#if !defined(Q_OS_LINUX)
+void ConsoleCapture::readFollowed()
+{
+	for (auto followed = m_followedFiles.begin(); followed != m_followedFiles.end(); ++followed)
+	{
+		QFile file(followed->filename);
+		if (!file.open(QIODevice::ReadOnly))
+			continue;
+
+		// Files that were cleared or rotated are followed from the start
+		qint64 size = file.size();
+		if (size < followed->offset)
+			followed->offset = 0;
+		if (size == followed->offset)
+			continue;
+
+		QByteArray data;
+		qint64 skipped = size - followed->offset - SIZE_CONSOLEFOLLOW;
+		if (skipped > 0)
+		{
+			data = skippedOutput(skipped);
+			followed->offset += skipped;
+		}
+
+		file.seek(followed->offset);
+		data.append(file.read(size - followed->offset));
+		followed->offset = size;
+		emit output(followed.key(), data);
+	}
+}
+#endif
+
+
+// Gets the capture file ready for writing. The file is cleared unless it's
+// kept, kept files that are due to rotate are rotated first.
+void ConsoleCapture::prepareFile(const CaptureConfig& config, bool keep)
+{
+	QFileInfo info(config.filename);
+	if (!info.exists())
+		return;
+
+	if (!keep)
+	{
+		QFile file(config.filename);
+		if (!file.resize(0))
+		{
+			Logger(LOG_ERROR) << tr("Error clearing console output file '%1': '%2'")
+				.arg(config.filename)
+				.arg(file.errorString());
+		}
+		return;
+	}
+
+	if (info.size() > 0 &&
+		((config.rotateSize > 0 && info.size() >= config.rotateSize) ||
+		rotationPeriod(config, info.lastModified()) != rotationPeriod(config, QDateTime::currentDateTime())))
+	{
+		rotateFile(config);
+	}
+}
+
+
+// Renames the capture file after the time it was rotated and starts compressing it
+bool ConsoleCapture::rotateFile(const CaptureConfig& config)
+{
+	QString base = config.filename + "." + QDateTime::currentDateTime().toString(s_segmentTimeFormat);
+	QString segment = base;
+	for (int n = 1; QFile::exists(segment) || QFile::exists(segment + ".gz"); n++)
+		segment = base + QString("-%1").arg(n);
+
+	if (!QFile::rename(config.filename, segment))
+	{
+		Logger(LOG_ERROR) << tr("Error rotating console output file '%1' to '%2'")
+			.arg(config.filename)
+			.arg(segment);
+		return false;
+	}
+
+	Logger(LOG_EXTRA) << tr("Rotated console output file '%1' to '%2'")
+		.arg(config.filename)
+		.arg(segment);
+
+	removeOldSegments(config.filename);
+	if (config.compress)
+		QtConcurrent::run(&ConsoleCapture::compressFile, segment);
+
+	return true;
+}
+
+
+// Index of the rotate period a time falls in, periods are counted from local
+// midnight so daily files start at midnight. Always 0 without time rotation.
+qint64 ConsoleCapture::rotationPeriod(const CaptureConfig& config, const QDateTime& time)
+{
+	if (config.rotatePeriod <= 0)
+		return 0;
+
+	qint64 localMSecs = time.toMSecsSinceEpoch() + static_cast<qint64>(time.offsetFromUtc()) * 1000;
+	return localMSecs / config.rotatePeriod;
+}
+
+
+// Runs on the thread pool, the file is written in chunks as concatenated gzip members
+void ConsoleCapture::compressFile(const QString& filename)
+{
+	QFile in(filename);
+	QSaveFile out(filename + ".gz");
+	if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly))
+	{
+		Logger(LOG_ERROR) << tr("Error compressing console output file '%1'").arg(filename);
+		return;
+	}
+
+	while (!in.atEnd())
+	{
+		QByteArray member = gzipMember(in.read(SIZE_CAPTURECOMPRESSCHUNK));
+		if (member.isEmpty() || out.write(member) != member.size())
+		{
+			Logger(LOG_ERROR) << tr("Error compressing console output file '%1'").arg(filename);
+			out.cancelWriting();
+			return;
+		}
+	}
+
+	in.close();
+	if (!out.commit())
+	{
+		Logger(LOG_ERROR) << tr("Error saving compressed console output file '%1': '%2'")
+			.arg(out.fileName())
+			.arg(out.errorString());
+		return;
+	}
+	QFile::remove(filename);
+}
+
+
+// Rotated files of a capture file with their full paths, oldest first
+QStringList ConsoleCapture::segmentFilenames(const QString& filename)
+{
+	QFileInfo info(filename);
+	QDir dir = info.absoluteDir();
+	QRegExp segmentName(QRegExp::escape(info.fileName()) + "\\.\\d{8}-\\d{6}(-\\d+)?(\\.gz)?");
+
+	QStringList segments;
+	for (const auto& name : dir.entryList(QStringList() << info.fileName() + ".*", QDir::Files, QDir::Name))
+	{
+		if (segmentName.exactMatch(name))
+			segments.append(dir.filePath(name));
+	}
+	return segments;
+}
+
+
+void ConsoleCapture::removeOldSegments(const QString& filename)
+{
+	QStringList segments = segmentFilenames(filename);
+	while (segments.size() > MAX_CAPTURESEGMENTS)
+	{
+		QString oldest = segments.takeFirst();
+		if (!QFile::remove(oldest))
+		{
+			Logger(LOG_WARNING) << tr("Error removing old console output file '%1'").arg(oldest);
+		}
+	}
+}
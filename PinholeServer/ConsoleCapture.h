@@ -0,0 +1,164 @@
+#pragma once
+
+/* ConsoleCapture.h - Writes app console output to capture files with size and time based rotation */
+
+#include <QObject>
+#include <QDateTime>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QTimer>
+
+class QThread;
+class QSocketNotifier;
+
+// How one app's console output is captured
+struct CaptureConfig
+{
+	QString name;					// App the output belongs to
+	QString filename;
+	bool enabled = false;			// Output is thrown away when not capturing
+	bool append = false;			// Keep the existing file when capturing starts
+	qint64 rotateSize = 0;			// Bytes, 0 to not rotate by size
+	qint64 rotatePeriod = 0;		// Milliseconds, 0 to not rotate by time
+	bool compress = false;			// Gzip rotated files
+};
+Q_DECLARE_METATYPE(CaptureConfig)
+
+
+#if defined(Q_OS_LINUX)
+// Moves console output from the apps' pipes to their capture files, lives on the capture thread
+class CaptureWriter : public QObject
+{
+	Q_OBJECT
+
+public:
+	CaptureWriter(QObject *parent = nullptr);
+	~CaptureWriter();
+
+	QByteArray recentOutput(const QString& name) const;
+	void forgetRecent(const QString& name);
+
+signals:
+	void output(const QString& name, const QByteArray& data);
+
+public slots:
+	void openChannel(quint64 id, int pipeFd, const CaptureConfig& config);
+	void configureChannel(quint64 id, const CaptureConfig& config);
+	void closeChannel(quint64 id);
+	void setFollowed(const QString& name, bool followed);
+
+private slots:
+	void pipeReadable(int pipeFd);
+	void checkRotation();
+	void sendFollowed();
+
+private:
+	// The read end of one app's stdout/stderr pipe and the file it goes to
+	struct Channel
+	{
+		int pipeFd = -1;
+		int fileFd = -1;
+		int teeReadFd = -1;			// Second pipe the output is duplicated into for the recent output
+		int teeWriteFd = -1;
+		QSocketNotifier* notifier = nullptr;
+		CaptureConfig config;
+		qint64 size = 0;
+		qint64 period = 0;			// Rotation period the file was started in
+		bool copy = false;			// The file system can't splice, copy instead
+	};
+
+	// Output of a followed app waiting to be sent
+	struct Pending
+	{
+		QByteArray data;
+		qint64 skipped = 0;
+	};
+
+	bool move(Channel& channel);
+	ssize_t transfer(Channel& channel, size_t length);
+	void openTee(Channel& channel);
+	void closeTee(Channel& channel);
+	void readTee(Channel& channel, ssize_t count);
+	void addOutput(const QString& name, const QByteArray& data);
+	void openFile(Channel& channel);
+	void closeFile(Channel& channel);
+	void rotate(Channel& channel);
+	void removeChannel(quint64 id);
+
+	QMap<quint64, Channel> m_channels;
+	int m_nullFd = -1;
+	QTimer m_rotateTimer;
+	mutable QMutex m_recentMutex;		// The recent output is read from the main thread
+	QMap<QString, QByteArray> m_recent;
+	QSet<QString> m_followed;
+	QMap<QString, Pending> m_pending;
+	QTimer m_followTimer;
+};
+#endif
+
+
+// App console output is written to a capture file in the data directory
+// without the server copying it through the event loop. On Linux each app's
+// stdout and stderr are a pipe that the capture thread splices into the file in
+// the kernel, everywhere else the app writes the file itself. Files are rotated
+// once they reach the rotate size or a new rotate period starts, the newest
+// MAX_CAPTURESEGMENTS rotated files are kept and can be gzipped in the background.
+// Without the capture thread, rotation only happens when an app is started.
+// The newest output of each app is also kept in memory for clients that follow
+// it, new output of followed apps is sent with the output signal.
+class ConsoleCapture : public QObject
+{
+	Q_OBJECT
+
+public:
+	ConsoleCapture(QObject *parent = nullptr);
+	~ConsoleCapture();
+
+#if defined(Q_OS_LINUX)
+	quint64 openChannel(const CaptureConfig& config, int& childFd);
+	void configureChannel(quint64 id, const CaptureConfig& config);
+	void closeChannel(quint64 id);
+#endif
+
+	QByteArray recentOutput(const QString& name, const QString& filename, int lines) const;
+	void setFollowed(const QString& name, const QString& filename, bool followed);
+	void forgetRecent(const QString& name);
+
+	static void prepareFile(const CaptureConfig& config, bool keep);
+	static bool rotateFile(const CaptureConfig& config);
+	static qint64 rotationPeriod(const CaptureConfig& config, const QDateTime& time);
+	static QByteArray skippedOutput(qint64 skipped);
+	static QStringList segmentFilenames(const QString& filename);
+
+signals:
+	void output(const QString& name, const QByteArray& data);
+	void writerOpenChannel(quint64 id, int pipeFd, const CaptureConfig& config);
+	void writerConfigureChannel(quint64 id, const CaptureConfig& config);
+	void writerCloseChannel(quint64 id);
+	void writerSetFollowed(const QString& name, bool followed);
+
+#if !defined(Q_OS_LINUX)
+private slots:
+	void readFollowed();
+#endif
+
+private:
+	static void compressFile(const QString& filename);
+	static void removeOldSegments(const QString& filename);
+
+#if defined(Q_OS_LINUX)
+	QThread* m_thread = nullptr;
+	CaptureWriter* m_writer = nullptr;
+	quint64 m_nextId = 1;
+#else
+	// Without the capture thread followed apps' capture files are watched for new output
+	struct FollowedFile
+	{
+		QString filename;
+		qint64 offset = 0;
+	};
+	QMap<QString, FollowedFile> m_followedFiles;
+	QTimer m_followTimer;
+#endif
+};
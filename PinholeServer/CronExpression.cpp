@@ -0,0 +1,189 @@
+#include "CronExpression.h"
+
+#include <QMap>
+#include <QStringList>
+
+// Longest search for a matching day, long enough to find February 29th across 2100
+static const int s_searchDays = 366 * 8;
+
+
+static bool parseValue(const QString& text, int min, int max, const QStringList& names, int& value)
+{
+	int index = names.indexOf(text);
+	if (index >= 0)
+	{
+		value = index + min;
+		return true;
+	}
+
+	bool ok = false;
+	value = text.toInt(&ok);
+	return ok && value >= min && value <= max;
+}
+
+
+// Parses a comma separated list of values, ranges and steps such as "*/15" or "1-5,10"
+static bool parseField(const QString& field, int min, int max, const QStringList& names, QVector<bool>& values)
+{
+	values.fill(false, max + 1);
+
+	for (const auto& part : field.split(','))
+	{
+		QString range = part.section('/', 0, 0);
+		bool hasStep = part.contains('/');
+		int step = 1;
+		if (hasStep)
+		{
+			bool ok = false;
+			step = part.section('/', 1).toInt(&ok);
+			if (!ok || step < 1)
+				return false;
+		}
+
+		int first = min;
+		int last = max;
+		if ("*" != range)
+		{
+			int dash = range.indexOf('-');
+			if (!parseValue(dash < 0 ? range : range.left(dash), min, max, names, first))
+				return false;
+
+			if (dash >= 0)
+			{
+				if (!parseValue(range.mid(dash + 1), min, max, names, last) || last < first)
+					return false;
+			}
+			else if (!hasStep)
+			{
+				last = first;
+			}
+		}
+
+		for (int n = first; n <= last; n += step)
+		{
+			values[n] = true;
+		}
+	}
+
+	return true;
+}
+
+
+CronExpression::CronExpression(const QString& expression)
+{
+	static const QMap<QString, QString> macros =
+	{
+		{ "@yearly", "0 0 1 1 *" },
+		{ "@annually", "0 0 1 1 *" },
+		{ "@monthly", "0 0 1 * *" },
+		{ "@weekly", "0 0 * * 0" },
+		{ "@daily", "0 0 * * *" },
+		{ "@midnight", "0 0 * * *" },
+		{ "@hourly", "0 * * * *" }
+	};
+	static const QStringList monthNames =
+		{ "jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec" };
+	static const QStringList dayNames =
+		{ "sun", "mon", "tue", "wed", "thu", "fri", "sat" };
+
+	QString simplified = expression.simplified().toLower();
+	QStringList fields = macros.value(simplified, simplified).split(' ', QString::SkipEmptyParts);
+
+	// A sixth leading field gives seconds, otherwise events trigger on the minute
+	if (5 == fields.size())
+		fields.prepend("0");
+	if (6 != fields.size())
+		return;
+
+	m_valid = parseField(fields[0], 0, 59, QStringList(), m_seconds) &&
+		parseField(fields[1], 0, 59, QStringList(), m_minutes) &&
+		parseField(fields[2], 0, 23, QStringList(), m_hours) &&
+		parseField(fields[3], 1, 31, QStringList(), m_daysOfMonth) &&
+		parseField(fields[4], 1, 12, monthNames, m_months) &&
+		parseField(fields[5], 0, 7, dayNames, m_daysOfWeek);
+
+	if (m_valid)
+	{
+		// 7 is also Sunday
+		m_daysOfWeek[0] = m_daysOfWeek[0] || m_daysOfWeek[7];
+
+		// Like cron, a day matches either day field when both are restricted
+		m_anyDayOfMonth = fields[3].startsWith('*');
+		m_anyDayOfWeek = fields[5].startsWith('*');
+	}
+}
+
+
+bool CronExpression::matchesDate(const QDate& date) const
+{
+	if (!m_months[date.month()])
+		return false;
+
+	bool dayOfMonth = m_daysOfMonth[date.day()];
+	bool dayOfWeek = m_daysOfWeek[date.dayOfWeek() % 7];
+	if (m_anyDayOfMonth || m_anyDayOfWeek)
+		return dayOfMonth && dayOfWeek;
+	return dayOfMonth || dayOfWeek;
+}
+
+
+// Returns the first time after the given time that matches in local time, or
+// an invalid QDateTime if there is none
+QDateTime CronExpression::next(const QDateTime& after) const
+{
+	if (!m_valid)
+		return QDateTime();
+
+	QDateTime start = after.toLocalTime();
+	start = start.addMSecs(1000 - start.time().msec());
+
+	QDate date = start.date();
+	QTime from = start.time();
+	for (int days = 0; days < s_searchDays; days++, date = date.addDays(1), from = QTime(0, 0))
+	{
+		if (!matchesDate(date))
+			continue;
+
+		for (int hour = from.hour(); hour < 24; hour++)
+		{
+			if (!m_hours[hour])
+				continue;
+
+			bool firstHour = hour == from.hour();
+			for (int minute = firstHour ? from.minute() : 0; minute < 60; minute++)
+			{
+				if (!m_minutes[minute])
+					continue;
+
+				bool firstMinute = firstHour && minute == from.minute();
+				for (int second = firstMinute ? from.second() : 0; second < 60; second++)
+				{
+					if (!m_seconds[second])
+						continue;
+
+					// Times repeated when daylight saving ends only trigger once
+					QDateTime candidate = localDateTime(date, QTime(hour, minute, second));
+					if (candidate > after)
+						return candidate;
+				}
+			}
+		}
+	}
+
+	return QDateTime();
+}
+
+
+// Returns a local time, times skipped when daylight saving starts happen when
+// the clock reaches the end of the gap
+QDateTime CronExpression::localDateTime(const QDate& date, const QTime& time)
+{
+	QDateTime dateTime(date, time);
+	QDateTime wallClock(date, time, Qt::UTC);
+	for (int minutes = 1; !dateTime.isValid() && minutes <= 180; minutes++)
+	{
+		QDateTime shifted = wallClock.addSecs(minutes * 60);
+		dateTime = QDateTime(shifted.date(), shifted.time());
+	}
+	return dateTime;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+/* CronExpression.h - Parses cron schedules and finds the next local time they match */
+
+#include <QDateTime>
+#include <QString>
+#include <QVector>
+
+// Standard five field cron expressions (minute hour day-of-month month day-of-week)
+// with an optional leading seconds field, plus the @hourly style macros.
+class CronExpression
+{
+public:
+	CronExpression() {}
+	explicit CronExpression(const QString& expression);
+
+	bool isValid() const { return m_valid; }
+	QDateTime next(const QDateTime& after) const;
+
+	static QDateTime localDateTime(const QDate& date, const QTime& time);
+
+private:
+	bool matchesDate(const QDate& date) const;
+
+	QVector<bool> m_seconds;
+	QVector<bool> m_minutes;
+	QVector<bool> m_hours;
+	QVector<bool> m_daysOfMonth;
+	QVector<bool> m_months;
+	QVector<bool> m_daysOfWeek;			// 0 is Sunday
+	bool m_anyDayOfMonth = true;
+	bool m_anyDayOfWeek = true;
+	bool m_valid = false;
+};
@@ -6,6 +6,7 @@
 #include "GlobalManager.h"
 #include "ScheduleManager.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include "Values.h"
 #include "WinUtil.h"
 #include "../common/PinholeCommon.h"
@@ -22,8 +23,31 @@
 EncryptedTcpServer::EncryptedTcpServer(Settings* settings, QObject *parent)
 	: QTcpServer(parent), m_settings(settings)
 {
-	QFile keyFile(settings->dataDir() + FILENAME_KEYFILE);
-	QFile certFile(settings->dataDir() + FILENAME_CERTFILE);
+	m_receivedBytes = Metrics::counter(METRIC_RECEIVED_BYTES, Metrics::label("interface", METRIC_INTERFACE_TCP));
+	m_sentBytes = Metrics::counter(METRIC_SENT_BYTES, Metrics::label("interface", METRIC_INTERFACE_TCP));
+
+	connect(this, (void (QTcpServer::*)(QAbstractSocket::SocketError))&QTcpServer::acceptError,
+		this, &EncryptedTcpServer::serverAcceptError);
+	connect(this, &EncryptedTcpServer::newConnection, 
+		this, &EncryptedTcpServer::link);
+}
+
+
+EncryptedTcpServer::~EncryptedTcpServer()
+{
+	delete m_key;
+	delete m_cert;
+}
+
+
+// Reads the key pair from the data directory, returns false if there isn't a valid one
+bool EncryptedTcpServer::loadKeys()
+{
+	if (m_cert != nullptr && m_key != nullptr)
+		return !m_cert->isNull() && !m_key->isNull();
+
+	QFile keyFile(m_settings->dataDir() + FILENAME_KEYFILE);
+	QFile certFile(m_settings->dataDir() + FILENAME_CERTFILE);
 
 	if (keyFile.exists() && certFile.exists() &&
 		keyFile.size() > 0 && certFile.size() > 0)
@@ -41,72 +65,75 @@ EncryptedTcpServer::EncryptedTcpServer(Settings* settings, QObject *parent)
 			.arg(certFile.fileName());
 	}
 
-	// If no keys or bad keys, generate keys
-	if (m_cert == nullptr || m_key == nullptr || m_cert->isNull() || m_key->isNull())
-	{
-		Logger() << tr("Generating key/cert pair...");
+	return m_cert != nullptr && m_key != nullptr && !m_cert->isNull() && !m_key->isNull();
+}
 
-		if (m_cert != nullptr)
-			delete m_cert;
-		if (m_key != nullptr)
-			delete m_key;
 
-		QPair<QSslCertificate, QSslKey> certPair = GenerateCertKeyPair("US", "Obscura", "Obscura LLC");
+// Generates a key pair and writes it to the data directory, slow so it's left
+// until the server is started
+void EncryptedTcpServer::generateKeys()
+{
+	QFile keyFile(m_settings->dataDir() + FILENAME_KEYFILE);
+	QFile certFile(m_settings->dataDir() + FILENAME_CERTFILE);
 
-		m_cert = new QSslCertificate(certPair.first);
-		m_key = new QSslKey(certPair.second);
+	Logger() << tr("Generating key/cert pair...");
 
-		if (!keyFile.open(QIODevice::WriteOnly))
-		{
-			Logger(LOG_ERROR) << tr("Failed to open key file '%1': %2")
-				.arg(keyFile.fileName())
-				.arg(keyFile.errorString());
-		}
-		else
-		{
-			keyFile.write(m_key->toPem());
-			keyFile.close();
-		}
+	if (m_cert != nullptr)
+		delete m_cert;
+	if (m_key != nullptr)
+		delete m_key;
 
-		if (!certFile.open(QIODevice::WriteOnly))
-		{
-			Logger(LOG_ERROR) << tr("Failed to open cert file '%1': %2")
-				.arg(keyFile.fileName())
-				.arg(keyFile.errorString());
-		}
-		else
-		{
-			certFile.write(m_cert->toPem());
-			certFile.close();
-		}
+	QPair<QSslCertificate, QSslKey> certPair = GenerateCertKeyPair("US", "Obscura", "Obscura LLC");
+
+	m_cert = new QSslCertificate(certPair.first);
+	m_key = new QSslKey(certPair.second);
 
-		Logger() << tr("Key pair written: %1 %2")
+	if (!keyFile.open(QIODevice::WriteOnly))
+	{
+		Logger(LOG_ERROR) << tr("Failed to open key file '%1': %2")
 			.arg(keyFile.fileName())
-			.arg(certFile.fileName());
+			.arg(keyFile.errorString());
+	}
+	else
+	{
+		keyFile.write(m_key->toPem());
+		keyFile.close();
 	}
 
-	// This is BAD
-	if (m_cert->isNull())
-		Logger(LOG_ALWAYS) << tr("WARNING:  Server certificate is null!!!");
-	if (m_key->isNull())
-		Logger(LOG_ALWAYS) << tr("WARNING:  Server key is null!!!");
+	if (!certFile.open(QIODevice::WriteOnly))
+	{
+		Logger(LOG_ERROR) << tr("Failed to open cert file '%1': %2")
+			.arg(keyFile.fileName())
+			.arg(keyFile.errorString());
+	}
+	else
+	{
+		certFile.write(m_cert->toPem());
+		certFile.close();
+	}
 
-	connect(this, (void (QTcpServer::*)(QAbstractSocket::SocketError))&QTcpServer::acceptError,
-		this, &EncryptedTcpServer::serverAcceptError);
-	connect(this, &EncryptedTcpServer::newConnection, 
-		this, &EncryptedTcpServer::link);
+	Logger() << tr("Key pair written: %1 %2")
+		.arg(keyFile.fileName())
+		.arg(certFile.fileName());
 }
 
 
-EncryptedTcpServer::~EncryptedTcpServer()
+void EncryptedTcpServer::start()
 {
-	delete m_key;
-	delete m_cert;
-}
+	if (isListening())
+		return;
 
+	if (!loadKeys())
+	{
+		generateKeys();
+	}
+
+	// This is BAD
+	if (m_cert->isNull())
+		Logger(LOG_ALWAYS) << tr("WARNING:  Server certificate is null!!!");
+	if (m_key->isNull())
+		Logger(LOG_ALWAYS) << tr("WARNING:  Server key is null!!!");
 
-void EncryptedTcpServer::start()
-{
 	// Make server listen
 	if (!listen(QHostAddress::Any, HOST_TCPPORT)) {
 		Logger(LOG_ERROR) << tr("Unable to start the TCP server");
@@ -132,6 +159,7 @@ void EncryptedTcpServer::sendDataToClient(const QString & clientId, const QByteA
 	auto client = m_clientMap[clientId];
 	client->socket->write(data);
 	client->socket->flush();
+	m_sentBytes->increment(data.size());
 }
 
 
@@ -201,12 +229,16 @@ void EncryptedTcpServer::rx()
 		if (0 == client->dataLeft)
 		{
 			QByteArray sizeArray = clientSocket->read(sizeof(uint32_t));
+			m_receivedBytes->increment(sizeArray.size());
 			uint32_t size;
 			memcpy(&size, sizeArray.data(), sizeof(size));
-			client->dataLeft = qFromLittleEndian(size);
+			size = qFromLittleEndian(size);
+			client->dataLeft = size & FRAME_SIZEMASK;
+			client->compressed = (size & FRAME_COMPRESSED) != 0;
 		}
 
 		QByteArray data = clientSocket->read(client->dataLeft);
+		m_receivedBytes->increment(data.size());
 		client->data += data;
 		client->dataLeft -= data.size();
 
@@ -216,6 +248,10 @@ void EncryptedTcpServer::rx()
 			return;
 		}
 
+		// Bad compressed data is empty, which disconnects the client
+		if (client->compressed)
+			client->data = UncompressFrameData(client->data);
+
 		QByteArray response;
 		bool disconnect = false;
 		emit incomingData(clientAddr, client->data, response, disconnect);
@@ -227,6 +263,7 @@ void EncryptedTcpServer::rx()
 		{
 			clientSocket->write(response);
 			clientSocket->flush();
+			m_sentBytes->increment(response.size());
 		}
 
 		if (disconnect)
@@ -13,6 +13,7 @@ class ScheduleManager;
 class QSslError;
 class QSslKey;
 class QSslCertificate;
+class MetricCounter;
 
 
 class EncryptedTcpServer : public QTcpServer
@@ -24,12 +25,14 @@ class EncryptedTcpServer : public QTcpServer
 	public:
 		QByteArray data;					// Data received from the client
 		uint32_t dataLeft = 0;				// Data left to receive from the client in this packet
+		bool compressed = false;			// This packet's data is compressed
 		QTcpSocket* socket = nullptr;		// Client socket
 	};
 
 public:
 	EncryptedTcpServer(Settings* settings, QObject *parent = nullptr);
 	~EncryptedTcpServer();
+	bool loadKeys();
 
 public slots:
 	void sslErrors(const QList<QSslError> &errors);
@@ -53,11 +56,14 @@ protected:
 	void incomingConnection(qintptr descriptor) override;
 
 private:
+	void generateKeys();
 
 	QSslKey* m_key = nullptr;
 	QSslCertificate* m_cert = nullptr;
 	QMap<QString, QSharedPointer<ClientInfo>> m_clientMap;
 	Settings* m_settings = nullptr;
+	MetricCounter* m_receivedBytes = nullptr;
+	MetricCounter* m_sentBytes = nullptr;
 };
 
 
@@ -1,23 +1,15 @@
 #include "GlobalManager.h"
 #include "Settings.h"
 #include "Logger.h"
-#include "Sigar.h"
+#include "SysInfo.h"
 #include "Values.h"
 #include "../common/Utilities.h"
-#include "../common/Version.h"
 
 #include <QSettings>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
-#include <QSysInfo>
-#include <QStorageInfo>
-#include <QNetworkInterface>
-#include <QHostInfo>
-#include <QDir>
-#include <QCoreApplication>
-#include <QDateTime>
 
 
 #if defined(Q_OS_WIN)
@@ -33,6 +25,8 @@ GlobalManager::GlobalManager(Settings* settings, QObject *parent)
 	: QObject(parent), m_settings(settings)
 {
 	readGlobalSettings();
+
+	m_sysInfo = new SysInfo(settings, this);
 }
 
 
@@ -43,34 +37,33 @@ GlobalManager::~GlobalManager()
 
 bool GlobalManager::readGlobalSettings()
 {
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
-	setRole(settings->value(PROP_GLOBAL_ROLE, "").toString());
-	setHostLogLevel(settings->value(PROP_GLOBAL_HOSTLOGLEVEL, LOG_LEVEL_NORMAL).toString());
-	setRemoteLogLevel(settings->value(PROP_GLOBAL_REMOTELOGLEVEL, LOG_LEVEL_NORMAL).toString());
-	setAppTerminateTimeout(settings->value(PROP_GLOBAL_TERMINATETIMEOUT, DEFAULT_TERMINATE_TO).toInt());
-	setAppHeartbeatTimeout(settings->value(PROP_GLOBAL_HEARTBEATTIMEOUT, DEFAULT_HEARTBEAT_TO).toInt());
-	setCrashPeriod(settings->value(PROP_GLOBAL_CRASHPERIOD, DEFAULT_CRASHPERIOD).toInt());
-	setCrashCount(settings->value(PROP_GLOBAL_CRASHCOUNT, DEFAULT_CRASHCOUNT).toInt());
-	setTrayLaunch(settings->value(PROP_GLOBAL_TRAYLAUNCH, true).toBool());
-	setTrayControl(settings->value(PROP_GLOBAL_TRAYCONTROL, false).toBool());
-	setHttpEnabled(settings->value(PROP_GLOBAL_HTTPENABLED, false).toBool());
-	setHttpPort(settings->value(PROP_GLOBAL_HTTPPORT, DEFAULT_HTTPPORT).toInt());
-	setBackendServer(settings->value(PROP_GLOBAL_BACKENDSERVER, "").toString());
-	setNovaSite(settings->value(PROP_GLOBAL_NOVASITE, "").toString());
-	setNovaArea(settings->value(PROP_GLOBAL_NOVAAREA, "").toString());
-	setNovaDisplay(settings->value(PROP_GLOBAL_NOVADISPLAY, "").toString());
-	setNovaTcpEnabled(settings->value(PROP_GLOBAL_NOVATCPENABLED, false).toBool());
-	setNovaTcpAddress(settings->value(PROP_GLOBAL_NOVATCPADDRESS, DEFAULT_NOVATCPADDRESS).toString());
-	setNovaTcpPort(settings->value(PROP_GLOBAL_NOVATCPPORT, DEFAULT_NOVATCPPORT).toInt());
-	setNovaUdpEnabled(settings->value(PROP_GLOBAL_NOVAUDPENABLED, false).toBool());
-	setNovaUdpAddress(settings->value(PROP_GLOBAL_NOVAUDPADDRESS, "").toString());
-	setNovaUdpPort(settings->value(PROP_GLOBAL_NOVAUDPPORT, DEFAULT_NOVAUDPPORT).toInt());
-	setAlertMemory(settings->value(PROP_GLOBAL_ALERTMEMORY, false).toBool());
-	setMinMemory(settings->value(PROP_GLOBAL_MINMEMORY, 0).toInt());
-	setAlertDisk(settings->value(PROP_GLOBAL_ALERTDISK, false).toBool());
-	setMinDisk(settings->value(PROP_GLOBAL_MINDISK, 0).toInt());
-	setAlertDiskList(settings->value(PROP_GLOBAL_ALERTDISKLIST, QStringList()).toStringList());
+	setRole(m_settings->value(PROP_GLOBAL_ROLE, "").toString());
+	setHostLogLevel(m_settings->value(PROP_GLOBAL_HOSTLOGLEVEL, LOG_LEVEL_NORMAL).toString());
+	setRemoteLogLevel(m_settings->value(PROP_GLOBAL_REMOTELOGLEVEL, LOG_LEVEL_NORMAL).toString());
+	setAppTerminateTimeout(m_settings->value(PROP_GLOBAL_TERMINATETIMEOUT, DEFAULT_TERMINATE_TO).toInt());
+	setAppHeartbeatTimeout(m_settings->value(PROP_GLOBAL_HEARTBEATTIMEOUT, DEFAULT_HEARTBEAT_TO).toInt());
+	setCrashPeriod(m_settings->value(PROP_GLOBAL_CRASHPERIOD, DEFAULT_CRASHPERIOD).toInt());
+	setCrashCount(m_settings->value(PROP_GLOBAL_CRASHCOUNT, DEFAULT_CRASHCOUNT).toInt());
+	setMaxLaunches(m_settings->value(PROP_GLOBAL_MAXLAUNCHES, DEFAULT_MAXLAUNCHES).toInt());
+	setTrayLaunch(m_settings->value(PROP_GLOBAL_TRAYLAUNCH, true).toBool());
+	setTrayControl(m_settings->value(PROP_GLOBAL_TRAYCONTROL, false).toBool());
+	setHttpEnabled(m_settings->value(PROP_GLOBAL_HTTPENABLED, false).toBool());
+	setHttpPort(m_settings->value(PROP_GLOBAL_HTTPPORT, DEFAULT_HTTPPORT).toInt());
+	setBackendServer(m_settings->value(PROP_GLOBAL_BACKENDSERVER, "").toString());
+	setNovaSite(m_settings->value(PROP_GLOBAL_NOVASITE, "").toString());
+	setNovaArea(m_settings->value(PROP_GLOBAL_NOVAAREA, "").toString());
+	setNovaDisplay(m_settings->value(PROP_GLOBAL_NOVADISPLAY, "").toString());
+	setNovaTcpEnabled(m_settings->value(PROP_GLOBAL_NOVATCPENABLED, false).toBool());
+	setNovaTcpAddress(m_settings->value(PROP_GLOBAL_NOVATCPADDRESS, DEFAULT_NOVATCPADDRESS).toString());
+	setNovaTcpPort(m_settings->value(PROP_GLOBAL_NOVATCPPORT, DEFAULT_NOVATCPPORT).toInt());
+	setNovaUdpEnabled(m_settings->value(PROP_GLOBAL_NOVAUDPENABLED, false).toBool());
+	setNovaUdpAddress(m_settings->value(PROP_GLOBAL_NOVAUDPADDRESS, "").toString());
+	setNovaUdpPort(m_settings->value(PROP_GLOBAL_NOVAUDPPORT, DEFAULT_NOVAUDPPORT).toInt());
+	setAlertMemory(m_settings->value(PROP_GLOBAL_ALERTMEMORY, false).toBool());
+	setMinMemory(m_settings->value(PROP_GLOBAL_MINMEMORY, 0).toInt());
+	setAlertDisk(m_settings->value(PROP_GLOBAL_ALERTDISK, false).toBool());
+	setMinDisk(m_settings->value(PROP_GLOBAL_MINDISK, 0).toInt());
+	setAlertDiskList(m_settings->value(PROP_GLOBAL_ALERTDISKLIST, QStringList()).toStringList());
 
 	return true;
 }
@@ -82,34 +75,33 @@ bool GlobalManager::writeGlobalSettings() const
 	//qDebug() << "Writing global settings" << settings->fileName() << settings->isWritable();
 #endif
 
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
-	settings->setValue(PROP_GLOBAL_ROLE, getRole());
-	settings->setValue(PROP_GLOBAL_HOSTLOGLEVEL, getHostLogLevel());
-	settings->setValue(PROP_GLOBAL_REMOTELOGLEVEL, getRemoteLogLevel());
-	settings->setValue(PROP_GLOBAL_TERMINATETIMEOUT, getAppTerminateTimeout());
-	settings->setValue(PROP_GLOBAL_HEARTBEATTIMEOUT, getAppHeartbeatTimeout());
-	settings->setValue(PROP_GLOBAL_CRASHPERIOD, getCrashPeriod());
-	settings->setValue(PROP_GLOBAL_CRASHCOUNT, getCrashCount());
-	settings->setValue(PROP_GLOBAL_TRAYLAUNCH, getTrayLaunch());
-	settings->setValue(PROP_GLOBAL_TRAYCONTROL, getTrayControl());
-	settings->setValue(PROP_GLOBAL_HTTPENABLED, getHttpEnabled());
-	settings->setValue(PROP_GLOBAL_HTTPPORT, getHttpPort());
-	settings->setValue(PROP_GLOBAL_BACKENDSERVER, getBackendServer());
-	settings->setValue(PROP_GLOBAL_NOVASITE, getNovaSite());
-	settings->setValue(PROP_GLOBAL_NOVAAREA, getNovaArea());
-	settings->setValue(PROP_GLOBAL_NOVADISPLAY, getNovaDisplay());
-	settings->setValue(PROP_GLOBAL_NOVATCPENABLED, getNovaTcpEnabled());
-	settings->setValue(PROP_GLOBAL_NOVATCPADDRESS, getNovaTcpAddress());
-	settings->setValue(PROP_GLOBAL_NOVATCPPORT, getNovaTcpPort());
-	settings->setValue(PROP_GLOBAL_NOVAUDPENABLED, getNovaUdpEnabled());
-	settings->setValue(PROP_GLOBAL_NOVAUDPADDRESS, getNovaUdpAddress());
-	settings->setValue(PROP_GLOBAL_NOVAUDPPORT, getNovaUdpPort());
-	settings->setValue(PROP_GLOBAL_ALERTMEMORY, getAlertMemory());
-	settings->setValue(PROP_GLOBAL_MINMEMORY, getMinMemory());
-	settings->setValue(PROP_GLOBAL_ALERTDISK, getAlertDisk());
-	settings->setValue(PROP_GLOBAL_MINDISK, getMinDisk());
-	settings->setValue(PROP_GLOBAL_ALERTDISKLIST, getAlertDiskList());
+	m_settings->setValue(PROP_GLOBAL_ROLE, getRole());
+	m_settings->setValue(PROP_GLOBAL_HOSTLOGLEVEL, getHostLogLevel());
+	m_settings->setValue(PROP_GLOBAL_REMOTELOGLEVEL, getRemoteLogLevel());
+	m_settings->setValue(PROP_GLOBAL_TERMINATETIMEOUT, getAppTerminateTimeout());
+	m_settings->setValue(PROP_GLOBAL_HEARTBEATTIMEOUT, getAppHeartbeatTimeout());
+	m_settings->setValue(PROP_GLOBAL_CRASHPERIOD, getCrashPeriod());
+	m_settings->setValue(PROP_GLOBAL_CRASHCOUNT, getCrashCount());
+	m_settings->setValue(PROP_GLOBAL_MAXLAUNCHES, getMaxLaunches());
+	m_settings->setValue(PROP_GLOBAL_TRAYLAUNCH, getTrayLaunch());
+	m_settings->setValue(PROP_GLOBAL_TRAYCONTROL, getTrayControl());
+	m_settings->setValue(PROP_GLOBAL_HTTPENABLED, getHttpEnabled());
+	m_settings->setValue(PROP_GLOBAL_HTTPPORT, getHttpPort());
+	m_settings->setValue(PROP_GLOBAL_BACKENDSERVER, getBackendServer());
+	m_settings->setValue(PROP_GLOBAL_NOVASITE, getNovaSite());
+	m_settings->setValue(PROP_GLOBAL_NOVAAREA, getNovaArea());
+	m_settings->setValue(PROP_GLOBAL_NOVADISPLAY, getNovaDisplay());
+	m_settings->setValue(PROP_GLOBAL_NOVATCPENABLED, getNovaTcpEnabled());
+	m_settings->setValue(PROP_GLOBAL_NOVATCPADDRESS, getNovaTcpAddress());
+	m_settings->setValue(PROP_GLOBAL_NOVATCPPORT, getNovaTcpPort());
+	m_settings->setValue(PROP_GLOBAL_NOVAUDPENABLED, getNovaUdpEnabled());
+	m_settings->setValue(PROP_GLOBAL_NOVAUDPADDRESS, getNovaUdpAddress());
+	m_settings->setValue(PROP_GLOBAL_NOVAUDPPORT, getNovaUdpPort());
+	m_settings->setValue(PROP_GLOBAL_ALERTMEMORY, getAlertMemory());
+	m_settings->setValue(PROP_GLOBAL_MINMEMORY, getMinMemory());
+	m_settings->setValue(PROP_GLOBAL_ALERTDISK, getAlertDisk());
+	m_settings->setValue(PROP_GLOBAL_MINDISK, getMinDisk());
+	m_settings->setValue(PROP_GLOBAL_ALERTDISKLIST, getAlertDiskList());
 
 	return true;
 }
@@ -124,6 +116,7 @@ bool GlobalManager::importSettings(const QJsonObject& root)
 	setAppHeartbeatTimeout(ReadJsonValueWithDefault(root, PROP_GLOBAL_HEARTBEATTIMEOUT, getAppHeartbeatTimeout()).toInt());
 	setCrashPeriod(ReadJsonValueWithDefault(root, PROP_GLOBAL_CRASHPERIOD, getCrashPeriod()).toInt());
 	setCrashCount(ReadJsonValueWithDefault(root, PROP_GLOBAL_CRASHCOUNT, getCrashCount()).toInt());
+	setMaxLaunches(ReadJsonValueWithDefault(root, PROP_GLOBAL_MAXLAUNCHES, getMaxLaunches()).toInt());
 	setTrayControl(ReadJsonValueWithDefault(root, PROP_GLOBAL_TRAYLAUNCH, getTrayLaunch()).toBool());
 	setTrayControl(ReadJsonValueWithDefault(root, PROP_GLOBAL_TRAYCONTROL, getTrayControl()).toBool());
 	setHttpEnabled(ReadJsonValueWithDefault(root, PROP_GLOBAL_HTTPENABLED, getHttpEnabled()).toBool());
@@ -158,6 +151,7 @@ QJsonObject GlobalManager::exportSettings() const
 	root[PROP_GLOBAL_HEARTBEATTIMEOUT] = getAppHeartbeatTimeout();
 	root[PROP_GLOBAL_CRASHPERIOD] = getCrashPeriod();
 	root[PROP_GLOBAL_CRASHCOUNT] = getCrashCount();
+	root[PROP_GLOBAL_MAXLAUNCHES] = getMaxLaunches();
 	root[PROP_GLOBAL_TRAYLAUNCH] = getTrayLaunch();
 	root[PROP_GLOBAL_TRAYCONTROL] = getTrayControl();
 	root[PROP_GLOBAL_HTTPENABLED] = getHttpEnabled();
@@ -339,6 +333,29 @@ bool GlobalManager::setCrashCount(int val)
 }
 
 
+int GlobalManager::getMaxLaunches() const
+{
+	return m_maxLaunches;
+}
+
+
+bool GlobalManager::setMaxLaunches(int val)
+{
+	if (m_maxLaunches != val)
+	{
+		if (val < MIN_MAXLAUNCHES || val > MAX_MAXLAUNCHES)
+		{
+			Logger(LOG_EXTRA) << tr("Invalid global maximum simultaneous launches value '%1'").arg(val);
+			emit valueChanged(GROUP_GLOBAL, QString(), PROP_GLOBAL_MAXLAUNCHES, QVariant(m_maxLaunches));
+			return false;
+		}
+		m_maxLaunches = val;
+		emit valueChanged(GROUP_GLOBAL, QString(), PROP_GLOBAL_MAXLAUNCHES, QVariant(m_maxLaunches));
+	}
+	return true;
+}
+
+
 bool GlobalManager::getTrayLaunch() const
 {
 	return m_trayLaunch;
@@ -713,6 +730,10 @@ QVariant GlobalManager::getGlobalVariant(const QString& item, const QString& pro
 	{
 		return getCrashCount();
 	}
+	else if (PROP_GLOBAL_MAXLAUNCHES == propName)
+	{
+		return getMaxLaunches();
+	}
 	else if (PROP_GLOBAL_TRAYLAUNCH == propName)
 	{
 		return getTrayLaunch();
@@ -827,6 +848,10 @@ bool GlobalManager::setGlobalVariant(const QString& item, const QString& propNam
 	{
 		return setCrashCount(value.toInt());
 	}
+	else if (PROP_GLOBAL_MAXLAUNCHES == propName)
+	{
+		return setMaxLaunches(value.toInt());
+	}
 	else if (PROP_GLOBAL_TRAYLAUNCH == propName)
 	{
 		return setTrayLaunch(value.toBool());
@@ -929,182 +954,17 @@ bool GlobalManager::shutdown()
 }
 
 
-// Returns compressed UTF8 system report text
+// Returns UTF8 system report text
 QByteArray GlobalManager::getSysInfoData() const
 {
-	QString data;
-
-	data += tr("\r\nHost name:          %1").arg(QHostInfo::localHostName());
-	data += tr("\r\nDomain name:        %1").arg(QHostInfo::localDomainName());
-
-	data += "\r\n";
-
-	data += tr("\r\nPinhole version:    %1").arg(PINHOLE_VERSION);
-	data += tr("\r\nQt version:         %1").arg(qVersion());
-	data += tr("\r\nPinhole path:       %1").arg(QDir::toNativeSeparators(QCoreApplication::applicationFilePath()));
-	data += tr("\r\nData directory:     %1").arg(QDir::toNativeSeparators(m_settings->dataDir()));
-	data += tr("\r\nPinhole uptime:     %1").arg(MillisecondsToString(m_settings->uptime()));
-	qint64 sysuptime = 0;
-	if (SystemUptime(sysuptime))
-	{
-		data += tr("\r\nSystem uptime:      %1").arg(MillisecondsToString(sysuptime * 1000));
-	}
-	data += tr("\r\nLocal datetime:     %1").arg(QDateTime::currentDateTime().toString());
-
-	data += "\r\n";
-
-	// CPU and OS
-	data += tr("\r\nOS product name:    %1").arg(QSysInfo::prettyProductName());
-	data += tr("\r\nOS product type:    %1").arg(QSysInfo::productType());
-	data += tr("\r\nOS product version: %1").arg(QSysInfo::productVersion());
-	data += tr("\r\nOS kernel type:     %1").arg(QSysInfo::kernelType());
-	data += tr("\r\nOS krnel version:   %1").arg(QSysInfo::kernelVersion());
-	data += tr("\r\nCPU architecture:   %1").arg(QSysInfo::currentCpuArchitecture());
-	
-	quint64 totalMemory = 0;
-	quint64 freeMemory = 0;
-	if (MemoryInformation(totalMemory, freeMemory))
-	{
-		data += tr("\r\nTotal memory:       %L1").arg(totalMemory);
-		data += tr("\r\nFree memory:        %L1").arg(freeMemory);
-	}
-
-	data += "\r\n";
-
-	QList<CpuInfo> cpuInfo = CpuInformation();
-	if (!cpuInfo.isEmpty())
-	{
-		data += tr("\r\nNum CPUs cores:     %1").arg(cpuInfo.size());
-		for (int n = 0; n < cpuInfo.size(); n++)
-		{
-			data += tr("\r\nCPU number %1 info:").arg(n + 1);
-			data += tr("\r\nCPU vendor:         %1").arg(cpuInfo[n].Vendor);
-			data += tr("\r\nCPU model:          %1").arg(cpuInfo[n].Model);
-			data += tr("\r\nCPU MHz:            %1 (Min %2 Max %3)").arg(cpuInfo[n].mhz).arg(cpuInfo[n].mhzMin).arg(cpuInfo[n].mhzMax);
-			data += tr("\r\nCPU cache size:     %L1").arg(cpuInfo[n].cacheSize);
-			data += "\r\n";
-		}
-	}
-
-	data += "\r\n";
-
-	// Network interface list
-	QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
-	data += tr("\r\nNetwork interfaces:");
-	for (const auto& iface : interfaces)
-	{
-		auto flags = iface.flags();
-
-		if (flags & (QNetworkInterface::IsUp | QNetworkInterface::IsRunning))
-		{
-			data += tr("\r\nInterface type:     %1").arg(QtEnumToString(iface.type()));
-			data += tr("\r\nInterface name:     %1 (%2)").arg(iface.humanReadableName()).arg(iface.name());
-			data += tr("\r\nHardware address:   %1").arg(iface.hardwareAddress());
-			data += tr("\r\nMTU:                %L1").arg(iface.maximumTransmissionUnit());
-			data += tr("\r\nNetwork addresses:");
-			QList<QNetworkAddressEntry> addresses = iface.addressEntries();
-			for (const auto& address : addresses)
-			{
-				data += tr("\r\nAddress:            %1").arg(HostAddressToString(address.ip()));
-				data += tr("\r\nNetmask:            %1").arg(HostAddressToString(address.netmask()));
-			}
-		}
-
-		data += "\r\n";
-	}
-
-	data += "\r\n";
-
-	// Route list
-	QList<RouteEntry> routeList = GetRouteList();
-	if (!routeList.isEmpty())
-	{
-		data += tr("\r\nRoute list:");
-		data += QString("\r\n%1%2%3%4%5%6%7%8")
-			.arg(tr("Destination"), -40)
-			.arg(tr("Gateway"), -40)
-			.arg(tr("Mask"), -40)
-			.arg(tr("Metric"), -10)
-			.arg(tr("MTU"), -10)
-			.arg(tr("Window"), -10)
-			.arg(tr("Use"), -10)
-			.arg(tr("Interface"));
-		for (const auto& route : routeList)
-		{
-			data += QString("\r\n%1%2%3%L4%L5%L6%L7%8")
-				.arg(route.destination.toString(), -40)
-				.arg(route.gateway.toString(), -40)
-				.arg(route.mask.toString(), -40)
-				.arg(route.metric, -10)
-				.arg(route.mtu, -10)
-				.arg(route.window, -10)
-				.arg(route.use, -10)
-				.arg(route.interfaceName);
-		}
-	}
-
-	data += "\r\n";
-
-	// Storage
-	data += tr("\r\nStorage volumes:");
-	for (const auto& volume : QStorageInfo::mountedVolumes())
-	{
-		if (volume.isValid())
-		{
-			data += tr("\r\nName:               %1 (%2)").arg(volume.displayName()).arg(volume.name());
-			data += tr("\r\nDevice:             %1").arg(QString(volume.device()));
-			data += tr("\r\nRoot:               %1").arg(QDir::toNativeSeparators(volume.rootPath()));
-			data += tr("\r\nFile system:        %1").arg(QString(volume.fileSystemType()));
-			data += tr("\r\nBytes total:        %L1").arg(volume.bytesTotal());
-			data += tr("\r\nBytes free:         %L1").arg(volume.bytesFree());
-			data += tr("\r\nBytes available:    %L1").arg(volume.bytesAvailable());
-			data += tr("\r\nRead only:          %1").arg(volume.isReadOnly() ? tr("Yes") : tr("No"));
-			data += tr("\r\nReady:              %1").arg(volume.isReady() ? tr("Yes") : tr("No"));
-			data += "\r\n";
-		}
-	}
-
-	data += "\r\n";
-
-	SystemProcessesInfo procInfo;
-	if (GetSystemProcessesInfo(procInfo))
-	{
-		data += tr("\r\nTotal processes:    %L1").arg(procInfo.total);
-		data += tr("\r\nSleeping processes: %L1").arg(procInfo.sleeping);
-		data += tr("\r\nRunning processes:  %L1").arg(procInfo.running);
-		data += tr("\r\nZombie proesses:    %L1").arg(procInfo.zombie);
-		data += tr("\r\nStopped proesses:   %L1").arg(procInfo.stopped);
-		data += tr("\r\nIdle processes:     %L1").arg(procInfo.idle);
-		data += tr("\r\nTotal threads:      %L1").arg(procInfo.threads);
-	}
-
-	// Process list
-	data += tr("\r\nProcess list:");
-	auto procList = runningProcesses();
-	std::sort(procList.begin(), procList.end(), [](ProcessInfo& procA, ProcessInfo& procB) { return procA.id < procB.id; });
-	for (const auto& proc : procList)
-	{
-		data += QString("\r\n%1 %2").arg(proc.id).arg(proc.name);
-	}
-	data += "\r\n";
-
-	QList<WhoEntry> wholist = GetWhoList();
-	if (!wholist.isEmpty())
-	{
-		data += tr("\r\nUsed devices:");
-		for (const auto& who : wholist)
-		{
-			data += tr("\r\nUser:               %1").arg(who.user);
-			data += tr("\r\nDevice:             %1").arg(who.device);
-			data += tr("\r\nHost:               %1").arg(who.host);
-			//data += tr("\r\nTime:               %1").arg(MillisecondsToString(who.time));
-			data += "\r\n";
-		}
-	}
+	return m_sysInfo->text();
+}
 
-	data += "\r\n";
 
-	return data.toUtf8();
+// Returns the system information sections as a map
+QVariantMap GlobalManager::getSysInfoMap() const
+{
+	return m_sysInfo->snapshot();
 }
 
 
@@ -5,6 +5,7 @@
 #include <QObject>
 
 class Settings;
+class SysInfo;
 
 class GlobalManager : public QObject
 {
@@ -32,6 +33,8 @@ public:
 	bool setCrashPeriod(int val);
 	int getCrashCount() const;
 	bool setCrashCount(int val);
+	int getMaxLaunches() const;
+	bool setMaxLaunches(int val);
 	bool getTrayLaunch() const;
 	bool setTrayLaunch(bool b);
 	bool getTrayControl() const;
@@ -77,6 +80,7 @@ public:
 	bool reboot();
 	bool shutdown();
 	QByteArray getSysInfoData() const;
+	QVariantMap getSysInfoMap() const;
 
 signals:
 	void valueChanged(const QString&, const QString&, const QString&, const QVariant&);
@@ -99,6 +103,7 @@ private:
 	int m_appHeartbeatTimeout = DEFAULT_HEARTBEAT_TO;
 	int m_crashPeriod = DEFAULT_CRASHPERIOD;
 	int m_crashCount = DEFAULT_CRASHCOUNT;
+	int m_maxLaunches = DEFAULT_MAXLAUNCHES;
 	bool m_trayLaunch = true;
 	bool m_trayControl = false;
 	bool m_httpEnabled = false;
@@ -120,4 +125,5 @@ private:
 	QStringList m_alertDiskList;
 
 	Settings* m_settings = nullptr;
+	SysInfo* m_sysInfo = nullptr;
 };
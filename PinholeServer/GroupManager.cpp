@@ -14,6 +14,16 @@ GroupManager::GroupManager(Settings* settings, AppManager* appManager, QObject *
 {
 	readGroupSettings();
 
+	// Only groups that change need writing to settings
+	connect(this, &GroupManager::valueChanged,
+		this, [this](const QString&, const QString& groupName, const QString&, const QVariant&)
+	{
+		if (groupName.isEmpty())
+			m_groupListDirty = true;
+		else
+			m_dirtyGroups.insert(groupName);
+	});
+
 	connect(appManager, &AppManager::valueChanged,
 		this, &GroupManager::appManagerValueChanged);
 
@@ -28,21 +38,19 @@ GroupManager::~GroupManager()
 
 bool GroupManager::readGroupSettings()
 {
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
-	QStringList groupList = settings->value(SETTINGS_GROUPLIST).toStringList();
+	QStringList groupList = m_settings->value(SETTINGS_GROUPLIST).toStringList();
 
 	for (const auto& groupName : groupList)
 	{
-		settings->beginGroup(SETTINGS_GROUPPREFIX + groupName);
+		m_settings->beginGroup(SETTINGS_GROUPPREFIX + groupName);
 		QSharedPointer<Group> newGroup = QSharedPointer<Group>::create(groupName);
 		connect(newGroup.data(), &Group::valueChanged,
 			this, &GroupManager::groupValueChanged);
-		newGroup->setApplications(settings->value(PROP_GROUP_APPLICATIONS).toStringList());
+		newGroup->setApplications(m_settings->value(PROP_GROUP_APPLICATIONS).toStringList());
 		
 		m_groupList[groupName] = newGroup;
 
-		settings->endGroup();
+		m_settings->endGroup();
 	}
 
 	return true;
@@ -51,29 +59,33 @@ bool GroupManager::readGroupSettings()
 
 bool GroupManager::writeGroupSettings() const
 {
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
 #ifdef QT_DEBUG
 	//qDebug() << "Writing group settings to " << settings->fileName() << settings->isWritable();
 #endif
 
-	// Delete old entries
-	QStringList groupList = settings->value(SETTINGS_GROUPLIST).toStringList();
+	// Delete entries that no longer exist
+	QStringList groupList = m_settings->value(SETTINGS_GROUPLIST).toStringList();
 	for (const auto& groupName : groupList)
 	{
-		settings->remove(SETTINGS_GROUPPREFIX + groupName);
+		if (!m_groupList.contains(groupName))
+			m_settings->remove(SETTINGS_GROUPPREFIX + groupName);
 	}
 
 	for (const auto& group : m_groupList)
 	{
 		QString groupName = group->getName();
-		settings->beginGroup(SETTINGS_GROUPPREFIX + groupName);
-		settings->setValue(PROP_GROUP_NAME, groupName);
-		settings->setValue(PROP_GROUP_APPLICATIONS, group->getApplications());
-		settings->endGroup();
+		if (!m_groupListDirty && !m_dirtyGroups.contains(groupName))
+			continue;
+
+		m_settings->beginGroup(SETTINGS_GROUPPREFIX + groupName);
+		m_settings->setValue(PROP_GROUP_NAME, groupName);
+		m_settings->setValue(PROP_GROUP_APPLICATIONS, group->getApplications());
+		m_settings->endGroup();
 	}
 
-	settings->setValue(SETTINGS_GROUPLIST, QStringList(m_groupList.keys()));
+	m_settings->setValue(SETTINGS_GROUPLIST, QStringList(m_groupList.keys()));
+	m_dirtyGroups.clear();
+	m_groupListDirty = false;
 
 	return true;
 }
@@ -337,7 +349,7 @@ bool GroupManager::startGroup(const QString& groupName) const
 
 	QStringList appList = m_groupList[groupName]->getApplications();
 
-	return m_appManager->startApps(appList);
+	return m_appManager->launchApps(tr("group %1").arg(groupName), appList);
 }
 
 
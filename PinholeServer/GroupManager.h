@@ -5,6 +5,7 @@
 
 #include <QObject>
 #include <QMap>
+#include <QSet>
 
 class Settings;
 class AppManager;
@@ -59,5 +60,7 @@ private:
 	AppManager* m_appManager = nullptr;
 
 	QMap<QString, QSharedPointer<Group>> m_groupList;
+	mutable QSet<QString> m_dirtyGroups;	// Groups changed since settings were last written
+	mutable bool m_groupListDirty = true;	// Groups added, removed or renamed since settings were last written
 };
 
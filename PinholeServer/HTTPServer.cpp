@@ -4,26 +4,59 @@
 #include "GroupManager.h"
 #include "GlobalManager.h"
 #include "ScheduleManager.h"
+#include "CommandInterface.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include "../common/Utilities.h"
-#include "../common/HostClient.h"
 #include "../common/Version.h"
 
 #include <QUrl>
 #include <QTcpServer>
 #include <QTcpSocket>
-#include <QEventLoop>
 #include <QHostInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#define HTTP_MAXHEADERSIZE		16384		// Largest request header accepted
+#define HTTP_MAXBODYSIZE		65536		// Largest request body accepted (it's ignored)
+#define HTTP_MAXPENDINGWRITE	1048576		// Pipelined requests wait while this many response bytes are unsent
+#define HTTP_IDLETIMEOUT		60000		// Keep-alive connections are closed after this long with no traffic
+#define HTTP_SCREENSHOTTIMEOUT	10000		// How long screenshot requests wait for the helper
+#define HTTP_SCREENSHOTCACHE	1000		// How long a screenshot is reused for later requests
 
 
 HTTPServer::HTTPServer(Settings* settings, AppManager* appManager, GroupManager* groupManager,
-	GlobalManager* globalManager, ScheduleManager* scheduleManager, QObject *parent)
+	GlobalManager* globalManager, ScheduleManager* scheduleManager, CommandInterface* commandInterface,
+	QObject *parent)
 	: QObject(parent), m_settings(settings), m_appManager(appManager), m_groupManager(groupManager),
-	m_globalManager(globalManager), m_scheduleManager(scheduleManager)
+	m_globalManager(globalManager), m_scheduleManager(scheduleManager), m_commandInterface(commandInterface)
 {
 	connect(m_globalManager, &GlobalManager::valueChanged,
 		this, &HTTPServer::globalValueChanged);
 
+	// Status pages are rendered once and served from the cache until what they show changes
+	connect(m_appManager, &AppManager::valueChanged,
+		this, &HTTPServer::managerValueChanged);
+	connect(m_groupManager, &GroupManager::valueChanged,
+		this, &HTTPServer::managerValueChanged);
+	connect(m_scheduleManager, &ScheduleManager::valueChanged,
+		this, &HTTPServer::managerValueChanged);
+
+	// Screenshots are requested from the helper through the command interface
+	connect(m_commandInterface, &CommandInterface::screenshotReady,
+		this, &HTTPServer::screenshotReady);
+	m_screenshotTimer.setInterval(HTTP_SCREENSHOTTIMEOUT);
+	m_screenshotTimer.setSingleShot(true);
+	connect(&m_screenshotTimer, &QTimer::timeout,
+		this, &HTTPServer::screenshotTimeout);
+
+	m_receivedBytes = Metrics::counter(METRIC_RECEIVED_BYTES, Metrics::label("interface", METRIC_INTERFACE_HTTP));
+	m_sentBytes = Metrics::counter(METRIC_SENT_BYTES, Metrics::label("interface", METRIC_INTERFACE_HTTP));
+	m_connectionCount = Metrics::gauge(METRIC_HTTP_CONNECTIONS);
+
 	m_tcpEnabled = m_globalManager->getHttpEnabled();
 	m_tcpPort = m_globalManager->getHttpPort();
 }
@@ -76,6 +109,27 @@ void HTTPServer::globalValueChanged(const QString& groupName, const QString& ite
 }
 
 
+// Moves the version of the pages showing the manager's data on, and drops the
+// rendered row of whatever changed
+void HTTPServer::managerValueChanged(const QString& groupName, const QString& itemName, const QString& propName, const QVariant& value)
+{
+	Q_UNUSED(value);
+
+	PageCache& cache = m_pageCache[groupName];
+	cache.version++;
+
+	if (itemName.isEmpty() || PROP_APP_NAME == propName || PROP_GROUP_NAME == propName || PROP_SCHED_NAME == propName)
+	{
+		// Added, removed or renamed
+		cache.rows.clear();
+	}
+	else
+	{
+		cache.rows.remove(itemName);
+	}
+}
+
+
 void HTTPServer::setupTcp()
 {
 	m_tcpServer.clear();
@@ -101,10 +155,38 @@ void HTTPServer::newConnection()
 	QTcpSocket* socket = m_tcpServer->nextPendingConnection();
 	Logger(LOG_DEBUG) << tr("HTTP connection received: ") << socket->peerAddress().toString();
 
+	// Connections stay open between requests until the client closes them or goes quiet
+	Connection& connection = m_connections[socket];
+	m_connectionCount->set(m_connections.size());
+	connection.idleTimer = new QTimer(socket);
+	connection.idleTimer->setInterval(HTTP_IDLETIMEOUT);
+	connection.idleTimer->setSingleShot(true);
+	connect(connection.idleTimer, &QTimer::timeout,
+		socket, [socket]()
+	{
+		Logger(LOG_DEBUG) << tr("HTTP client idle, closing: ") << socket->peerAddress().toString();
+		socket->disconnectFromHost();
+	});
+	connection.idleTimer->start();
+
 	connect(socket, &QTcpSocket::readyRead,
 		this, &HTTPServer::rx);
+	connect(socket, &QTcpSocket::bytesWritten,
+		this, &HTTPServer::bytesWritten);
 	connect(socket, &QTcpSocket::disconnected,
 		this, &HTTPServer::clientDisconnected);
+	// Sockets are also destroyed with the server when it's stopped
+	connect(socket, &QObject::destroyed,
+		this, [this, socket]()
+	{
+		m_connections.remove(socket);
+		m_connectionCount->set(m_connections.size());
+		for (int n = m_pendingScreenshots.size() - 1; n >= 0; n--)
+		{
+			if (m_pendingScreenshots[n].socket == socket)
+				m_pendingScreenshots.removeAt(n);
+		}
+	});
 }
 
 
@@ -119,42 +201,95 @@ void HTTPServer::clientDisconnected()
 }
 
 
-QString HTTPServer::parseHTTPRequest(QString req, QString& auth)
+// Parses one request from the start of the receive buffer. Returns the number of
+// bytes the request used, 0 if it hasn't all arrived yet or -1 if it's malformed.
+int HTTPServer::parseHTTPRequest(const QByteArray& buffer, HTTPRequest& request)
 {
-	// We only care about the first line
-	QTextStream reqStream(&req);
-	QString firstline = reqStream.readLine();
-	if (firstline.size() < 13)
+	int headerEnd = buffer.indexOf("\r\n\r\n");
+	if (-1 == headerEnd)
 	{
-		Logger(LOG_WARNING) << tr("Short HTTP request");
-		return "";
+		if (buffer.size() > HTTP_MAXHEADERSIZE)
+		{
+			Logger(LOG_WARNING) << tr("HTTP request header too large");
+			return -1;
+		}
+		return 0;
 	}
-	else if (!firstline.startsWith("GET "))
+
+	QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+
+	// Request line is method, path and version
+	QList<QByteArray> requestLine = lines[0].trimmed().split(' ');
+	if (requestLine.size() != 3)
 	{
-		Logger(LOG_WARNING) << tr("HTTP request missing GET");
-		return "";
+		Logger(LOG_WARNING) << tr("Malformed HTTP request line");
+		return -1;
 	}
 
-	int httpPos = firstline.indexOf(" HTTP/1.1");
-	if (-1 == httpPos)
+	request.method = requestLine[0];
+	request.path = QUrl::fromPercentEncoding(requestLine[1]);
+	if ("HTTP/1.1" == requestLine[2])
+	{
+		request.keepAlive = true;
+	}
+	else if ("HTTP/1.0" == requestLine[2])
 	{
-		Logger(LOG_WARNING) << tr("HTTP request missing HTTP/1.1");
-		return "";
+		request.keepAlive = false;
+	}
+	else
+	{
+		Logger(LOG_WARNING) << tr("HTTP request has unsupported version %1").arg(QString(requestLine[2]));
+		return -1;
 	}
 
-	// Read the rest of the headers looking for the authentication
-	QString line;
-	while (reqStream.readLineInto(&line))
+	// Read the rest of the headers looking for the ones we care about
+	int contentLength = 0;
+	for (int n = 1; n < lines.size(); n++)
 	{
-		if (line.startsWith("Authorization: Basic "))
+		int colonPos = lines[n].indexOf(':');
+		if (colonPos <= 0)
+			continue;
+
+		QByteArray name = lines[n].left(colonPos).trimmed().toLower();
+		QByteArray value = lines[n].mid(colonPos + 1).trimmed();
+		if ("authorization" == name && value.startsWith("Basic "))
+		{
+			request.auth = QString(QByteArray::fromBase64(value.mid(6)));
+		}
+		else if ("if-none-match" == name)
+		{
+			request.ifNoneMatch = value;
+		}
+		else if ("connection" == name)
 		{
-			auth = QString(QByteArray::fromBase64(line.mid(21).toUtf8()));
-			break;
+			value = value.toLower();
+			if (value.contains("close"))
+				request.keepAlive = false;
+			else if (value.contains("keep-alive"))
+				request.keepAlive = true;
+		}
+		else if ("content-length" == name)
+		{
+			bool ok = false;
+			contentLength = value.toInt(&ok);
+			if (!ok || contentLength < 0 || contentLength > HTTP_MAXBODYSIZE)
+			{
+				Logger(LOG_WARNING) << tr("HTTP request has bad content length");
+				return -1;
+			}
+		}
+		else if ("transfer-encoding" == name)
+		{
+			Logger(LOG_WARNING) << tr("HTTP request uses unsupported transfer encoding");
+			return -1;
 		}
 	}
 
-	// The path is everything between the GET and the HTTP
-	return firstline.mid(4, httpPos - 4);
+	// Wait for the body too, even though no request needs it
+	int size = headerEnd + 4 + contentLength;
+	if (buffer.size() < size)
+		return 0;
+	return size;
 }
 
 
@@ -165,29 +300,134 @@ QString HTTPServer::escapeString(const QString& str)
 }
 
 
-// generates a response with headers, returns the response
-QByteArray HTTPServer::generateResponse(unsigned int errorLevel, const QString& errorText, const QByteArray& data, const QString& contentType)
+// Returns true if an If-None-Match header lists the entity tag
+static bool etagMatches(const QByteArray& ifNoneMatch, const QByteArray& etag)
+{
+	if (ifNoneMatch.isEmpty() || etag.isEmpty())
+		return false;
+
+	for (auto tag : ifNoneMatch.split(','))
+	{
+		tag = tag.trimmed();
+		// Weak comparison is fine for GET and HEAD
+		if (tag.startsWith("W/"))
+			tag = tag.mid(2);
+		if ("*" == tag || etag == tag)
+			return true;
+	}
+	return false;
+}
+
+
+// generates a response with headers, returns the response. Responses with an
+// entity tag may be cached by the client as long as it checks back every time.
+QByteArray HTTPServer::generateResponse(const HTTPRequest& request, unsigned int errorLevel, const QString& errorText, const QByteArray& data, const QString& contentType, const QByteArray& etag)
 {
 	QByteArray response;
 	response += "HTTP/1.1 " + QString::number(errorLevel) + " " + errorText + "\r\n";
 	response += "Server: Pinhole Server\r\n"\
 		"WWW-Authenticate: Basic realm=\"Pinhole Server\"\r\n"\
-		"Cache-Control: no-cache, no-store, must-revalidate\r\n"\
-		"Access-Control-Allow-Origin: *\r\n"\
-		"Pragma: no-cache\r\n"\
-		"Expires: 0\r\n";
-	response += "Content-Length: " + QString::number(data.length()) + "\r\n";
-	response += "Content-Type: ";
-	if (contentType.isEmpty())
-		response += "text/html; charset=UTF-8";
+		"Access-Control-Allow-Origin: *\r\n";
+	if (etag.isEmpty())
+	{
+		response += "Cache-Control: no-cache, no-store, must-revalidate\r\n"\
+			"Pragma: no-cache\r\n"\
+			"Expires: 0\r\n";
+	}
 	else
-		response += contentType;
+	{
+		response += "Cache-Control: no-cache\r\n"\
+			"ETag: " + etag + "\r\n";
+	}
+	// Not modified responses have no body
+	if (304 != errorLevel)
+	{
+		response += "Content-Length: " + QString::number(data.length()) + "\r\n";
+		response += "Content-Type: ";
+		if (contentType.isEmpty())
+			response += "text/html; charset=UTF-8";
+		else
+			response += contentType;
+		response += "\r\n";
+	}
+	response += "Connection: ";
+	response += request.keepAlive ? "keep-alive" : "close";
 	response += "\r\n\r\n";
-	response += data;
+	if ("HEAD" != request.method && 304 != errorLevel)
+		response += data;
 	return response;
 }
 
 
+// Responds with a cached status page, or just a 304 if the client already has it
+QByteArray HTTPServer::generateCachedResponse(const HTTPRequest& request, const QString& groupName, bool json)
+{
+	const RenderedPage& page = renderedPage(groupName, json);
+	if (etagMatches(request.ifNoneMatch, page.etag))
+	{
+		return generateResponse(request, 304, "Not modified", QByteArray(), QString(), page.etag);
+	}
+
+	return generateResponse(request, 200, "OK", page.data, json ? "application/json" : "", page.etag);
+}
+
+
+// Returns the status page for a manager group, rendering it again if its data has changed
+const HTTPServer::RenderedPage& HTTPServer::renderedPage(const QString& groupName, bool json)
+{
+	quint64 version = m_pageCache[groupName].version;
+	if ((json ? m_pageCache[groupName].json : m_pageCache[groupName].html).version == version)
+		return json ? m_pageCache[groupName].json : m_pageCache[groupName].html;
+
+	QByteArray data;
+	if (GROUP_APP == groupName)
+		data = json ? generateJsonList(groupName, m_appManager->getAppNames()) : generateRootData();
+	else if (GROUP_GROUP == groupName)
+		data = json ? generateJsonList(groupName, m_groupManager->getGroupList()) : generateGroupsData();
+	else
+		data = json ? generateJsonList(groupName, m_scheduleManager->getEventNames()) : generateScheduleData();
+
+	RenderedPage& page = json ? m_pageCache[groupName].json : m_pageCache[groupName].html;
+	page.version = version;
+	page.data = data;
+	page.etag = "\"" + QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex() + "\"";
+	return page;
+}
+
+
+// Returns the rendered table row of an app, group or event, rendering it if it has changed
+const HTTPServer::RenderedRow& HTTPServer::renderedRow(const QString& groupName, const QString& itemName)
+{
+	QHash<QString, RenderedRow>& rows = m_pageCache[groupName].rows;
+	auto row = rows.find(itemName);
+	if (row == rows.end())
+	{
+		if (GROUP_APP == groupName)
+			row = rows.insert(itemName, renderApplicationRow(itemName));
+		else if (GROUP_GROUP == groupName)
+			row = rows.insert(itemName, renderGroupRow(itemName));
+		else
+			row = rows.insert(itemName, renderScheduleRow(itemName));
+	}
+	return row.value();
+}
+
+
+// Generates a JSON array of the rows of apps, groups or events
+QByteArray HTTPServer::generateJsonList(const QString& groupName, const QStringList& itemNames)
+{
+	QByteArray data = "[";
+	for (int n = 0; n < itemNames.size(); n++)
+	{
+		if (0 != n)
+			data += ',';
+		data += renderedRow(groupName, itemNames[n]).json;
+	}
+	data += "]";
+	return data;
+}
+
+
 QByteArray HTTPServer::generateHeaderData(const QString& title)
 {
 	return ("<!DOCTYPE html><html><head><title>" + title + "</title>"\
@@ -386,33 +626,7 @@ QByteArray HTTPServer::generateApplicationTable()
 
 		for (const auto & app : appNames)
 		{
-			bool appRunning = m_appManager->getAppVariant(app, PROP_APP_RUNNING).toBool();
-			QString state = m_appManager->getAppVariant(app, PROP_APP_STATE).toString();
-			int restarts = m_appManager->getAppVariant(app, PROP_APP_RESTARTS).toInt();
-			QString executable = m_appManager->getAppVariant(app, PROP_APP_EXECUTABLE).toString();
-			QString arguments = m_appManager->getAppVariant(app, PROP_APP_ARGUMENTS).toString();
-			QString directory = m_appManager->getAppVariant(app, PROP_APP_DIRECTORY).toString();
-			QString lastStarted = m_appManager->getAppVariant(app, PROP_APP_LASTSTARTED).toString();
-			QString lastExited = m_appManager->getAppVariant(app, PROP_APP_LASTEXITED).toString();
-
-			ret += "<tr><td><button onclick=\"";
-			if (appRunning)
-			{
-				ret += "appStop('" + escapeString(app) + "')\">Stop";
-			}
-			else
-			{
-				ret += "appStart('" + escapeString(app) + "')\">Start";
-			}
-			ret += "</button></td><td>" + app + "</td>";
-			ret += "<td>" + state + "</td>";
-			ret += "<td>" + QString::number(restarts) + "</td>";
-			ret += "<td>" + executable + "</td>";
-			ret += "<td>" + arguments + "</td>";
-			ret += "<td>" + directory + "</td>";
-			ret += "<td>" + lastStarted + "</td>";
-			ret += "<td>" + lastExited + "</td>";
-			ret += "</tr>";
+			ret += renderedRow(GROUP_APP, app).html;
 		}
 		ret += "</table>";
 	}
@@ -441,19 +655,7 @@ QByteArray HTTPServer::generateGroupsTable()
 
 		for (const auto& group : groupNames)
 		{
-			bool launchAtStart = m_groupManager->getGroupVariant(group, PROP_GROUP_LAUNCHATSTART).toBool();
-			QStringList members = m_groupManager->getGroupVariant(group, PROP_GROUP_APPLICATIONS).toStringList();
-
-			ret += "<tr><td><button onclick=\"";
-			ret += "groupStart('" + escapeString(group) + "')\">Start";
-			ret += "</button></td>";
-			ret += "<td><button onclick=\"";
-			ret += "groupStop('" + escapeString(group) + "')\">Stop";
-			ret += "</button></td>";
-			ret += "<td>" + group + "</td>";
-			ret += "<td>" + QString(launchAtStart ? "Yes" : "No") + "</td>";
-			ret += "<td>" + members.join(" ") + "</td>";
-			ret += "</tr>";
+			ret += renderedRow(GROUP_GROUP, group).html;
 		}
 
 		ret += "</table>";
@@ -485,22 +687,7 @@ QByteArray HTTPServer::generateScheduleTable()
 
 		for (const auto& event : eventNames)
 		{
-			QString type = m_scheduleManager->getEventVariant(event, PROP_SCHED_TYPE).toString();
-			QString frequency = m_scheduleManager->getEventVariant(event, PROP_SCHED_FREQUENCY).toString();
-			int offset = m_scheduleManager->getEventVariant(event, PROP_SCHED_OFFSET).toInt();
-			QString lastTriggered = m_scheduleManager->getEventVariant(event, PROP_SCHED_LASTTRIGGERED).toString();
-			QString arguments = m_scheduleManager->getEventVariant(event, PROP_SCHED_ARGUMENTS).toString();
-
-			ret += "<tr><td><button onclick=\"";
-			ret += "eventTrigger('" + escapeString(event) + "')\">Trigger";
-			ret += "</button></td>";
-			ret += "<td>" + event + "</td>";
-			ret += "<td>" + type + "</td>";
-			ret += "<td>" + frequency + "</td>";
-			ret += "<td>" + EventOffsetToString(frequency, offset) + "</td>";
-			ret += "<td>" + lastTriggered + "</td>";
-			ret += "<td>" + arguments + "</td>";
-			ret += "</td>";
+			ret += renderedRow(GROUP_SCHEDULE, event).html;
 		}
 
 		ret += "</table>";
@@ -510,6 +697,114 @@ QByteArray HTTPServer::generateScheduleTable()
 }
 
 
+HTTPServer::RenderedRow HTTPServer::renderApplicationRow(const QString& app)
+{
+	bool appRunning = m_appManager->getAppVariant(app, PROP_APP_RUNNING).toBool();
+	QString state = m_appManager->getAppVariant(app, PROP_APP_STATE).toString();
+	int restarts = m_appManager->getAppVariant(app, PROP_APP_RESTARTS).toInt();
+	QString executable = m_appManager->getAppVariant(app, PROP_APP_EXECUTABLE).toString();
+	QString arguments = m_appManager->getAppVariant(app, PROP_APP_ARGUMENTS).toString();
+	QString directory = m_appManager->getAppVariant(app, PROP_APP_DIRECTORY).toString();
+	QString lastStarted = m_appManager->getAppVariant(app, PROP_APP_LASTSTARTED).toString();
+	QString lastExited = m_appManager->getAppVariant(app, PROP_APP_LASTEXITED).toString();
+
+	RenderedRow row;
+	row.html += "<tr><td><button onclick=\"";
+	if (appRunning)
+	{
+		row.html += "appStop('" + escapeString(app) + "')\">Stop";
+	}
+	else
+	{
+		row.html += "appStart('" + escapeString(app) + "')\">Start";
+	}
+	row.html += "</button></td><td>" + app + "</td>";
+	row.html += "<td>" + state + "</td>";
+	row.html += "<td>" + QString::number(restarts) + "</td>";
+	row.html += "<td>" + executable + "</td>";
+	row.html += "<td>" + arguments + "</td>";
+	row.html += "<td>" + directory + "</td>";
+	row.html += "<td>" + lastStarted + "</td>";
+	row.html += "<td>" + lastExited + "</td>";
+	row.html += "</tr>";
+
+	QJsonObject object;
+	object[PROP_APP_NAME] = app;
+	object[PROP_APP_RUNNING] = appRunning;
+	object[PROP_APP_STATE] = state;
+	object[PROP_APP_RESTARTS] = restarts;
+	object[PROP_APP_EXECUTABLE] = executable;
+	object[PROP_APP_ARGUMENTS] = arguments;
+	object[PROP_APP_DIRECTORY] = directory;
+	object[PROP_APP_LASTSTARTED] = lastStarted;
+	object[PROP_APP_LASTEXITED] = lastExited;
+	row.json = QJsonDocument(object).toJson(QJsonDocument::Compact);
+	return row;
+}
+
+
+HTTPServer::RenderedRow HTTPServer::renderGroupRow(const QString& group)
+{
+	bool launchAtStart = m_groupManager->getGroupVariant(group, PROP_GROUP_LAUNCHATSTART).toBool();
+	QStringList members = m_groupManager->getGroupVariant(group, PROP_GROUP_APPLICATIONS).toStringList();
+
+	RenderedRow row;
+	row.html += "<tr><td><button onclick=\"";
+	row.html += "groupStart('" + escapeString(group) + "')\">Start";
+	row.html += "</button></td>";
+	row.html += "<td><button onclick=\"";
+	row.html += "groupStop('" + escapeString(group) + "')\">Stop";
+	row.html += "</button></td>";
+	row.html += "<td>" + group + "</td>";
+	row.html += "<td>" + QString(launchAtStart ? "Yes" : "No") + "</td>";
+	row.html += "<td>" + members.join(" ") + "</td>";
+	row.html += "</tr>";
+
+	QJsonObject object;
+	object[PROP_GROUP_NAME] = group;
+	object[PROP_GROUP_LAUNCHATSTART] = launchAtStart;
+	object[PROP_GROUP_APPLICATIONS] = QJsonArray::fromStringList(members);
+	row.json = QJsonDocument(object).toJson(QJsonDocument::Compact);
+	return row;
+}
+
+
+HTTPServer::RenderedRow HTTPServer::renderScheduleRow(const QString& event)
+{
+	QString type = m_scheduleManager->getEventVariant(event, PROP_SCHED_TYPE).toString();
+	QString frequency = m_scheduleManager->getEventVariant(event, PROP_SCHED_FREQUENCY).toString();
+	int offset = m_scheduleManager->getEventVariant(event, PROP_SCHED_OFFSET).toInt();
+	QString lastTriggered = m_scheduleManager->getEventVariant(event, PROP_SCHED_LASTTRIGGERED).toString();
+	QString arguments = m_scheduleManager->getEventVariant(event, PROP_SCHED_ARGUMENTS).toString();
+	QString cron = m_scheduleManager->getEventVariant(event, PROP_SCHED_CRON).toString();
+	QString when = SCHED_FREQ_CRON == frequency ? cron : EventOffsetToString(frequency, offset);
+
+	RenderedRow row;
+	row.html += "<tr><td><button onclick=\"";
+	row.html += "eventTrigger('" + escapeString(event) + "')\">Trigger";
+	row.html += "</button></td>";
+	row.html += "<td>" + event + "</td>";
+	row.html += "<td>" + type + "</td>";
+	row.html += "<td>" + frequency + "</td>";
+	row.html += "<td>" + when + "</td>";
+	row.html += "<td>" + lastTriggered + "</td>";
+	row.html += "<td>" + arguments + "</td>";
+	row.html += "</tr>";
+
+	QJsonObject object;
+	object[PROP_SCHED_NAME] = event;
+	object[PROP_SCHED_TYPE] = type;
+	object[PROP_SCHED_FREQUENCY] = frequency;
+	object[PROP_SCHED_OFFSET] = offset;
+	object[PROP_SCHED_CRON] = cron;
+	object["when"] = when;
+	object[PROP_SCHED_LASTTRIGGERED] = lastTriggered;
+	object[PROP_SCHED_ARGUMENTS] = arguments;
+	row.json = QJsonDocument(object).toJson(QJsonDocument::Compact);
+	return row;
+}
+
+
 // generates response for starting or stopping an app
 QByteArray HTTPServer::generateStartStopAppData(const QString& appName, bool start)
 {
@@ -604,48 +899,10 @@ QByteArray HTTPServer::generateShutdownRebootAppData(bool reboot)
 
 QByteArray HTTPServer::generateShowScreenIDsData()
 {
-	HostClient* hostClient = new HostClient("127.0.0.1", HOST_TCPPORT, QString(), true, false, this);
-
-	bool success = false;
-
-	connect(hostClient, &HostClient::connected,
-		this, [hostClient]()
-	{
-		// Request show screen IDs
-		hostClient->showScreenIds();
-	});
-
-	connect(hostClient, &HostClient::connectFailed,
-		this, [hostClient](const QString& reason)
-	{
-		Logger(LOG_WARNING) << tr("HTTP server: Failed to request show screen IDs (failed to connect to localhost? %1)")
-			.arg(reason);
-		hostClient->deleteLater();
-	});
-
-	connect(hostClient, &HostClient::commandError,
-		this, [hostClient]()
-	{
-		Logger(LOG_WARNING) << "HTTP server: Failed to request show screen IDs (command error, helper not running?)";
-		hostClient->deleteLater();
-	});
-
-	connect(hostClient, &HostClient::commandSuccess,
-		this, [hostClient, &success]()
-	{
-		success = true;
-		hostClient->deleteLater();
-	});
-
-	// Block until we receive a response from the server
-	QEventLoop eventLoop(this);
-	connect(hostClient, &HostClient::destroyed,
-		&eventLoop, &QEventLoop::quit);
-	eventLoop.exec();
-
 	QByteArray data = generateHeaderData("Show screen IDs");
-	if (!success)
+	if (!m_commandInterface->showScreenIds())
 	{
+		Logger(LOG_WARNING) << "HTTP server: Failed to request show screen IDs (helper not running?)";
 		data += "Failed to show screen IDs";
 	}
 	else
@@ -658,177 +915,303 @@ QByteArray HTTPServer::generateShowScreenIDsData()
 }
 
 
-QByteArray HTTPServer::generateScreenshotData()
+QByteArray HTTPServer::generateScreenshotResponse(const HTTPRequest& request, const QByteArray& screenshot)
 {
-	QByteArray screenshot;
+	if (screenshot.isEmpty())
+	{
+		return generateResponse(request, 500, "Internal server error", "There was a problem reading the screenshot image");
+	}
 
-	HostClient* hostClient = new HostClient("127.0.0.1", HOST_TCPPORT, QString(), true, false, this);
+	return generateResponse(request, 200, "OK", screenshot, "image/png");
+}
 
-	connect(hostClient, &HostClient::connected,
-		this, [hostClient]()
+
+void HTTPServer::screenshotReady(const QByteArray& screenshot)
+{
+	m_screenshotCache = screenshot;
+	m_screenshotCacheTime = MonotonicTime::now();
+
+	if (!m_pendingScreenshots.isEmpty())
 	{
-		// Request screenshot
-		hostClient->requestScreenshot();
-	});
+		m_screenshotTimer.stop();
+		completePendingScreenshots(screenshot);
+	}
+}
 
-	connect(hostClient, &HostClient::connectFailed,
-		this, [hostClient](const QString& reason)
+
+void HTTPServer::screenshotTimeout()
+{
+	Logger(LOG_WARNING) << tr("HTTP server: Failed to aquire screenshot (helper did not respond)");
+	completePendingScreenshots(QByteArray());
+}
+
+
+// Sends the screenshot (or an error if it's empty) to every connection waiting on one
+void HTTPServer::completePendingScreenshots(const QByteArray& screenshot)
+{
+	QList<PendingResponse> pendingScreenshots;
+	pendingScreenshots.swap(m_pendingScreenshots);
+
+	for (const auto& pending : pendingScreenshots)
 	{
-		Logger(LOG_WARNING) << tr("HTTP server: Failed to aquire screenshot (failed to connect to localhost? %1)")
-			.arg(reason);
-		hostClient->deleteLater();
-	});
+		sendResponse(pending.socket, pending.request, generateScreenshotResponse(pending.request, screenshot));
+	}
 
-	connect(hostClient, &HostClient::commandError,
-		this, [hostClient]()
+	// Carry on with anything pipelined behind them
+	for (const auto& pending : pendingScreenshots)
 	{
-		Logger(LOG_WARNING) << tr("HTTP server: Failed to aquire screenshot (command error, helper not running?)");
-		hostClient->deleteLater();
-	});
+		processRequests(pending.socket);
+	}
+}
+
+
+void HTTPServer::rx()
+{
+	QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+	if (nullptr == socket || !m_connections.contains(socket))
+		return;
 
-	connect(hostClient, &HostClient::commandData,
-		this, [hostClient, &screenshot](const QString& group, const QString& subCommand, const QVariant& data)
+	Connection& connection = m_connections[socket];
+	connection.idleTimer->start();
+	if (connection.closing)
 	{
-		if (GROUP_NONE != group || CMD_NONE_GETSCREENSHOT != subCommand)
-		{
-			Logger(LOG_WARNING) << tr("HTTP server: Failed to aquire screenshot (internal error, wrong data from server)");
-		}
-		else
+		// Already answered the last request we'll take
+		socket->readAll();
+		return;
+	}
+
+	// Requests can arrive in pieces, buffer until they're complete
+	QByteArray data = socket->readAll();
+	m_receivedBytes->increment(data.size());
+	connection.buffer += data;
+	processRequests(socket);
+}
+
+
+// Resumes pipelined requests once the client has read enough of the earlier responses
+void HTTPServer::bytesWritten()
+{
+	QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+	if (nullptr == socket || !m_connections.contains(socket))
+		return;
+
+	m_connections[socket].idleTimer->start();
+	if (!m_connections[socket].buffer.isEmpty())
+	{
+		processRequests(socket);
+	}
+}
+
+
+// Answers every complete request in the connection's receive buffer, in order
+void HTTPServer::processRequests(QTcpSocket* socket)
+{
+	while (m_connections.contains(socket) && QAbstractSocket::ConnectedState == socket->state())
+	{
+		Connection& connection = m_connections[socket];
+
+		// Don't queue up responses faster than the client reads them, the socket
+		//  buffers whatever the OS won't take and bytesWritten() picks back up
+		if (connection.busy || connection.closing || socket->bytesToWrite() > HTTP_MAXPENDINGWRITE)
+			return;
+
+		HTTPRequest request;
+		int size = parseHTTPRequest(connection.buffer, request);
+		if (0 == size)
+			return;
+
+		if (size < 0)
 		{
-			screenshot = data.toByteArray();
+			// Can't tell where the next request would start, give up on the connection
+			Logger(LOG_WARNING) << "Bad HTTP request from " << socket->peerAddress().toString();
+			connection.buffer.clear();
+			request.keepAlive = false;
+			sendResponse(socket, request, generateResponse(request, 400, "Bad request", "<html>Bad request</html>\r\n"));
+			return;
 		}
 
-		hostClient->deleteLater();
-	});
+		connection.buffer.remove(0, size);
+		connection.busy = true;
 
-	// Block until we receive a response from the server
-	QEventLoop eventLoop(this);
-	connect(hostClient, &HostClient::destroyed,
-		&eventLoop, &QEventLoop::quit);
-	eventLoop.exec();
-	return screenshot;
+		// An empty response means it's pending, and requests behind it wait their turn
+		QByteArray response = processRequest(socket, request);
+		if (response.isEmpty())
+			return;
+
+		sendResponse(socket, request, response);
+	}
 }
 
 
-void HTTPServer::rx()
+// Writes the response to a request and lets the connection take the next one
+void HTTPServer::sendResponse(QTcpSocket* socket, const HTTPRequest& request, const QByteArray& response)
 {
-	QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
-	QByteArray data = socket->readAll();
+	if (!m_connections.contains(socket))
+		return;
+
+	Connection& connection = m_connections[socket];
+	connection.busy = false;
+	socket->write(response);
+	m_sentBytes->increment(response.size());
+
+	if (!request.keepAlive)
+	{
+		// disconnectFromHost() waits for the response to be written
+		connection.closing = true;
+		socket->disconnectFromHost();
+	}
+}
+
 
-	QString auth;
-	QString path = QUrl::fromPercentEncoding(parseHTTPRequest(data, auth).toUtf8());
+// Generates the response to a request, or parks it and returns nothing if it has to wait
+QByteArray HTTPServer::processRequest(QTcpSocket* socket, const HTTPRequest& request)
+{
+	QString path = request.path;
+	QString auth = request.auth;
 	QByteArray response;
 
+	if ("GET" != request.method && "HEAD" != request.method)
+	{
+		Logger(LOG_WARNING) << "HTTP request with unsupported method " << QString(request.method);
+		return generateResponse(request, 405, "Method not allowed", "<html>Method not allowed</html>\r\n");
+	}
+
 	if (path.isEmpty())
 	{
-		// Bad request, do nothing
 		Logger(LOG_WARNING) << "Bad HTTP request (no path)";
+		return generateResponse(request, 400, "Bad request", "<html>Bad request</html>\r\n");
 	}
-	else
+
+	// Parse out the argument if it exists
+	QString arg;
+	int qPos = path.indexOf("?");
+	if (-1 != qPos)
 	{
-		// Parse out the argument if it exists
-		QString arg;
-		int qPos = path.indexOf("?");
-		if (-1 != qPos)
-		{
-			arg = path.mid(qPos + 1);
-			path = path.left(qPos);
-		}
-		// Parse out just the password
-		int colPos = auth.indexOf(":");
-		if (-1 != colPos)
-		{
-			auth = auth.mid(colPos + 1);
-		}
+		arg = path.mid(qPos + 1);
+		path = path.left(qPos);
+	}
+	// Parse out just the password
+	int colPos = auth.indexOf(":");
+	if (-1 != colPos)
+	{
+		auth = auth.mid(colPos + 1);
+	}
 
-		Logger(LOG_DEBUG) << "HTTP request received, path '" << path << "' arg '" << arg << "'";
+	Logger(LOG_DEBUG) << "HTTP request received, path '" << path << "' arg '" << arg << "'";
 
-		if ("/" == path)
-		{
-			// Root page (applications)
-			response = generateResponse(200, "OK", generateRootData());
-		}
-		else if ("/groups" == path)
-		{
-			response = generateResponse(200, "OK", generateGroupsData());
-		}
-		else if ("/schedule" == path)
-		{
-			response = generateResponse(200, "OK", generateScheduleData());
-		}
-		else if ("/sysinfo" == path)
-		{
-			response = generateResponse(200, "OK", generateSystemInfoData());
-		}
-		else if ("/viewlog" == path)
-		{
-			response = generateResponse(200, "OK", generateLogData(arg));
-		}
-		else if ("/heartbeat" == path)
-		{
-			int err;
-			QString errMsg;
-			QByteArray data = generateAppHeartbeatData(arg, err, errMsg);
-			response = generateResponse(err, errMsg, data);
-		}
-		else if ("/appstart" == path)
-		{
-			response = generateResponse(200, "OK", generateStartStopAppData(arg, true));
-		}
-		else if ("/appstop" == path)
-		{
-			response = generateResponse(200, "OK", generateStartStopAppData(arg, false));
-		}
-		else if ("/groupstart" == path)
-		{
-			response = generateResponse(200, "OK", generateStartStopGroupData(arg, true));
-		}
-		else if ("/groupstop" == path)
-		{
-			response = generateResponse(200, "OK", generateStartStopGroupData(arg, false));
-		}
-		else if ("/eventtrigger" == path)
-		{
-			response = generateResponse(200, "OK", generateTriggerEventData(arg));
-		}
-		else if ("/reboot/" == path)
-		{
-			response = generateResponse(200, "OK", generateShutdownRebootAppData(true));
-		}
-		else if ("/shutdown/" == path)
-		{
-			response = generateResponse(200, "OK", generateShutdownRebootAppData(false));
-		}
-		else if ("/showids" == path)
+	if ("/" == path)
+	{
+		// Root page (applications)
+		response = generateCachedResponse(request, GROUP_APP, false);
+	}
+	else if ("/groups" == path)
+	{
+		response = generateCachedResponse(request, GROUP_GROUP, false);
+	}
+	else if ("/schedule" == path)
+	{
+		response = generateCachedResponse(request, GROUP_SCHEDULE, false);
+	}
+	else if ("/apps.json" == path)
+	{
+		response = generateCachedResponse(request, GROUP_APP, true);
+	}
+	else if ("/groups.json" == path)
+	{
+		response = generateCachedResponse(request, GROUP_GROUP, true);
+	}
+	else if ("/schedule.json" == path)
+	{
+		response = generateCachedResponse(request, GROUP_SCHEDULE, true);
+	}
+	else if ("/sysinfo" == path)
+	{
+		response = generateResponse(request, 200, "OK", generateSystemInfoData());
+	}
+	else if ("/sysinfo.json" == path)
+	{
+		response = generateResponse(request, 200, "OK",
+			QJsonDocument::fromVariant(m_globalManager->getSysInfoMap()).toJson(QJsonDocument::Compact), "application/json");
+	}
+	else if ("/viewlog" == path)
+	{
+		response = generateResponse(request, 200, "OK", generateLogData(arg));
+	}
+	else if ("/metrics" == path)
+	{
+		// Prometheus text exposition format
+		m_appManager->updateResourceMetrics();
+		response = generateResponse(request, 200, "OK", Metrics::exportText(), "text/plain; version=0.0.4; charset=utf-8");
+	}
+	else if ("/heartbeat" == path)
+	{
+		int err;
+		QString errMsg;
+		QByteArray data = generateAppHeartbeatData(arg, err, errMsg);
+		response = generateResponse(request, err, errMsg, data);
+	}
+	else if ("/appstart" == path)
+	{
+		response = generateResponse(request, 200, "OK", generateStartStopAppData(arg, true));
+	}
+	else if ("/appstop" == path)
+	{
+		response = generateResponse(request, 200, "OK", generateStartStopAppData(arg, false));
+	}
+	else if ("/groupstart" == path)
+	{
+		response = generateResponse(request, 200, "OK", generateStartStopGroupData(arg, true));
+	}
+	else if ("/groupstop" == path)
+	{
+		response = generateResponse(request, 200, "OK", generateStartStopGroupData(arg, false));
+	}
+	else if ("/eventtrigger" == path)
+	{
+		response = generateResponse(request, 200, "OK", generateTriggerEventData(arg));
+	}
+	else if ("/reboot/" == path)
+	{
+		response = generateResponse(request, 200, "OK", generateShutdownRebootAppData(true));
+	}
+	else if ("/shutdown/" == path)
+	{
+		response = generateResponse(request, 200, "OK", generateShutdownRebootAppData(false));
+	}
+	else if ("/showids" == path)
+	{
+		response = generateResponse(request, 200, "OK", generateShowScreenIDsData());
+	}
+	else if ("/screenshot.png" == path)
+	{
+		if (!m_screenshotCache.isEmpty() &&
+			m_screenshotCacheTime.elapsed() < HTTP_SCREENSHOTCACHE)
 		{
-			response = generateResponse(200, "OK", generateShowScreenIDsData());
+			// Captured moments ago
+			response = generateScreenshotResponse(request, m_screenshotCache);
 		}
-		else if ("/screenshot.png" == path)
+		else if (m_pendingScreenshots.isEmpty() && !m_commandInterface->requestScreenshot())
 		{
-			QByteArray data = generateScreenshotData();
-			if (data.isEmpty())
-			{
-				response = generateResponse(500, "Internal server error", "There was a problem reading the screenshot image");
-			}
-			else
-			{
-				response = generateResponse(200, "OK", data, "image/png");
-			}
+			Logger(LOG_WARNING) << tr("HTTP server: Failed to aquire screenshot (helper not running?)");
+			response = generateScreenshotResponse(request, QByteArray());
 		}
 		else
 		{
-			response = generateResponse(404, "Not found", "<html>No such page</html>\r\n");
-			Logger(LOG_WARNING) << "Bad HTTP request path: '" << path << "'";
-		}
-
-		// Send response
-		if (!response.isEmpty())
-		{
-			// todo - will data send all in one packet?
-			// Seems to break it up/buffer
-			socket->write(response);
+			// Wait for the capture, sharing one already in progress
+			if (m_pendingScreenshots.isEmpty())
+				m_screenshotTimer.start();
+
+			PendingResponse pending;
+			pending.socket = socket;
+			pending.request = request;
+			m_pendingScreenshots.append(pending);
 		}
 	}
-}
-
+	else
+	{
+		response = generateResponse(request, 404, "Not found", "<html>No such page</html>\r\n");
+		Logger(LOG_WARNING) << "Bad HTTP request path: '" << path << "'";
+	}
 
+	return response;
+}
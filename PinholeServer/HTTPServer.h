@@ -1,14 +1,22 @@
 #pragma once
 
+#include "MonotonicTime.h"
+
 #include <QObject>
 #include <QSharedPointer>
+#include <QHash>
+#include <QTimer>
 
 class Settings;
 class AppManager;
 class GlobalManager;
 class GroupManager;
 class ScheduleManager;
+class CommandInterface;
 class QTcpServer;
+class QTcpSocket;
+class MetricCounter;
+class MetricGauge;
 
 class HTTPServer : public QObject
 {
@@ -16,7 +24,8 @@ class HTTPServer : public QObject
 
 public:
 	HTTPServer(Settings* settings, AppManager* appManager, GroupManager* groupManager,
-		GlobalManager* globalManager, ScheduleManager* scheduleManager, QObject *parent = nullptr);
+		GlobalManager* globalManager, ScheduleManager* scheduleManager, CommandInterface* commandInterface,
+		QObject *parent = nullptr);
 	~HTTPServer();
 
 public slots:
@@ -24,13 +33,79 @@ public slots:
 	void setupTcp();
 	void newConnection();
 	void rx();
+	void bytesWritten();
 	void clientDisconnected();
 	void start();
 
+private slots:
+	void screenshotReady(const QByteArray& screenshot);
+	void screenshotTimeout();
+	void managerValueChanged(const QString& groupName, const QString& itemName, const QString& propName, const QVariant& value);
+
 private:
-	QString parseHTTPRequest(QString req, QString& auth);
+	// A parsed request
+	struct HTTPRequest
+	{
+		QByteArray method;
+		QString path;
+		QString auth;
+		QByteArray ifNoneMatch;
+		bool keepAlive = true;
+	};
+
+	// State of a client connection, requests may arrive split up or pipelined
+	struct Connection
+	{
+		QByteArray buffer;				// Received data not parsed yet
+		bool busy = false;				// A request is being processed or waiting on a pending response
+		bool closing = false;			// The last response has been sent, ignore anything else
+		QTimer* idleTimer = nullptr;	// Closes keep-alive connections that go quiet
+	};
+
+	// A response waiting on the helper, completed by screenshotReady() or screenshotTimeout()
+	struct PendingResponse
+	{
+		QTcpSocket* socket = nullptr;
+		HTTPRequest request;
+	};
+
+	// A rendered status page or one row of its table, as HTML and JSON
+	struct RenderedRow
+	{
+		QByteArray html;
+		QByteArray json;
+	};
+
+	struct RenderedPage
+	{
+		quint64 version = 0;	// Version of the data it was rendered from, 0 if never rendered
+		QByteArray data;
+		QByteArray etag;
+	};
+
+	// Rendered pages for one manager group (GROUP_APP, GROUP_GROUP or GROUP_SCHEDULE),
+	// valueChanged() moves the version on and drops the rows of whatever changed
+	struct PageCache
+	{
+		quint64 version = 1;
+		QHash<QString, RenderedRow> rows;
+		RenderedPage html;
+		RenderedPage json;
+	};
+
+	int parseHTTPRequest(const QByteArray& buffer, HTTPRequest& request);
+	void processRequests(QTcpSocket* socket);
+	QByteArray processRequest(QTcpSocket* socket, const HTTPRequest& request);
+	void sendResponse(QTcpSocket* socket, const HTTPRequest& request, const QByteArray& response);
+	void completePendingScreenshots(const QByteArray& screenshot);
 	QString escapeString(const QString& str);
-	QByteArray generateResponse(unsigned int errorLevel, const QString& errorText, const QByteArray& data, const QString& contentType = "");
+	QByteArray generateResponse(const HTTPRequest& request, unsigned int errorLevel, const QString& errorText, const QByteArray& data, const QString& contentType = "", const QByteArray& etag = QByteArray());
+	QByteArray generateCachedResponse(const HTTPRequest& request, const QString& groupName, bool json);
+	const RenderedPage& renderedPage(const QString& groupName, bool json);
+	const RenderedRow& renderedRow(const QString& groupName, const QString& itemName);
+	RenderedRow renderApplicationRow(const QString& app);
+	RenderedRow renderGroupRow(const QString& group);
+	RenderedRow renderScheduleRow(const QString& event);
 	QByteArray generateHeaderData(const QString& title);
 	QByteArray generateAppHeartbeatData(const QString& appName, int& err, QString& errmsg);
 	QByteArray generateStartStopAppData(const QString& appName, bool start);
@@ -38,10 +113,11 @@ private:
 	QByteArray generateTriggerEventData(const QString eventName);
 	QByteArray generateShutdownRebootAppData(bool reboot);
 	QByteArray generateShowScreenIDsData();
-	QByteArray generateScreenshotData();
+	QByteArray generateScreenshotResponse(const HTTPRequest& request, const QByteArray& screenshot);
 	QByteArray generateApplicationTable();
 	QByteArray generateGroupsTable();
 	QByteArray generateScheduleTable();
+	QByteArray generateJsonList(const QString& groupName, const QStringList& itemNames);
 	QByteArray generateRootData();
 	QByteArray generateGroupsData();
 	QByteArray generateScheduleData();
@@ -51,10 +127,20 @@ private:
 	bool m_tcpEnabled = false;
 	QSharedPointer<QTcpServer> m_tcpServer;
 	int m_tcpPort = 0;
+	QHash<QTcpSocket*, Connection> m_connections;
+	QList<PendingResponse> m_pendingScreenshots;
+	QTimer m_screenshotTimer;			// Gives up on the helper if it never answers
+	QByteArray m_screenshotCache;		// Last screenshot, shared by requests arriving close together
+	MonotonicTime m_screenshotCacheTime;	// When the cached screenshot was captured
+	QHash<QString, PageCache> m_pageCache;
 
 	Settings* m_settings = nullptr;
 	AppManager* m_appManager = nullptr;
 	GroupManager* m_groupManager = nullptr;
 	GlobalManager* m_globalManager = nullptr;
 	ScheduleManager* m_scheduleManager = nullptr;
+	CommandInterface* m_commandInterface = nullptr;
+	MetricCounter* m_receivedBytes = nullptr;
+	MetricCounter* m_sentBytes = nullptr;
+	MetricGauge* m_connectionCount = nullptr;
 };
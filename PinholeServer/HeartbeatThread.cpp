@@ -61,7 +61,7 @@ void HeartbeatThread::heartbeat()
 {
 	//qDebug() << "heartbeat" << QThread::currentThreadId();
 
-	m_lastHeartbeat = QDateTime::currentDateTime();
+	m_lastHeartbeat.store(MonotonicTime::now().toMSecs());
 }
 
 
@@ -69,7 +69,7 @@ void HeartbeatThread::checkHeartbeat()
 {
 	//qDebug() << "checkHeartbeat" << QThread::currentThreadId();
 
-	if (m_lastHeartbeat.msecsTo(QDateTime::currentDateTime()) > INTERVAL_APPTIMEOUT)
+	if (MonotonicTime::fromMSecs(m_lastHeartbeat.load()).elapsed() > INTERVAL_APPTIMEOUT)
 	{
 		Logger(LOG_ERROR) << tr("!!! INTERNAL HEARTBEAT TIMEOUT %1 SECS, MAIN THREAD LOCKUP?  TERMINATING!")
 			.arg(INTERVAL_APPTIMEOUT / 1000);
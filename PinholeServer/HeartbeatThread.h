@@ -1,7 +1,9 @@
 #pragma once
 
+#include "MonotonicTime.h"
+
 #include <QObject>
-#include <QDateTime>
+#include <QAtomicInteger>
 
 // The purpose of this class is to listen for heartbeats
 // from the main thread and kill the program if it fails to receive
@@ -26,6 +28,6 @@ private slots:
 	void checkHeartbeat();
 
 private:
-	QDateTime m_lastHeartbeat = QDateTime::currentDateTime();
+	QAtomicInteger<qint64> m_lastHeartbeat { MonotonicTime::now().toMSecs() };	// Written by the main thread, read by m_thread
 	QThread* m_thread = nullptr;
 };
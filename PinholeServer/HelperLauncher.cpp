@@ -13,7 +13,7 @@
 #include <QDir>
 
 HelperLauncher::HelperLauncher(Settings* settings, GlobalManager* globalManager, QObject *parent)
-	: QObject(parent), m_settings(settings), m_globalManager(globalManager)
+	: QObject(parent), m_restartInPeriod(HELPER_THROTTLE_COUNT), m_settings(settings), m_globalManager(globalManager)
 {
 	m_helperProcess = new UserProcess(m_settings, this);
 
@@ -28,6 +28,11 @@ HelperLauncher::HelperLauncher(Settings* settings, GlobalManager* globalManager,
 		this, &HelperLauncher::globalValueChanged);
 
 	m_trayLaunch = m_globalManager->getTrayLaunch();
+
+	m_startDelayTimer.setSingleShot(true);
+	m_startDelayTimer.setInterval(INTERVAL_HELPERSTARTDELAY);
+	connect(&m_startDelayTimer, &QTimer::timeout,
+		this, &HelperLauncher::finishedStarting);
 }
 
 
@@ -94,7 +99,7 @@ void HelperLauncher::startHelper()
 		if (helperPath == process.name)
 		{
 			Logger() << tr("Killing previous instance of helper process");
-			killProcess(process.id);
+			killProcess(process.id, INTERVAL_HELPERKILLWAIT);
 		}
 	}
 
@@ -148,12 +153,18 @@ void HelperLauncher::helperStarted()
 	{
 		started = true;
 		// Delay starting of applications so PinholeHelper has a chance to 
-		// connect to EncryptedTcpServer
-		QTimer::singleShot(INTERVAL_HELPERSTARTDELAY,
-			[this]()
-		{
-			emit finishedStarting();
-		});
+		// connect to EncryptedTcpServer, cut short when it authenticates
+		m_startDelayTimer.start();
+	}
+}
+
+
+void HelperLauncher::helperAuthenticated()
+{
+	if (m_startDelayTimer.isActive())
+	{
+		m_startDelayTimer.stop();
+		emit finishedStarting();
 	}
 }
 
@@ -20,6 +20,7 @@ public:
 
 public slots:
 	void helperStarted();
+	void helperAuthenticated();
 	void helperFinished(int exitCode, QProcess::ExitStatus exitStatus);
 	void helperError(QProcess::ProcessError error);
 	void globalValueChanged(const QString& group, const QString& item, const QString& prop, const QVariant& value);
@@ -41,6 +42,7 @@ private:
 	UserProcess* m_helperProcess = nullptr;
 	bool m_exitExpected = false;
 	TimePeriodCount m_restartInPeriod;
+	QTimer m_startDelayTimer;
 
 	Settings* m_settings = nullptr;
 	GlobalManager* m_globalManager = nullptr;
@@ -2,7 +2,9 @@
 #include "Settings.h"
 #include "StatusInterface.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include "../common/Utilities.h"
+#include "../common/DiscoveryPacket.h"
 #include "../common/PinholeCommon.h"
 
 #include <QNetworkDatagram>
@@ -26,12 +28,19 @@ HostUdpServer::HostUdpServer(Settings* settings, StatusInterface* statusInterfac
 	connect(networkConfigurationManager, &QNetworkConfigurationManager::configurationRemoved,
 		this, [this] { m_interfaces = QNetworkInterface::allInterfaces(); });
 
+	m_receivedBytes = Metrics::counter(METRIC_RECEIVED_BYTES, Metrics::label("interface", METRIC_INTERFACE_UDP));
+	m_sentBytes = Metrics::counter(METRIC_SENT_BYTES, Metrics::label("interface", METRIC_INTERFACE_UDP));
+
 	// Create socket
 	m_sock = new QUdpSocket(this);
 
 	// Read incomming packets
 	connect(m_sock, &QUdpSocket::readyRead,
 		this, &HostUdpServer::readyRead);
+
+	// Push state changes to listening consoles
+	connect(m_statusInterface, &StatusInterface::presenceChanged,
+		this, &HostUdpServer::sendPresence);
 }
 
 
@@ -61,12 +70,16 @@ void HostUdpServer::start()
 	{
 		//Logger(LOG_DEBUG) << "HostUdpServer: Multicast group joined";
 	}
+
+	// Let listening consoles know we're here
+	sendPresence();
 }
 
 
 bool HostUdpServer::parseDatagram(const QNetworkDatagram& datagram, const QString& MAC)
 {
-	QByteArray response = m_statusInterface->processPacket(datagram.data(), MAC);
+	int encoding = DISCOVERY_ENCODING_JSON;
+	QByteArray response = m_statusInterface->processPacket(datagram.data(), MAC, &encoding);
 
 	if (response.isEmpty())
 		return false;
@@ -74,26 +87,50 @@ bool HostUdpServer::parseDatagram(const QNetworkDatagram& datagram, const QStrin
 	QHostAddress senderAddress = datagram.senderAddress();
 	int senderPort = datagram.senderPort();
 
-	// Store a list of any hosts we have received packets from
-	if (!m_serverAddresses.contains(QPair<QHostAddress, int>(senderAddress, senderPort)))
-	{
-		m_serverAddresses.append(QPair<QHostAddress, int>(senderAddress, senderPort));
-	}
+	// Store a list of any hosts we have received packets from and how to talk to them
+	m_serverAddresses[QPair<QHostAddress, int>(senderAddress, senderPort)] = encoding;
 
 	// Send response packet
 	m_sock->writeDatagram(response, senderAddress, senderPort);
+	m_sentBytes->increment(response.size());
 	//qInfo() << "Response sent " << QTime::currentTime().toString();
 
 	return true;
 }
 
 
+// Returns the MAC address reported in announce packets for an interface
+QString HostUdpServer::interfaceMAC(const QNetworkInterface& iface) const
+{
+	QString MAC;
+	if (!iface.isValid())
+	{
+		//MAC = tr("(No valid adapters found)");
+	}
+	else if (QNetworkInterface::Ethernet == iface.type())
+	{
+		MAC = iface.hardwareAddress();
+	}
+	else if (QNetworkInterface::Loopback == iface.type())
+	{
+		// Leave loopback blank
+		//MAC = tr("Loopback");
+	}
+	else
+	{
+		MAC = QtEnumToString(iface.type()) + " " + iface.humanReadableName() + "(" + iface.name() + ")";
+	}
+	return MAC;
+}
+
+
 void HostUdpServer::readyRead()
 {
 	while (m_sock->hasPendingDatagrams())
 	{
 		// Read entire datagram
 		QNetworkDatagram datagram = m_sock->receiveDatagram();
+		m_receivedBytes->increment(datagram.data().size());
 		uint ifaceIndex = datagram.interfaceIndex();
 
 		// Determine the interface the datagram was received on
@@ -127,41 +164,105 @@ void HostUdpServer::readyRead()
 		}
 
 		// Get the MAC address for the interface
-		QString MAC;
-		if (!iface.isValid())
-		{
-			//MAC = tr("(No valid adapters found)");
-		}
-		else if (QNetworkInterface::Ethernet == iface.type())
+		QString MAC = interfaceMAC(iface);
+		//qInfo() << "Packet received length " << datagram.data().length();
+
+		if (!parseDatagram(datagram, MAC))
 		{
-			MAC = iface.hardwareAddress();
+			Logger(LOG_DEBUG) << tr("Bad UDP packet received from %1:%2")
+				.arg(datagram.senderAddress().toString())
+				.arg(datagram.senderPort());
 		}
-		else if (QNetworkInterface::Loopback == iface.type())
+	}
+}
+
+
+void HostUdpServer::sendPacketToServers(const QVariantMap& values)
+{
+	// Encode once per encoding in use
+	QMap<int, QByteArray> packets;
+	for (auto server = m_serverAddresses.constBegin(); server != m_serverAddresses.constEnd(); server++)
+	{
+		if (!packets.contains(server.value()))
 		{
-			// Leave loopback blank
-			//MAC = tr("Loopback");
+			packets[server.value()] = EncodeDiscoveryPacket(values, server.value());
 		}
-		else
+		m_sock->writeDatagram(packets[server.value()], server.key().first, server.key().second);
+		m_sentBytes->increment(packets[server.value()].size());
+	}
+
+	// Consoles listening for presence packets get it too, writing before
+	//  start() would bind the socket to a random port
+	if (QAbstractSocket::BoundState != m_sock->state())
+		return;
+
+	QByteArray presencePacket = EncodeDiscoveryPacket(values, DISCOVERY_ENCODING_LATEST);
+	for (const auto& iface : m_interfaces)
+	{
+		if (isPresenceInterface(iface))
 		{
-			MAC = QtEnumToString(iface.type()) + " " + iface.humanReadableName() + "(" + iface.name() + ")";
+			sendPresenceDatagram(presencePacket, iface);
 		}
-		//qInfo() << "Packet received length " << datagram.data().length();
+	}
+	m_sock->writeDatagram(presencePacket, QHostAddress(QHostAddress::LocalHost), PRESENCE_UDPPORT);
+	m_sentBytes->increment(presencePacket.size());
+}
 
-		if (!parseDatagram(datagram, MAC))
+
+// Pushes the announce packet to consoles listening on each network interface,
+// sent when our state changes and as a keepalive instead of waiting to be queried
+void HostUdpServer::sendPresence()
+{
+	if (QAbstractSocket::BoundState != m_sock->state())
+		return;
+
+	for (const auto& iface : m_interfaces)
+	{
+		if (isPresenceInterface(iface))
 		{
-			Logger(LOG_DEBUG) << tr("Bad UDP packet received from %1:%2")
-				.arg(datagram.senderAddress().toString())
-				.arg(datagram.senderPort());
+			sendPresenceDatagram(m_statusInterface->presencePacket(interfaceMAC(iface)), iface);
 		}
 	}
+
+	// Consoles on this machine
+	QByteArray loopbackPacket = m_statusInterface->presencePacket(QString());
+	m_sock->writeDatagram(loopbackPacket, QHostAddress(QHostAddress::LocalHost), PRESENCE_UDPPORT);
+	m_sentBytes->increment(loopbackPacket.size());
+}
+
+
+bool HostUdpServer::isPresenceInterface(const QNetworkInterface& iface) const
+{
+	return iface.isValid() &&
+		iface.flags().testFlag(QNetworkInterface::IsUp) &&
+		iface.flags().testFlag(QNetworkInterface::IsRunning) &&
+		!iface.flags().testFlag(QNetworkInterface::IsLoopBack);
 }
 
 
-void HostUdpServer::sendPacketToServers(const QByteArray& packet)
+// Broadcasts (IPv4) or multicasts (IPv6) a packet to the presence port on an interface
+void HostUdpServer::sendPresenceDatagram(const QByteArray& packet, const QNetworkInterface& iface)
 {
-	for (const auto& server : m_serverAddresses)
+	for (const auto& address : iface.addressEntries())
 	{
-		m_sock->writeDatagram(packet, server.first, server.second);
+		if (address.ip().protocol() == QAbstractSocket::IPv4Protocol)
+		{
+			if (iface.flags().testFlag(QNetworkInterface::CanBroadcast))
+			{
+				m_sock->writeDatagram(packet, address.broadcast(), PRESENCE_UDPPORT);
+				m_sentBytes->increment(packet.size());
+			}
+		}
+		else if (address.ip().protocol() == QAbstractSocket::IPv6Protocol)
+		{
+			QNetworkDatagram datagram;
+			datagram.setInterfaceIndex(iface.index());
+			datagram.setSender(address.ip());
+			datagram.setData(packet);
+			datagram.setDestination(QHostAddress(IPV6_MULTICAST), PRESENCE_UDPPORT);
+			m_sock->writeDatagram(datagram);
+			m_sentBytes->increment(packet.size());
+		}
 	}
 }
 
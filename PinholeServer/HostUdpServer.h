@@ -1,13 +1,16 @@
 #pragma once
 
 #include <QObject>
+#include <QHash>
+#include <QHostAddress>
+#include <QVariantMap>
 
 class Settings;
 class StatusInterface;
 class QUdpSocket;
 class QNetworkDatagram;
 class QNetworkInterface;
-class QHostAddress;
+class MetricCounter;
 
 class HostUdpServer : public QObject
 {
@@ -20,14 +23,21 @@ public:
 public slots:
 	void readyRead();
 	void start();
-	void sendPacketToServers(const QByteArray& packet);
+	void sendPacketToServers(const QVariantMap& values);
+	void sendPresence();
 
 private:
 	bool parseDatagram(const QNetworkDatagram& datagram, const QString& MAC);
+	QString interfaceMAC(const QNetworkInterface& iface) const;
+	bool isPresenceInterface(const QNetworkInterface& iface) const;
+	void sendPresenceDatagram(const QByteArray& packet, const QNetworkInterface& iface);
 
 	QList<QNetworkInterface> m_interfaces;
 	Settings* m_settings = nullptr;
 	StatusInterface* m_statusInterface = nullptr;
 	QUdpSocket* m_sock = nullptr;
-	QList<QPair<QHostAddress, int>> m_serverAddresses;
+	// Address/port of hosts we have received packets from, discovery encoding they understand
+	QHash<QPair<QHostAddress, int>, int> m_serverAddresses;
+	MetricCounter* m_receivedBytes = nullptr;
+	MetricCounter* m_sentBytes = nullptr;
 };
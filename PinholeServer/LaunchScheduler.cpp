@@ -0,0 +1,381 @@
+#include "LaunchScheduler.h"
+#include "Application.h"
+#include "GlobalManager.h"
+#include "Logger.h"
+#include "Values.h"
+
+#include <QSet>
+
+
+LaunchScheduler::LaunchScheduler(GlobalManager* globalManager, QObject *parent)
+	: QObject(parent), m_globalManager(globalManager)
+{
+	m_clock.start();
+
+	m_readyTimer.setInterval(INTERVAL_LAUNCHREADYCHECK);
+	connect(&m_readyTimer, &QTimer::timeout,
+		this, &LaunchScheduler::checkReadyTimeouts);
+}
+
+
+LaunchScheduler::~LaunchScheduler()
+{
+}
+
+
+// Queues apps to start once the apps they depend on are ready, the apps they
+// depend on must be included. Returns false if any can't start because of a
+// dependency cycle.
+bool LaunchScheduler::launch(const QString& description, const QMap<QString, QSharedPointer<Application>>& apps)
+{
+	Batch batch;
+	batch.description = description;
+	batch.started = m_clock.elapsed();
+
+	for (auto it = apps.constBegin(); it != apps.constEnd(); it++)
+	{
+		const QString& appName = it.key();
+		batch.apps.append(appName);
+
+		// Already being launched for an earlier request
+		auto existing = m_launches.constFind(appName);
+		if (existing != m_launches.constEnd() &&
+			(LaunchState::Waiting == existing->state || LaunchState::Launching == existing->state))
+			continue;
+
+		Launch launch;
+		launch.app = it.value();
+		launch.queued = batch.started;
+		for (const auto& dependency : it.value()->getDependencies())
+		{
+			if (apps.contains(dependency))
+			{
+				launch.dependencies.append(dependency);
+			}
+			else
+			{
+				Logger(LOG_WARNING) << tr("App %1: Ignoring dependency on missing application '%2'")
+					.arg(appName)
+					.arg(dependency);
+			}
+		}
+		m_launches[appName] = launch;
+		m_queue.append(appName);
+
+		connect(it.value().data(), &Application::applicationReady,
+			this, &LaunchScheduler::appReady, Qt::UniqueConnection);
+		connect(it.value().data(), &Application::applicationExited,
+			this, &LaunchScheduler::appExited, Qt::UniqueConnection);
+	}
+
+	// Apps in or waiting behind a dependency cycle would never start
+	QSet<QString> resolved;
+	for (auto it = m_launches.constBegin(); it != m_launches.constEnd(); it++)
+	{
+		if (LaunchState::Waiting != it->state)
+			resolved.insert(it.key());
+	}
+	bool progress = true;
+	while (progress)
+	{
+		progress = false;
+		for (const auto& appName : m_queue)
+		{
+			if (resolved.contains(appName))
+				continue;
+
+			bool dependenciesResolved = true;
+			for (const auto& dependency : m_launches[appName].dependencies)
+			{
+				if (!resolved.contains(dependency))
+					dependenciesResolved = false;
+			}
+			if (dependenciesResolved)
+			{
+				resolved.insert(appName);
+				progress = true;
+			}
+		}
+	}
+
+	bool ret = true;
+	for (const auto& appName : QStringList(m_queue))
+	{
+		if (!resolved.contains(appName))
+		{
+			Logger(LOG_ERROR) << tr("App %1: Not launching, its dependencies form a cycle: %2")
+				.arg(appName)
+				.arg(m_launches[appName].dependencies.join(", "));
+			finishLaunch(appName, LaunchState::Failed);
+			ret = false;
+		}
+	}
+
+	m_batches.append(batch);
+	schedule();
+	reportBatches();
+
+	return ret;
+}
+
+
+// Starts every waiting app whose dependencies are ready while launch slots are free
+void LaunchScheduler::schedule()
+{
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		int launching = launchingCount();
+
+		for (const auto& appName : QStringList(m_queue))
+		{
+			Launch& launch = m_launches[appName];
+
+			bool dependenciesReady = true;
+			QString failedDependency;
+			qint64 lastReady = -1;
+			for (const auto& dependency : launch.dependencies)
+			{
+				const Launch& dependencyLaunch = m_launches[dependency];
+				if (LaunchState::Failed == dependencyLaunch.state)
+				{
+					failedDependency = dependency;
+					break;
+				}
+				else if (LaunchState::Ready != dependencyLaunch.state)
+				{
+					dependenciesReady = false;
+				}
+				else if (dependencyLaunch.ready > lastReady)
+				{
+					lastReady = dependencyLaunch.ready;
+					// Only on the critical path if this app actually waited for it
+					launch.gatedBy = lastReady > launch.queued ? dependency : QString();
+				}
+			}
+
+			if (!failedDependency.isEmpty())
+			{
+				Logger(LOG_WARNING) << tr("App %1: Not launching, dependency %2 failed to start")
+					.arg(appName)
+					.arg(failedDependency);
+				finishLaunch(appName, LaunchState::Failed);
+				changed = true;
+				continue;
+			}
+
+			if (!dependenciesReady)
+				continue;
+
+			if (launching >= m_globalManager->getMaxLaunches())
+			{
+				launch.waitedForSlot = true;
+				continue;
+			}
+
+			startLaunch(appName);
+			if (LaunchState::Launching == m_launches[appName].state)
+				launching++;
+			else
+				changed = true;
+		}
+	}
+
+	if (launchingCount() > 0)
+	{
+		if (!m_readyTimer.isActive())
+			m_readyTimer.start();
+	}
+	else
+	{
+		m_readyTimer.stop();
+	}
+}
+
+
+void LaunchScheduler::startLaunch(const QString& appName)
+{
+	Launch& launch = m_launches[appName];
+	m_queue.removeAll(appName);
+	launch.state = LaunchState::Launching;
+	launch.started = m_clock.elapsed();
+
+	QSharedPointer<Application> app = launch.app.toStrongRef();
+	if (app.isNull())
+	{
+		// Deleted while waiting
+		finishLaunch(appName, LaunchState::Failed);
+	}
+	else if (app->getRunning())
+	{
+		// Already running, wait for it to be ready if it isn't yet
+		if (app->getReady())
+			finishLaunch(appName, LaunchState::Ready);
+	}
+	else if (!app->start())
+	{
+		finishLaunch(appName, LaunchState::Failed);
+	}
+}
+
+
+void LaunchScheduler::finishLaunch(const QString& appName, LaunchState state)
+{
+	Launch& launch = m_launches[appName];
+	m_queue.removeAll(appName);
+	launch.state = state;
+	launch.ready = m_clock.elapsed();
+	if (launch.started < 0)
+		launch.started = launch.ready;
+}
+
+
+// Logs a summary of each request once all its apps are ready or failed
+void LaunchScheduler::reportBatches()
+{
+	for (int n = 0; n < m_batches.size(); )
+	{
+		const Batch& batch = m_batches[n];
+
+		bool finished = true;
+		int failures = 0;
+		QString lastApp;
+		qint64 lastReady = batch.started;
+		for (const auto& appName : batch.apps)
+		{
+			const Launch& launch = m_launches[appName];
+			if (LaunchState::Waiting == launch.state || LaunchState::Launching == launch.state)
+			{
+				finished = false;
+				break;
+			}
+			else if (LaunchState::Failed == launch.state)
+			{
+				failures++;
+			}
+			else if (launch.ready >= lastReady)
+			{
+				lastReady = launch.ready;
+				lastApp = appName;
+			}
+		}
+
+		if (!finished)
+		{
+			n++;
+			continue;
+		}
+
+		// Walk back from the last app to be ready through the dependencies that held each one up
+		QStringList criticalPath;
+		QSet<QString> visited;
+		for (QString appName = lastApp; !appName.isEmpty() && !visited.contains(appName); appName = m_launches[appName].gatedBy)
+		{
+			visited.insert(appName);
+			const Launch& launch = m_launches[appName];
+			criticalPath.prepend(tr("%1 (%2-%3 ms%4)")
+				.arg(appName)
+				.arg(qMax(launch.started - batch.started, Q_INT64_C(0)))
+				.arg(qMax(launch.ready - batch.started, Q_INT64_C(0)))
+				.arg(launch.waitedForSlot ? tr(", waited for launch slot") : QString()));
+		}
+
+		Logger(failures > 0 ? LOG_WARNING : LOG_NORMAL) << tr("Launched %1: %2 of %3 applications ready in %4 ms, critical path: %5")
+			.arg(batch.description)
+			.arg(batch.apps.size() - failures)
+			.arg(batch.apps.size())
+			.arg(lastReady - batch.started)
+			.arg(criticalPath.isEmpty() ? tr("none") : criticalPath.join(" -> "));
+
+		m_batches.removeAt(n);
+	}
+
+	// Forget finished launches no remaining request refers to
+	QSet<QString> referenced;
+	for (const auto& batch : m_batches)
+	{
+		for (const auto& appName : batch.apps)
+			referenced.insert(appName);
+	}
+	for (auto it = m_launches.begin(); it != m_launches.end(); )
+	{
+		if (!referenced.contains(it.key()) &&
+			LaunchState::Waiting != it->state && LaunchState::Launching != it->state)
+			it = m_launches.erase(it);
+		else
+			it++;
+	}
+}
+
+
+int LaunchScheduler::launchingCount() const
+{
+	int count = 0;
+	for (const auto& launch : m_launches)
+	{
+		if (LaunchState::Launching == launch.state)
+			count++;
+	}
+	return count;
+}
+
+
+void LaunchScheduler::appReady()
+{
+	QString appName = sender()->property(PROP_APP_NAME).toString();
+	auto launch = m_launches.constFind(appName);
+	if (launch == m_launches.constEnd() || LaunchState::Launching != launch->state)
+		return;
+
+	finishLaunch(appName, LaunchState::Ready);
+	schedule();
+	reportBatches();
+}
+
+
+// Called when an app exits without being restarted or its process fails to start,
+// either way the launch fails straight away and its dependants are not started
+void LaunchScheduler::appExited()
+{
+	QString appName = sender()->property(PROP_APP_NAME).toString();
+	auto launch = m_launches.constFind(appName);
+	if (launch == m_launches.constEnd() || LaunchState::Launching != launch->state)
+		return;
+
+	Logger(LOG_WARNING) << tr("App %1: Exited before it was ready").arg(appName);
+	finishLaunch(appName, LaunchState::Failed);
+	schedule();
+	reportBatches();
+}
+
+
+// Apps that never send a heartbeat shouldn't hold up the apps depending on them forever
+void LaunchScheduler::checkReadyTimeouts()
+{
+	bool changed = false;
+	qint64 now = m_clock.elapsed();
+
+	for (auto it = m_launches.begin(); it != m_launches.end(); it++)
+	{
+		if (LaunchState::Launching != it->state)
+			continue;
+
+		QSharedPointer<Application> app = it->app.toStrongRef();
+		qint64 timeout = INTERVAL_LAUNCHREADYTIMEOUT + (app.isNull() ? 0 : app->getLaunchDelay());
+		if (now - it->started > timeout)
+		{
+			Logger(LOG_WARNING) << tr("App %1: Not ready after %2 ms, launching the applications depending on it anyway")
+				.arg(it.key())
+				.arg(now - it->started);
+			finishLaunch(it.key(), LaunchState::Ready);
+			changed = true;
+		}
+	}
+
+	if (changed)
+	{
+		schedule();
+		reportBatches();
+	}
+}
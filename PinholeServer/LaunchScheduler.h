@@ -0,0 +1,72 @@
+#pragma once
+
+/* LaunchScheduler.h - Launches applications once the applications they depend on are ready */
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QTimer>
+
+class Application;
+class GlobalManager;
+
+class LaunchScheduler : public QObject
+{
+	Q_OBJECT
+
+public:
+	LaunchScheduler(GlobalManager* globalManager, QObject *parent = nullptr);
+	~LaunchScheduler();
+
+	bool launch(const QString& description, const QMap<QString, QSharedPointer<Application>>& apps);
+
+private slots:
+	void appReady();
+	void appExited();
+	void checkReadyTimeouts();
+
+private:
+	enum class LaunchState
+	{
+		Waiting,		// Waiting for dependencies or a launch slot
+		Launching,		// Started, waiting to be ready
+		Ready,
+		Failed
+	};
+
+	// One application being launched
+	struct Launch
+	{
+		QWeakPointer<Application> app;
+		QStringList dependencies;			// Apps that must be ready before this one is started
+		LaunchState state = LaunchState::Waiting;
+		qint64 queued = 0;					// Times are from m_clock in milliseconds
+		qint64 started = -1;
+		qint64 ready = -1;
+		QString gatedBy;					// Dependency that became ready last, for the critical path
+		bool waitedForSlot = false;			// Waited for a launch slot after dependencies were ready
+	};
+
+	// Apps launched by one request, summarized once all of them are ready or failed
+	struct Batch
+	{
+		QString description;
+		QStringList apps;
+		qint64 started = 0;
+	};
+
+	void schedule();
+	void startLaunch(const QString& appName);
+	void finishLaunch(const QString& appName, LaunchState state);
+	void reportBatches();
+	int launchingCount() const;
+
+	GlobalManager* m_globalManager = nullptr;
+	QMap<QString, Launch> m_launches;
+	QStringList m_queue;					// Waiting apps in the order they were requested
+	QList<Batch> m_batches;
+	QElapsedTimer m_clock;
+	QTimer m_readyTimer;
+};
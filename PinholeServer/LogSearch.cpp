@@ -0,0 +1,315 @@
+#include "LogSearch.h"
+#include "Logger.h"
+#include "Values.h"
+#include "../qmsgpack/msgpack.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QByteArrayMatcher>
+#include <QRegularExpression>
+#include <QtConcurrent>
+
+#include <string.h>
+
+// Log lines start with "yyyy-MM-dd HH:mm:ss", which sorts the same as the time
+#define SIZE_LOGTIME			19
+
+
+// Collects matching lines and their context into result groups
+class SearchScanner
+{
+public:
+	SearchScanner(const SearchQuery& query)
+		: m_query(query),
+		m_matcher(query.caseSensitive ? query.pattern.toUtf8() : query.pattern.toUtf8().toLower()),
+		m_regExp(query.pattern, query.caseSensitive ? QRegularExpression::NoPatternOption : QRegularExpression::CaseInsensitiveOption)
+	{
+		if (!query.start.isNull())
+			m_startKey = query.start.toString(DATETIME_STRINGFORMAT).toLatin1();
+		if (!query.end.isNull())
+			m_endKey = query.end.toString(DATETIME_STRINGFORMAT).toLatin1();
+	}
+
+	void beginFile(const QString& filename)
+	{
+		closeGroup();
+		m_before.clear();
+		m_file = QFileInfo(filename).fileName();
+	}
+
+	// Returns false once nothing more is wanted
+	bool scanLine(const char* data, int length)
+	{
+		while (length > 0 && ('\n' == data[length - 1] || '\r' == data[length - 1]))
+			length--;
+
+		// Lines without a time belong to the log entry before them
+		if (m_query.timestamped && isEntryStart(data, length))
+		{
+			m_entryKey = QByteArray(data, SIZE_LOGTIME);
+			m_entryLevel = entryLevel(data, length);
+
+			// Files are searched oldest first so nothing after this can be in range
+			if (!m_endKey.isEmpty() && m_entryKey > m_endKey)
+			{
+				closeGroup();
+				return false;
+			}
+		}
+
+		bool inRange = !m_query.timestamped ||
+			((m_startKey.isEmpty() || m_entryKey >= m_startKey) && m_entryLevel >= m_query.level);
+
+		if (inRange && m_matches < m_query.maxResults && matches(data, length))
+		{
+			if (!m_groupOpen)
+				openGroup();
+			addLine('>', data, length);
+			m_matches++;
+			m_after = m_query.context;
+			if (0 == m_after)
+				closeGroup();
+		}
+		else if (m_groupOpen)
+		{
+			addLine(' ', data, length);
+			if (--m_after <= 0)
+				closeGroup();
+		}
+		else if (m_query.context > 0)
+		{
+			m_before.append(QByteArray(data, qMin(length, SIZE_SEARCHLINE)));
+			if (m_before.size() > m_query.context)
+				m_before.removeFirst();
+		}
+
+		if (!m_groupOpen && (m_matches >= m_query.maxResults || m_size >= SIZE_SEARCHRESULTS))
+		{
+			m_limitReached = true;
+			return false;
+		}
+		return true;
+	}
+
+	QVariant results()
+	{
+		closeGroup();
+
+		QVariantList results;
+		results << m_matches << m_limitReached << qCompress(MsgPack::pack(m_groups));
+		return results;
+	}
+
+private:
+	static bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	static bool isEntryStart(const char* data, int length)
+	{
+		return length >= SIZE_LOGTIME &&
+			isDigit(data[0]) && isDigit(data[1]) && isDigit(data[2]) && isDigit(data[3]) &&
+			'-' == data[4] && '-' == data[7] && ' ' == data[10] && ':' == data[13] && ':' == data[16];
+	}
+
+	// "yyyy-MM-dd HH:mm:ss ddd: [Level] ", normal entries have no level and the day name depends on the locale.
+	// LOG_ALWAYS entries have no level either, so they can only be read as normal, the level control says so.
+	static int entryLevel(const char* data, int length)
+	{
+		const char* end = data + qMin(length, SIZE_LOGTIME + 24);
+		const char* colon = static_cast<const char*>(memchr(data + SIZE_LOGTIME, ':', end - data - SIZE_LOGTIME));
+		if (nullptr == colon || colon + 2 >= end || '[' != colon[2])
+			return LOG_NORMAL;
+
+		const char* name = colon + 3;
+		const char* close = static_cast<const char*>(memchr(name, ']', end - name));
+		if (nullptr == close || close == name)
+			return LOG_NORMAL;
+
+		int level = Logger::s_LogLevelNames.indexOf(QString::fromLatin1(name, close - name));
+		return level > 0 ? level : LOG_NORMAL;
+	}
+
+	bool matches(const char* data, int length)
+	{
+		if (m_query.regularExpression)
+			return m_regExp.match(QString::fromUtf8(data, length)).hasMatch();
+
+		if (m_query.caseSensitive)
+			return m_matcher.indexIn(data, length) >= 0;
+
+		m_lowerLine.resize(length);
+		char* lower = m_lowerLine.data();
+		for (int n = 0; n < length; n++)
+			lower[n] = (data[n] >= 'A' && data[n] <= 'Z') ? data[n] + ('a' - 'A') : data[n];
+		return m_matcher.indexIn(lower, length) >= 0;
+	}
+
+	void openGroup()
+	{
+		m_groupOpen = true;
+		m_groupKey = m_entryKey;
+		m_groupFile = m_file;
+		for (const auto& line : m_before)
+			addLine(' ', line.constData(), line.size());
+		m_before.clear();
+	}
+
+	void closeGroup()
+	{
+		if (!m_groupOpen)
+			return;
+
+		QVariantList group;
+		group << QString::fromLatin1(m_groupKey) << m_groupFile << m_group;
+		m_groups.append(QVariant(group));
+		m_size += m_group.size();
+		m_group.clear();
+		m_groupOpen = false;
+	}
+
+	void addLine(char marker, const char* data, int length)
+	{
+		m_group.append(marker);
+		m_group.append(' ');
+		m_group.append(data, qMin(length, SIZE_SEARCHLINE));
+		if (length > SIZE_SEARCHLINE)
+			m_group.append("...");
+		m_group.append('\n');
+	}
+
+	const SearchQuery& m_query;
+	QByteArrayMatcher m_matcher;
+	QRegularExpression m_regExp;
+	QByteArray m_startKey;
+	QByteArray m_endKey;
+	QByteArray m_lowerLine;
+	QString m_file;
+	QByteArray m_entryKey;
+	int m_entryLevel = LOG_NORMAL;
+	QList<QByteArray> m_before;			// Lines that may be shown before the next match
+	bool m_groupOpen = false;
+	QByteArray m_group;
+	QByteArray m_groupKey;
+	QString m_groupFile;
+	int m_after = 0;					// Lines still shown after the last match
+	QVariantList m_groups;
+	int m_matches = 0;
+	qint64 m_size = 0;
+	bool m_limitReached = false;
+};
+
+
+LogSearch::LogSearch(QObject *parent)
+	: QObject(parent)
+{
+	m_threadPool.setMaxThreadCount(MAX_SEARCHTHREADS);
+}
+
+
+LogSearch::~LogSearch()
+{
+	m_threadPool.waitForDone();
+}
+
+
+// Starts a search, finished() is emitted with the results. Returns 0 if the search can't be done.
+quint64 LogSearch::start(const SearchQuery& query)
+{
+	if (query.regularExpression && !QRegularExpression(query.pattern).isValid())
+	{
+		Logger(LOG_WARNING) << tr("Invalid search expression '%1'").arg(query.pattern);
+		return 0;
+	}
+
+	quint64 id = m_nextId++;
+	auto watcher = new QFutureWatcher<QVariant>(this);
+	connect(watcher, &QFutureWatcher<QVariant>::finished,
+		this, [this, watcher, id]()
+	{
+		emit finished(id, watcher->result());
+		watcher->deleteLater();
+	});
+	watcher->setFuture(QtConcurrent::run(&m_threadPool, &LogSearch::search, query));
+	return id;
+}
+
+
+// The Pinhole log files, oldest first
+QStringList LogSearch::logFilenames(const QString& dataDir)
+{
+	QString baseLogFilename = dataDir + FILENAME_LOGFILE;
+	QStringList logFilenames;
+	for (int n = MAX_LOG_FILES; n > 0; n--)
+	{
+		if (QFile::exists(baseLogFilename + "." + QString::number(n)))
+			logFilenames.append(baseLogFilename + "." + QString::number(n));
+	}
+	if (QFile::exists(baseLogFilename))
+		logFilenames.append(baseLogFilename);
+
+	return logFilenames;
+}
+
+
+// Runs on the thread pool
+QVariant LogSearch::search(const SearchQuery& query)
+{
+	SearchScanner scanner(query);
+	bool searching = true;
+	for (int n = 0; searching && n < query.filenames.size(); n++)
+	{
+		const QString& filename = query.filenames[n];
+
+		// Files last written before the start have nothing in range, once the
+		// file before was written after the end so is everything from here on
+		if (!query.start.isNull() && QFileInfo(filename).lastModified() < query.start)
+			continue;
+		if (!query.end.isNull() && n > 0 && QFileInfo(query.filenames[n - 1]).lastModified() > query.end)
+			break;
+
+		QFile file(filename);
+		if (!file.open(QIODevice::ReadOnly))
+			continue;
+
+		scanner.beginFile(filename);
+		QByteArray buffer;
+		while (searching)
+		{
+			QByteArray chunk = file.read(SIZE_SEARCHCHUNK);
+			if (chunk.isEmpty())
+			{
+				if (!buffer.isEmpty())
+					searching = scanner.scanLine(buffer.constData(), buffer.size());
+				break;
+			}
+
+			if (buffer.isEmpty())
+				buffer = chunk;
+			else
+				buffer.append(chunk);
+
+			const char* data = buffer.constData();
+			const char* newline;
+			int pos = 0;
+			while (searching && nullptr != (newline = static_cast<const char*>(memchr(data + pos, '\n', buffer.size() - pos))))
+			{
+				int length = static_cast<int>(newline - data) - pos + 1;
+				searching = scanner.scanLine(data + pos, length);
+				pos += length;
+			}
+
+			// A line longer than a chunk is searched as it is
+			if (0 == pos && buffer.size() >= SIZE_SEARCHCHUNK)
+			{
+				searching = searching && scanner.scanLine(data, buffer.size());
+				pos = buffer.size();
+			}
+			buffer = buffer.mid(pos);
+		}
+	}
+
+	return scanner.results();
+}
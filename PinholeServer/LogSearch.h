@@ -0,0 +1,53 @@
+#pragma once
+
+/* LogSearch.h - Finds matching lines in the log and console output files on a thread pool */
+
+#include "../common/PinholeCommon.h"
+
+#include <QObject>
+#include <QDateTime>
+#include <QThreadPool>
+#include <QVariant>
+
+// What to look for and which files to look in
+struct SearchQuery
+{
+	QStringList filenames;			// Oldest first
+	bool timestamped = false;		// Lines start with the log's date and level
+	QString pattern;
+	bool regularExpression = false;
+	bool caseSensitive = false;
+	QDateTime start;				// Null for no limit
+	QDateTime end;
+	int level = LOG_DEBUG;			// Lowest log level matched, timestamped files only
+	int maxResults = 0;
+	int context = 0;				// Lines shown before and after each match
+};
+
+
+// Searches run on their own small thread pool so a search of a large log never
+// holds up the main thread and many at once can't take over the machine.
+// Files are read in big chunks and scanned line by line, only matching lines
+// and their context are kept. Each match with its context is a result group
+// keyed by its log time so results from several hosts can be merged.
+class LogSearch : public QObject
+{
+	Q_OBJECT
+
+public:
+	LogSearch(QObject *parent = nullptr);
+	~LogSearch();
+
+	quint64 start(const SearchQuery& query);
+
+	static QStringList logFilenames(const QString& dataDir);
+
+signals:
+	void finished(quint64 id, const QVariant& results);
+
+private:
+	static QVariant search(const SearchQuery& query);
+
+	QThreadPool m_threadPool;
+	quint64 m_nextId = 1;
+};
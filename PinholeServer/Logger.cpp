@@ -2,10 +2,12 @@
 #include "Settings.h"
 #include "CommandInterface.h"
 #include "Values.h"
+#include "Metrics.h"
 
 #include <QFile>
 #include <QDateTime>
 #include <QHostInfo>
+#include <QVector>
 #include <QDebug>
 
 #include <iostream>
@@ -27,6 +29,24 @@ const QMap<QString, int> Logger::s_logLevelMap =
 
 const QStringList Logger::s_LogLevelNames = { "", "Debug", "Extra", "", "Warning", "Error", "" };
 
+// Level label values for the log line metrics
+static const QStringList s_metricLevelNames = { "", LOG_LEVEL_DEBUG, LOG_LEVEL_EXTRA, LOG_LEVEL_NORMAL, LOG_LEVEL_WARNING, LOG_LEVEL_ERROR, "always" };
+
+// Counters are looked up the first time a line is logged, by level, instead of for every line
+static MetricCounter* logLinesCounter(int level)
+{
+	static const QVector<MetricCounter*> counters = []()
+	{
+		QVector<MetricCounter*> levelCounters;
+		for (const auto& levelName : s_metricLevelNames)
+		{
+			levelCounters.append(Metrics::counter(METRIC_LOG_LINES, Metrics::label("level", levelName)));
+		}
+		return levelCounters;
+	}();
+	return counters[qBound(0, level, counters.size() - 1)];
+}
+
 QTextStream& qStdOut()
 {
 	static QTextStream ts(stdout);
@@ -93,12 +113,15 @@ Logger::~Logger()
 		if (!logFile.open(QFile::WriteOnly | QFile::Append))
 		{
 			qDebug() << tr("Unable to open log file:") << logFilename;
+			static MetricCounter* droppedLines = Metrics::counter(METRIC_LOG_DROPPED);
+			droppedLines->increment();
 		}
 		else
 		{
 			logFile.write(header.toUtf8());
 			logFile.write(m_string.toUtf8());
 			logFile.close();
+			logLinesCounter(m_level)->increment();
 		}
 	}
 
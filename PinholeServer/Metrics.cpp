@@ -0,0 +1,197 @@
+#include "Metrics.h"
+#include "Values.h"
+
+#include <QCoreApplication>
+#include <QTimer>
+
+QReadWriteLock Metrics::s_lock;
+QMap<QString, Metrics::Family> Metrics::s_families;
+
+const qint64 MetricHistogram::s_bucketBounds[METRIC_BUCKETCOUNT] =
+{
+	1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+
+// Name, type and help text of every metric
+static const QMap<QString, QPair<QByteArray, QByteArray>> s_definitions =
+{
+	{ METRIC_COMMAND_DURATION, { "histogram", "Time taken to handle client commands by command type" } },
+	{ METRIC_RECEIVED_BYTES, { "counter", "Bytes received by network interface" } },
+	{ METRIC_SENT_BYTES, { "counter", "Bytes sent by network interface" } },
+	{ METRIC_CLIENTS, { "gauge", "Command clients currently connected" } },
+	{ METRIC_HTTP_CONNECTIONS, { "gauge", "HTTP connections currently open" } },
+	{ METRIC_APP_STARTS, { "counter", "Application process starts by application" } },
+	{ METRIC_APP_CRASHES, { "counter", "Unexpected application exits by application" } },
+	{ METRIC_APP_RESTARTS, { "counter", "Application restarts after a crash or lockup by application" } },
+	{ METRIC_APP_HEARTBEATTIMEOUTS, { "counter", "Application heartbeat timeouts by application" } },
+	{ METRIC_APP_CPU, { "gauge", "CPU time used since the last start by applications contained in a cgroup" } },
+	{ METRIC_APP_MEMORY, { "gauge", "Memory used by applications contained in a cgroup" } },
+	{ METRIC_ALERTS, { "counter", "Alerts generated" } },
+	{ METRIC_ALERT_SENDS, { "counter", "Alerts sent by alert slot type" } },
+	{ METRIC_ALERT_FAILURES, { "counter", "Alerts that failed to send by alert slot type" } },
+	{ METRIC_LOG_LINES, { "counter", "Log lines written to the log file by level" } },
+	{ METRIC_LOG_DROPPED, { "counter", "Log lines that could not be written to the log file" } },
+	{ METRIC_EVENTLOOP_LAG, { "histogram", "How late the main event loop runs timers" } },
+	{ METRIC_TIMER_LATENCY, { "histogram", "How long after their deadline app timeouts fire by timer kind" } },
+	{ METRIC_FRAME_UNCOMPRESSED, { "counter", "Bytes of frames sent to clients that accept compression, before compressing" } },
+	{ METRIC_FRAME_COMPRESSED, { "counter", "Bytes of frames sent to clients that accept compression, as sent" } },
+	{ METRIC_FRAME_COMPRESS_DURATION, { "histogram", "Time taken to compress frames sent to clients" } }
+};
+
+
+void MetricHistogram::observe(qint64 usecs)
+{
+	int bucket = 0;
+	while (bucket < METRIC_BUCKETCOUNT && usecs > s_bucketBounds[bucket])
+	{
+		bucket++;
+	}
+
+	m_buckets[bucket].fetchAndAddRelaxed(1);
+	m_sum.fetchAndAddRelaxed(usecs);
+	m_count.fetchAndAddRelaxed(1);
+}
+
+
+QByteArray MetricHistogram::exportText(const QByteArray& name, const QString& labels) const
+{
+	QByteArray labelPrefix = labels.isEmpty() ? QByteArray() : labels.toUtf8() + ",";
+	QByteArray labelSuffix = labels.isEmpty() ? QByteArray() : "{" + labels.toUtf8() + "}";
+
+	// Buckets are exported cumulatively
+	QByteArray text;
+	qint64 cumulative = 0;
+	for (int n = 0; n < METRIC_BUCKETCOUNT; n++)
+	{
+		cumulative += m_buckets[n].load();
+		text += name + "_bucket{" + labelPrefix + "le=\"" + QByteArray::number(s_bucketBounds[n] / 1000000.0) + "\"} " +
+			QByteArray::number(cumulative) + "\n";
+	}
+	cumulative += m_buckets[METRIC_BUCKETCOUNT].load();
+	text += name + "_bucket{" + labelPrefix + "le=\"+Inf\"} " + QByteArray::number(cumulative) + "\n";
+	text += name + "_sum" + labelSuffix + " " + QByteArray::number(m_sum.load() / 1000000.0, 'f', 6) + "\n";
+	// Use the bucket total so the count always matches +Inf
+	text += name + "_count" + labelSuffix + " " + QByteArray::number(cumulative) + "\n";
+	return text;
+}
+
+
+MetricTimer::~MetricTimer()
+{
+	if (nullptr != m_histogram)
+	{
+		m_histogram->observe(m_timer.nsecsElapsed() / 1000);
+	}
+}
+
+
+// Returns the series for a name and labels, creating it the first time
+template <class T>
+T* Metrics::find(QMap<QString, QSharedPointer<T>> Family::* series, const char* name, const QString& labels)
+{
+	{
+		// Nearly always already exists
+		QReadLocker locker(&s_lock);
+		auto family = s_families.constFind(name);
+		if (family != s_families.constEnd())
+		{
+			const QMap<QString, QSharedPointer<T>>& familySeries = family.value().*series;
+			auto metric = familySeries.constFind(labels);
+			if (metric != familySeries.constEnd())
+				return metric.value().data();
+		}
+	}
+
+	QWriteLocker locker(&s_lock);
+	QSharedPointer<T>& metric = (s_families[name].*series)[labels];
+	if (metric.isNull())
+	{
+		metric = QSharedPointer<T>::create();
+	}
+	return metric.data();
+}
+
+
+MetricCounter* Metrics::counter(const char* name, const QString& labels)
+{
+	return find(&Family::counters, name, labels);
+}
+
+
+MetricGauge* Metrics::gauge(const char* name, const QString& labels)
+{
+	return find(&Family::gauges, name, labels);
+}
+
+
+MetricHistogram* Metrics::histogram(const char* name, const QString& labels)
+{
+	return find(&Family::histograms, name, labels);
+}
+
+
+// Returns a label string for a series, join several with commas
+QString Metrics::label(const QString& name, const QString& value)
+{
+	QString escaped(value);
+	escaped.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+	return name + "=\"" + escaped + "\"";
+}
+
+
+// Returns every metric in Prometheus text format
+QByteArray Metrics::exportText()
+{
+	QReadLocker locker(&s_lock);
+
+	QByteArray text;
+	for (auto family = s_families.constBegin(); family != s_families.constEnd(); family++)
+	{
+		QByteArray name = family.key().toUtf8();
+		QPair<QByteArray, QByteArray> definition = s_definitions.value(family.key());
+		text += "# HELP " + name + " " + definition.second + "\n";
+		text += "# TYPE " + name + " " + definition.first + "\n";
+
+		for (auto metric = family->counters.constBegin(); metric != family->counters.constEnd(); metric++)
+		{
+			text += name + (metric.key().isEmpty() ? QByteArray() : "{" + metric.key().toUtf8() + "}") +
+				" " + QByteArray::number(metric.value()->value()) + "\n";
+		}
+
+		for (auto metric = family->gauges.constBegin(); metric != family->gauges.constEnd(); metric++)
+		{
+			text += name + (metric.key().isEmpty() ? QByteArray() : "{" + metric.key().toUtf8() + "}") +
+				" " + QByteArray::number(metric.value()->value()) + "\n";
+		}
+
+		for (auto metric = family->histograms.constBegin(); metric != family->histograms.constEnd(); metric++)
+		{
+			text += metric.value()->exportText(name, metric.key());
+		}
+	}
+
+	return text;
+}
+
+
+// Measures how late a timer on the calling thread's event loop fires, which is
+// how long events sit waiting behind whatever is blocking the loop
+void Metrics::startEventLoopMonitor()
+{
+	MetricHistogram* lag = histogram(METRIC_EVENTLOOP_LAG);
+	QSharedPointer<QElapsedTimer> elapsed = QSharedPointer<QElapsedTimer>::create();
+
+	QTimer* timer = new QTimer(QCoreApplication::instance());
+	timer->setTimerType(Qt::PreciseTimer);
+	timer->setInterval(INTERVAL_EVENTLOOPCHECK);
+	QObject::connect(timer, &QTimer::timeout,
+		[lag, elapsed]()
+	{
+		qint64 late = elapsed->nsecsElapsed() / 1000 - static_cast<qint64>(INTERVAL_EVENTLOOPCHECK) * 1000;
+		lag->observe(qMax(late, Q_INT64_C(0)));
+		elapsed->restart();
+	});
+
+	elapsed->start();
+	timer->start();
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+/* Metrics.h - Counters, gauges and histograms exported in Prometheus text format */
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QString>
+
+// Metric names, see s_definitions in Metrics.cpp for their type and help text
+#define METRIC_COMMAND_DURATION			"pinhole_command_duration_seconds"
+#define METRIC_RECEIVED_BYTES			"pinhole_network_received_bytes_total"
+#define METRIC_SENT_BYTES				"pinhole_network_sent_bytes_total"
+#define METRIC_CLIENTS					"pinhole_clients_connected"
+#define METRIC_HTTP_CONNECTIONS			"pinhole_http_connections"
+#define METRIC_APP_STARTS				"pinhole_app_starts_total"
+#define METRIC_APP_CRASHES				"pinhole_app_crashes_total"
+#define METRIC_APP_RESTARTS				"pinhole_app_restarts_total"
+#define METRIC_APP_HEARTBEATTIMEOUTS	"pinhole_app_heartbeat_timeouts_total"
+#define METRIC_APP_CPU					"pinhole_app_cpu_seconds"
+#define METRIC_APP_MEMORY				"pinhole_app_memory_bytes"
+#define METRIC_ALERTS					"pinhole_alerts_total"
+#define METRIC_ALERT_SENDS				"pinhole_alert_sends_total"
+#define METRIC_ALERT_FAILURES			"pinhole_alert_send_failures_total"
+#define METRIC_LOG_LINES				"pinhole_log_lines_total"
+#define METRIC_LOG_DROPPED				"pinhole_log_lines_dropped_total"
+#define METRIC_EVENTLOOP_LAG			"pinhole_event_loop_lag_seconds"
+#define METRIC_TIMER_LATENCY			"pinhole_timer_latency_seconds"
+#define METRIC_FRAME_UNCOMPRESSED		"pinhole_frame_uncompressed_bytes_total"
+#define METRIC_FRAME_COMPRESSED			"pinhole_frame_compressed_bytes_total"
+#define METRIC_FRAME_COMPRESS_DURATION	"pinhole_frame_compress_duration_seconds"
+
+// Interface label values for the network metrics
+#define METRIC_INTERFACE_TCP			"tcp"
+#define METRIC_INTERFACE_BACKEND		"backend"
+#define METRIC_INTERFACE_UDP			"udp"
+#define METRIC_INTERFACE_HTTP			"http"
+
+// Kind label values for the timer latency metric
+#define METRIC_TIMER_HEARTBEAT			"heartbeat"
+#define METRIC_TIMER_TERMINATE			"terminate"
+
+#define METRIC_BUCKETCOUNT				12
+
+// A value that only goes up
+class MetricCounter
+{
+public:
+	void increment(qint64 amount = 1) { m_value.fetchAndAddRelaxed(amount); }
+	qint64 value() const { return m_value.load(); }
+
+private:
+	QAtomicInteger<qint64> m_value;
+};
+
+
+// A value that goes up and down
+class MetricGauge
+{
+public:
+	void set(qint64 value) { m_value.store(value); }
+	void add(qint64 amount) { m_value.fetchAndAddRelaxed(amount); }
+	qint64 value() const { return m_value.load(); }
+
+private:
+	QAtomicInteger<qint64> m_value;
+};
+
+
+// Counts durations into fixed buckets, exported in seconds
+class MetricHistogram
+{
+public:
+	void observe(qint64 usecs);
+	QByteArray exportText(const QByteArray& name, const QString& labels) const;
+
+	// Upper bounds of each bucket in microseconds
+	static const qint64 s_bucketBounds[METRIC_BUCKETCOUNT];
+
+private:
+	QAtomicInteger<qint64> m_buckets[METRIC_BUCKETCOUNT + 1];
+	QAtomicInteger<qint64> m_sum;
+	QAtomicInteger<qint64> m_count;
+};
+
+
+// Observes the time until it goes out of scope into a histogram, if one was set
+class MetricTimer
+{
+public:
+	MetricTimer() { m_timer.start(); }
+	~MetricTimer();
+	void setHistogram(MetricHistogram* histogram) { m_histogram = histogram; }
+
+private:
+	MetricHistogram* m_histogram = nullptr;
+	QElapsedTimer m_timer;
+};
+
+
+// Registry of every metric. Lookups are safe from any thread and the returned
+// pointers live forever, so hot paths can look a metric up once and keep it.
+class Metrics
+{
+public:
+	static MetricCounter* counter(const char* name, const QString& labels = QString());
+	static MetricGauge* gauge(const char* name, const QString& labels = QString());
+	static MetricHistogram* histogram(const char* name, const QString& labels = QString());
+	static QString label(const QString& name, const QString& value);
+	static QByteArray exportText();
+	static void startEventLoopMonitor();
+
+private:
+	// Series of one metric name, by label string
+	struct Family
+	{
+		QMap<QString, QSharedPointer<MetricCounter>> counters;
+		QMap<QString, QSharedPointer<MetricGauge>> gauges;
+		QMap<QString, QSharedPointer<MetricHistogram>> histograms;
+	};
+
+	template <class T>
+	static T* find(QMap<QString, QSharedPointer<T>> Family::* series, const char* name, const QString& labels);
+
+	static QReadWriteLock s_lock;
+	static QMap<QString, Family> s_families;
+};
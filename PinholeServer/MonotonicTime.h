@@ -0,0 +1,50 @@
+#pragma once
+
+// A point in time on the monotonic clock, for heartbeats, throttles and timeouts.
+// Unlike QDateTime it doesn't jump when NTP steps the system clock or daylight
+// saving changes, and is cheap to read. Only meaningful compared to other
+// MonotonicTime values from the same boot.
+
+#include <QElapsedTimer>
+
+class MonotonicTime
+{
+public:
+	MonotonicTime() {}
+
+	static MonotonicTime now()
+	{
+		QElapsedTimer timer;
+		timer.start();
+		return MonotonicTime(timer.msecsSinceReference());
+	}
+
+	static MonotonicTime fromMSecs(qint64 msecs)
+	{
+		return MonotonicTime(msecs);
+	}
+
+	qint64 toMSecs() const
+	{
+		return m_msecs;
+	}
+
+	qint64 msecsTo(const MonotonicTime& other) const
+	{
+		return other.m_msecs - m_msecs;
+	}
+
+	qint64 elapsed() const
+	{
+		return msecsTo(now());
+	}
+
+	bool operator<(const MonotonicTime& other) const { return m_msecs < other.m_msecs; }
+	bool operator==(const MonotonicTime& other) const { return m_msecs == other.m_msecs; }
+	bool operator!=(const MonotonicTime& other) const { return m_msecs != other.m_msecs; }
+
+private:
+	explicit MonotonicTime(qint64 msecs) : m_msecs(msecs) {}
+
+	qint64 m_msecs = 0;
+};
@@ -2,12 +2,14 @@
 #include "GlobalManager.h"
 #include "Settings.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include "Values.h"
 #include "StatusInterface.h"
 #include "CommandInterface.h"
 #include "../common/Utilities.h"
 #include "../common/PinholeCommon.h"
 #include "../common/MultiplexSocket.h"
+#include "../common/DiscoveryPacket.h"
 
 #include <QSslSocket>
 #include <QSslKey>
@@ -27,6 +29,9 @@ MultiplexServer::MultiplexServer(Settings* settings, StatusInterface* statusInte
 	connect(m_globalManager, &GlobalManager::valueChanged,
 		this, &MultiplexServer::globalValueChanged);
 
+	m_receivedBytes = Metrics::counter(METRIC_RECEIVED_BYTES, Metrics::label("interface", METRIC_INTERFACE_BACKEND));
+	m_sentBytes = Metrics::counter(METRIC_SENT_BYTES, Metrics::label("interface", METRIC_INTERFACE_BACKEND));
+
 	m_serverAddress = m_globalManager->getBackendServer();
 
 	QFile keyFile(settings->dataDir() + FILENAME_KEYFILE);
@@ -135,12 +140,14 @@ MultiplexServer::MultiplexServer(Settings* settings, StatusInterface* statusInte
 			connect(m_multiplexSocket, &MultiplexSocket::datagramReceived,
 				this, [this](unsigned int id, const QByteArray& datagram)
 				{
+					m_receivedBytes->increment(datagram.size());
 					if (HOST_UDPPORT == id)
 					{
-						QByteArray response = m_statusInterface->processPacket(datagram.data(), "");
+						QByteArray response = m_statusInterface->processPacket(datagram.data(), "", &m_backendEncoding);
 						if (!response.isEmpty())
 						{
 							m_multiplexSocket->writeDatagram(HOST_UDPPORT, response);
+							m_sentBytes->increment(response.size());
 						}
 					}
 				});
@@ -158,22 +165,29 @@ MultiplexServer::MultiplexServer(Settings* settings, StatusInterface* statusInte
 					connect(connection, &MultiplexSocketConnection::dataReceived,
 						this, [this, address, connection](const QByteArray& data)
 						{
+							m_receivedBytes->increment(data.size());
 							uint32_t size;
 							memcpy(&size, data.data(), sizeof(size));
-							unsigned int dataSize = qFromLittleEndian(size);
+							size = qFromLittleEndian(size);
+							unsigned int dataSize = size & FRAME_SIZEMASK;
 							if (dataSize != data.size() - sizeof(uint32_t))
 							{
 								Logger(LOG_WARNING) << tr("MultiplexServer received bad sized data packet");
 							}
 							else
 							{
+								QByteArray packet = data.mid(4);
+								if (size & FRAME_COMPRESSED)
+									packet = UncompressFrameData(packet);
+
 								QByteArray response;
 								bool disconnect = false;
-								emit incomingData(address, data.mid(4), response, disconnect);
+								emit incomingData(address, packet, response, disconnect);
 
 								if (!response.isEmpty())
 								{
 									connection->writeData(response);
+									m_sentBytes->increment(response.size());
 								}
 
 								if (disconnect)
@@ -226,12 +240,18 @@ void MultiplexServer::sendDataToClient(const QString & clientId, const QByteArra
 	}
 
 	m_connectionMap[clientId]->writeData(data);
+	m_sentBytes->increment(data.size());
 }
 
 
-void MultiplexServer::sendPacketToServers(const QByteArray & packet)
+void MultiplexServer::sendPacketToServers(const QVariantMap& values)
 {
+	if (nullptr == m_multiplexSocket)
+		return;
+
+	QByteArray packet = EncodeDiscoveryPacket(values, m_backendEncoding);
 	m_multiplexSocket->writeDatagram(HOST_UDPPORT, packet);
+	m_sentBytes->increment(packet.size());
 }
 
 
@@ -11,6 +11,7 @@ class MultiplexSocketConnection;
 class QSslSocket;
 class QSslKey;
 class QSslCertificate;
+class MetricCounter;
 
 
 class MultiplexServer : public QObject
@@ -26,7 +27,7 @@ public slots:
 	void start();	
 	void stop();
 	void sendDataToClient(const QString& clientId, const QByteArray& data) const;
-	void sendPacketToServers(const QByteArray& packet);
+	void sendPacketToServers(const QVariantMap& values);
 
 signals:
 	void newClient(const QString& clientId);
@@ -40,6 +41,7 @@ private slots:
 private:
 
 	int m_retryCount = 0;
+	int m_backendEncoding = 0;
 	QString m_serverAddress;
 	QSslSocket* m_socket = nullptr;
 	QSslKey* m_key = nullptr;
@@ -49,4 +51,6 @@ private:
 	StatusInterface* m_statusInterface = nullptr;
 	GlobalManager* m_globalManager = nullptr;
 	Settings* m_settings = nullptr;
+	MetricCounter* m_receivedBytes = nullptr;
+	MetricCounter* m_sentBytes = nullptr;
 };
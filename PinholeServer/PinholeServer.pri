@@ -32,7 +32,6 @@ HEADERS += ../common/PinholeCommon.h \
     ./CommandInterface.h \
     ./qnamedpipe.h \
     ./NovaServer.h \
-    ./smtp.h \
     ./PasswordReset.h \
     ./ServiceHandler.h \
     ./ResourceMonitor.h \
@@ -45,7 +44,22 @@ HEADERS += ../common/PinholeCommon.h \
     ./Logger.h \
     ./EncryptedTcpServer.h \
     ./Application.h \
-    ./HeartbeatThread.h
+    ./HeartbeatThread.h \
+    ../common/DiscoveryPacket.h \
+    ./Metrics.h \
+    ./LaunchScheduler.h \
+    ./CronExpression.h \
+    ./MonotonicTime.h \
+    ./TimingWheel.h \
+    ./AlertDispatcher.h \
+    ./SmtpSession.h \
+    ./AlertStore.h \
+    ./ConsoleCapture.h \
+    ./LogSearch.h \
+    ./SysInfo.h \
+    ./AppCgroup.h \
+    ./ProcessScheduling.h \
+    ./ScheduleQueue.h
 SOURCES += ../common/DummyWindow.cpp \
     ../common/HostClient.cpp \
     ../common/MultiplexSocket.cpp \
@@ -80,8 +94,21 @@ SOURCES += ../common/DummyWindow.cpp \
     ./ServiceHandler.cpp \
     ./Settings.cpp \
     ./Sigar.cpp \
-    ./smtp.cpp \
     ./StatusInterface.cpp \
     ./UserProcess.cpp \
     ./WinUtil.cpp \
-    ./HeartbeatThread.cpp
+    ./HeartbeatThread.cpp \
+    ../common/DiscoveryPacket.cpp \
+    ./Metrics.cpp \
+    ./LaunchScheduler.cpp \
+    ./CronExpression.cpp \
+    ./TimingWheel.cpp \
+    ./AlertDispatcher.cpp \
+    ./SmtpSession.cpp \
+    ./AlertStore.cpp \
+    ./ConsoleCapture.cpp \
+    ./LogSearch.cpp \
+    ./SysInfo.cpp \
+    ./AppCgroup.cpp \
+    ./ProcessScheduling.cpp \
+    ./ScheduleQueue.cpp
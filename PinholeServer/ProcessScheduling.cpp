@@ -0,0 +1,246 @@
+#include "ProcessScheduling.h"
+#include "../common/PinholeCommon.h"
+
+#include <QStringList>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+
+// glibc has no ioprio_set wrapper or constants
+#define IOPRIO_WHO_PROCESS		1
+#define IOPRIO_CLASS_RT			1
+#define IOPRIO_CLASS_BE			2
+#define IOPRIO_CLASS_IDLE		3
+#define IOPRIO_CLASS_SHIFT		13
+
+#define MAX_AFFINITYCPUS		CPU_SETSIZE
+#else
+#define MAX_AFFINITYCPUS		1024
+#endif
+
+
+// Checking for root stands in for checking CAP_SYS_NICE and CAP_SYS_ADMIN,
+// the service runs as root and a user run server normally has neither
+static bool privileged()
+{
+#if defined(Q_OS_UNIX)
+	return 0 == geteuid();
+#else
+	return true;
+#endif
+}
+
+
+// Lists like "0-3,6", empty for every CPU
+bool ProcessScheduling::parseCpuList(const QString& cpuList, QList<int>* cpus)
+{
+	cpus->clear();
+	for (const auto& part : cpuList.split(',', QString::SkipEmptyParts))
+	{
+		QStringList range = part.trimmed().split('-');
+		bool firstOk = false;
+		int first = range[0].trimmed().toInt(&firstOk);
+		bool lastOk = firstOk;
+		int last = first;
+		if (2 == range.size())
+			last = range[1].trimmed().toInt(&lastOk);
+
+		if (!firstOk || !lastOk || range.size() > 2 || first < 0 || last < first || last >= MAX_AFFINITYCPUS)
+			return false;
+
+		for (int cpu = first; cpu <= last; cpu++)
+		{
+			if (!cpus->contains(cpu))
+				cpus->append(cpu);
+		}
+	}
+	return true;
+}
+
+
+// The app can only be given CPUs the server may run on itself
+bool ProcessScheduling::permittedCpus(const QList<int>& cpus)
+{
+#if defined(Q_OS_LINUX)
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (0 != sched_getaffinity(0, sizeof(allowed), &allowed))
+		return cpus.isEmpty();
+
+	for (auto cpu : cpus)
+	{
+		if (!CPU_ISSET(cpu, &allowed))
+			return false;
+	}
+#else
+	Q_UNUSED(cpus);
+#endif
+	return true;
+}
+
+
+// Anyone may lower their priority, raising it needs privileges or RLIMIT_NICE
+bool ProcessScheduling::permittedNice(int nice)
+{
+	if (nice >= 0 || privileged())
+		return true;
+
+#if defined(Q_OS_LINUX)
+	struct rlimit limit;
+	if (0 == getrlimit(RLIMIT_NICE, &limit))
+	{
+		// The limit is 20 - nice, so 40 allows -20
+		return RLIM_INFINITY == limit.rlim_cur || 20 - static_cast<int>(limit.rlim_cur) <= nice;
+	}
+#endif
+	return false;
+}
+
+
+// The realtime policies need privileges or RLIMIT_RTPRIO, the others can always be set
+bool ProcessScheduling::permittedPolicy(const QString& policy, int priority)
+{
+	if ((SCHEDPOLICY_FIFO != policy && SCHEDPOLICY_RR != policy) || privileged())
+		return true;
+
+#if defined(Q_OS_LINUX)
+	struct rlimit limit;
+	if (0 == getrlimit(RLIMIT_RTPRIO, &limit))
+	{
+		return RLIM_INFINITY == limit.rlim_cur || static_cast<int>(limit.rlim_cur) >= qMax(priority, 1);
+	}
+#else
+	Q_UNUSED(priority);
+#endif
+	return false;
+}
+
+
+bool ProcessScheduling::permittedIoClass(const QString& ioClass)
+{
+	return IOCLASS_REALTIME != ioClass || privileged();
+}
+
+
+// Runs in the server before the process starts, values have been checked by the app's setters
+void ProcessScheduling::set(const QString& cpuList, int nice, const QString& policy, int priority, const QString& ioClass, int ioPriority)
+{
+	m_nice = nice;
+
+#if defined(Q_OS_LINUX)
+	QList<int> cpus;
+	m_setAffinity = parseCpuList(cpuList, &cpus) && !cpus.isEmpty();
+	CPU_ZERO(&m_cpus);
+	for (auto cpu : cpus)
+	{
+		CPU_SET(cpu, &m_cpus);
+	}
+
+	m_priority = 0;
+	if (SCHEDPOLICY_BATCH == policy)
+		m_policy = SCHED_BATCH;
+	else if (SCHEDPOLICY_IDLE == policy)
+		m_policy = SCHED_IDLE;
+	else if (SCHEDPOLICY_FIFO == policy || SCHEDPOLICY_RR == policy)
+	{
+		m_policy = SCHEDPOLICY_FIFO == policy ? SCHED_FIFO : SCHED_RR;
+		m_priority = qBound(1, priority, MAX_SCHEDPRIORITY);
+	}
+	else
+		m_policy = SCHED_OTHER;
+
+	if (IOCLASS_REALTIME == ioClass)
+		m_ioPriority = (IOPRIO_CLASS_RT << IOPRIO_CLASS_SHIFT) | ioPriority;
+	else if (IOCLASS_BESTEFFORT == ioClass)
+		m_ioPriority = (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | ioPriority;
+	else if (IOCLASS_IDLE == ioClass)
+		m_ioPriority = IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT;
+	else
+		m_ioPriority = 0;
+#else
+	Q_UNUSED(cpuList);
+	Q_UNUSED(policy);
+	Q_UNUSED(priority);
+	Q_UNUSED(ioClass);
+	Q_UNUSED(ioPriority);
+#endif
+}
+
+
+// Runs in the child between fork and exec, while it still has the server's privileges.
+// Values left at their defaults are not set so the child inherits the server's.
+void ProcessScheduling::applyInChild() const
+{
+#if defined(Q_OS_LINUX)
+	if (m_setAffinity)
+		sched_setaffinity(0, sizeof(m_cpus), &m_cpus);
+
+	if (SCHED_OTHER != m_policy)
+	{
+		struct sched_param param;
+		param.sched_priority = m_priority;
+		sched_setscheduler(0, m_policy, &param);
+	}
+
+	if (0 != m_ioPriority)
+		syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, m_ioPriority);
+#endif
+#if defined(Q_OS_UNIX)
+	if (0 != m_nice)
+		setpriority(PRIO_PROCESS, 0, m_nice);
+#endif
+}
+
+
+// Runs in the server once the process has started, returns the settings of the
+// ones set in the child that the process doesn't have. Values that can't be read,
+// because the process already exited, are not reported.
+QStringList ProcessScheduling::notApplied(qint64 pid) const
+{
+	QStringList failed;
+#if defined(Q_OS_LINUX)
+	if (m_setAffinity)
+	{
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		if (0 == sched_getaffinity(static_cast<pid_t>(pid), sizeof(cpus), &cpus) && !CPU_EQUAL(&cpus, &m_cpus))
+			failed << PROP_APP_CPUAFFINITY;
+	}
+
+	if (SCHED_OTHER != m_policy)
+	{
+		int policy = sched_getscheduler(static_cast<pid_t>(pid));
+		struct sched_param param;
+		if (policy >= 0 && (m_policy != (policy & ~SCHED_RESET_ON_FORK) ||
+			(0 == sched_getparam(static_cast<pid_t>(pid), &param) && m_priority != param.sched_priority)))
+		{
+			failed << PROP_APP_SCHEDPOLICY;
+		}
+	}
+
+	if (0 != m_ioPriority)
+	{
+		long ioPriority = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, static_cast<pid_t>(pid));
+		if (ioPriority >= 0 && m_ioPriority != ioPriority)
+			failed << PROP_APP_IOCLASS;
+	}
+#endif
+#if defined(Q_OS_UNIX)
+	if (0 != m_nice)
+	{
+		// -1 is a valid nice value, errno tells it apart from a failure
+		errno = 0;
+		int nice = getpriority(PRIO_PROCESS, static_cast<id_t>(pid));
+		if (0 == errno && m_nice != nice)
+			failed << PROP_APP_NICE;
+	}
+#else
+	Q_UNUSED(pid);
+#endif
+	return failed;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+/* ProcessScheduling.h - CPU affinity, nice, scheduling policy and IO priority of an app's process */
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+#if defined(Q_OS_LINUX)
+#include <sched.h>
+#endif
+
+// Everything the child needs is worked out in the server before the fork, the
+// child only makes system calls. The checks say whether the server is allowed
+// to set a value, so a setting that would fail in the child is refused when it
+// is made instead of silently not being applied at every start. The child
+// can't report failures, so the server reads the values back once it started.
+// Affinity, policy and IO priority are Linux only, nice applies on every Unix.
+class ProcessScheduling
+{
+public:
+	static bool parseCpuList(const QString& cpuList, QList<int>* cpus);
+	static bool permittedCpus(const QList<int>& cpus);
+	static bool permittedNice(int nice);
+	static bool permittedPolicy(const QString& policy, int priority);
+	static bool permittedIoClass(const QString& ioClass);
+
+	void set(const QString& cpuList, int nice, const QString& policy, int priority, const QString& ioClass, int ioPriority);
+	void applyInChild() const;
+	QStringList notApplied(qint64 pid) const;
+
+private:
+	int m_nice = 0;
+#if defined(Q_OS_LINUX)
+	bool m_setAffinity = false;
+	cpu_set_t m_cpus;
+	int m_policy = SCHED_OTHER;
+	int m_priority = 0;
+	int m_ioPriority = 0;			// Class and level as the kernel takes them, 0 to leave alone
+#endif
+};
@@ -109,6 +109,31 @@ bool ScheduleEvent::setOffset(int val)
 }
 
 
+QString ScheduleEvent::getCron() const
+{
+	return m_cron;
+}
+
+
+bool ScheduleEvent::setCron(const QString& str)
+{
+	if (m_cron != str)
+	{
+		CronExpression cronExpression(str);
+		if (!str.isEmpty() && !cronExpression.isValid())
+		{
+			Logger(LOG_EXTRA) << tr("Invalid scheduled event cron value '%1'").arg(str);
+			emit valueChanged(PROP_SCHED_CRON, QVariant(m_cron));
+			return false;
+		}
+		m_cron = str;
+		m_cronExpression = cronExpression;
+		emit valueChanged(PROP_SCHED_CRON, QVariant(m_cron));
+	}
+	return true;
+}
+
+
 QString ScheduleEvent::getLastTriggeredString() const
 {
 	return m_lastTriggered.toString();
@@ -129,6 +154,62 @@ bool ScheduleEvent::setLastTriggered(const QDateTime& time)
 }
 
 
+// Returns the first time after the given time this event should trigger, or an
+// invalid QDateTime if it never will
+QDateTime ScheduleEvent::nextTrigger(const QDateTime& after) const
+{
+	if (m_offset < 0 && SCHED_FREQ_CRON != m_frequency)
+		return QDateTime();
+
+	QDateTime local = after.toLocalTime();
+
+	if (SCHED_FREQ_ONCE == m_frequency)
+	{
+		QDateTime eventTime = QDateTime::fromSecsSinceEpoch(static_cast<qint64>(m_offset) * 60);
+		return eventTime > after ? eventTime : QDateTime();
+	}
+	else if (SCHED_FREQ_HOURLY == m_frequency)
+	{
+		// Step in real hours so the repeated hour when daylight saving ends still triggers
+		QDateTime eventTime = CronExpression::localDateTime(local.date(), QTime(local.time().hour(), 0))
+			.addSecs((m_offset % 60) * 60);
+		while (eventTime <= after)
+		{
+			eventTime = eventTime.addSecs(60 * 60);
+		}
+		return eventTime;
+	}
+	else if (SCHED_FREQ_DAILY == m_frequency)
+	{
+		QTime time((m_offset % 1440) / 60, m_offset % 60);
+		for (int days = 0; days <= 2; days++)
+		{
+			QDateTime eventTime = CronExpression::localDateTime(local.date().addDays(days), time);
+			if (eventTime > after)
+				return eventTime;
+		}
+	}
+	else if (SCHED_FREQ_WEEKLY == m_frequency)
+	{
+		QTime time((m_offset % 1440) / 60, m_offset % 60);
+		int dayOfWeek = (m_offset % 10080) / 1440;
+		QDate date = local.date().addDays((dayOfWeek - (local.date().dayOfWeek() - 1) + 7) % 7);
+		for (int weeks = 0; weeks <= 2; weeks++)
+		{
+			QDateTime eventTime = CronExpression::localDateTime(date.addDays(weeks * 7), time);
+			if (eventTime > after)
+				return eventTime;
+		}
+	}
+	else if (SCHED_FREQ_CRON == m_frequency)
+	{
+		return m_cronExpression.next(after);
+	}
+
+	return QDateTime();
+}
+
+
 void ScheduleEvent::trigger()
 {
 	Logger() << tr("Event %1: Triggered; type: %2; arguments: %3")
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "CronExpression.h"
 #include "../common/PinholeCommon.h"
 
 #include <QObject>
@@ -24,10 +25,13 @@ public:
 	bool setArguments(const QString& str);
 	int getOffset() const;
 	bool setOffset(int val);
+	QString getCron() const;
+	bool setCron(const QString& str);
 	QString getLastTriggeredString() const;
 	QDateTime getLastTriggered() const;
 	bool setLastTriggered(const QDateTime& time);
 
+	QDateTime nextTrigger(const QDateTime& after) const;
 	void trigger();
 
 signals:
@@ -56,7 +60,8 @@ private:
 		SCHED_FREQ_WEEKLY,
 		SCHED_FREQ_DAILY,
 		SCHED_FREQ_HOURLY,
-		SCHED_FREQ_ONCE
+		SCHED_FREQ_ONCE,
+		SCHED_FREQ_CRON
 	};
 
 	QString m_name = "";
@@ -65,9 +70,12 @@ private:
 	QString m_arguments = "";
 	int m_offset = 0;
 	// Offset is the number of minutes from origin:
-	// Weekly: Midnight Sunday
+	// Weekly: Midnight Monday
 	// Daily: Midnight
 	// Hourly: Top of the hour
+	// Once: The epoch
+	QString m_cron = "";
+	CronExpression m_cronExpression;
 	QDateTime m_lastTriggered;
 
 };
@@ -16,79 +16,38 @@
 
 
 ScheduleManager::ScheduleManager(Settings* settings, AppManager* appManager, 
-	GroupManager* groupManager, GlobalManager* globalManager, QObject *parent)
-	: QObject(parent), m_settings(settings), m_appManager(appManager), 
+	GroupManager* groupManager, GlobalManager* globalManager, QObject *parent,
+	std::function<QDateTime()> wallClock)
+	: QObject(parent), m_queue(m_scheduleList, wallClock), m_settings(settings), m_appManager(appManager), 
 	m_groupManager(groupManager), m_globalManager(globalManager)
 {
 
 	readScheduleSettings();
 
-	// Setup the timer that will execute the schedule events
-	m_triggerTimer.setInterval(1000 * 60); // Once a minute
-	m_triggerTimer.setSingleShot(false);
-	connect(&m_triggerTimer, &QTimer::timeout,
-		this, &ScheduleManager::triggerTimerCallback);
-	m_triggerTimer.start();
-}
-
-
-ScheduleManager::~ScheduleManager()
-{
-}
-
-
-void ScheduleManager::triggerTimerCallback()
-{
-	QDateTime now = QDateTime::currentDateTime();
-
-	for (const auto& event : m_scheduleList)
+	// Only events that change need writing to settings, events are rescheduled
+	// when anything that decides when they trigger changes
+	connect(this, &ScheduleManager::valueChanged,
+		this, [this](const QString&, const QString& eventName, const QString& propName, const QVariant&)
 	{
-		QString frequency = event->getFrequency();
-		int offset = event->getOffset();
-		bool triggerEvent = false;
-		if (SCHED_FREQ_ONCE == frequency)
-		{
-			QDateTime eventTime;
-			eventTime.setSecsSinceEpoch(static_cast<qint64>(offset) * 60);
-
-			if (eventTime.date() == now.date() &&
-				eventTime.time().hour() == now.time().hour() &&
-				eventTime.time().minute() == now.time().minute())
-			{
-				triggerEvent = true;
-			}
-		}
-		else if (SCHED_FREQ_HOURLY == frequency)
-		{
-			if (now.time().minute() == offset % 60)
-			{
-				triggerEvent = true;
-			}
-		}
-		else if (SCHED_FREQ_DAILY == frequency)
+		if (eventName.isEmpty())
 		{
-			if (now.time().hour() == (offset % 1440) / 60 &&
-				now.time().minute() == offset % 60)
-			{
-				triggerEvent = true;
-			}
+			m_eventListDirty = true;
+			m_queue.scheduleAllEvents();
 		}
-		else if (SCHED_FREQ_WEEKLY == frequency)
+		else
 		{
-			if (now.date().dayOfWeek() - 1 == (offset % 10080) / 1440 &&
-				now.time().hour() == (offset % 1440) / 60 &&
-				now.time().minute() == offset % 60)
-			{
-				triggerEvent = true;
-			}
+			m_dirtyEvents.insert(eventName);
+			if (PROP_SCHED_FREQUENCY == propName || PROP_SCHED_OFFSET == propName || PROP_SCHED_CRON == propName)
+				m_queue.scheduleEvent(eventName);
 		}
+	});
 
-		if (triggerEvent)
-		{
-			event->trigger();
-		}
-	}
+	m_queue.scheduleAllEvents();
+}
 
+
+ScheduleManager::~ScheduleManager()
+{
 }
 
 
@@ -100,21 +59,20 @@ QStringList ScheduleManager::getEventNames() const
 
 bool ScheduleManager::readScheduleSettings()
 {
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
-	QStringList eventList = settings->value(SETTINGS_EVENTLIST).toStringList();
+	QStringList eventList = m_settings->value(SETTINGS_EVENTLIST).toStringList();
 	for (const auto& eventName : eventList)
 	{
-		settings->beginGroup(SETTINGS_EVENTPREFIX + eventName);
+		m_settings->beginGroup(SETTINGS_EVENTPREFIX + eventName);
 
 		QSharedPointer<ScheduleEvent> newEvent = QSharedPointer<ScheduleEvent>::create(eventName);
-		newEvent->setType(settings->value(PROP_SCHED_TYPE, SCHED_TYPE_STARTAPPS).toString());
-		newEvent->setFrequency(settings->value(PROP_SCHED_FREQUENCY, SCHED_FREQ_DISABLED).toString());
-		newEvent->setArguments(settings->value(PROP_SCHED_ARGUMENTS, "").toString());
-		newEvent->setOffset(settings->value(PROP_SCHED_OFFSET, 0).toInt());
+		newEvent->setType(m_settings->value(PROP_SCHED_TYPE, SCHED_TYPE_STARTAPPS).toString());
+		newEvent->setFrequency(m_settings->value(PROP_SCHED_FREQUENCY, SCHED_FREQ_DISABLED).toString());
+		newEvent->setArguments(m_settings->value(PROP_SCHED_ARGUMENTS, "").toString());
+		newEvent->setOffset(m_settings->value(PROP_SCHED_OFFSET, 0).toInt());
+		newEvent->setCron(m_settings->value(PROP_SCHED_CRON, "").toString());
 
-		if (settings->contains(PROP_SCHED_LASTTRIGGERED))
-			newEvent->setLastTriggered(QDateTime::fromString(settings->value(PROP_SCHED_LASTTRIGGERED).toString()));
+		if (m_settings->contains(PROP_SCHED_LASTTRIGGERED))
+			newEvent->setLastTriggered(QDateTime::fromString(m_settings->value(PROP_SCHED_LASTTRIGGERED).toString()));
 
 		connect(newEvent.data(), &ScheduleEvent::valueChanged,
 			this, &ScheduleManager::eventValueChanged);
@@ -123,7 +81,7 @@ bool ScheduleManager::readScheduleSettings()
 
 		m_scheduleList[eventName] = newEvent;
 
-		settings->endGroup();
+		m_settings->endGroup();
 	}
 
 	return true;
@@ -136,34 +94,39 @@ bool ScheduleManager::writeScheduleSettings() const
 	//qDebug() << "Writing schedule settings to " << settings->fileName() << settings->isWritable();
 #endif
 
-	QSharedPointer<QSettings> settings = m_settings->getScopedSettings();
-
-	// Delete old entries
-	QStringList eventList = settings->value(SETTINGS_EVENTLIST).toStringList();
+	// Delete entries that no longer exist
+	QStringList eventList = m_settings->value(SETTINGS_EVENTLIST).toStringList();
 	for (const auto& eventName : eventList)
 	{
-		settings->remove(SETTINGS_EVENTPREFIX + eventName);
+		if (!m_scheduleList.contains(eventName))
+			m_settings->remove(SETTINGS_EVENTPREFIX + eventName);
 	}
 
 	for (const auto& event : m_scheduleList)
 	{
 		QString eventName = event->getName();
-		settings->beginGroup(SETTINGS_EVENTPREFIX + eventName);
-		settings->setValue(PROP_SCHED_NAME, eventName);
-		settings->setValue(PROP_SCHED_TYPE, event->getType());
-		settings->setValue(PROP_SCHED_FREQUENCY, event->getFrequency());
-		settings->setValue(PROP_SCHED_ARGUMENTS, event->getArguments());
-		settings->setValue(PROP_SCHED_OFFSET, event->getOffset());
+		if (!m_eventListDirty && !m_dirtyEvents.contains(eventName))
+			continue;
+
+		m_settings->beginGroup(SETTINGS_EVENTPREFIX + eventName);
+		m_settings->setValue(PROP_SCHED_NAME, eventName);
+		m_settings->setValue(PROP_SCHED_TYPE, event->getType());
+		m_settings->setValue(PROP_SCHED_FREQUENCY, event->getFrequency());
+		m_settings->setValue(PROP_SCHED_ARGUMENTS, event->getArguments());
+		m_settings->setValue(PROP_SCHED_OFFSET, event->getOffset());
+		m_settings->setValue(PROP_SCHED_CRON, event->getCron());
 
 		QDateTime time;
 		time = event->getLastTriggered();
 		if (!time.isNull())
-			settings->setValue(PROP_SCHED_LASTTRIGGERED, time.toString());
+			m_settings->setValue(PROP_SCHED_LASTTRIGGERED, time.toString());
 
-		settings->endGroup();
+		m_settings->endGroup();
 	}
 
-	settings->setValue(SETTINGS_EVENTLIST, QStringList(m_scheduleList.keys()));
+	m_settings->setValue(SETTINGS_EVENTLIST, QStringList(m_scheduleList.keys()));
+	m_dirtyEvents.clear();
+	m_eventListDirty = false;
 
 	return true;
 }
@@ -230,6 +193,7 @@ bool ScheduleManager::importSettings(const QJsonObject& root)
 				newEvent->setFrequency(ReadJsonValueWithDefault(jevent, PROP_SCHED_FREQUENCY, newEvent->getFrequency()).toString());
 				newEvent->setArguments(ReadJsonValueWithDefault(jevent, PROP_SCHED_ARGUMENTS, newEvent->getArguments()).toString());
 				newEvent->setOffset(ReadJsonValueWithDefault(jevent, PROP_SCHED_OFFSET, newEvent->getOffset()).toInt());
+				newEvent->setCron(ReadJsonValueWithDefault(jevent, PROP_SCHED_CRON, newEvent->getCron()).toString());
 
 				if (jevent.contains(PROP_SCHED_LASTTRIGGERED))
 					newEvent->setLastTriggered(QDateTime::fromString(jevent[PROP_SCHED_LASTTRIGGERED].toString()));
@@ -269,6 +233,7 @@ QJsonObject ScheduleManager::exportSettings() const
 		jevent[PROP_SCHED_FREQUENCY] = event->getFrequency();
 		jevent[PROP_SCHED_ARGUMENTS] = event->getArguments();
 		jevent[PROP_SCHED_OFFSET] = event->getOffset();
+		jevent[PROP_SCHED_CRON] = event->getCron();
 
 		QDateTime time;
 		time = event->getLastTriggered();
@@ -332,6 +297,7 @@ bool ScheduleManager::renameEvent(const QString& oldName, const QString& newName
 	m_scheduleList.remove(oldName);
 	event->setName(newName);
 	m_scheduleList[newName] = event;
+	m_queue.renameEvent(oldName, newName);
 
 	emit valueChanged(GROUP_SCHEDULE, "", PROP_SCHED_LIST, QVariant(m_scheduleList.keys()));
 	return true;
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "ScheduleEvent.h"
+#include "ScheduleQueue.h"
 
 #include <QObject>
-#include <QTimer>
+#include <QHash>
 #include <QMap>
+#include <QSet>
 
 class Settings;
 class AppManager;
@@ -17,7 +19,8 @@ class ScheduleManager : public QObject
 
 public:
 	ScheduleManager(Settings* settings, AppManager* appManager, GroupManager* groupManager, 
-		GlobalManager* globalManager, QObject *parent = nullptr);
+		GlobalManager* globalManager, QObject *parent = nullptr,
+		std::function<QDateTime()> wallClock = &QDateTime::currentDateTime);
 	~ScheduleManager();
 
 	QStringList getEventNames() const;
@@ -37,7 +40,6 @@ signals:
 	void generateAlert(const QString& text);
 
 public slots:
-	void triggerTimerCallback();
 	void eventValueChanged(const QString&, const QVariant&) const;
 	void eventTriggered();
 	void triggerEventsSlot(const QStringList eventNames) const;
@@ -53,6 +55,7 @@ private:
 		{ PROP_SCHED_FREQUENCY, { &ScheduleEvent::getFrequency, &ScheduleEvent::setFrequency } },
 		{ PROP_SCHED_ARGUMENTS, { &ScheduleEvent::getArguments, &ScheduleEvent::setArguments } },
 		{ PROP_SCHED_LASTTRIGGERED, { &ScheduleEvent::getLastTriggeredString, nullptr } },
+		{ PROP_SCHED_CRON, { &ScheduleEvent::getCron, &ScheduleEvent::setCron } },
 	};
 
 	const std::map<QString, std::pair<std::function<int(ScheduleEvent*)>, std::function<bool(ScheduleEvent*, int)>>> m_eventIntCallMap =
@@ -60,8 +63,10 @@ private:
 		{ PROP_SCHED_OFFSET, { &ScheduleEvent::getOffset, &ScheduleEvent::setOffset } }
 	};
 
-	QTimer m_triggerTimer;
 	QMap<QString, QSharedPointer<ScheduleEvent>> m_scheduleList;
+	ScheduleQueue m_queue;					// When each event in m_scheduleList triggers next
+	mutable QSet<QString> m_dirtyEvents;	// Events changed since settings were last written
+	mutable bool m_eventListDirty = true;	// Events added, removed or renamed since settings were last written
 	Settings * m_settings = nullptr;
 	AppManager * m_appManager = nullptr;
 	GroupManager * m_groupManager = nullptr;
@@ -0,0 +1,143 @@
+#include "ScheduleQueue.h"
+#include "Logger.h"
+#include "Values.h"
+
+
+ScheduleQueue::ScheduleQueue(const EventMap& events, std::function<QDateTime()> wallClock,
+	std::function<MonotonicTime()> monotonicClock, QObject *parent)
+	: QObject(parent), m_events(events), m_wallClock(wallClock), m_monotonicClock(monotonicClock)
+{
+	// The timer is started for the next event due rather than polling
+	m_triggerTimer.setSingleShot(true);
+	m_triggerTimer.setTimerType(Qt::PreciseTimer);
+	connect(&m_triggerTimer, &QTimer::timeout,
+		this, &ScheduleQueue::triggerTimerCallback);
+
+	m_clockOffset = clockOffset(m_wallClock());
+}
+
+
+qint64 ScheduleQueue::clockOffset(const QDateTime& now) const
+{
+	return now.toMSecsSinceEpoch() - m_monotonicClock().toMSecs();
+}
+
+
+void ScheduleQueue::triggerTimerCallback()
+{
+	QDateTime now = m_wallClock();
+
+	// The monotonic clock doesn't follow changes to the system clock
+	qint64 offset = clockOffset(now);
+	qint64 clockChange = offset - m_clockOffset;
+	m_clockOffset = offset;
+	if (clockChange < -INTERVAL_SCHEDULECLOCKCHANGE || clockChange > INTERVAL_SCHEDULECATCHUP)
+	{
+		// Events already triggered aren't triggered again when the clock goes back,
+		// events missed by the clock going a long way forward are skipped
+		Logger(LOG_WARNING) << tr("System clock changed by %1 seconds, rescheduling events")
+			.arg(clockChange / 1000);
+		scheduleAllEvents();
+		return;
+	}
+	else if (clockChange > INTERVAL_SCHEDULECLOCKCHANGE)
+	{
+		Logger(LOG_WARNING) << tr("System clock changed by %1 seconds, triggering missed events")
+			.arg(clockChange / 1000);
+	}
+
+	while (!m_triggerQueue.isEmpty() && m_triggerQueue.firstKey() <= now.toMSecsSinceEpoch())
+	{
+		qint64 triggerTime = m_triggerQueue.firstKey();
+		QString eventName = m_triggerQueue.first();
+		m_triggerQueue.erase(m_triggerQueue.begin());
+		m_nextTrigger.remove(eventName);
+		m_lastTrigger[eventName] = triggerTime;
+
+		// Schedule from now so occurrences missed by a clock change only trigger once
+		scheduleEvent(eventName, now);
+
+		QSharedPointer<ScheduleEvent> event = m_events.value(eventName);
+		if (!event.isNull())
+		{
+			event->trigger();
+		}
+	}
+
+	startTriggerTimer();
+}
+
+
+// Queues an event for the first time it is due from now
+void ScheduleQueue::scheduleEvent(const QString& eventName)
+{
+	scheduleEvent(eventName, m_wallClock());
+	startTriggerTimer();
+}
+
+
+// Queues an event for the first time it is due after the given time
+void ScheduleQueue::scheduleEvent(const QString& eventName, const QDateTime& after)
+{
+	auto queued = m_nextTrigger.find(eventName);
+	if (queued != m_nextTrigger.end())
+	{
+		m_triggerQueue.remove(queued.value(), eventName);
+		m_nextTrigger.erase(queued);
+	}
+
+	if (!m_events.contains(eventName))
+		return;
+
+	// Never trigger the same time twice, even if the clock was set back
+	QDateTime from = after;
+	if (m_lastTrigger.value(eventName, 0) > after.toMSecsSinceEpoch())
+		from = QDateTime::fromMSecsSinceEpoch(m_lastTrigger.value(eventName));
+
+	QDateTime next = m_events[eventName]->nextTrigger(from);
+	if (next.isValid())
+	{
+		m_triggerQueue.insert(next.toMSecsSinceEpoch(), eventName);
+		m_nextTrigger[eventName] = next.toMSecsSinceEpoch();
+	}
+}
+
+
+void ScheduleQueue::scheduleAllEvents()
+{
+	m_triggerQueue.clear();
+	m_nextTrigger.clear();
+
+	for (const auto& eventName : m_lastTrigger.keys())
+	{
+		if (!m_events.contains(eventName))
+			m_lastTrigger.remove(eventName);
+	}
+
+	QDateTime now = m_wallClock();
+	for (const auto& eventName : m_events.keys())
+	{
+		scheduleEvent(eventName, now);
+	}
+
+	startTriggerTimer();
+}
+
+
+void ScheduleQueue::renameEvent(const QString& oldName, const QString& newName)
+{
+	if (m_lastTrigger.contains(oldName))
+		m_lastTrigger[newName] = m_lastTrigger.take(oldName);
+}
+
+
+void ScheduleQueue::startTriggerTimer()
+{
+	// Wake up at least every INTERVAL_SCHEDULECHECK to notice system clock changes
+	qint64 interval = INTERVAL_SCHEDULECHECK;
+	if (!m_triggerQueue.isEmpty())
+	{
+		interval = qBound(Q_INT64_C(0), m_triggerQueue.firstKey() - m_wallClock().toMSecsSinceEpoch(), interval);
+	}
+	m_triggerTimer.start(static_cast<int>(interval));
+}
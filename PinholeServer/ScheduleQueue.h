@@ -0,0 +1,51 @@
+#pragma once
+
+/* ScheduleQueue.h - Triggers scheduled events when they are due on the wall clock */
+
+#include "ScheduleEvent.h"
+#include "MonotonicTime.h"
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QMap>
+#include <QSharedPointer>
+
+#include <functional>
+
+// Keeps the next trigger time of each event and notices the system clock being
+// changed by comparing it with the monotonic clock. Both clocks can be replaced
+// so clock changes can be tested without changing the system clock.
+class ScheduleQueue : public QObject
+{
+	Q_OBJECT
+
+public:
+	typedef QMap<QString, QSharedPointer<ScheduleEvent>> EventMap;
+
+	ScheduleQueue(const EventMap& events,
+		std::function<QDateTime()> wallClock = &QDateTime::currentDateTime,
+		std::function<MonotonicTime()> monotonicClock = &MonotonicTime::now,
+		QObject *parent = nullptr);
+
+	void scheduleEvent(const QString& eventName);
+	void scheduleAllEvents();
+	void renameEvent(const QString& oldName, const QString& newName);
+
+public slots:
+	void triggerTimerCallback();
+
+private:
+	void scheduleEvent(const QString& eventName, const QDateTime& after);
+	void startTriggerTimer();
+	qint64 clockOffset(const QDateTime& now) const;
+
+	const EventMap& m_events;
+	std::function<QDateTime()> m_wallClock;
+	std::function<MonotonicTime()> m_monotonicClock;
+	QTimer m_triggerTimer;					// Single shot, started for the first event in m_triggerQueue
+	QMultiMap<qint64, QString> m_triggerQueue;	// Event names by next trigger time in msecs since the epoch
+	QHash<QString, qint64> m_nextTrigger;	// Each event's entry in m_triggerQueue
+	QHash<QString, qint64> m_lastTrigger;	// Last trigger time each event was triggered for
+	qint64 m_clockOffset = 0;				// Wall clock minus monotonic clock, changes when the system clock is changed
+};
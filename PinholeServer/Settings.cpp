@@ -1,7 +1,21 @@
 #include "Settings.h"
+#include "Logger.h"
+#include "Values.h"
 #include "../common/PinholeCommon.h"
+#include "../common/Utilities.h"
+#include "../qmsgpack/msgpack.h"
 
 #include <QSettings>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QUuid>
+
+#define JOURNAL_SET				1		// Record of a value being set
+#define JOURNAL_REMOVE			2		// Record of a value being removed
+#define JOURNAL_HEADERSIZE		6		// Record payload size and checksum
+#define SNAPSHOT_VERSION		1		// Change if the snapshot layout changes
 
 QSharedPointer<QSettings> Settings::getScopedSettings() const
 {
@@ -16,3 +30,349 @@ QSharedPointer<QSettings> Settings::getScopedSettings() const
 	return settings;
 }
 
+
+// QSettings rewrites its whole file whenever anything in it changes, so the
+// managers write through here instead. Values are compared against a copy of
+// what's stored and only changes are recorded, first appended to a journal in
+// the data directory by flushJournal() then folded into QSettings by
+// compactJournal(). QSettings replaces its file atomically and the journal is
+// only emptied once that succeeds, so whenever the process or power goes the
+// journal can be replayed over the last complete snapshot by openJournal().
+//
+// Every compaction also writes a msgpack snapshot of all the values, which is
+// read at startup in one go instead of having QSettings parse the store, as
+// long as the store hasn't been changed by anything else since.
+
+// Loads the settings and opens the journal, replaying anything left in it. Must
+// be called before the managers read their settings.
+bool Settings::openJournal()
+{
+	m_journal.setFileName(m_dataDir + FILENAME_SETTINGSJOURNAL);
+	bool ok = m_journal.open(QIODevice::ReadWrite);
+	if (!ok)
+	{
+		Logger(LOG_ERROR) << QObject::tr("Unable to open settings journal %1, settings will only be saved periodically")
+			.arg(m_journal.fileName());
+	}
+	else
+	{
+		qint64 validSize = readJournal(m_journal.readAll());
+		if (validSize < m_journal.size())
+		{
+			// The last write was cut short, new records have to follow on from valid ones
+			Logger(LOG_WARNING) << QObject::tr("Discarding incomplete settings journal record");
+			m_journal.resize(validSize);
+		}
+		m_journal.seek(validSize);
+	}
+
+	if (!readSnapshot())
+	{
+		// First run or the store was changed elsewhere, fall back to parsing it
+		QSharedPointer<QSettings> settings = getScopedSettings();
+		if (!settings->isWritable())
+		{
+			Logger(LOG_ERROR) << QObject::tr("WARNING: SETTINGS ARE NOT WRITABLE, NO CHANGES TO CONFIGURATION WILL BE STORED");
+			Logger(LOG_ERROR) << settings->fileName();
+		}
+
+		m_values.clear();
+		for (const auto& key : settings->allKeys())
+		{
+			if (SETTINGS_SNAPSHOTID != key)
+				m_values[key] = settings->value(key);
+		}
+		m_snapshotStale = true;
+	}
+
+	for (const auto& key : m_pendingRemoves)
+	{
+		m_values.remove(key);
+	}
+	for (auto value = m_pendingValues.constBegin(); value != m_pendingValues.constEnd(); ++value)
+	{
+		m_values[value.key()] = value.value();
+	}
+
+	if (!m_pendingValues.isEmpty() || !m_pendingRemoves.isEmpty())
+	{
+		Logger(LOG_ALWAYS) << QObject::tr("Recovering %1 settings changes from journal")
+			.arg(m_pendingValues.size() + m_pendingRemoves.size());
+		compactJournal();
+	}
+
+	return ok;
+}
+
+
+QVariant Settings::value(const QString& key, const QVariant& defaultValue) const
+{
+	return m_values.value(m_group + key, defaultValue);
+}
+
+
+void Settings::setValue(const QString& key, const QVariant& value)
+{
+	QString fullKey = m_group + key;
+	auto stored = m_values.constFind(fullKey);
+	if (stored != m_values.constEnd() && stored.value() == value)
+		return;
+
+	m_values[fullKey] = value;
+	m_pendingRemoves.remove(fullKey);
+	m_pendingValues[fullKey] = value;
+	appendRecord(JOURNAL_SET, fullKey, value);
+}
+
+
+// Removes a value, or a group and every value in it
+void Settings::remove(const QString& key)
+{
+	QString fullKey = m_group + key;
+	auto stored = m_values.lowerBound(fullKey);
+	while (stored != m_values.end() && stored.key().startsWith(fullKey))
+	{
+		if (stored.key().size() == fullKey.size() || '/' == stored.key().at(fullKey.size()))
+		{
+			m_pendingValues.remove(stored.key());
+			m_pendingRemoves.insert(stored.key());
+			appendRecord(JOURNAL_REMOVE, stored.key());
+			stored = m_values.erase(stored);
+		}
+		else
+		{
+			++stored;
+		}
+	}
+}
+
+
+// Appends changes to the journal and waits for them to reach the disk
+bool Settings::flushJournal()
+{
+	if (m_unwritten.isEmpty())
+		return true;
+
+	// Changes stay pending for compaction even if they can't be journaled
+	QByteArray records;
+	records.swap(m_unwritten);
+	if (!m_journal.isOpen())
+		return false;
+
+	qint64 size = m_journal.size();
+	if (m_journal.write(records) != records.size() || !SyncFileToDisk(m_journal))
+	{
+		Logger(LOG_WARNING) << QObject::tr("Failed to write settings journal: %1").arg(m_journal.errorString());
+		m_journal.resize(size);
+		m_journal.seek(size);
+		return false;
+	}
+
+	return true;
+}
+
+
+// Writes every change since the last compaction to QSettings and empties the journal
+bool Settings::compactJournal()
+{
+	// Journal them first in case the snapshot can't be written
+	flushJournal();
+
+	if (m_pendingValues.isEmpty() && m_pendingRemoves.isEmpty() && !m_snapshotStale)
+		return true;
+
+	// The ID ties the snapshot to this version of the store
+	QString snapshotId = QUuid::createUuid().toString();
+	QSharedPointer<QSettings> settings = getScopedSettings();
+	applyPending(settings.data());
+	settings->setValue(SETTINGS_SNAPSHOTID, snapshotId);
+	settings->sync();
+	if (QSettings::NoError != settings->status())
+	{
+		Logger(LOG_ERROR) << QObject::tr("Failed to write settings to %1, changes remain in the journal")
+			.arg(settings->fileName());
+		return false;
+	}
+
+	m_pendingValues.clear();
+	m_pendingRemoves.clear();
+	m_snapshotStale = false;
+	writeSnapshot(settings.data(), snapshotId);
+
+	if (m_journal.isOpen())
+	{
+		// The renames that replaced the store and snapshot have to reach the disk
+		// before the journal that could replay their changes is emptied
+		if (!SyncDirectoryToDisk(QFileInfo(m_journal.fileName()).absolutePath()) ||
+			!SyncDirectoryToDisk(QFileInfo(settings->fileName()).absolutePath()))
+		{
+			Logger(LOG_WARNING) << QObject::tr("Failed to sync settings directories to disk, keeping the settings journal");
+			return true;
+		}
+
+		m_journal.resize(0);
+		m_journal.seek(0);
+		SyncFileToDisk(m_journal);
+	}
+
+	return true;
+}
+
+
+// Returns true if the journal has grown enough that it should be compacted early
+bool Settings::journalFull() const
+{
+	return m_journal.size() + m_unwritten.size() > SIZE_SETTINGSJOURNAL;
+}
+
+
+// Records are the payload size and checksum followed by the type, key and value
+void Settings::appendRecord(quint8 type, const QString& key, const QVariant& value)
+{
+	QByteArray payload;
+	QDataStream payloadStream(&payload, QIODevice::WriteOnly);
+	payloadStream.setVersion(QDataStream::Qt_5_6);
+	payloadStream << type << key;
+	if (JOURNAL_SET == type)
+		payloadStream << value;
+
+	QByteArray header;
+	QDataStream headerStream(&header, QIODevice::WriteOnly);
+	headerStream << static_cast<quint32>(payload.size()) << qChecksum(payload.constData(), payload.size());
+
+	m_unwritten += header;
+	m_unwritten += payload;
+}
+
+
+// Reads journal records into the pending changes, returns the size of the valid records
+qint64 Settings::readJournal(const QByteArray& data)
+{
+	int pos = 0;
+	while (data.size() - pos >= JOURNAL_HEADERSIZE)
+	{
+		quint32 size = 0;
+		quint16 checksum = 0;
+		QDataStream headerStream(data.mid(pos, JOURNAL_HEADERSIZE));
+		headerStream >> size >> checksum;
+		if (static_cast<qint64>(size) > data.size() - pos - JOURNAL_HEADERSIZE)
+			break;
+
+		QByteArray payload = data.mid(pos + JOURNAL_HEADERSIZE, size);
+		if (checksum != qChecksum(payload.constData(), payload.size()))
+			break;
+
+		QDataStream payloadStream(payload);
+		payloadStream.setVersion(QDataStream::Qt_5_6);
+		quint8 type = 0;
+		QString key;
+		QVariant value;
+		payloadStream >> type >> key;
+		if (JOURNAL_SET == type)
+			payloadStream >> value;
+		if (QDataStream::Ok != payloadStream.status())
+			break;
+
+		if (JOURNAL_SET == type)
+		{
+			m_pendingRemoves.remove(key);
+			m_pendingValues[key] = value;
+		}
+		else if (JOURNAL_REMOVE == type)
+		{
+			m_pendingValues.remove(key);
+			m_pendingRemoves.insert(key);
+		}
+		else
+		{
+			break;
+		}
+
+		pos += JOURNAL_HEADERSIZE + payload.size();
+	}
+
+	return pos;
+}
+
+
+void Settings::applyPending(QSettings* settings) const
+{
+	for (const auto& key : m_pendingRemoves)
+	{
+		settings->remove(key);
+	}
+
+	for (auto value = m_pendingValues.constBegin(); value != m_pendingValues.constEnd(); ++value)
+	{
+		settings->setValue(value.key(), value.value());
+	}
+}
+
+
+// Reads the values from the snapshot, returns false if there isn't one or the
+// settings store has changed since it was written
+bool Settings::readSnapshot()
+{
+	QFile file(m_dataDir + FILENAME_SETTINGSSNAPSHOT);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QVariantList snapshot = MsgPack::unpack(file.readAll()).toList();
+	if (snapshot.size() < 7 || SNAPSHOT_VERSION != snapshot[0].toInt())
+	{
+		Logger(LOG_WARNING) << QObject::tr("Ignoring unreadable settings snapshot %1").arg(file.fileName());
+		return false;
+	}
+
+	// Service and user settings are stored separately
+	if (snapshot[6].toBool() != m_runningAsService)
+		return false;
+
+	QString storeFile = snapshot[1].toString();
+	if (!storeFile.isEmpty())
+	{
+		// Stored in a file, which is unchanged if it's exactly as it was after the snapshot
+		QFileInfo info(storeFile);
+		if (!info.exists() || info.size() != snapshot[3].toLongLong() ||
+			info.lastModified().toMSecsSinceEpoch() != snapshot[2].toLongLong())
+			return false;
+
+		if (!info.isWritable())
+		{
+			Logger(LOG_ERROR) << QObject::tr("WARNING: SETTINGS ARE NOT WRITABLE, NO CHANGES TO CONFIGURATION WILL BE STORED");
+			Logger(LOG_ERROR) << storeFile;
+		}
+	}
+	else if (getScopedSettings()->value(SETTINGS_SNAPSHOTID).toString() != snapshot[4].toString())
+	{
+		// Stored in the registry, where reading one value is cheap
+		return false;
+	}
+
+	m_values = snapshot[5].toMap();
+	return true;
+}
+
+
+// Writes the values as a snapshot of the settings store just written
+void Settings::writeSnapshot(QSettings* settings, const QString& snapshotId) const
+{
+	QVariantList snapshot;
+	snapshot << SNAPSHOT_VERSION;
+
+	QFileInfo info(settings->fileName());
+	if (info.exists())
+		snapshot << info.absoluteFilePath() << info.lastModified().toMSecsSinceEpoch() << info.size();
+	else
+		snapshot << QString() << 0 << 0;
+
+	snapshot << snapshotId << QVariant(m_values) << m_runningAsService;
+
+	QSaveFile file(m_dataDir + FILENAME_SETTINGSSNAPSHOT);
+	if (!file.open(QIODevice::WriteOnly) || file.write(MsgPack::pack(snapshot)) < 0 || !file.commit())
+	{
+		Logger(LOG_WARNING) << QObject::tr("Failed to write settings snapshot %1: %2")
+			.arg(file.fileName())
+			.arg(file.errorString());
+	}
+}
@@ -2,6 +2,10 @@
 
 #include <QElapsedTimer>
 #include <QSharedPointer>
+#include <QFile>
+#include <QMap>
+#include <QSet>
+#include <QVariant>
 
 class QSettings;
 
@@ -28,12 +32,37 @@ public:
 	qint64 idleTime() const { return m_idleTimer.elapsed(); }
 	void resetIdle() { m_idleTimer.start(); }
 
+	// Journaled reads and writes of the settings store, see Settings.cpp
+	bool openJournal();
+	void beginGroup(const QString& prefix) { m_group = prefix + "/"; }
+	void endGroup() { m_group.clear(); }
+	bool contains(const QString& key) const { return m_values.contains(m_group + key); }
+	QVariant value(const QString& key, const QVariant& defaultValue = QVariant()) const;
+	void setValue(const QString& key, const QVariant& value);
+	void remove(const QString& key);
+	bool flushJournal();
+	bool compactJournal();
+	bool journalFull() const;
+
 private:
+	void appendRecord(quint8 type, const QString& key, const QVariant& value = QVariant());
+	qint64 readJournal(const QByteArray& data);
+	void applyPending(QSettings* settings) const;
+	bool readSnapshot();
+	void writeSnapshot(QSettings* settings, const QString& snapshotId) const;
+
 	QElapsedTimer m_upTimer;
 	QElapsedTimer m_idleTimer;
 	QString m_serverId;
 	QString m_dataDir;
 	bool m_runningAsService = false;
 	bool m_noGui = false;
-};
 
+	QFile m_journal;
+	QString m_group;						// Prefix added to keys between beginGroup() and endGroup()
+	QMap<QString, QVariant> m_values;		// Everything stored, as it will be once the journal is compacted
+	QMap<QString, QVariant> m_pendingValues;	// Values set since the last compaction
+	QSet<QString> m_pendingRemoves;			// Keys removed since the last compaction
+	QByteArray m_unwritten;					// Journal records not yet appended to the file
+	bool m_snapshotStale = false;			// The snapshot doesn't match the settings store
+};
@@ -0,0 +1,601 @@
+#include "SmtpSession.h"
+#include "Logger.h"
+#include "Values.h"
+
+#include <QDateTime>
+#include <QMessageAuthenticationCode>
+#include <QSslSocket>
+
+
+SmtpSession::SmtpSession(const AlertSmtpConfig& config, QObject *parent)
+	: QObject(parent), m_config(config)
+{
+	m_socket = new QSslSocket(this);
+	connect(m_socket, &QSslSocket::encrypted,
+		this, &SmtpSession::socketEncrypted);
+	connect(m_socket, &QSslSocket::readyRead,
+		this, &SmtpSession::socketReadyRead);
+	connect(m_socket, (void (QSslSocket::*)(QAbstractSocket::SocketError))&QSslSocket::error,
+		this, &SmtpSession::socketError);
+	connect(m_socket, &QSslSocket::disconnected,
+		this, &SmtpSession::socketDisconnected);
+
+	m_replyTimer.setSingleShot(true);
+	m_replyTimer.setInterval(INTERVAL_SMTPTIMEOUT);
+	connect(&m_replyTimer, &QTimer::timeout,
+		this, &SmtpSession::replyTimeout);
+
+	m_idleTimer.setSingleShot(true);
+	m_idleTimer.setInterval(m_config.idle * 1000);
+	connect(&m_idleTimer, &QTimer::timeout,
+		this, &SmtpSession::idleTimeout);
+}
+
+
+SmtpSession::~SmtpSession()
+{
+}
+
+
+void SmtpSession::sendMail(quint64 id, const QStringList& recipients, const QString& subject, const QString& body)
+{
+	Message message;
+	message.id = id;
+	message.recipients = recipients;
+	message.subject = subject;
+	message.body = body;
+	m_queue.append(message);
+
+	if (State::Disconnected == m_state)
+	{
+		connectToServer();
+	}
+	else if (State::Ready == m_state && !m_transaction.active && m_expected.isEmpty())
+	{
+		m_idleTimer.stop();
+		nextTransaction();
+	}
+}
+
+
+// Sends the queued messages, then logs out and deletes the session
+void SmtpSession::closeWhenIdle()
+{
+	m_closing = true;
+
+	if (State::Disconnected == m_state)
+		deleteLater();
+	else if (State::Ready == m_state && !m_transaction.active && m_expected.isEmpty())
+		quit();
+}
+
+
+void SmtpSession::connectToServer()
+{
+	Logger(LOG_EXTRA) << tr("Connecting to SMTP server %1:%2")
+		.arg(m_config.server)
+		.arg(m_config.port);
+
+	m_state = State::Connecting;
+	m_expected.clear();
+	m_replyLines.clear();
+	m_pipelining = false;
+	m_startTls = false;
+	m_authMethods.clear();
+
+	if (m_config.ssl)
+		m_socket->connectToHostEncrypted(m_config.server, m_config.port);
+	else
+		m_socket->connectToHost(m_config.server, m_config.port);
+
+	m_expected.append(Command::Greeting);
+	m_replyTimer.start();
+}
+
+
+void SmtpSession::write(const QByteArray& line, Command command)
+{
+	m_socket->write(line + "\r\n");
+	m_expected.append(command);
+	if (!m_replyTimer.isActive())
+		m_replyTimer.start();
+}
+
+
+void SmtpSession::socketEncrypted()
+{
+	// The server forgets everything from before STARTTLS
+	if (m_startTls)
+	{
+		m_startTls = false;
+		write("EHLO localhost", Command::Ehlo);
+	}
+}
+
+
+void SmtpSession::socketReadyRead()
+{
+	while (m_socket->canReadLine())
+	{
+		QByteArray line = m_socket->readLine();
+		while (line.endsWith('\n') || line.endsWith('\r'))
+			line.chop(1);
+
+		// Continuation lines have a dash after the code
+		m_replyLines.append(QString::fromUtf8(line.mid(4)));
+		if (line.size() > 3 && '-' == line[3])
+			continue;
+
+		int code = line.left(3).toInt();
+		QStringList lines = m_replyLines;
+		m_replyLines.clear();
+
+		if (421 == code)
+		{
+			connectionFailed(tr("Server closing connection: %1").arg(lines.join(" ")));
+			return;
+		}
+		if (m_expected.isEmpty())
+		{
+			Logger(LOG_WARNING) << tr("Unexpected SMTP reply %1 %2").arg(code).arg(lines.join(" "));
+			continue;
+		}
+
+		Command command = m_expected.takeFirst();
+		if (m_expected.isEmpty())
+			m_replyTimer.stop();
+		else
+			m_replyTimer.start();
+
+		handleReply(command, code, lines);
+		if (State::Disconnected == m_state)
+			return;
+	}
+}
+
+
+void SmtpSession::handleReply(Command command, int code, const QStringList& lines)
+{
+	switch (command)
+	{
+	case Command::Greeting:
+		if (220 != code)
+			connectionFailed(tr("Failed to connect (response %1)").arg(code));
+		else
+			write("EHLO localhost", Command::Ehlo);
+		break;
+
+	case Command::Ehlo:
+		{
+			if (250 != code)
+			{
+				connectionFailed(tr("EHLO rejected (response %1)").arg(code));
+				break;
+			}
+
+			// The first line is the greeting, the rest are the supported extensions
+			bool canStartTls = false;
+			m_pipelining = false;
+			m_authMethods.clear();
+			for (const auto& extension : lines.mid(1))
+			{
+				QString keyword = extension.section(' ', 0, 0).toUpper();
+				if ("PIPELINING" == keyword)
+					m_pipelining = true;
+				else if ("STARTTLS" == keyword)
+					canStartTls = true;
+				else if ("AUTH" == keyword)
+					m_authMethods = extension.toUpper().split(' ', QString::SkipEmptyParts).mid(1);
+			}
+
+			// Going on in cleartext would send the login and alerts unencrypted
+			if (m_config.tls && !m_socket->isEncrypted() && !canStartTls)
+				connectionFailed(tr("Server does not support STARTTLS"));
+			else if (m_config.tls && !m_socket->isEncrypted())
+				write("STARTTLS", Command::StartTls);
+			else
+				authenticate();
+		}
+		break;
+
+	case Command::StartTls:
+		if (220 != code)
+		{
+			connectionFailed(tr("STARTTLS rejected (response %1)").arg(code));
+		}
+		else
+		{
+			// EHLO is sent again once the connection is encrypted
+			m_startTls = true;
+			m_socket->startClientEncryption();
+		}
+		break;
+
+	case Command::AuthCramMd5:
+		if (334 != code)
+		{
+			connectionFailed(tr("Authentication failed (response %1)").arg(code));
+		}
+		else
+		{
+			QByteArray challenge = QByteArray::fromBase64(lines.value(0).toLatin1());
+			QByteArray digest = QMessageAuthenticationCode::hash(challenge, m_config.pass.toUtf8(), QCryptographicHash::Md5).toHex();
+			write((m_config.user.toUtf8() + " " + digest).toBase64(), Command::AuthResult);
+		}
+		break;
+
+	case Command::AuthLogin:
+		if (334 != code)
+			connectionFailed(tr("Authentication failed (response %1)").arg(code));
+		else
+			write(m_config.user.toUtf8().toBase64(), Command::AuthUser);
+		break;
+
+	case Command::AuthUser:
+		if (334 != code)
+			connectionFailed(tr("Authentication failed (response %1)").arg(code));
+		else
+			write(m_config.pass.toUtf8().toBase64(), Command::AuthResult);
+		break;
+
+	case Command::AuthResult:
+		if (235 != code)
+			connectionFailed(tr("Authentication failed (response %1)").arg(code));
+		else
+			ready();
+		break;
+
+	case Command::Mail:
+		if (250 != code)
+		{
+			// Pipelined RCPT and DATA replies still follow and fail the transaction
+			if (!m_pipelining)
+				finishTransaction(false, tr("Sender rejected (response %1 %2)").arg(code).arg(lines.join(" ")));
+		}
+		else if (!m_pipelining)
+		{
+			sendRcptOrData();
+		}
+		break;
+
+	case Command::Rcpt:
+		{
+			QString recipient = m_transaction.recipients.value(m_transaction.nextRcpt++);
+			if (250 == code || 251 == code)
+			{
+				m_transaction.accepted.insert(recipient);
+			}
+			else
+			{
+				Logger(LOG_ERROR) << tr("SMTP server rejected alert email recipient '%1' (response %2 %3)")
+					.arg(recipient)
+					.arg(code)
+					.arg(lines.join(" "));
+			}
+			if (!m_pipelining)
+				sendRcptOrData();
+		}
+		break;
+
+	case Command::Data:
+		if (354 != code)
+		{
+			finishTransaction(false, tr("DATA rejected (response %1 %2)").arg(code).arg(lines.join(" ")));
+		}
+		else if (m_transaction.accepted.isEmpty())
+		{
+			// Pipelined DATA can be accepted with no recipients, end it empty
+			write(".", Command::Body);
+		}
+		else
+		{
+			m_socket->write(messageData());
+			write(".", Command::Body);
+		}
+		break;
+
+	case Command::Body:
+		if (250 != code)
+			finishTransaction(false, tr("Message rejected (response %1 %2)").arg(code).arg(lines.join(" ")));
+		else
+			finishTransaction(!m_transaction.accepted.isEmpty(), tr("All recipients rejected"));
+		break;
+
+	case Command::Rset:
+		if (250 != code)
+			connectionFailed(tr("RSET rejected (response %1)").arg(code));
+		else
+			nextTransaction();
+		break;
+
+	case Command::Quit:
+		m_socket->disconnectFromHost();
+		break;
+	}
+}
+
+
+void SmtpSession::authenticate()
+{
+	if (m_config.user.isEmpty())
+	{
+		ready();
+	}
+	else if (m_authMethods.isEmpty())
+	{
+		// A login is configured, sending without it could relay through the wrong server
+		connectionFailed(tr("No auth header"));
+	}
+	else if (m_authMethods.contains("CRAM-MD5"))
+	{
+		write("AUTH CRAM-MD5", Command::AuthCramMd5);
+	}
+	else if (m_authMethods.contains("LOGIN"))
+	{
+		write("AUTH LOGIN", Command::AuthLogin);
+	}
+	else if (m_authMethods.contains("PLAIN"))
+	{
+		QByteArray credentials = '\0' + m_config.user.toUtf8() + '\0' + m_config.pass.toUtf8();
+		write("AUTH PLAIN " + credentials.toBase64(), Command::AuthResult);
+	}
+	else
+	{
+		connectionFailed(tr("No compatible authentication methods"));
+	}
+}
+
+
+void SmtpSession::ready()
+{
+	Logger(LOG_EXTRA) << tr("SMTP session ready%1").arg(m_pipelining ? tr(", pipelining") : QString());
+	m_state = State::Ready;
+	nextTransaction();
+}
+
+
+// Starts sending the next queued message, merging in other queued messages
+// with the same text so each recipient gets one copy in one transaction
+void SmtpSession::nextTransaction()
+{
+	m_transaction = Transaction();
+
+	if (m_queue.isEmpty())
+	{
+		if (m_closing)
+			quit();
+		else
+			m_idleTimer.start();
+		return;
+	}
+
+	m_transaction.active = true;
+	m_transaction.messages.append(m_queue.takeFirst());
+	const Message& first = m_transaction.messages.first();
+	for (int n = 0; n < m_queue.size(); )
+	{
+		if (m_queue[n].subject == first.subject && m_queue[n].body == first.body &&
+			m_transaction.messages.size() < SMTP_MAXMERGEDMESSAGES)
+			m_transaction.messages.append(m_queue.takeAt(n));
+		else
+			n++;
+	}
+	for (const auto& message : m_transaction.messages)
+	{
+		for (const auto& recipient : message.recipients)
+		{
+			if (!m_transaction.recipients.contains(recipient))
+				m_transaction.recipients.append(recipient);
+		}
+	}
+
+	// Apparently Google needs the addresses in angle brackets
+	write("MAIL FROM:<" + m_config.email.toUtf8() + ">", Command::Mail);
+	if (m_pipelining)
+	{
+		for (const auto& recipient : m_transaction.recipients)
+		{
+			write("RCPT TO:<" + recipient.toUtf8() + ">", Command::Rcpt);
+		}
+		write("DATA", Command::Data);
+	}
+}
+
+
+// Sends the next RCPT, or DATA after the last one, when not pipelining
+void SmtpSession::sendRcptOrData()
+{
+	int sent = m_transaction.nextRcpt;
+	if (sent < m_transaction.recipients.size())
+	{
+		write("RCPT TO:<" + m_transaction.recipients[sent].toUtf8() + ">", Command::Rcpt);
+	}
+	else if (m_transaction.accepted.isEmpty())
+	{
+		finishTransaction(false, tr("All recipients rejected"));
+	}
+	else
+	{
+		write("DATA", Command::Data);
+	}
+}
+
+
+void SmtpSession::finishTransaction(bool success, const QString& error)
+{
+	if (success)
+	{
+		Logger() << tr("SMTP alert email sent to %1").arg(QStringList(m_transaction.accepted.values()).join(", "));
+	}
+
+	for (const auto& message : m_transaction.messages)
+	{
+		bool delivered = false;
+		for (const auto& recipient : message.recipients)
+		{
+			if (m_transaction.accepted.contains(recipient))
+				delivered = true;
+		}
+		emit finished(message.id, success && delivered, success && !delivered ? tr("Recipient rejected") : error);
+	}
+	m_transaction = Transaction();
+
+	// A failed transaction is reset before starting the next one, pipelined
+	// commands have all been answered by the time the transaction finishes
+	if (success)
+	{
+		nextTransaction();
+	}
+	else
+	{
+		write("RSET", Command::Rset);
+	}
+}
+
+
+void SmtpSession::connectionFailed(const QString& error)
+{
+	if (State::Disconnected == m_state)
+		return;
+
+	bool wasReady = State::Ready == m_state || State::Quitting == m_state;
+	m_state = State::Disconnected;
+	m_expected.clear();
+	m_replyTimer.stop();
+	m_idleTimer.stop();
+	m_socket->abort();
+
+	// Messages being sent when an established connection drops get one more
+	// try on a new connection, failures while connecting fail everything queued
+	QList<Message> resend;
+	for (auto message : m_transaction.messages)
+	{
+		if (wasReady && !message.resent)
+		{
+			message.resent = true;
+			resend.append(message);
+		}
+		else
+		{
+			emit finished(message.id, false, error);
+		}
+	}
+	m_transaction = Transaction();
+	m_queue = resend + m_queue;
+
+	if (wasReady && !m_queue.isEmpty())
+	{
+		Logger(LOG_WARNING) << tr("SMTP connection lost (%1), reconnecting to send %2 queued alert emails")
+			.arg(error)
+			.arg(m_queue.size());
+	}
+
+	if (!wasReady)
+	{
+		for (const auto& message : m_queue)
+		{
+			emit finished(message.id, false, error);
+		}
+		m_queue.clear();
+	}
+
+	if (!m_queue.isEmpty())
+		reconnectLater();
+	else if (m_closing)
+		deleteLater();
+}
+
+
+// Connecting again from inside the socket's error or disconnected signal would
+// be undone as the socket finishes closing the old connection
+void SmtpSession::reconnectLater()
+{
+	QTimer::singleShot(0, this, [this]()
+	{
+		if (State::Disconnected == m_state && !m_queue.isEmpty())
+			connectToServer();
+	});
+}
+
+
+void SmtpSession::socketError(QAbstractSocket::SocketError socketError)
+{
+	Q_UNUSED(socketError);
+
+	// Servers close idle connections, that's only a problem when there's something to send
+	if (State::Quitting == m_state ||
+		(State::Ready == m_state && !m_transaction.active && m_expected.isEmpty()))
+		return;
+
+	connectionFailed(tr("Socket error '%1'").arg(m_socket->errorString()));
+}
+
+
+void SmtpSession::socketDisconnected()
+{
+	if (State::Quitting == m_state ||
+		(State::Ready == m_state && !m_transaction.active && m_expected.isEmpty()))
+	{
+		Logger(LOG_EXTRA) << tr("SMTP session closed");
+		m_state = State::Disconnected;
+		m_replyTimer.stop();
+		m_idleTimer.stop();
+
+		if (m_closing)
+			deleteLater();
+		else if (!m_queue.isEmpty())
+			reconnectLater();
+		return;
+	}
+
+	connectionFailed(tr("Disconnected"));
+}
+
+
+void SmtpSession::replyTimeout()
+{
+	connectionFailed(tr("No response from SMTP server after %1 seconds").arg(INTERVAL_SMTPTIMEOUT / 1000));
+}
+
+
+void SmtpSession::idleTimeout()
+{
+	if (State::Ready == m_state && !m_transaction.active && m_expected.isEmpty())
+		quit();
+}
+
+
+void SmtpSession::quit()
+{
+	m_idleTimer.stop();
+	m_state = State::Quitting;
+	write("QUIT", Command::Quit);
+}
+
+
+// The message text ready to send after DATA, without the terminating dot
+QByteArray SmtpSession::messageData() const
+{
+	const Message& message = m_transaction.messages.first();
+
+	QString text;
+	text += "To: " + m_transaction.recipients.join(", ") + "\n";
+	text += "From: " + m_config.email + "\n";
+	text += "Subject: " + message.subject + "\n";
+	text += "Date: " + QDateTime::currentDateTime().toString(Qt::RFC2822Date) + "\n";
+	text += "\n";
+	text += message.body;
+
+	// Lines starting with a dot get another so they aren't read as the end
+	QByteArray data;
+	for (const auto& line : text.split('\n'))
+	{
+		QByteArray encoded = line.toUtf8();
+		if (encoded.endsWith('\r'))
+			encoded.chop(1);
+		if (encoded.startsWith('.'))
+			data += '.';
+		data += encoded + "\r\n";
+	}
+	return data;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+/* SmtpSession.h - Sends alert emails over one reused SMTP connection */
+
+#include "AlertDispatcher.h"
+
+#include <QObject>
+#include <QAbstractSocket>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+class QSslSocket;
+
+// Keeps an authenticated connection to the SMTP server open for the configured
+// idle time so bursts of alerts don't each connect, negotiate TLS and log in.
+// Queued messages with the same subject and body are sent as one message to
+// all their recipients, and commands are pipelined when the server supports it.
+// Messages sent while connecting or reconnecting wait in the queue.
+class SmtpSession : public QObject
+{
+	Q_OBJECT
+
+public:
+	SmtpSession(const AlertSmtpConfig& config, QObject *parent = nullptr);
+	~SmtpSession();
+
+	const AlertSmtpConfig& config() const { return m_config; }
+	void sendMail(quint64 id, const QStringList& recipients, const QString& subject, const QString& body);
+	void closeWhenIdle();
+
+signals:
+	void finished(quint64 id, bool success, const QString& error);
+
+private slots:
+	void socketEncrypted();
+	void socketReadyRead();
+	void socketError(QAbstractSocket::SocketError socketError);
+	void socketDisconnected();
+	void replyTimeout();
+	void idleTimeout();
+
+private:
+	enum class State
+	{
+		Disconnected,
+		Connecting,			// Connected but not logged in yet
+		Ready,
+		Quitting
+	};
+
+	// Commands waiting for a reply, in the order they were sent
+	enum class Command
+	{
+		Greeting,
+		Ehlo,
+		StartTls,
+		AuthCramMd5,
+		AuthLogin,
+		AuthUser,
+		AuthResult,
+		Mail,
+		Rcpt,
+		Data,
+		Body,
+		Rset,
+		Quit
+	};
+
+	struct Message
+	{
+		quint64 id = 0;
+		QStringList recipients;
+		QString subject;
+		QString body;
+		bool resent = false;		// Already resent after losing the connection
+	};
+
+	// Queued messages sent together as one mail transaction
+	struct Transaction
+	{
+		bool active = false;
+		QList<Message> messages;
+		QStringList recipients;
+		QSet<QString> accepted;
+		int nextRcpt = 0;
+	};
+
+	void connectToServer();
+	void reconnectLater();
+	void write(const QByteArray& line, Command command);
+	void handleReply(Command command, int code, const QStringList& lines);
+	void authenticate();
+	void ready();
+	void nextTransaction();
+	void sendRcptOrData();
+	void finishTransaction(bool success, const QString& error);
+	void connectionFailed(const QString& error);
+	void quit();
+	QByteArray messageData() const;
+
+	AlertSmtpConfig m_config;
+	QSslSocket* m_socket = nullptr;
+	State m_state = State::Disconnected;
+	QList<Command> m_expected;
+	QStringList m_replyLines;
+	bool m_pipelining = false;
+	bool m_startTls = false;
+	QStringList m_authMethods;
+	QList<Message> m_queue;
+	Transaction m_transaction;
+	bool m_closing = false;
+	QTimer m_replyTimer;
+	QTimer m_idleTimer;
+};
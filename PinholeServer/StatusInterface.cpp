@@ -4,20 +4,51 @@
 #include "AppManager.h"
 #include "GlobalManager.h"
 #include "Logger.h"
+#include "Values.h"
 #include "../common/Utilities.h"
+#include "../common/DiscoveryPacket.h"
 #include "../common/PinholeCommon.h"
 
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QHostInfo>
 #include <QCoreApplication>
 
+#define IDLE_BUCKET_SHORT	1000		// Idle status granularity for the first minute
+#define IDLE_BUCKET_LONG	60000		// Idle status granularity after the first minute
+
 
 StatusInterface::StatusInterface(Settings* settings, AlertManager* alertManager, 
 	AppManager* appManager, GlobalManager* globalManager, QObject *parent)
 	: QObject(parent), m_settings(settings), m_alertManager(alertManager),
 	m_appManager(appManager), m_globalManager(globalManager)
 {
+	// These are comparatively expensive (prettyProductName reads OS release files)
+	m_hostName = QHostInfo::localHostName();
+	m_version = QCoreApplication::applicationVersion();
+	m_os = QSysInfo::prettyProductName();
+
+	m_role = m_globalManager->getRole();
+	m_alertCount = m_alertManager->getAlertCount();
+	m_runningCount = m_appManager->runningAppCount();
+
+	// Watch for changes to the values reported in the announce response
+	connect(m_globalManager, &GlobalManager::valueChanged,
+		this, &StatusInterface::managerValueChanged);
+	connect(m_alertManager, &AlertManager::valueChanged,
+		this, &StatusInterface::managerValueChanged);
+	connect(m_appManager, &AppManager::valueChanged,
+		this, &StatusInterface::managerValueChanged);
+
+	// Push the announce to listening consoles on change and periodically
+	m_presenceDelayTimer.setInterval(INTERVAL_PRESENCEDELAY);
+	m_presenceDelayTimer.setSingleShot(true);
+	connect(&m_presenceDelayTimer, &QTimer::timeout,
+		this, &StatusInterface::presenceTimeout);
+
+	m_keepaliveTimer.setInterval(INTERVAL_PRESENCEKEEPALIVE);
+	m_keepaliveTimer.setSingleShot(false);
+	connect(&m_keepaliveTimer, &QTimer::timeout,
+		this, &StatusInterface::presenceTimeout);
+	m_keepaliveTimer.start();
 }
 
 
@@ -26,83 +57,168 @@ StatusInterface::~StatusInterface()
 }
 
 
-QByteArray StatusInterface::processPacket(const QByteArray & packet, const QString& MAC)
+// Returns the response to a discovery packet, encoding receives the encoding the response uses
+QByteArray StatusInterface::processPacket(const QByteArray & packet, const QString& MAC, int* encoding)
 {
-	// Parse the data as JSON
-	QJsonDocument jsonDoc = QJsonDocument::fromJson(packet);
-	// Validate the data
-	if (jsonDoc.isNull())
+	// Queries are recognized without building a JSON document
+	int acceptEncoding = DISCOVERY_ENCODING_JSON;
+	if (!IsDiscoveryQuery(packet, &acceptEncoding))
 	{
+		// Only queries are currently supported
 		return QByteArray();
 	}
-	else
+
+	if (nullptr != encoding)
+		*encoding = acceptEncoding;
+	return announcePacket(MAC, acceptEncoding);
+}
+
+
+// Returns the announce pushed to listening consoles, always the latest encoding
+// since only consoles that understand it listen for presence packets
+QByteArray StatusInterface::presencePacket(const QString& MAC)
+{
+	return announcePacket(MAC, DISCOVERY_ENCODING_LATEST);
+}
+
+
+void StatusInterface::sendStatus(const QString& status)
+{
+	QVariantMap values;
+	values[TAG_COMMAND] = UDPCOMMAND_STATUS;
+	values[TAG_ID] = m_settings->serverId();
+	values[TAG_STATUS] = status;
+	emit sendPacket(values);
+}
+
+
+void StatusInterface::managerValueChanged(const QString& group, const QString& item, const QString& prop, const QVariant& value)
+{
+	Q_UNUSED(item);
+
+	if (GROUP_GLOBAL == group && PROP_GLOBAL_ROLE == prop)
+	{
+		m_role = value.toString();
+		invalidateAnnounce();
+		schedulePresence();
+	}
+	else if (GROUP_ALERT == group && PROP_ALERT_ALERTCOUNT == prop)
+	{
+		m_alertCount = value.toInt();
+		invalidateAnnounce();
+		schedulePresence();
+	}
+	else if (GROUP_APP == group && (PROP_APP_RUNNING == prop || PROP_APP_LIST == prop))
 	{
-		QJsonObject jsonObject = jsonDoc.object();
-		QString command = jsonObject[QString(TAG_COMMAND)].toString();
-		if (command != UDPCOMMAND_QUERY)
+		int runningCount = m_appManager->runningAppCount();
+		if (runningCount != m_runningCount)
 		{
-			// Only queries are currently supported
-			return QByteArray();
+			m_runningCount = runningCount;
+			invalidateAnnounce();
+			schedulePresence();
 		}
-		else
-		{
-			// Build response json
-			QJsonObject jsonResponse;
-			jsonResponse[TAG_COMMAND] = UDPCOMMAND_ANNOUNCE;
-			jsonResponse[TAG_ID] = m_settings->serverId();
-			jsonResponse[TAG_MAC] = MAC;
-			jsonResponse[TAG_NAME] = QHostInfo::localHostName();
-			jsonResponse[TAG_ROLE] = m_globalManager->getRole();
-			jsonResponse[TAG_VERSION] = QCoreApplication::applicationVersion();
-			jsonResponse[TAG_OS] = QSysInfo::prettyProductName();
-
-			QString statusText;
-			int alertCount = m_alertManager->getAlertCount();
-			if (0 != alertCount)
-			{
-				statusText += tr("%1 alert%2, ")
-					.arg(alertCount)
-					.arg(alertCount == 1 ? "" : "s");
-			}
-
-			int runningCount = m_appManager->runningAppCount();
-			if (0 != runningCount)
-			{
-				statusText += tr("%1 app%2 running")
-					.arg(runningCount)
-					.arg(runningCount == 1 ? "" : "s");
-			}
-			else
-			{
-				statusText += tr("Idle %1").arg(MillisecondsToString(m_settings->idleTime()));
-			}
-
-			jsonResponse[TAG_STATUS] = statusText;
+	}
+}
+
+
+// Returns the announce response for an interface, rebuilt only when a reported value changes
+QByteArray StatusInterface::announcePacket(const QString& MAC, int encoding)
+{
+	qint64 bucket = idleBucket();
+	if (bucket != m_idleBucket)
+	{
+		m_idleBucket = bucket;
+		invalidateAnnounce();
+	}
+
+	QPair<QString, int> cacheKey(MAC, encoding);
+	auto cached = m_announceCache.constFind(cacheKey);
+	if (cached != m_announceCache.constEnd())
+	{
+		return cached.value();
+	}
+
+	// Build response
+	QVariantMap values;
+	values[TAG_COMMAND] = UDPCOMMAND_ANNOUNCE;
+	values[TAG_ID] = m_settings->serverId();
+	values[TAG_MAC] = MAC;
+	values[TAG_NAME] = m_hostName;
+	values[TAG_ROLE] = m_role;
+	values[TAG_VERSION] = m_version;
+	values[TAG_OS] = m_os;
+
+	QString statusText;
+	if (0 != m_alertCount)
+	{
+		statusText += tr("%1 alert%2, ")
+			.arg(m_alertCount)
+			.arg(m_alertCount == 1 ? "" : "s");
+	}
+
+	if (0 != m_runningCount)
+	{
+		statusText += tr("%1 app%2 running")
+			.arg(m_runningCount)
+			.arg(m_runningCount == 1 ? "" : "s");
+	}
+	else
+	{
+		statusText += tr("Idle %1").arg(MillisecondsToString(m_idleBucket));
+	}
+
+	values[TAG_STATUS] = statusText;
 
 #if defined(Q_OS_WIN)
-			jsonResponse[TAG_PLATFORM] = "WIN";
+	values[TAG_PLATFORM] = "WIN";
 #elif defined(Q_OS_MAC)
-			jsonResponse[TAG_PLATFORM] = "MAC";
+	values[TAG_PLATFORM] = "MAC";
 #elif defined(Q_OS_UNIX)
-			jsonResponse[TAG_PLATFORM] = "UNI";
+	values[TAG_PLATFORM] = "UNI";
 #else
-			jsonResponse[TAG_PLATFORM] = "UNK";
+	values[TAG_PLATFORM] = "UNK";
 #endif
 
-			// Return response packet
-			return QJsonDocument(jsonResponse).toJson();
-		}
-	}
+	QByteArray packet = EncodeDiscoveryPacket(values, encoding);
+	m_announceCache[cacheKey] = packet;
+	return packet;
+}
+
+
+// Returns the idle time rounded down to the granularity shown in the status text,
+// or 0 if apps are running and the idle time isn't shown
+qint64 StatusInterface::idleBucket() const
+{
+	if (0 != m_runningCount)
+		return 0;
 
-	return QByteArray();
+	qint64 idle = m_settings->idleTime();
+	if (idle < IDLE_BUCKET_LONG)
+		return idle - idle % IDLE_BUCKET_SHORT;
+	return idle - idle % IDLE_BUCKET_LONG;
 }
 
 
-void StatusInterface::sendStatus(const QString& status)
+void StatusInterface::invalidateAnnounce()
+{
+	m_announceCache.clear();
+}
+
+
+// Pushes the announce after a short delay so a burst of changes (like a group
+// launching) goes out as a single packet
+void StatusInterface::schedulePresence()
+{
+	if (!m_presenceDelayTimer.isActive())
+	{
+		m_presenceDelayTimer.start();
+	}
+}
+
+
+void StatusInterface::presenceTimeout()
 {
-	QJsonObject jsonResponse;
-	jsonResponse[TAG_COMMAND] = UDPCOMMAND_STATUS;
-	jsonResponse[TAG_ID] = m_settings->serverId();
-	jsonResponse[TAG_STATUS] = status;
-	emit sendPacket(QJsonDocument(jsonResponse).toJson());
+	// Anything just sent counts as the keepalive
+	m_keepaliveTimer.start();
+	emit presenceChanged();
 }
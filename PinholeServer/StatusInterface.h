@@ -1,6 +1,9 @@
 #pragma once
 
 #include <QObject>
+#include <QMap>
+#include <QTimer>
+#include <QVariantMap>
 
 class Settings;
 class AlertManager;
@@ -15,18 +18,44 @@ public:
 	StatusInterface(Settings* settings, AlertManager* alertManager, AppManager* appManager,
 		GlobalManager* globalManager, QObject *parent = nullptr);
 	~StatusInterface();
-	QByteArray processPacket(const QByteArray& packet, const QString& MAC);
+	QByteArray processPacket(const QByteArray& packet, const QString& MAC, int* encoding = nullptr);
+	QByteArray presencePacket(const QString& MAC);
 
 public slots:
 	void sendStatus(const QString& status);
 
 signals:
-	void sendPacket(const QByteArray& packet);
+	void sendPacket(const QVariantMap& values);
+	void presenceChanged();
+
+private slots:
+	void managerValueChanged(const QString& group, const QString& item, const QString& prop, const QVariant& value);
+	void presenceTimeout();
 
 private:
+	QByteArray announcePacket(const QString& MAC, int encoding);
+	qint64 idleBucket() const;
+	void invalidateAnnounce();
+	void schedulePresence();
+
 	Settings* m_settings = nullptr;
 	AlertManager* m_alertManager = nullptr;
 	AppManager* m_appManager = nullptr;
 	GlobalManager* m_globalManager = nullptr;
 
+	// Values that don't change while running, read once
+	QString m_hostName;
+	QString m_version;
+	QString m_os;
+	// Values that invalidate the announce cache when changed
+	QString m_role;
+	int m_alertCount = 0;
+	int m_runningCount = 0;
+	qint64 m_idleBucket = -1;
+	// MAC address/encoding, serialized announce response
+	QMap<QPair<QString, int>, QByteArray> m_announceCache;
+	// Coalesces state changes before they are pushed to listening consoles
+	QTimer m_presenceDelayTimer;
+	// Repeats the announce when nothing changes so consoles know we're alive
+	QTimer m_keepaliveTimer;
 };
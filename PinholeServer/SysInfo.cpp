@@ -0,0 +1,516 @@
+#include "SysInfo.h"
+#include "Settings.h"
+#include "Sigar.h"
+#include "Values.h"
+#include "../common/Utilities.h"
+#include "../common/Version.h"
+
+#include <QThread>
+#include <QSysInfo>
+#include <QStorageInfo>
+#include <QNetworkInterface>
+#include <QHostInfo>
+#include <QDir>
+#include <QCoreApplication>
+
+#include <algorithm>
+
+
+static QVariant gatherHost()
+{
+	QVariantMap host;
+	host["hostName"] = QHostInfo::localHostName();
+	host["domainName"] = QHostInfo::localDomainName();
+	return host;
+}
+
+
+static QVariant gatherOs()
+{
+	QVariantMap os;
+	os["productName"] = QSysInfo::prettyProductName();
+	os["productType"] = QSysInfo::productType();
+	os["productVersion"] = QSysInfo::productVersion();
+	os["kernelType"] = QSysInfo::kernelType();
+	os["kernelVersion"] = QSysInfo::kernelVersion();
+	os["cpuArchitecture"] = QSysInfo::currentCpuArchitecture();
+	return os;
+}
+
+
+static QVariant gatherMemory()
+{
+	QVariantMap memory;
+	quint64 totalMemory = 0;
+	quint64 freeMemory = 0;
+	if (MemoryInformation(totalMemory, freeMemory))
+	{
+		memory["total"] = totalMemory;
+		memory["free"] = freeMemory;
+	}
+	return memory;
+}
+
+
+static QVariant gatherCpus()
+{
+	QVariantList cpus;
+	for (const auto& cpuInfo : CpuInformation())
+	{
+		QVariantMap cpu;
+		cpu["vendor"] = cpuInfo.Vendor;
+		cpu["model"] = cpuInfo.Model;
+		cpu["mhz"] = cpuInfo.mhz;
+		cpu["mhzMin"] = cpuInfo.mhzMin;
+		cpu["mhzMax"] = cpuInfo.mhzMax;
+		cpu["cacheSize"] = cpuInfo.cacheSize;
+		cpus.append(cpu);
+	}
+	return cpus;
+}
+
+
+// Only interfaces that are up or running
+static QVariant gatherInterfaces()
+{
+	QVariantList interfaces;
+	for (const auto& iface : QNetworkInterface::allInterfaces())
+	{
+		if (!(iface.flags() & (QNetworkInterface::IsUp | QNetworkInterface::IsRunning)))
+			continue;
+
+		QVariantList addresses;
+		for (const auto& entry : iface.addressEntries())
+		{
+			QVariantMap address;
+			address["address"] = HostAddressToString(entry.ip());
+			address["netmask"] = HostAddressToString(entry.netmask());
+			addresses.append(address);
+		}
+
+		QVariantMap netInterface;
+		netInterface["type"] = QtEnumToString(iface.type());
+		netInterface["name"] = iface.name();
+		netInterface["humanReadableName"] = iface.humanReadableName();
+		netInterface["hardwareAddress"] = iface.hardwareAddress();
+		netInterface["mtu"] = iface.maximumTransmissionUnit();
+		netInterface["addresses"] = addresses;
+		interfaces.append(netInterface);
+	}
+	return interfaces;
+}
+
+
+static QVariant gatherRoutes()
+{
+	QVariantList routes;
+	for (const auto& routeEntry : GetRouteList())
+	{
+		QVariantMap route;
+		route["destination"] = routeEntry.destination.toString();
+		route["gateway"] = routeEntry.gateway.toString();
+		route["mask"] = routeEntry.mask.toString();
+		route["metric"] = routeEntry.metric;
+		route["mtu"] = routeEntry.mtu;
+		route["window"] = routeEntry.window;
+		route["use"] = routeEntry.use;
+		route["interface"] = routeEntry.interfaceName;
+		routes.append(route);
+	}
+	return routes;
+}
+
+
+static QVariant gatherVolumes()
+{
+	QVariantList volumes;
+	for (const auto& storage : QStorageInfo::mountedVolumes())
+	{
+		if (!storage.isValid())
+			continue;
+
+		QVariantMap volume;
+		volume["displayName"] = storage.displayName();
+		volume["name"] = storage.name();
+		volume["device"] = QString(storage.device());
+		volume["root"] = QDir::toNativeSeparators(storage.rootPath());
+		volume["fileSystem"] = QString(storage.fileSystemType());
+		volume["bytesTotal"] = storage.bytesTotal();
+		volume["bytesFree"] = storage.bytesFree();
+		volume["bytesAvailable"] = storage.bytesAvailable();
+		volume["readOnly"] = storage.isReadOnly();
+		volume["ready"] = storage.isReady();
+		volumes.append(volume);
+	}
+	return volumes;
+}
+
+
+static QVariant gatherProcesses()
+{
+	QVariantMap processes;
+	SystemProcessesInfo procInfo;
+	if (GetSystemProcessesInfo(procInfo))
+	{
+		processes["total"] = procInfo.total;
+		processes["sleeping"] = procInfo.sleeping;
+		processes["running"] = procInfo.running;
+		processes["zombie"] = procInfo.zombie;
+		processes["stopped"] = procInfo.stopped;
+		processes["idle"] = procInfo.idle;
+		processes["threads"] = procInfo.threads;
+	}
+
+	auto procList = runningProcesses();
+	std::sort(procList.begin(), procList.end(), [](ProcessInfo& procA, ProcessInfo& procB) { return procA.id < procB.id; });
+	QVariantList list;
+	for (const auto& proc : procList)
+	{
+		QVariantMap process;
+		process["id"] = proc.id;
+		process["name"] = proc.name;
+		list.append(process);
+	}
+	processes["list"] = list;
+	return processes;
+}
+
+
+static QVariant gatherUsers()
+{
+	QVariantList users;
+	for (const auto& who : GetWhoList())
+	{
+		QVariantMap user;
+		user["user"] = who.user;
+		user["device"] = who.device;
+		user["host"] = who.host;
+		users.append(user);
+	}
+	return users;
+}
+
+
+SysInfoGatherer::SysInfoGatherer(QObject *parent)
+	: QObject(parent)
+{
+}
+
+
+SysInfoGatherer::~SysInfoGatherer()
+{
+}
+
+
+// Each section is sent as soon as it's gathered so slow ones don't hold up the rest
+void SysInfoGatherer::gather(const QStringList& sections)
+{
+	for (const auto& section : sections)
+	{
+		QVariant value;
+		if (SYSINFO_HOST == section)
+			value = gatherHost();
+		else if (SYSINFO_OS == section)
+			value = gatherOs();
+		else if (SYSINFO_MEMORY == section)
+			value = gatherMemory();
+		else if (SYSINFO_CPUS == section)
+			value = gatherCpus();
+		else if (SYSINFO_INTERFACES == section)
+			value = gatherInterfaces();
+		else if (SYSINFO_ROUTES == section)
+			value = gatherRoutes();
+		else if (SYSINFO_VOLUMES == section)
+			value = gatherVolumes();
+		else if (SYSINFO_PROCESSES == section)
+			value = gatherProcesses();
+		else if (SYSINFO_USERS == section)
+			value = gatherUsers();
+
+		emit gathered(section, value);
+	}
+}
+
+
+SysInfo::SysInfo(Settings* settings, QObject *parent)
+	: QObject(parent), m_settings(settings)
+{
+	m_sections[SYSINFO_HOST].lifetime = INTERVAL_SYSINFOHARDWARE;
+	m_sections[SYSINFO_OS].lifetime = INTERVAL_SYSINFOHARDWARE;
+	m_sections[SYSINFO_CPUS].lifetime = INTERVAL_SYSINFOHARDWARE;
+	m_sections[SYSINFO_INTERFACES].lifetime = INTERVAL_SYSINFONETWORK;
+	m_sections[SYSINFO_ROUTES].lifetime = INTERVAL_SYSINFONETWORK;
+	m_sections[SYSINFO_VOLUMES].lifetime = INTERVAL_SYSINFONETWORK;
+	m_sections[SYSINFO_USERS].lifetime = INTERVAL_SYSINFONETWORK;
+	m_sections[SYSINFO_MEMORY].lifetime = INTERVAL_SYSINFOLOAD;
+	m_sections[SYSINFO_PROCESSES].lifetime = INTERVAL_SYSINFOLOAD;
+
+	m_thread = new QThread(this);
+	m_gatherer = new SysInfoGatherer(nullptr);	// Must be nullptr
+	m_gatherer->moveToThread(m_thread);
+	connect(this, &SysInfo::gathererGather,
+		m_gatherer, &SysInfoGatherer::gather);
+	connect(m_gatherer, &SysInfoGatherer::gathered,
+		this, &SysInfo::gathered);
+	connect(m_thread, &QThread::finished,
+		m_gatherer, &SysInfoGatherer::deleteLater);
+	m_thread->start();
+
+	// Have everything ready for the first request
+	refresh();
+}
+
+
+SysInfo::~SysInfo()
+{
+	m_thread->quit();
+	m_thread->wait();
+}
+
+
+// Returns the cached sections and when each was gathered, expired sections are
+// gathered again in the background for the next request
+QVariantMap SysInfo::snapshot()
+{
+	refresh();
+
+	QVariantMap snapshot;
+	QVariantMap updated;
+	for (auto section = m_sections.cbegin(); section != m_sections.cend(); ++section)
+	{
+		if (!section->gatheredTime.isNull())
+		{
+			snapshot[section.key()] = section->value;
+			updated[section.key()] = section->gatheredTime.toString(Qt::ISODate);
+		}
+	}
+	snapshot[SYSINFO_PINHOLE] = pinholeSection();
+	snapshot[SYSINFO_UPDATED] = updated;
+
+	return snapshot;
+}
+
+
+// Returns the UTF8 system report text
+QByteArray SysInfo::text()
+{
+	QVariantMap snapshot = this->snapshot();
+	QString data;
+
+	QVariantMap host = snapshot[SYSINFO_HOST].toMap();
+	data += tr("\r\nHost name:          %1").arg(host["hostName"].toString());
+	data += tr("\r\nDomain name:        %1").arg(host["domainName"].toString());
+
+	data += "\r\n";
+
+	QVariantMap pinhole = snapshot[SYSINFO_PINHOLE].toMap();
+	data += tr("\r\nPinhole version:    %1").arg(pinhole["version"].toString());
+	data += tr("\r\nQt version:         %1").arg(pinhole["qtVersion"].toString());
+	data += tr("\r\nPinhole path:       %1").arg(pinhole["path"].toString());
+	data += tr("\r\nData directory:     %1").arg(pinhole["dataDirectory"].toString());
+	data += tr("\r\nPinhole uptime:     %1").arg(MillisecondsToString(pinhole["uptime"].toLongLong()));
+	if (pinhole.contains("systemUptime"))
+	{
+		data += tr("\r\nSystem uptime:      %1").arg(MillisecondsToString(pinhole["systemUptime"].toLongLong()));
+	}
+	data += tr("\r\nLocal datetime:     %1").arg(QDateTime::fromString(pinhole["localTime"].toString(), Qt::ISODate).toString());
+
+	data += "\r\n";
+
+	// CPU and OS
+	QVariantMap os = snapshot[SYSINFO_OS].toMap();
+	data += tr("\r\nOS product name:    %1").arg(os["productName"].toString());
+	data += tr("\r\nOS product type:    %1").arg(os["productType"].toString());
+	data += tr("\r\nOS product version: %1").arg(os["productVersion"].toString());
+	data += tr("\r\nOS kernel type:     %1").arg(os["kernelType"].toString());
+	data += tr("\r\nOS krnel version:   %1").arg(os["kernelVersion"].toString());
+	data += tr("\r\nCPU architecture:   %1").arg(os["cpuArchitecture"].toString());
+
+	QVariantMap memory = snapshot[SYSINFO_MEMORY].toMap();
+	if (memory.contains("total"))
+	{
+		data += tr("\r\nTotal memory:       %L1").arg(memory["total"].toULongLong());
+		data += tr("\r\nFree memory:        %L1").arg(memory["free"].toULongLong());
+	}
+
+	data += "\r\n";
+
+	QVariantList cpus = snapshot[SYSINFO_CPUS].toList();
+	if (!cpus.isEmpty())
+	{
+		data += tr("\r\nNum CPUs cores:     %1").arg(cpus.size());
+		for (int n = 0; n < cpus.size(); n++)
+		{
+			QVariantMap cpu = cpus[n].toMap();
+			data += tr("\r\nCPU number %1 info:").arg(n + 1);
+			data += tr("\r\nCPU vendor:         %1").arg(cpu["vendor"].toString());
+			data += tr("\r\nCPU model:          %1").arg(cpu["model"].toString());
+			data += tr("\r\nCPU MHz:            %1 (Min %2 Max %3)").arg(cpu["mhz"].toInt()).arg(cpu["mhzMin"].toInt()).arg(cpu["mhzMax"].toInt());
+			data += tr("\r\nCPU cache size:     %L1").arg(cpu["cacheSize"].toULongLong());
+			data += "\r\n";
+		}
+	}
+
+	data += "\r\n";
+
+	// Network interface list
+	data += tr("\r\nNetwork interfaces:");
+	for (const auto& interfaceVariant : snapshot[SYSINFO_INTERFACES].toList())
+	{
+		QVariantMap iface = interfaceVariant.toMap();
+		data += tr("\r\nInterface type:     %1").arg(iface["type"].toString());
+		data += tr("\r\nInterface name:     %1 (%2)").arg(iface["humanReadableName"].toString()).arg(iface["name"].toString());
+		data += tr("\r\nHardware address:   %1").arg(iface["hardwareAddress"].toString());
+		data += tr("\r\nMTU:                %L1").arg(iface["mtu"].toInt());
+		data += tr("\r\nNetwork addresses:");
+		for (const auto& addressVariant : iface["addresses"].toList())
+		{
+			QVariantMap address = addressVariant.toMap();
+			data += tr("\r\nAddress:            %1").arg(address["address"].toString());
+			data += tr("\r\nNetmask:            %1").arg(address["netmask"].toString());
+		}
+
+		data += "\r\n";
+	}
+
+	data += "\r\n";
+
+	// Route list
+	QVariantList routes = snapshot[SYSINFO_ROUTES].toList();
+	if (!routes.isEmpty())
+	{
+		data += tr("\r\nRoute list:");
+		data += QString("\r\n%1%2%3%4%5%6%7%8")
+			.arg(tr("Destination"), -40)
+			.arg(tr("Gateway"), -40)
+			.arg(tr("Mask"), -40)
+			.arg(tr("Metric"), -10)
+			.arg(tr("MTU"), -10)
+			.arg(tr("Window"), -10)
+			.arg(tr("Use"), -10)
+			.arg(tr("Interface"));
+		for (const auto& routeVariant : routes)
+		{
+			QVariantMap route = routeVariant.toMap();
+			data += QString("\r\n%1%2%3%L4%L5%L6%L7%8")
+				.arg(route["destination"].toString(), -40)
+				.arg(route["gateway"].toString(), -40)
+				.arg(route["mask"].toString(), -40)
+				.arg(route["metric"].toULongLong(), -10)
+				.arg(route["mtu"].toULongLong(), -10)
+				.arg(route["window"].toULongLong(), -10)
+				.arg(route["use"].toULongLong(), -10)
+				.arg(route["interface"].toString());
+		}
+	}
+
+	data += "\r\n";
+
+	// Storage
+	data += tr("\r\nStorage volumes:");
+	for (const auto& volumeVariant : snapshot[SYSINFO_VOLUMES].toList())
+	{
+		QVariantMap volume = volumeVariant.toMap();
+		data += tr("\r\nName:               %1 (%2)").arg(volume["displayName"].toString()).arg(volume["name"].toString());
+		data += tr("\r\nDevice:             %1").arg(volume["device"].toString());
+		data += tr("\r\nRoot:               %1").arg(volume["root"].toString());
+		data += tr("\r\nFile system:        %1").arg(volume["fileSystem"].toString());
+		data += tr("\r\nBytes total:        %L1").arg(volume["bytesTotal"].toLongLong());
+		data += tr("\r\nBytes free:         %L1").arg(volume["bytesFree"].toLongLong());
+		data += tr("\r\nBytes available:    %L1").arg(volume["bytesAvailable"].toLongLong());
+		data += tr("\r\nRead only:          %1").arg(volume["readOnly"].toBool() ? tr("Yes") : tr("No"));
+		data += tr("\r\nReady:              %1").arg(volume["ready"].toBool() ? tr("Yes") : tr("No"));
+		data += "\r\n";
+	}
+
+	data += "\r\n";
+
+	QVariantMap processes = snapshot[SYSINFO_PROCESSES].toMap();
+	if (processes.contains("total"))
+	{
+		data += tr("\r\nTotal processes:    %L1").arg(processes["total"].toULongLong());
+		data += tr("\r\nSleeping processes: %L1").arg(processes["sleeping"].toULongLong());
+		data += tr("\r\nRunning processes:  %L1").arg(processes["running"].toULongLong());
+		data += tr("\r\nZombie proesses:    %L1").arg(processes["zombie"].toULongLong());
+		data += tr("\r\nStopped proesses:   %L1").arg(processes["stopped"].toULongLong());
+		data += tr("\r\nIdle processes:     %L1").arg(processes["idle"].toULongLong());
+		data += tr("\r\nTotal threads:      %L1").arg(processes["threads"].toULongLong());
+	}
+
+	// Process list
+	data += tr("\r\nProcess list:");
+	for (const auto& processVariant : processes["list"].toList())
+	{
+		QVariantMap process = processVariant.toMap();
+		data += QString("\r\n%1 %2").arg(process["id"].toUInt()).arg(process["name"].toString());
+	}
+	data += "\r\n";
+
+	data += "\r\n";
+
+	QVariantList users = snapshot[SYSINFO_USERS].toList();
+	if (!users.isEmpty())
+	{
+		data += tr("\r\nUsed devices:");
+		for (const auto& userVariant : users)
+		{
+			QVariantMap user = userVariant.toMap();
+			data += tr("\r\nUser:               %1").arg(user["user"].toString());
+			data += tr("\r\nDevice:             %1").arg(user["device"].toString());
+			data += tr("\r\nHost:               %1").arg(user["host"].toString());
+			data += "\r\n";
+		}
+	}
+
+	data += "\r\n";
+
+	return data.toUtf8();
+}
+
+
+void SysInfo::gathered(const QString& section, const QVariant& value)
+{
+	Section& cached = m_sections[section];
+	cached.value = value;
+	cached.gatheredAt = MonotonicTime::now();
+	cached.gatheredTime = QDateTime::currentDateTime();
+	cached.gathering = false;
+}
+
+
+// Asks the gatherer for the sections that have expired and aren't already being gathered
+void SysInfo::refresh()
+{
+	QStringList expired;
+	for (auto section = m_sections.begin(); section != m_sections.end(); ++section)
+	{
+		if (!section->gathering &&
+			(section->gatheredTime.isNull() || section->gatheredAt.elapsed() >= section->lifetime))
+		{
+			section->gathering = true;
+			expired.append(section.key());
+		}
+	}
+
+	if (!expired.isEmpty())
+		emit gathererGather(expired);
+}
+
+
+// Cheap enough to be current every time
+QVariantMap SysInfo::pinholeSection() const
+{
+	QVariantMap pinhole;
+	pinhole["version"] = PINHOLE_VERSION;
+	pinhole["qtVersion"] = qVersion();
+	pinhole["path"] = QDir::toNativeSeparators(QCoreApplication::applicationFilePath());
+	pinhole["dataDirectory"] = QDir::toNativeSeparators(m_settings->dataDir());
+	pinhole["uptime"] = m_settings->uptime();
+	qint64 sysuptime = 0;
+	if (SystemUptime(sysuptime))
+	{
+		pinhole["systemUptime"] = sysuptime * 1000;
+	}
+	pinhole["localTime"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+	return pinhole;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+/* SysInfo.h - System information gathered in sections on a background thread and cached */
+
+#include "MonotonicTime.h"
+
+#include <QObject>
+#include <QDateTime>
+#include <QMap>
+#include <QVariant>
+
+class QThread;
+class Settings;
+
+// Gathers sections of system information, lives on the sysinfo thread
+class SysInfoGatherer : public QObject
+{
+	Q_OBJECT
+
+public:
+	SysInfoGatherer(QObject *parent = nullptr);
+	~SysInfoGatherer();
+
+signals:
+	void gathered(const QString& section, const QVariant& value);
+
+public slots:
+	void gather(const QStringList& sections);
+};
+
+
+// System information is split into sections that each stay fresh for their
+// own time, hardware for hours and memory and processes for seconds. Expired
+// sections are gathered again on a background thread when asked for, libSigar,
+// interface, volume and DNS calls never run on the main thread. Requests get
+// the cached sections straight away with when each was gathered, as a map that
+// can go out as msgpack or JSON, the text report is rendered from the same map.
+class SysInfo : public QObject
+{
+	Q_OBJECT
+
+public:
+	SysInfo(Settings* settings, QObject *parent = nullptr);
+	~SysInfo();
+
+	QVariantMap snapshot();
+	QByteArray text();
+
+signals:
+	void gathererGather(const QStringList& sections);
+
+private slots:
+	void gathered(const QString& section, const QVariant& value);
+
+private:
+	// One section of the cached system information
+	struct Section
+	{
+		qint64 lifetime = 0;		// Milliseconds the section stays fresh
+		QVariant value;
+		MonotonicTime gatheredAt;
+		QDateTime gatheredTime;		// Null until first gathered
+		bool gathering = false;
+	};
+
+	void refresh();
+	QVariantMap pinholeSection() const;
+
+	QMap<QString, Section> m_sections;
+	QThread* m_thread = nullptr;
+	SysInfoGatherer* m_gatherer = nullptr;
+	Settings* m_settings = nullptr;
+};
@@ -1,42 +1,62 @@
 #pragma once
 
-// Counts the number of occurances in a time period
+// Counts the number of occurances in a time period, up to a maximum count.
+// Keeps the times in a fixed size ring buffer so counting never allocates.
+// The clock can be replaced so periods can be tested without waiting.
 
-#include <QDateTime>
+#include "MonotonicTime.h"
+
+#include <QVector>
+
+#include <functional>
 
 class TimePeriodCount
 {
 public:
+	explicit TimePeriodCount(int capacity, std::function<MonotonicTime()> clock = &MonotonicTime::now)
+		: m_times(qMax(capacity, 1)), m_clock(clock)
+	{
+	}
+
 	int getCount() const
 	{
-		return m_list.size();
+		return m_count;
 	}
 
 	void reset()
 	{
-		m_list.clear();
+		m_count = 0;
 	}
 
+	// Returns the number of occurances in the period including this one,
+	// which never goes higher than the capacity
 	int increment(qint64 period)
 	{
-		QDateTime now = QDateTime::currentDateTime();
+		MonotonicTime now = m_clock();
 
-		// Remove entries older than period
-		auto it = m_list.begin();
-		while (it != m_list.end())
+		// Remove entries older than period, oldest first
+		while (m_count > 0 && m_times[m_first].msecsTo(now) > period)
 		{
-			if (it->msecsTo(now) > period)
-				it = m_list.erase(it);
-			else
-				++it;
+			m_first = (m_first + 1) % m_times.size();
+			m_count--;
 		}
 
-		m_list.append(now);
+		// Full, forget the oldest
+		if (m_count == m_times.size())
+		{
+			m_first = (m_first + 1) % m_times.size();
+			m_count--;
+		}
 
-		return m_list.size();
+		m_times[(m_first + m_count) % m_times.size()] = now;
+		m_count++;
+
+		return m_count;
 	}
 
 private:
-	QList<QDateTime> m_list;
+	QVector<MonotonicTime> m_times;
+	std::function<MonotonicTime()> m_clock;
+	int m_first = 0;
+	int m_count = 0;
 };
-
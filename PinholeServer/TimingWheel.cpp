@@ -0,0 +1,213 @@
+#include "TimingWheel.h"
+#include "Metrics.h"
+#include "Values.h"
+
+#include <QtAlgorithms>
+
+
+TimingWheel::TimingWheel(QObject *parent)
+	: QObject(parent)
+{
+	m_clock.start();
+
+	m_timer.setSingleShot(true);
+	m_timer.setTimerType(Qt::PreciseTimer);
+	connect(&m_timer, &QTimer::timeout,
+		this, &TimingWheel::advance);
+}
+
+
+TimingWheel::~TimingWheel()
+{
+}
+
+
+quint64 TimingWheel::newTimerId()
+{
+	return m_nextId++;
+}
+
+
+// Calls the callback once msecs have passed, replacing any deadline the timer already had
+void TimingWheel::start(quint64 id, qint64 msecs, MetricHistogram* latency, const std::function<void()>& callback)
+{
+	stop(id);
+	catchUp();
+
+	Entry& entry = m_entries[id];
+	entry.deadline = m_clock.elapsed() + qMax(msecs, Q_INT64_C(0));
+	// The current tick has already fired
+	entry.tick = qMax((entry.deadline + INTERVAL_TIMINGWHEELTICK - 1) / INTERVAL_TIMINGWHEELTICK, m_currentTick + 1);
+	entry.latency = latency;
+	entry.callback = callback;
+	place(id, entry);
+
+	armTimer();
+}
+
+
+void TimingWheel::stop(quint64 id)
+{
+	auto entry = m_entries.find(id);
+	if (entry == m_entries.end())
+		return;
+
+	QSet<quint64>& slot = m_slots[entry->level][entry->slot];
+	slot.remove(id);
+	if (slot.isEmpty())
+		m_occupied[entry->level] &= ~(Q_UINT64_C(1) << entry->slot);
+	m_entries.erase(entry);
+
+	// Leave m_timer running, waking up for nothing is cheaper than working out the next slot
+}
+
+
+bool TimingWheel::isActive(quint64 id) const
+{
+	return m_entries.contains(id);
+}
+
+
+// Puts an entry in the finest wheel that reaches its tick, entries cascaded
+// down for the current tick go in the slot about to fire
+void TimingWheel::place(quint64 id, Entry& entry)
+{
+	qint64 delta = entry.tick - m_currentTick;
+	int level = 0;
+	while (level < TIMINGWHEEL_LEVELS - 1 && delta >= (Q_INT64_C(1) << (TIMINGWHEEL_SLOTBITS * (level + 1))))
+	{
+		level++;
+	}
+
+	// Beyond the last wheel, park in its furthest slot and place again when that cascades
+	qint64 tick = qMin(entry.tick, m_currentTick + (Q_INT64_C(1) << (TIMINGWHEEL_SLOTBITS * TIMINGWHEEL_LEVELS)) - 1);
+
+	entry.level = level;
+	entry.slot = static_cast<int>((tick >> (TIMINGWHEEL_SLOTBITS * level)) & (TIMINGWHEEL_SLOTS - 1));
+	m_slots[level][entry.slot].insert(id);
+	m_occupied[level] |= Q_UINT64_C(1) << entry.slot;
+}
+
+
+void TimingWheel::cascade(int level, int slot)
+{
+	QSet<quint64> ids;
+	ids.swap(m_slots[level][slot]);
+	m_occupied[level] &= ~(Q_UINT64_C(1) << slot);
+
+	for (quint64 id : ids)
+	{
+		place(id, m_entries[id]);
+	}
+}
+
+
+void TimingWheel::fire(qint64 tick)
+{
+	int slot = static_cast<int>(tick & (TIMINGWHEEL_SLOTS - 1));
+	QSet<quint64> ids;
+	ids.swap(m_slots[0][slot]);
+	m_occupied[0] &= ~(Q_UINT64_C(1) << slot);
+
+	qint64 now = m_clock.elapsed();
+	for (quint64 id : ids)
+	{
+		// An earlier callback may have stopped or restarted it
+		auto it = m_entries.find(id);
+		if (it == m_entries.end() || it->tick != tick)
+			continue;
+
+		Entry entry = it.value();
+		m_entries.erase(it);
+
+		entry.latency->observe(qMax(now - entry.deadline, Q_INT64_C(0)) * 1000);
+		entry.callback();
+	}
+}
+
+
+// Moves the current tick up to now if nothing before now is waiting, so new
+// deadlines go straight into the right wheel
+void TimingWheel::catchUp()
+{
+	qint64 nowTick = m_clock.elapsed() / INTERVAL_TIMINGWHEELTICK;
+	qint64 next = nextTick();
+	if (next < 0 || next > nowTick)
+		m_currentTick = qMax(m_currentTick, nowTick);
+}
+
+
+// Returns the next tick with entries to fire or cascade, -1 if there are none
+qint64 TimingWheel::nextTick() const
+{
+	qint64 next = -1;
+	for (int level = 0; level < TIMINGWHEEL_LEVELS; level++)
+	{
+		if (0 == m_occupied[level])
+			continue;
+
+		// First slot index after the current one, rotate the occupied bits so it is bit 0
+		int shift = TIMINGWHEEL_SLOTBITS * level;
+		qint64 index = (m_currentTick >> shift) + 1;
+		int first = static_cast<int>(index & (TIMINGWHEEL_SLOTS - 1));
+		quint64 rotated = 0 == first ? m_occupied[level] :
+			(m_occupied[level] >> first) | (m_occupied[level] << (TIMINGWHEEL_SLOTS - first));
+
+		qint64 tick = (index + qCountTrailingZeroBits(rotated)) << shift;
+		if (next < 0 || tick < next)
+			next = tick;
+	}
+	return next;
+}
+
+
+void TimingWheel::armTimer()
+{
+	qint64 tick = nextTick();
+	if (tick < 0)
+	{
+		m_timer.stop();
+		m_timerTick = -1;
+		return;
+	}
+
+	if (tick == m_timerTick && m_timer.isActive())
+		return;
+
+	m_timerTick = tick;
+	m_timer.start(static_cast<int>(qMax(tick * INTERVAL_TIMINGWHEELTICK - m_clock.elapsed(), Q_INT64_C(0))));
+}
+
+
+void TimingWheel::advance()
+{
+	qint64 nowTick = m_clock.elapsed() / INTERVAL_TIMINGWHEELTICK;
+
+	// Skip straight to each tick that has something to do
+	for (qint64 tick = nextTick(); tick >= 0 && tick <= nowTick; tick = nextTick())
+	{
+		m_currentTick = tick;
+
+		// Move deadlines down from coarser wheels whose slot has come round
+		for (int level = 1; level < TIMINGWHEEL_LEVELS; level++)
+		{
+			int shift = TIMINGWHEEL_SLOTBITS * level;
+			if (0 != (tick & ((Q_INT64_C(1) << shift) - 1)))
+				break;
+			cascade(level, static_cast<int>((tick >> shift) & (TIMINGWHEEL_SLOTS - 1)));
+		}
+
+		fire(tick);
+	}
+
+	catchUp();
+	m_timerTick = -1;
+	armTimer();
+}
+
+
+WheelTimer::WheelTimer(TimingWheel* wheel, const char* kind, const std::function<void()>& callback)
+	: m_wheel(wheel), m_id(wheel->newTimerId()),
+	m_latency(Metrics::histogram(METRIC_TIMER_LATENCY, Metrics::label("kind", kind))), m_callback(callback)
+{
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+/* TimingWheel.h - One shot deadlines for large numbers of timers on a single QTimer */
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+#include <functional>
+
+#define TIMINGWHEEL_LEVELS		4
+#define TIMINGWHEEL_SLOTBITS	6
+#define TIMINGWHEEL_SLOTS		(1 << TIMINGWHEEL_SLOTBITS)
+
+class MetricHistogram;
+
+// Deadlines are kept in wheels of 64 slots, each wheel 64 times coarser than the
+// one below, and cascade down to the finer wheels as they get closer. Starting,
+// moving and stopping a timer is cheap however many there are, and the QTimer
+// only wakes up when the next occupied slot comes round.
+class TimingWheel : public QObject
+{
+	Q_OBJECT
+
+public:
+	TimingWheel(QObject *parent = nullptr);
+	~TimingWheel();
+
+	quint64 newTimerId();
+	void start(quint64 id, qint64 msecs, MetricHistogram* latency, const std::function<void()>& callback);
+	void stop(quint64 id);
+	bool isActive(quint64 id) const;
+
+private slots:
+	void advance();
+
+private:
+	struct Entry
+	{
+		qint64 tick = 0;				// Tick the deadline falls in
+		qint64 deadline = 0;			// Milliseconds on m_clock, for the latency metric
+		int level = 0;
+		int slot = 0;
+		MetricHistogram* latency = nullptr;	// Latency metric of the timer's kind
+		std::function<void()> callback;
+	};
+
+	void place(quint64 id, Entry& entry);
+	void cascade(int level, int slot);
+	void fire(qint64 tick);
+	void catchUp();
+	qint64 nextTick() const;
+	void armTimer();
+
+	QHash<quint64, Entry> m_entries;
+	QSet<quint64> m_slots[TIMINGWHEEL_LEVELS][TIMINGWHEEL_SLOTS];
+	quint64 m_occupied[TIMINGWHEEL_LEVELS] = {};	// Bit for each slot with entries
+	qint64 m_currentTick = 0;			// Last tick processed
+	qint64 m_timerTick = -1;			// Tick m_timer is started for
+	quint64 m_nextId = 1;
+	QElapsedTimer m_clock;
+	QTimer m_timer;
+};
+
+
+// A one shot timer on a TimingWheel, used like a single shot QTimer.
+// The latency metric for its kind is looked up once, when it is made.
+class WheelTimer
+{
+public:
+	WheelTimer(TimingWheel* wheel, const char* kind, const std::function<void()>& callback);
+	~WheelTimer() { stop(); }
+
+	void start(qint64 msecs) { m_wheel->start(m_id, msecs, m_latency, m_callback); }
+	void stop() { m_wheel->stop(m_id); }
+	bool isActive() const { return m_wheel->isActive(m_id); }
+
+private:
+	Q_DISABLE_COPY(WheelTimer)
+
+	TimingWheel* m_wheel;
+	quint64 m_id;
+	MetricHistogram* m_latency;
+	std::function<void()> m_callback;
+};
@@ -4,6 +4,9 @@
 #if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
 #include "LinuxUtil.h"
 #endif
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
 
 
 UserProcess::UserProcess(Settings* settings, QObject *parent)
@@ -14,11 +17,74 @@ UserProcess::UserProcess(Settings* settings, QObject *parent)
 
 UserProcess::~UserProcess()
 {
+#if defined(Q_OS_LINUX)
+	closeCaptureFd();
+	closeCgroupFd();
+#endif
+}
+
+
+#if defined(Q_OS_LINUX)
+// Takes ownership of fd
+void UserProcess::setCaptureFd(int fd)
+{
+	closeCaptureFd();
+	m_captureFd = fd;
+}
+
+
+// Once the child has started the server's copy must be closed so the reader sees the end of the output
+void UserProcess::closeCaptureFd()
+{
+	if (m_captureFd >= 0)
+	{
+		::close(m_captureFd);
+		m_captureFd = -1;
+	}
+}
+
+
+// Takes ownership of fd
+void UserProcess::setCgroupFd(int fd)
+{
+	closeCgroupFd();
+	m_cgroupFd = fd;
 }
 
 
+void UserProcess::closeCgroupFd()
+{
+	if (m_cgroupFd >= 0)
+	{
+		::close(m_cgroupFd);
+		m_cgroupFd = -1;
+	}
+}
+#endif
+
+
 void UserProcess::setupChildProcess()
 {
+#if defined(Q_OS_LINUX)
+	// Runs in the child before exec. The cgroup is joined first, while the child
+	// still has the server's privileges, the server checks it worked once started.
+	if (m_cgroupFd >= 0)
+	{
+		ssize_t joined = write(m_cgroupFd, "0", 1);
+		Q_UNUSED(joined);
+	}
+
+	// The duplicates don't have close on exec set
+	if (m_captureFd >= 0)
+	{
+		dup2(m_captureFd, STDOUT_FILENO);
+		dup2(m_captureFd, STDERR_FILENO);
+	}
+#endif
+
+	// Scheduling is set while the child still has the server's privileges too
+	m_scheduling.applyInChild();
+
 #if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
 	if (m_settings->runningAsService() && !m_elevated)
 	{
@@ -1,6 +1,8 @@
 #pragma once
 // Subclass of QProcess to allow further control
 
+#include "ProcessScheduling.h"
+
 #include <QProcess>
 
 class Settings;
@@ -13,11 +15,24 @@ public:
 	UserProcess(Settings* settings, QObject *parent = nullptr);
 	~UserProcess();
 	void setElevated(bool set) { m_elevated = set; }
+	void setScheduling(const ProcessScheduling& scheduling) { m_scheduling = scheduling; }
+	const ProcessScheduling& scheduling() const { return m_scheduling; }
+#if defined(Q_OS_LINUX)
+	void setCaptureFd(int fd);
+	void closeCaptureFd();
+	void setCgroupFd(int fd);
+	void closeCgroupFd();
+#endif
 
 protected:
 	void setupChildProcess() override;
 
 private:
 	bool m_elevated = false;
+	ProcessScheduling m_scheduling;
+#if defined(Q_OS_LINUX)
+	int m_captureFd = -1;		// Becomes the child's stdout and stderr
+	int m_cgroupFd = -1;		// cgroup.procs of the app's cgroup, the child moves itself in
+#endif
 	Settings* m_settings = nullptr;
 };
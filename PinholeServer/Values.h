@@ -7,21 +7,91 @@
 #define HELPER_THROTTLE_COUNT		10			// Max number of times helper can crash in throttle period
 #define HELPER_THROTTLE_PERIOD		300000		// Crash throttle period for helper
 #define HELPER_RELAUNCH_DELAY		5000		// Delay before relaunching crashed helper
-#define INTERVAL_AUTOSAVE			600000		// How often settings are automatically saved
+#define INTERVAL_AUTOSAVE			600000		// How often the settings journal is compacted into the settings store
+#define INTERVAL_SETTINGSJOURNAL	2000		// How often changed settings are appended to the settings journal
+#define SIZE_SETTINGSJOURNAL		262144		// Settings journal size in bytes that triggers an early compaction
 #define INTERVAL_RESOURCECHECK		100000		// How often resources (disk/mem) is checked
 #define INTERVAL_HELPERSTARTDELAY	1000		// Milliseconds after PinholeHelper starts to start launching apps, gives a chance for helper to connect
+#define INTERVAL_HELPERKILLWAIT		200			// Milliseconds a previous PinholeHelper is given to exit before it is killed, the event loop waits for it
 #define INTERVAL_GUITIMEOUT			30			// Number of seconds to wait for x11/Login
 #define INTERVAL_APPHEARTBEAT		1000		// How often the application heartbeats itself to detect lockups
 #define INTERVAL_APPTIMEOUT			30000		// App lockup timeout
+#define INTERVAL_PRESENCEDELAY		250			// Delay to coalesce state changes before announcing them to listening consoles
+#define INTERVAL_PRESENCEKEEPALIVE	30000		// How often the announce is repeated to listening consoles when nothing changes
+#define INTERVAL_EVENTLOOPCHECK		500			// How often the main event loop lag is measured for metrics
+#define INTERVAL_DEFERREDSTART		60000		// Servers not needed to launch apps are started after this long if apps haven't launched
+#define INTERVAL_LAUNCHREADYCHECK	1000		// How often applications being launched are checked for the ready timeout
+#define INTERVAL_LAUNCHREADYTIMEOUT	60000		// Launched apps not ready after this long are treated as ready so dependent apps still start
+#define INTERVAL_TIMINGWHEELTICK	10			// Resolution of the timing wheel used for app heartbeat and terminate timeouts
+#define INTERVAL_SCHEDULECHECK		60000		// Longest wait between schedule checks, so system clock changes are noticed
+#define INTERVAL_SCHEDULECLOCKCHANGE	2000	// System clock changes bigger than this are logged
+#define INTERVAL_SCHEDULECATCHUP	10800000	// Events missed by the system clock going forward up to this far are still triggered
+#define INTERVAL_ALERTDISPATCHCHECK	5000		// How often held back alerts, digests and retries are checked
+#define INTERVAL_ALERTDEDUP			300000		// Identical alerts within this are sent once, then the number of repeats
+#define INTERVAL_ALERTRATEPERIOD	600000		// Period for the alert slot rate limit
+#define ALERT_RATELIMIT_COUNT		5			// Max messages an alert slot sends in the rate limit period, more are sent as a digest
+#define MAX_ALERTDIGEST				100			// Max alerts listed in one digest
+#define INTERVAL_ALERTSENDTIMEOUT	120000		// Alert deliveries with no result after this long have failed
+#define INTERVAL_ALERTRETRY			30000		// Delay before the first retry of a failed alert delivery, doubles each time
+#define INTERVAL_ALERTMAXRETRY		3600000		// Longest delay between retries of a failed alert delivery
+#define ALERT_MAXATTEMPTS			30			// Failed alert deliveries are given up after this many attempts
+#define INTERVAL_SMTPTIMEOUT		60000		// SMTP connections that don't reply to a command within this are closed
+#define SMTP_MAXMERGEDMESSAGES		50			// Max queued alert emails with the same text sent as one message
+#define MAX_ALERTRECENT				500			// Newest alerts kept in memory
+#define MAX_ALERTSEGMENTS			20			// Max alert store segment files, the oldest are deleted
+#define SIZE_ALERTSEGMENT			262144		// Alert store segment size in bytes that starts a new segment
+#define MAX_ALERTQUERY				5000		// Max alerts returned by one alert query
+#define INTERVAL_CAPTUREROTATECHECK	60000		// How often running console captures are checked for a new rotate period
+#define MAX_CAPTURESEGMENTS			10			// Rotated console output files kept per app, the oldest are deleted
+#define SIZE_CAPTUREPIPE			1048576		// Size asked for app console pipes and the most moved to the file at once
+#define SIZE_CAPTURECOMPRESSCHUNK	4194304		// Rotated console output files are compressed this many bytes at a time
+#define SIZE_CONSOLERECENT			65536		// Newest console output kept in memory per app
+#define SIZE_CONSOLEFOLLOW			262144		// Most followed console output sent at once, older output is skipped
+#define INTERVAL_CONSOLEFOLLOW		250			// How often new output of followed apps is sent to clients
+#define MAX_CONSOLEFOLLOWLINES		5000		// Most recent console output lines sent when a client starts following
+#define MAX_SEARCHTHREADS			2			// Log and console output searches run at once, more wait their turn
+#define SIZE_SEARCHCHUNK			1048576		// Files are searched this many bytes at a time
+#define SIZE_SEARCHLINE				4096		// Longer lines are cut short in search results
+#define SIZE_SEARCHRESULTS			4194304		// A search stops once its results are this big
+#define INTERVAL_SYSINFOHARDWARE	3600000		// How long system info that rarely changes (OS, CPUs, host name) is kept
+#define INTERVAL_SYSINFONETWORK		60000		// How long network, volume and user system info is kept
+#define INTERVAL_SYSINFOLOAD		10000		// How long memory and process system info is kept
+#define CGROUP_PERIOD				100000		// Microseconds the app cgroups' CPU quota is given for
+#define CGROUP_DEFAULTWEIGHT		100			// Kernel default CPU and IO weight, set when an app has none
+#define MAX_CGROUPKILLPASSES		10			// Times processes are killed one by one when cgroup.kill can't be used
+#define INTERVAL_CGROUPKILLPASS		10			// Milliseconds waited between those passes
+
+// System info sections
+#define SYSINFO_HOST				"host"
+#define SYSINFO_PINHOLE				"pinhole"
+#define SYSINFO_OS					"os"
+#define SYSINFO_MEMORY				"memory"
+#define SYSINFO_CPUS				"cpus"
+#define SYSINFO_INTERFACES			"interfaces"
+#define SYSINFO_ROUTES				"routes"
+#define SYSINFO_VOLUMES				"volumes"
+#define SYSINFO_PROCESSES			"processes"
+#define SYSINFO_USERS				"users"
+#define SYSINFO_UPDATED				"updated"
+
+// Application cgroups
+#define CGROUP_ROOT					"/sys/fs/cgroup"
+#define CGROUP_PINHOLE				"pinhole"			// Made under the root cgroup to hold the app cgroups when the server runs in the root
+#define CGROUP_SERVER				"pinhole-server"	// The server's own processes move here so its cgroup can hold the app cgroups
+#define CGROUP_APPPREFIX			"app-"				// Followed by the percent encoded app name
 
 #define ARG_RESETPASSWORD			"RESETPASSWORD"	// Command line argument to reset password
 
 #define FILENAME_LOGFILE			"pinholelog.txt"	// The base name of the log file
 #define FILENAME_ALERTLOG			"pinholealerts.txt"		// Log of alerts
+#define FILENAME_ALERTQUEUE			"alertqueue.json"	// Alert deliveries waiting to be retried
 #define FILENAME_KEYFILE			"host.key"	// The server encryption private key file name
 #define FILENAME_CERTFILE			"host.pem"	// The serevr encryption public key file name
+#define FILENAME_SETTINGSJOURNAL	"settings.journal"	// Settings changes not yet compacted into the settings store
+#define FILENAME_SETTINGSSNAPSHOT	"settings.snapshot"	// Binary copy of the settings store, read at startup instead of parsing it
 
 #define SUBDIR_APPOUTPUT			"appoutput/"	// Where app console output is stored
+#define SUBDIR_ALERTS				"alerts/"		// Where the alert store segments are stored
 
 #define PROP_SERVER_SALT			"salt"
 #define PROP_SERVER_HASH			"hash"
@@ -29,6 +99,7 @@
 #define PROPERTY_ADDRESS			"clientAddress"
 
 // Settings names and prefixes used when reading QSettings
+#define SETTINGS_SNAPSHOTID			"snapshotId"
 #define SETTINGS_APPLIST			"appList"
 #define SETTINGS_APPPREFIX			"app_"
 
@@ -12,6 +12,7 @@
 #include "ScheduleManager.h"
 #include "NovaServer.h"
 #include "HTTPServer.h"
+#include "Metrics.h"
 #include "Logger.h"
 #include "HelperLauncher.h"
 #include "PasswordReset.h"
@@ -19,6 +20,7 @@
 #include "GuiWaiter.h"
 #include "ResourceMonitor.h"
 #include "HeartbeatThread.h"
+#include "AppCgroup.h"
 #include "../common/DummyWindow.h"
 #include "../common/Utilities.h"
 #include "../common/Version.h"
@@ -30,7 +32,6 @@
 #include <QLibraryInfo>
 #include <QDir>
 #include <QMap>
-#include <QSettings>
 #include <QUuid>
 
 #include <iostream>
@@ -232,21 +233,28 @@ int main(int argc, char *argv[])
 	parser.process(application);
 	settings.setRunningAsService(parser.isSet(serviceOption));
 	settings.setNoGui(parser.isSet(noGuiOption));
+	// The service's unit delegates its cgroup, a server run by a user is in the user's session cgroup
+	AppCgroup::setDelegated(settings.runningAsService());
 
+	// Startup timeline, how long after startup each stage was reached
+	auto startupStage = [&](const QString& stage)
 	{
-		// Get or create server ID
-		QSharedPointer<QSettings> pSettings = settings.getScopedSettings();
-		if (!pSettings->isWritable())
-		{
-			Logger(LOG_ERROR) << QObject::tr("WARNING: SETTINGS ARE NOT WRITABLE, NO CHANGES TO CONFIGURATION WILL BE STORED");
-			Logger(LOG_ERROR) << pSettings->fileName();
-		}
+		Logger(LOG_EXTRA) << QObject::tr("Startup +%1 ms: %2").arg(settings.uptime()).arg(stage);
+	};
+
+	// Load settings, from the snapshot if it's current, and replay any changes
+	// journaled before an unclean exit
+	settings.openJournal();
+	startupStage(QObject::tr("Settings loaded"));
 
-		QString serverId = pSettings->value(VALUE_SERVERID, "").toString();
+	{
+		// Get or create server ID
+		QString serverId = settings.value(VALUE_SERVERID, "").toString();
 		if (serverId.isEmpty())
 		{
 			serverId = QUuid::createUuid().toString();
-			pSettings->setValue(VALUE_SERVERID, serverId);
+			settings.setValue(VALUE_SERVERID, serverId);
+			settings.flushJournal();
 			Logger(LOG_ALWAYS) << QObject::tr("Server ID created: %1").arg(serverId);
 		}
 		settings.setServerId(serverId);
@@ -289,6 +297,7 @@ int main(int argc, char *argv[])
 	ScheduleManager scheduleManager(&settings, &appManager, &groupManager,
 		&globalManager);
 	Logger(LOG_DEBUG) << "ScheduleManager created";
+	startupStage(QObject::tr("Managers created"));
 
 	// Status and locator interface
 	StatusInterface statusInterface(&settings, &alertManager, &appManager,
@@ -334,7 +343,7 @@ int main(int argc, char *argv[])
 
 	// HTTP server interface
 	HTTPServer httpServer(&settings, &appManager, &groupManager, &globalManager,
-		&scheduleManager);
+		&scheduleManager, &commandInterface);
 	Logger(LOG_DEBUG) << "HTTPServer created";
 
 	// Helper launcher, launches the helper executable
@@ -344,6 +353,7 @@ int main(int argc, char *argv[])
 	// Resource monitor, watches memory and disk space and generates alerts
 	ResourceMonitor resourceMonitor(&settings, &globalManager);
 	Logger(LOG_DEBUG) << "ResourceMonitor created";
+	startupStage(QObject::tr("Servers created"));
 
 	// Dummy window used to intercept window messages
 	DummyWindow dummyWindow;
@@ -372,9 +382,44 @@ int main(int argc, char *argv[])
 	// Allow ScheduleManager to generate alerts
 	QObject::connect(&scheduleManager, &ScheduleManager::generateAlert,
 		&alertManager, &AlertManager::generateAlert);
+	// Start applications as soon as the helper has connected
+	QObject::connect(&commandInterface, &CommandInterface::helperAuthenticated,
+		&helperLauncher, &HelperLauncher::helperAuthenticated);
 	// Start applications after helper is running
 	QObject::connect(&helperLauncher, &HelperLauncher::finishedStarting,
 		&appManager, &AppManager::start);
+
+	// Servers that aren't needed to get the startup applications running are
+	// started after them, or after a while if they never start
+	bool deferredStarted = false;
+	QTimer deferredStartTimer;
+	deferredStartTimer.setInterval(INTERVAL_DEFERREDSTART);
+	deferredStartTimer.setSingleShot(true);
+	auto startDeferred = [&]()
+	{
+		if (deferredStarted)
+			return;
+		deferredStarted = true;
+		deferredStartTimer.stop();
+
+		// Generates the key pair on first run
+		tcpServer.start();
+		multiplexServer.start();
+		novaServer.start();
+		httpServer.start();
+
+		startupStage(QObject::tr("Deferred servers started"));
+		Logger(LOG_ALWAYS) << QObject::tr("Startup completed in %1 ms").arg(settings.uptime());
+	};
+	QObject::connect(&deferredStartTimer, &QTimer::timeout,
+		startDeferred);
+	QObject::connect(&helperLauncher, &HelperLauncher::finishedStarting,
+		[&]()
+	{
+		startupStage(QObject::tr("Startup applications launched"));
+		// Let the launches get going first
+		QTimer::singleShot(0, startDeferred);
+	});
 	// Let alert manager send status messages
 	QObject::connect(&alertManager, &AlertManager::sendStatus,
 		&statusInterface, &StatusInterface::sendStatus);
@@ -396,8 +441,8 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	// Settings save functions
-	auto saveAllSettings = [&]()
+	// Settings save functions, only what changed since the last save is journaled
+	auto journalAllSettings = [&]()
 	{
 		commandInterface.writeSettings();
 		appManager.writeApplicationSettings();
@@ -405,9 +450,28 @@ int main(int argc, char *argv[])
 		scheduleManager.writeScheduleSettings();
 		globalManager.writeGlobalSettings();
 		alertManager.writeAlertSettings();
+		settings.flushJournal();
+	};
+	auto saveAllSettings = [&]()
+	{
+		journalAllSettings();
+		settings.compactJournal();
 	};
 
-	// Save all settings on a timer (in case app crashes)
+	// Journal changed settings soon after they change (in case app crashes)
+	QTimer journalSettingsTimer;
+	journalSettingsTimer.setInterval(INTERVAL_SETTINGSJOURNAL);
+	journalSettingsTimer.setSingleShot(false);
+	QObject::connect(&journalSettingsTimer, &QTimer::timeout,
+		[&]()
+	{
+		journalAllSettings();
+		if (settings.journalFull())
+			settings.compactJournal();
+	});
+	journalSettingsTimer.start();
+
+	// Fold the journal into the settings store on a timer
 	QTimer saveSettingsTimer;
 	saveSettingsTimer.setInterval(INTERVAL_AUTOSAVE);
 	saveSettingsTimer.setSingleShot(false);
@@ -415,6 +479,9 @@ int main(int argc, char *argv[])
 		saveAllSettings);
 	saveSettingsTimer.start();
 
+	// Track how long events wait behind a busy main loop
+	Metrics::startEventLoopMonitor();
+
 	QObject::connect(&application, &QCoreApplication::aboutToQuit,
 		[&]()
 		{
@@ -470,10 +537,17 @@ int main(int argc, char *argv[])
 		// Start servers with network components AFTER reporting service started
 		// Windows boot seems to stop if IP networking is attempted before service finishes starting??
 		udpServer.start();
-		tcpServer.start();
-		multiplexServer.start();
-		novaServer.start();
-		httpServer.start();
+		// The helper and local consoles connect through the TCP server, so start it
+		// now unless the key pair still has to be generated
+		if (tcpServer.loadKeys())
+			tcpServer.start();
+		startupStage(QObject::tr("Event loop started"));
+
+		// Applications aren't started without a GUI
+		if (settings.noGui())
+			startDeferred();
+		else
+			deferredStartTimer.start();
 
 		std::cout << "Server started, use CTRL-C quit..." << std::endl;
 		Logger(LOG_ALWAYS) << QObject::tr("Server started");
@@ -0,0 +1,241 @@
+/* DiscoveryPacket.cpp - Encoding of the UDP discovery/status packets */
+
+#include "DiscoveryPacket.h"
+#include "PinholeCommon.h"
+#include "../qmsgpack/msgpack.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// Binary command codes are the index in this list, never reorder
+static const QStringList s_commands =
+{
+	UDPCOMMAND_QUERY,
+	UDPCOMMAND_ANNOUNCE,
+	UDPCOMMAND_REDIRECT,
+	UDPCOMMAND_STATUS,
+	UDPCOMMAND_REDIRECTBATCH
+};
+
+// Order of the values following the command code for each command, only append
+static const QMap<QString, QStringList> s_fields =
+{
+	{ UDPCOMMAND_QUERY, { TAG_BATCH, TAG_SINCE, TAG_ENCODING } },
+	{ UDPCOMMAND_ANNOUNCE, { TAG_ID, TAG_MAC, TAG_NAME, TAG_ROLE, TAG_VERSION, TAG_OS, TAG_STATUS, TAG_PLATFORM } },
+	{ UDPCOMMAND_REDIRECT, { TAG_ID, TAG_ADDRESS, TAG_NAME, TAG_ROLE, TAG_VERSION, TAG_STATUS, TAG_PLATFORM, TAG_OS, TAG_PORT } },
+	{ UDPCOMMAND_STATUS, { TAG_ID, TAG_STATUS } },
+	{ UDPCOMMAND_REDIRECTBATCH, { TAG_SEQUENCE, TAG_FULL, TAG_PART, TAG_REMOVED, TAG_SERVERS } }
+};
+
+
+// Converts a msgpack value list back into a map of TAG_ values
+static QVariantMap decodeValueList(const QVariantList& list)
+{
+	if (list.isEmpty())
+		return QVariantMap();
+
+	int commandCode = list[0].toInt();
+	if (commandCode < 0 || commandCode >= s_commands.size())
+		return QVariantMap();
+
+	QString command = s_commands[commandCode];
+	const QStringList& fields = s_fields[command];
+
+	QVariantMap values;
+	values[TAG_COMMAND] = command;
+	// Newer senders may append values we don't know about yet
+	for (int n = 0; n < fields.size() && n + 1 < list.size(); n++)
+	{
+		if (list[n + 1].isValid())
+			values[fields[n]] = list[n + 1];
+	}
+
+	if (values.contains(TAG_SERVERS))
+	{
+		QVariantList servers;
+		for (const auto& server : values[TAG_SERVERS].toList())
+		{
+			servers.append(decodeValueList(server.toList()));
+		}
+		values[TAG_SERVERS] = servers;
+	}
+
+	return values;
+}
+
+
+// Returns the msgpack header of an array with count elements
+static QByteArray arrayHeader(int count)
+{
+	QByteArray header;
+	if (count < 16)
+	{
+		header.append(char(0x90 | count));
+	}
+	else
+	{
+		header.append(char(0xdc));
+		header.append(char((count >> 8) & 0xff));
+		header.append(char(count & 0xff));
+	}
+	return header;
+}
+
+
+// Returns the raw JSON token following a key without parsing the document,
+// only handles unescaped keys which is all we send
+static QByteArray jsonToken(const QByteArray& packet, const char* key)
+{
+	QByteArray quotedKey = QByteArray("\"") + key + "\"";
+	int pos = packet.indexOf(quotedKey);
+	if (pos < 0)
+		return QByteArray();
+	pos += quotedKey.size();
+
+	// Skip whitespace and the separator
+	bool separator = false;
+	while (pos < packet.size())
+	{
+		char c = packet[pos];
+		if (':' == c && !separator)
+			separator = true;
+		else if (' ' != c && '\t' != c && '\r' != c && '\n' != c)
+			break;
+		pos++;
+	}
+	if (!separator)
+		return QByteArray();
+
+	int end = pos;
+	if (end < packet.size() && '"' == packet[end])
+	{
+		end = packet.indexOf('"', end + 1);
+		if (end < 0)
+			return QByteArray();
+		end++;
+	}
+	else
+	{
+		while (end < packet.size() && ',' != packet[end] && '}' != packet[end] &&
+			' ' != packet[end] && '\r' != packet[end] && '\n' != packet[end])
+			end++;
+	}
+
+	return packet.mid(pos, end - pos);
+}
+
+
+QVariantMap DecodeDiscoveryPacket(const QByteArray& packet, int* encoding)
+{
+	if (packet.isEmpty())
+		return QVariantMap();
+
+	int packetEncoding = static_cast<unsigned char>(packet[0]);
+	if (packetEncoding > DISCOVERY_ENCODING_JSON && packetEncoding <= DISCOVERY_ENCODING_LATEST)
+	{
+		if (nullptr != encoding)
+			*encoding = packetEncoding;
+		return decodeValueList(MsgPack::unpack(packet.mid(1)).toList());
+	}
+
+	if (nullptr != encoding)
+		*encoding = DISCOVERY_ENCODING_JSON;
+
+	QJsonDocument jsonDoc = QJsonDocument::fromJson(packet);
+	if (jsonDoc.isNull())
+		return QVariantMap();
+
+	return jsonDoc.object().toVariantMap();
+}
+
+
+QByteArray EncodeDiscoveryPacket(const QVariantMap& values, int encoding)
+{
+	if (DISCOVERY_ENCODING_JSON == encoding)
+	{
+		return QJsonDocument(QJsonObject::fromVariantMap(values)).toJson(QJsonDocument::Compact);
+	}
+
+	QString command = values[TAG_COMMAND].toString();
+	QVariantList list;
+	list.append(s_commands.indexOf(command));
+	for (const auto& field : s_fields[command])
+	{
+		list.append(values.value(field));
+	}
+
+	// Trailing missing values don't need to be sent
+	while (list.size() > 1 && !list.last().isValid())
+	{
+		list.removeLast();
+	}
+
+	return char(encoding) + MsgPack::pack(list);
+}
+
+
+QByteArray EncodeRedirectBatch(const QVariantMap& header, const QList<QByteArray>& records, int encoding)
+{
+	QVariantMap headerValues = header;
+	headerValues[TAG_COMMAND] = UDPCOMMAND_REDIRECTBATCH;
+
+	if (DISCOVERY_ENCODING_JSON == encoding)
+	{
+		QByteArray packet = EncodeDiscoveryPacket(headerValues, encoding);
+		packet.chop(1);
+		packet += ",\"" TAG_SERVERS "\":[";
+		for (int n = 0; n < records.size(); n++)
+		{
+			if (0 != n)
+				packet += ',';
+			packet += records[n];
+		}
+		packet += "]}";
+		return packet;
+	}
+
+	// Values in field order followed by the server array, spliced in from the pre-encoded records
+	const QStringList& fields = s_fields[UDPCOMMAND_REDIRECTBATCH];
+	QByteArray packet(1, char(encoding));
+	packet += arrayHeader(fields.size() + 1);
+	packet += MsgPack::pack(s_commands.indexOf(UDPCOMMAND_REDIRECTBATCH));
+	for (const auto& field : fields)
+	{
+		if (TAG_SERVERS == field)
+			continue;
+		packet += MsgPack::pack(headerValues.value(field));
+	}
+	packet += arrayHeader(records.size());
+	for (const auto& record : records)
+	{
+		// Strip the encoding byte
+		packet += record.mid(1);
+	}
+	return packet;
+}
+
+
+bool IsDiscoveryQuery(const QByteArray& packet, int* acceptEncoding)
+{
+	if (packet.isEmpty())
+		return false;
+
+	int packetEncoding = static_cast<unsigned char>(packet[0]);
+	if (packetEncoding > DISCOVERY_ENCODING_JSON && packetEncoding <= DISCOVERY_ENCODING_LATEST)
+	{
+		// Binary queries are tiny, just decode them
+		QVariantMap values = DecodeDiscoveryPacket(packet);
+		if (UDPCOMMAND_QUERY != values[TAG_COMMAND].toString())
+			return false;
+		if (nullptr != acceptEncoding)
+			*acceptEncoding = qMin(qMax(packetEncoding, values[TAG_ENCODING].toInt()), DISCOVERY_ENCODING_LATEST);
+		return true;
+	}
+
+	if (jsonToken(packet, TAG_COMMAND) != "\"" UDPCOMMAND_QUERY "\"")
+		return false;
+
+	if (nullptr != acceptEncoding)
+		*acceptEncoding = qBound(DISCOVERY_ENCODING_JSON, jsonToken(packet, TAG_ENCODING).toInt(), DISCOVERY_ENCODING_LATEST);
+	return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+/* DiscoveryPacket.h - Encoding of the UDP discovery/status packets */
+
+#include <QVariantMap>
+
+// Discovery packets are either JSON objects (legacy) or a version byte
+// followed by a msgpack array of values in a fixed order per command
+#define DISCOVERY_ENCODING_JSON		0
+#define DISCOVERY_ENCODING_BINARY	1
+#define DISCOVERY_ENCODING_LATEST	DISCOVERY_ENCODING_BINARY
+
+// Decodes a JSON or binary discovery packet into a map of TAG_ values,
+// encoding receives the encoding of the packet. Returns an empty map if invalid.
+QVariantMap DecodeDiscoveryPacket(const QByteArray& packet, int* encoding = nullptr);
+
+// Encodes a map of TAG_ values as a discovery packet
+QByteArray EncodeDiscoveryPacket(const QVariantMap& values, int encoding);
+
+// Encodes a batched redirect packet from the header values and redirect
+// packets previously encoded with EncodeDiscoveryPacket in the same encoding
+QByteArray EncodeRedirectBatch(const QVariantMap& header, const QList<QByteArray>& records, int encoding);
+
+// Returns true if the packet is a query without building a JSON document,
+// acceptEncoding receives the highest encoding the sender understands
+bool IsDiscoveryQuery(const QByteArray& packet, int* acceptEncoding = nullptr);
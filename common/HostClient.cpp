@@ -266,6 +266,23 @@ void HostClient::getApplicationConsoleOutput(const QString& name) const
 }
 
 
+// Asks for the last lines of an app's console output, new output follows in consoleOutput
+void HostClient::followApplicationConsole(const QString& name, int lines) const
+{
+	QVariantList vlist;
+	vlist << CMD_COMMAND << GROUP_APP << CMD_APP_FOLLOWCONSOLE << name << lines;
+	sendVariantList(vlist);
+}
+
+
+void HostClient::unfollowApplicationConsole(const QString& name) const
+{
+	QVariantList vlist;
+	vlist << CMD_COMMAND << GROUP_APP << CMD_APP_UNFOLLOWCONSOLE << name;
+	sendVariantList(vlist);
+}
+
+
 void HostClient::startGroup(const QString& name) const
 {
 	QVariantList vlist;
@@ -456,6 +473,17 @@ void HostClient::retrieveLog(const QString& startDate, const QString& endDate) c
 }
 
 
+// Searches the log, or an app's console output when appName isn't empty, on the host
+void HostClient::searchLogs(const QString& appName, const QString& pattern, bool regularExpression, bool caseSensitive,
+	const QString& startDate, const QString& endDate, int level, int maxResults, int context) const
+{
+	QVariantList vlist;
+	vlist << CMD_COMMAND << GROUP_NONE << CMD_NONE_SEARCHLOGS << appName << pattern << regularExpression <<
+		caseSensitive << startDate << endDate << level << maxResults << context;
+	sendVariantList(vlist);
+}
+
+
 void HostClient::retrieveSystemInfo() const
 {
 	QVariantList vlist;
@@ -464,6 +492,14 @@ void HostClient::retrieveSystemInfo() const
 }
 
 
+void HostClient::retrieveSystemInfoMap() const
+{
+	QVariantList vlist;
+	vlist << CMD_COMMAND << GROUP_GLOBAL << CMD_GLOBAL_SYSINFOMAP;
+	sendVariantList(vlist);
+}
+
+
 void HostClient::retrieveAlertList() const
 {
 	QVariantList vlist;
@@ -472,6 +508,14 @@ void HostClient::retrieveAlertList() const
 }
 
 
+void HostClient::queryAlerts(qint64 sinceSequence, qint64 beforeSequence, int limit) const
+{
+	QVariantList vlist;
+	vlist << CMD_COMMAND << GROUP_ALERT << CMD_ALERT_QUERY << sinceSequence << beforeSequence << limit;
+	sendVariantList(vlist);
+}
+
+
 void HostClient::addAlertSlot(const QString& name) const
 {
 	QVariantList vlist;
@@ -568,6 +612,10 @@ void HostClient::serverDisconnect(void)
 	qDebug() << "Host disconnected";
 #endif
 	emit disconnected();
+
+	// Compression is agreed again when reconnected
+	m_compression = false;
+
 	// Reconnect
 	if (m_reconnect && !m_closing)
 	{
@@ -597,7 +645,9 @@ void HostClient::rx(void)
 			QByteArray sizeArray = m_socket->read(sizeof(uint32_t));
 			uint32_t size;
 			memcpy(&size, sizeArray.data(), sizeof(size));
-			dataLeft = qFromLittleEndian(size);
+			size = qFromLittleEndian(size);
+			dataLeft = size & FRAME_SIZEMASK;
+			dataCompressed = (size & FRAME_COMPRESSED) != 0;
 		}
 
 		QByteArray newdata = m_socket->read(dataLeft);
@@ -610,6 +660,9 @@ void HostClient::rx(void)
 			return;
 		}
 
+		if (dataCompressed)
+			data = UncompressFrameData(data);
+
 		// Parse as msgpack data
 		QVariant var = MsgPack::unpack(data);
 
@@ -694,6 +747,9 @@ void HostClient::rx(void)
 				m_hostName = message;
 				m_hostVersion = vlist[3].toString();
 
+				// Servers that understand compressed frames say so after the host id
+				m_compression = COMPRESSION_ZLIB == vlist.value(5).toString();
+
 				QVersionNumber serverVer = QVersionNumber::fromString(m_hostVersion);
 				if (serverVer >= QVersionNumber(QVector<int>({ 0, 7, 5 })))
 				{
@@ -798,20 +854,19 @@ void HostClient::rx(void)
 			QString command = vlist[3].toString();
 			emit commandControlWindow(pid, display, command);
 		}
+		else if (CMD_CONSOLEOUTPUT == command)
+		{
+			QString appName = vlist[1].toString();
+			QByteArray data = vlist[2].toByteArray();
+			emit consoleOutput(appName, data);
+		}
 	} while (m_socket->bytesAvailable());
 }
 
 
 void HostClient::sendVariantList(const QVariantList& vlist) const
 {
-	static QByteArray sizeArray(sizeof(uint32_t), 0);
-	QByteArray dataArray(MsgPack::pack(vlist));
-	uint32_t size = qToLittleEndian(dataArray.size());
-	memcpy(sizeArray.data(), &size, sizeof(size));
-	// Send size
-	m_socket->write(sizeArray);
-	// Send data
-	m_socket->write(dataArray);
+	m_socket->write(MakeFrame(MsgPack::pack(vlist), m_compression));
 	m_socket->flush();
 }
 
@@ -902,7 +957,8 @@ bool HostClient::getSharedPassword(QString& password) const
 QVariantList HostClient::makeAuthPacket(const QString& password)
 {
 	QVariantList vlist;
-	vlist << CMD_AUTH << QCoreApplication::applicationVersion() << QHostInfo::localHostName() << password << m_helperClient;
+	vlist << CMD_AUTH << QCoreApplication::applicationVersion() << QHostInfo::localHostName() << password << m_helperClient
+		<< QStringList({ COMPRESSION_ZLIB });
 	return vlist;
 }
 
@@ -37,6 +37,8 @@ public:
 	void deleteApplication(const QString& name) const;
 	void renameApplication(const QString& name, const QString& newName) const;
 	void getApplicationConsoleOutput(const QString& name) const;
+	void followApplicationConsole(const QString& name, int lines) const;
+	void unfollowApplicationConsole(const QString& name) const;
 	void startGroup(const QString& name) const;
 	void stopGroup(const QString& name) const;
 	void addGroup(const QString& name) const;
@@ -61,8 +63,12 @@ public:
 	void sendImportData(const QByteArray& importData) const;
 	void showScreenIds() const;
 	void retrieveLog(const QString& startDate, const QString& endDate) const;
+	void searchLogs(const QString& appName, const QString& pattern, bool regularExpression, bool caseSensitive,
+		const QString& startDate, const QString& endDate, int level, int maxResults, int context) const;
 	void retrieveSystemInfo() const;
+	void retrieveSystemInfoMap() const;
 	void retrieveAlertList() const;
+	void queryAlerts(qint64 sinceSequence, qint64 beforeSequence, int limit) const;
 	void addAlertSlot(const QString& name) const;
 	void deleteAlertSlot(const QString& name) const;
 	void renameAlertSlot(const QString& oldName, const QString& newName) const;
@@ -96,6 +102,7 @@ signals:
 	void commandScreenshot();
 	void commandShowScreenIds();
 	void commandControlWindow(int pid, const QString& display, const QString& command);
+	void consoleOutput(const QString& appName, const QByteArray& data);
 	void terminationRequested();
 
 private:
@@ -115,6 +122,8 @@ private:
 	bool m_helperClient = false;
 	QByteArray data;
 	uint32_t dataLeft = 0;
+	bool dataCompressed = false;
+	bool m_compression = false;			// Server accepted compressed frames
 	QString m_hostName;
 	QString m_hostVersion;
 	QSslSocket* m_socket = nullptr;
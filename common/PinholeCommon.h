@@ -14,21 +14,36 @@
 
 #define IPV6_MULTICAST			"FF02:0:0:0:0:0:0:175"
 #define HOST_UDPPORT			5457
+#define PRESENCE_UDPPORT		5459
 #define HOST_TCPPORT			5457
 #define HOST_QUERY_FREQ			2.0
 #define PROXY_TCPPORT			5458
 
+// Command protocol frames are a 32 bit little endian size and that much msgpack
+// data, the top bit of the size flags data compressed with qCompress
+#define FRAME_COMPRESSED		0x80000000u
+#define FRAME_SIZEMASK			0x7fffffffu
+#define FRAME_COMPRESSMIN		1024		// Smaller frames aren't worth compressing
+#define FRAME_MAXUNCOMPRESSED	268435456	// Compressed frames claiming to be bigger are refused
+#define COMPRESSION_ZLIB		"zlib"		// Frame compression offered and accepted in CMD_AUTH
+
 #define DEFAULT_APPLOOPBACKPORT	9999
 #define DEFAULT_TERMINATE_TO	200
 #define DEFAULT_HEARTBEAT_TO	5000
 #define DEFAULT_CRASHPERIOD		60
 #define DEFAULT_CRASHCOUNT		10
+#define DEFAULT_MAXLAUNCHES		4
 #define DEFAULT_HTTPPORT		8090
 #define DEFAULT_NOVATCPPORT		2000
 #define DEFAULT_NOVAUDPPORT		2002
 #define DEFAULT_NOVATCPADDRESS	""
 #define DEFAULT_SMTPPORT		587
 #define DEFAULT_SMTPUSER		"no-reply@obscuradigital.com"
+#define DEFAULT_SMTPIDLE		60
+#define DEFAULT_CONSOLEFOLLOWLINES	200
+#define DEFAULT_SEARCHRESULTS	100
+#define DEFAULT_SEARCHCONTEXT	2
+#define DEFAULT_IOPRIORITY		4
 
 //#define MIN_LISTENINGPORT		2049
 #define MIN_LISTENINGPORT		1
@@ -36,10 +51,24 @@
 #define MIN_HEARTBEATTIMEOUT	100
 #define MAX_HEARTBEATTIMEOUT	99999
 #define MAX_TERMINATETIMEOUT	120000
+#define MAX_SMTPIDLE			3600
+#define MAX_CAPTUREROTATESIZE	102400
+#define MAX_CAPTUREROTATEHOURS	8760
+#define MAX_SEARCHRESULTS		1000
+#define MAX_SEARCHCONTEXT		10
+#define MAX_CGROUPWEIGHT		10000
+#define MAX_CPUQUOTA			102400
+#define MAX_APPMEMORY			4194304
+#define MIN_NICE				-20
+#define MAX_NICE				19
+#define MAX_SCHEDPRIORITY		99
+#define MAX_IOPRIORITY			7
 #define MIN_CRASHPERIOD			5
 #define MAX_CRASHPERIOD			99999
 #define MIN_CRASHCOUNT			2
 #define MAX_CRASHCOUNT			99
+#define MIN_MAXLAUNCHES			1
+#define MAX_MAXLAUNCHES			99
 
 #define TAG_COMMAND				"command"
 #define TAG_ID					"ID"
@@ -52,11 +81,22 @@
 #define TAG_MAC					"MAC"
 #define TAG_ADDRESS				"address"
 #define TAG_PORT				"port"
+#define TAG_BATCH				"batch"		// Set in a query if the sender understands batched redirect responses
+#define TAG_SINCE				"since"		// Change sequence token of the last batched redirect response received
+#define TAG_SEQUENCE			"seq"		// Current change sequence token of the responder
+#define TAG_FULL				"full"		// True if a batched redirect response contains every server
+#define TAG_SERVERS				"servers"	// Array of redirect records in a batched redirect response
+#define TAG_REMOVED				"removed"	// Array of server IDs removed since the query's sequence token
+#define TAG_PART				"part"		// Index of a datagram within a batched redirect response
+#define TAG_ENCODING			"enc"		// Set in a query to the highest discovery packet encoding the sender understands
 
 #define UDPCOMMAND_QUERY		"query"
 #define UDPCOMMAND_ANNOUNCE		"announce"
 #define UDPCOMMAND_REDIRECT		"redir"
 #define UDPCOMMAND_STATUS		"status"
+#define UDPCOMMAND_REDIRECTBATCH	"redirs"
+
+#define UDP_SAFEPAYLOAD			1200	// Largest datagram payload that is not fragmented on any sane IPv4/IPv6 path
 
 #define CMD_NOOP				"nop"
 #define CMD_TERMINATE			"xxx"
@@ -75,6 +115,7 @@
 #define CMD_SCREENSHOT			"scr"
 #define CMD_SHOWSCREENIDS		"ids"
 #define CMD_CONTROLWINDOW		"win"
+#define CMD_CONSOLEOUTPUT		"out"
 
 #define CMD_RESPONSE_SUCCESS	0
 #define CMD_RESPONSE_ERROR		1
@@ -95,6 +136,7 @@
 #define CMD_NONE_EXPORTSETTINGS	"exportSettings"
 #define CMD_NONE_RETRIEVELOG	"getLog"
 #define CMD_NONE_LOGMESSAGE		"logMessage"
+#define CMD_NONE_SEARCHLOGS		"searchLogs"
 
 #define CMD_APP_ADDAPP			"addApp"
 #define CMD_APP_DELETEAPP		"delApp"
@@ -105,6 +147,8 @@
 #define CMD_APP_STOPAPPS		"stopApps"
 #define CMD_APP_STOPALLAPPS		"stopAllApps"
 #define CMD_APP_GETCONSOLE		"getConsole"
+#define CMD_APP_FOLLOWCONSOLE	"followConsole"
+#define CMD_APP_UNFOLLOWCONSOLE	"unfollowConsole"
 #define CMD_APP_EXECUTE			"execute"
 #define CMD_APP_STARTVARS		"startAppVars"
 
@@ -121,18 +165,36 @@
 #define PROP_APP_LOCKUPSCREENSHOT	"lockupScreenshot"
 #define PROP_APP_CONSOLECAPTURE	"consoleCapture"
 #define PROP_APP_APPENDCAPTURE	"appendCapture"
+#define PROP_APP_CAPTUREROTATESIZE	"captureRotateSize"
+#define PROP_APP_CAPTUREROTATEHOURS	"captureRotateHours"
+#define PROP_APP_CAPTURECOMPRESS	"captureCompress"
+#define PROP_APP_CGROUP			"cgroup"
+#define PROP_APP_CPUWEIGHT		"cpuWeight"
+#define PROP_APP_CPUQUOTA		"cpuQuota"
+#define PROP_APP_MEMORYHIGH		"memoryHigh"
+#define PROP_APP_MEMORYMAX		"memoryMax"
+#define PROP_APP_IOWEIGHT		"ioWeight"
+#define PROP_APP_CPUAFFINITY	"cpuAffinity"
+#define PROP_APP_NICE			"nice"
+#define PROP_APP_SCHEDPOLICY	"schedPolicy"
+#define PROP_APP_SCHEDPRIORITY	"schedPriority"
+#define PROP_APP_IOCLASS		"ioClass"
+#define PROP_APP_IOPRIORITY		"ioPriority"
 #define PROP_APP_LAUNCHDISPLAY	"launchDisplay"
 #define PROP_APP_LAUNCHDELAY	"launchDelay"
 #define PROP_APP_TCPLOOPBACK	"tcpLoopback"
 #define PROP_APP_TCPLOOPBACKPORT	"tcpLoopbackPort"
 #define PROP_APP_HEARTBEATS		"heartbeats"
 #define PROP_APP_ENVIRONMENT	"environment"
+#define PROP_APP_DEPENDENCIES	"dependencies"
 
 #define PROP_APP_LASTSTARTED	"lastStarted"
 #define PROP_APP_LASTEXITED		"lastExited"
 #define PROP_APP_RESTARTS		"restarts"
 #define PROP_APP_STATE			"state"
 #define PROP_APP_RUNNING		"running"
+#define PROP_APP_CPUSECONDS		"cpuSeconds"
+#define PROP_APP_MEMORYUSAGE	"memoryUsage"
 
 #define CMD_GROUP_ADDGROUP		"addGroup"
 #define CMD_GROUP_DELETEGROUP	"delGroup"
@@ -148,6 +210,7 @@
 #define CMD_GLOBAL_SHUTDOWN		"shutdown"
 #define CMD_GLOBAL_REBOOT		"reboot"
 #define CMD_GLBOAL_SYSINFO		"sysinfo"
+#define CMD_GLOBAL_SYSINFOMAP	"sysinfoMap"
 
 #define PROP_GLOBAL_ROLE		"role"
 #define PROP_GLOBAL_REMOTELOGLEVEL	"remoteLogLevel"
@@ -156,6 +219,7 @@
 #define PROP_GLOBAL_HEARTBEATTIMEOUT	"heatbeatTimeout"
 #define PROP_GLOBAL_CRASHPERIOD	"crashPeriod"
 #define PROP_GLOBAL_CRASHCOUNT	"crashCount"
+#define PROP_GLOBAL_MAXLAUNCHES	"maxLaunches"
 #define PROP_GLOBAL_TRAYCONTROL	"trayControl"
 #define PROP_GLOBAL_TRAYLAUNCH	"trayLaunch"
 #define PROP_GLOBAL_HTTPENABLED		"httpEnabled"
@@ -188,6 +252,7 @@
 #define PROP_SCHED_ARGUMENTS	"schedArgs"
 #define PROP_SCHED_OFFSET		"offset"
 #define PROP_SCHED_LASTTRIGGERED	"lastTriggered"
+#define PROP_SCHED_CRON			"cron"
 
 #define SCHED_TYPE_STARTAPPS	"startApps"
 #define SCHED_TYPE_STOPAPPS		"stopApps"
@@ -205,6 +270,7 @@
 #define SCHED_FREQ_DAILY		"daily"
 #define SCHED_FREQ_HOURLY		"hourly"
 #define SCHED_FREQ_ONCE			"once"
+#define SCHED_FREQ_CRON			"cron"
 
 #define PROP_ALERT_ALERTCOUNT	"alertCount"
 #define PROP_ALERT_SMTPSERVER	"smptServer"
@@ -215,6 +281,7 @@
 #define PROP_ALERT_SMTPPASS		"smptPass"
 #define PROP_ALERT_SMTPEMAIL	"smptEmail"
 #define PROP_ALERT_SMTPNAME		"smptName"
+#define PROP_ALERT_SMTPIDLE		"smtpIdle"
 #define PROP_ALERT_SLOTLIST		"alertSlotList"
 #define PROP_ALERT_SLOTNAME		"alertSlotName"
 #define PROP_ALERT_SLOTENABLED	"alertSlotEnabled"
@@ -226,6 +293,9 @@
 #define CMD_ALERT_RENAMESLOT	"renAlertSlot"
 #define CMD_ALERT_RESETCOUNT	"resetAlerts"
 #define CMD_ALERT_RETRIEVELIST	"getAlerts"
+#define CMD_ALERT_QUERY			"queryAlerts"	// Returns [first sequence, last sequence, [[sequence, msecs since epoch, text], ...]]
+
+#define ALERT_PAGESIZE			500
 
 #define ALERTSLOT_TYPE_SMPTEMAIL	"smtpEmail"
 #define ALERTSLOT_TYPE_HTTPGET		"httpGet"
@@ -253,6 +323,17 @@
 #define DISPLAY_MINIMIZE		"minimize"
 #define DISPLAY_MAXIMIZE		"maximize"
 
+#define SCHEDPOLICY_NORMAL		"normal"
+#define SCHEDPOLICY_BATCH		"batch"
+#define SCHEDPOLICY_IDLE		"idle"
+#define SCHEDPOLICY_FIFO		"fifo"
+#define SCHEDPOLICY_RR			"rr"
+
+#define IOCLASS_NONE			"none"
+#define IOCLASS_REALTIME		"realtime"
+#define IOCLASS_BESTEFFORT		"besteffort"
+#define IOCLASS_IDLE			"idle"
+
 #define NOVA_CMD_SWITCH_APP		"switch_app"	// Switch between apps in a group
 #define NOVA_CMD_START_APP		"start_app"		// Start an app, can be semicolon seperated list
 #define NOVA_CMD_START_APP_VARS	"start_app_vars"	// Start an app with variables
@@ -11,6 +11,7 @@
 #include <QSslKey>
 #include <QDir>
 #include <QCoreApplication>
+#include <QtEndian>
 
 #include <openssl/crypto.h>
 #include <openssl/evp.h>
@@ -275,23 +276,27 @@ class ProcessnameEquals
 public:
 	ProcessnameEquals(const QString &name)
 #ifdef Q_OS_WIN
-		: m_name(name.toLower())
+		: m_name(name.toLower()), m_nativeName(QDir::toNativeSeparators(m_name)),
 #else
-		: m_name(name)
+		: m_name(name),
 #endif
+		// A path can't be a file name, so there's no need to split every process name
+		m_path(name.contains('/') || name.contains(QDir::separator()))
 	{}
 
 	bool operator()(const ProcessInfo &info)
 	{
 #ifdef Q_OS_WIN
 		const QString infoName = info.name.toLower();
-		if (infoName == QDir::toNativeSeparators(m_name))
+		if (infoName == m_nativeName)
 			return true;
 #else
-		const QString infoName = info.name;
+		const QString& infoName = info.name;
 #endif
 		if (infoName == m_name)
 			return true;
+		if (m_path)
+			return false;
 
 		const QFileInfo fi(infoName);
 		if (fi.fileName() == m_name || fi.baseName() == m_name)
@@ -301,6 +306,10 @@ public:
 
 private:
 	QString m_name;
+#ifdef Q_OS_WIN
+	QString m_nativeName;
+#endif
+	bool m_path = false;
 };
 
 
@@ -315,9 +324,9 @@ bool IsThisProgramAlreadyRunning()
 
 quint32 findProcessWithPath(const QString& name)
 {
+	ProcessnameEquals p(name);
 	for (const auto& proc : runningProcesses())
 	{
-		ProcessnameEquals p(name);
 		if (p(proc))
 			return proc.id;
 	}
@@ -560,3 +569,43 @@ void modifyJsonValue(QJsonValue& destValue, const QString& path, const QJsonValu
 		destValue = newValue;
 }
 
+
+
+// Returns a command protocol frame of msgpack data, compressed if asked and worth it
+QByteArray MakeFrame(const QByteArray& data, bool compress)
+{
+	QByteArray frame(sizeof(quint32), 0);
+	qToLittleEndian<quint32>(data.size(), reinterpret_cast<uchar*>(frame.data()));
+	frame += data;
+	return compress ? CompressFrame(frame) : frame;
+}
+
+
+// Returns a frame compressed if it's worth it, or the frame as it is
+QByteArray CompressFrame(const QByteArray& frame)
+{
+	const uchar* header = reinterpret_cast<const uchar*>(frame.constData());
+	int size = frame.size() - static_cast<int>(sizeof(quint32));
+	if (size < FRAME_COMPRESSMIN || (qFromLittleEndian<quint32>(header) & FRAME_COMPRESSED))
+		return frame;
+
+	QByteArray compressed = qCompress(header + sizeof(quint32), size);
+	if (compressed.size() >= size)
+		return frame;
+
+	QByteArray compressedFrame(sizeof(quint32), 0);
+	qToLittleEndian<quint32>(compressed.size() | FRAME_COMPRESSED, reinterpret_cast<uchar*>(compressedFrame.data()));
+	return compressedFrame + compressed;
+}
+
+
+// Returns the data of a compressed frame, empty if it's bad
+QByteArray UncompressFrameData(const QByteArray& data)
+{
+	// qCompress puts the uncompressed size first, big endian
+	if (data.size() < static_cast<int>(sizeof(quint32)) ||
+		qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data.constData())) > FRAME_MAXUNCOMPRESSED)
+		return QByteArray();
+
+	return qUncompress(data);
+}
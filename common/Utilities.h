@@ -14,6 +14,7 @@ inline size_t countof(T(&)[N])
 }
 
 class QSslCertificate;
+class QFile;
 class QSslKey;
 class QHostAddress;
 class QJsonObject;
@@ -92,3 +93,18 @@ bool IsProcessRunning(qint64 pid);
 
 // Modifies a nested JSON value
 void modifyJsonValue(QJsonValue& destValue, const QString& path, const QJsonValue& newValue);
+
+// Flushes a file and waits for the OS to write it to disk
+bool SyncFileToDisk(QFile& file);
+
+// Waits for the OS to write a directory's entries to disk, so files renamed into it survive power loss
+bool SyncDirectoryToDisk(const QString& path);
+
+// Returns a command protocol frame of msgpack data, compressed if asked and worth it
+QByteArray MakeFrame(const QByteArray& data, bool compress);
+
+// Returns a frame compressed if it's worth it, or the frame as it is
+QByteArray CompressFrame(const QByteArray& frame);
+
+// Returns the data of a compressed frame, empty if it's bad
+QByteArray UncompressFrameData(const QByteArray& data);
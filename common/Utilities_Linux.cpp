@@ -3,6 +3,7 @@
 #if (defined(Q_OS_UNIX)) && !defined(Q_OS_MAC)
 
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QDebug>
 
@@ -12,10 +13,136 @@
 #include <sys/stat.h>
 #include <signal.h>
 #include <unistd.h>
+#include <fcntl.h>
 #ifdef Q_OS_FREEBSD
 #include <sys/sysctl.h>
 #endif
+#if defined(Q_OS_LINUX)
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QThread>
 
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+#if defined(Q_OS_LINUX)
+// Processes are found by reading /proc with getdents64 and readlinkat, which
+// only makes a QString for processes that have an executable. Starting a group
+// of apps that terminate previous instances looks for processes once per app,
+// so a scan is reused by every lookup for a short time.
+
+#define SIZE_PROCDIRBUFFER			32768
+#define INTERVAL_PROCESSSNAPSHOT	1000	// Milliseconds a scan of /proc is reused
+
+// Directory entry returned by getdents64, glibc only wraps the syscall from 2.30
+struct LinuxDirent64
+{
+	quint64 d_ino;
+	qint64 d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[1];
+};
+
+static QMutex s_processSnapshotMutex;
+static QList<ProcessInfo> s_processSnapshot;
+static QElapsedTimer s_processSnapshotAge;
+
+
+static QList<ProcessInfo> scanProcesses()
+{
+	QList<ProcessInfo> processes;
+	int procFd = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (-1 == procFd)
+		return processes;
+
+	alignas(LinuxDirent64) char buffer[SIZE_PROCDIRBUFFER];
+	char linkPath[32];
+	char target[PATH_MAX];
+	long count;
+	while ((count = ::syscall(SYS_getdents64, procFd, buffer, sizeof(buffer))) > 0)
+	{
+		for (long pos = 0; pos < count;)
+		{
+			const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(buffer + pos);
+			pos += entry->d_reclen;
+
+			// Processes are the directories named by their pid
+			if (DT_DIR != entry->d_type || entry->d_name[0] < '1' || entry->d_name[0] > '9')
+				continue;
+			char* end;
+			unsigned long pid = strtoul(entry->d_name, &end, 10);
+			if ('\0' != *end)
+				continue;
+
+			// Kernel threads have no executable and other users' processes can't be read,
+			// executables deleted since they started can't be the one looked for
+			snprintf(linkPath, sizeof(linkPath), "%s/exe", entry->d_name);
+			ssize_t length = ::readlinkat(procFd, linkPath, target, sizeof(target));
+			if (length <= 0 || length >= static_cast<ssize_t>(sizeof(target)) ||
+				(length > 10 && 0 == memcmp(target + length - 10, " (deleted)", 10)))
+				continue;
+
+			ProcessInfo processInfo;
+			processInfo.id = static_cast<quint32>(pid);
+			processInfo.name = QFile::decodeName(QByteArray::fromRawData(target, static_cast<int>(length)));
+			processes.append(processInfo);
+		}
+	}
+
+	::close(procFd);
+	return processes;
+}
+
+
+QList<ProcessInfo> runningProcesses()
+{
+	QMutexLocker locker(&s_processSnapshotMutex);
+	if (!s_processSnapshotAge.isValid() || s_processSnapshotAge.elapsed() >= INTERVAL_PROCESSSNAPSHOT)
+	{
+		s_processSnapshot = scanProcesses();
+		s_processSnapshotAge.start();
+	}
+	return s_processSnapshot;
+}
+
+
+// Killed processes are taken out of the reused scan so they aren't found again
+static void forgetProcess(quint32 id)
+{
+	QMutexLocker locker(&s_processSnapshotMutex);
+	for (int n = 0; n < s_processSnapshot.size(); n++)
+	{
+		if (s_processSnapshot[n].id == id)
+		{
+			s_processSnapshot.removeAt(n);
+			break;
+		}
+	}
+}
+
+
+// Asks the process to terminate and waits for it like on Windows, then makes sure
+bool killProcess(quint32 id, int msecs)
+{
+	::kill(id, SIGTERM);
+
+	QElapsedTimer timer;
+	timer.start();
+	while (IsProcessRunning(id) && timer.elapsed() < msecs)
+		QThread::msleep(10);
+	if (IsProcessRunning(id))
+		::kill(id, SIGKILL);
+
+	forgetProcess(id);
+	return true;
+}
+#else
 QList<ProcessInfo> runningProcesses()
 {
 	QList<ProcessInfo> processes;
@@ -44,6 +171,7 @@ bool killProcess(quint32 id, int msecs)
 	::kill(id, SIGTERM);
 	return true;
 }
+#endif
 
 /*
 bool MemoryInformation(unsigned long long& totalMemory, unsigned long long& freeMemory)
@@ -67,4 +195,23 @@ bool IsProcessRunning(qint64 pid)
 	return 0 == ::kill((pid_t)pid, 0);
 }
 
+
+bool SyncFileToDisk(QFile& file)
+{
+	if (!file.flush())
+		return false;
+	return 0 == ::fdatasync(file.handle());
+}
+
+
+bool SyncDirectoryToDisk(const QString& path)
+{
+	int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY);
+	if (-1 == fd)
+		return false;
+	bool ok = 0 == ::fsync(fd);
+	::close(fd);
+	return ok;
+}
+
 #endif
@@ -7,6 +7,9 @@
 #include <sys/sysctl.h>
 #include <sys/types.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <QFile>
 
 #include <QtCore/QList>
 
@@ -112,4 +115,26 @@ bool IsProcessRunning(qint64 pid)
 	return 0 == ::kill((pid_t)pid, 0);
 }
 
+
+bool SyncFileToDisk(QFile& file)
+{
+	if (!file.flush())
+		return false;
+	// fsync() on macOS doesn't make the drive flush its cache
+	if (-1 != ::fcntl(file.handle(), F_FULLFSYNC))
+		return true;
+	return 0 == ::fsync(file.handle());
+}
+
+
+bool SyncDirectoryToDisk(const QString& path)
+{
+	int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY);
+	if (-1 == fd)
+		return false;
+	bool ok = 0 == ::fsync(fd);
+	::close(fd);
+	return ok;
+}
+
 #endif
@@ -3,9 +3,11 @@
 #if defined(Q_OS_WIN32)
 
 #include <QLibrary>
+#include <QFile>
 
 #include <Windows.h>
 #include <Tlhelp32.h>
+#include <io.h>
 
 const int KDSYSINFO_PROCESS_QUERY_LIMITED_INFORMATION = 0x1000;
 
@@ -184,6 +186,21 @@ bool IsProcessRunning(qint64 pid)
 	return true;
 }
 
+
+bool SyncFileToDisk(QFile& file)
+{
+	if (!file.flush())
+		return false;
+	return FALSE != FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle())));
+}
+
+
+bool SyncDirectoryToDisk(const QString&)
+{
+	// NTFS journals renames itself, directories can't be flushed without backup privileges
+	return true;
+}
+
 #endif
 
 
@@ -0,0 +1,91 @@
+#include "Utilities.h"
+#include "PinholeCommon.h"
+#include "../../qmsgpack/msgpack.h"
+
+#include <QtTest>
+
+// Times sending one broadcast to every client that accepts compression, with
+// the frame compressed for each client as before or once and shared as
+// CommandInterface::clientFrame() does now.
+
+// Console output of an app, the broadcast most worth compressing
+static QVariantList consoleOutput(int size)
+{
+	QByteArray output;
+	for (int line = 0; output.size() < size; line++)
+	{
+		output += QString("2026-06-10 10:15:%1 [info] Frame %2 rendered in 16.%3 ms, %4 sprites\n")
+			.arg(line % 60, 2, 10, QChar('0'))
+			.arg(line)
+			.arg(line % 10)
+			.arg(100 + line % 37)
+			.toUtf8();
+	}
+	output.truncate(size);
+
+	QVariantList vlist;
+	vlist << CMD_CONSOLEOUTPUT << "Exhibit" << output;
+	return vlist;
+}
+
+
+class BroadcastBenchmark : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void compress_data();
+	void compress();
+};
+
+
+void BroadcastBenchmark::compress_data()
+{
+	QTest::addColumn<int>("size");
+	QTest::addColumn<int>("clients");
+	QTest::addColumn<bool>("once");
+
+	for (int size : { 4096, 65536 })
+	{
+		for (int clients : { 1, 10, 50 })
+		{
+			QTest::newRow(qPrintable(QString("%1 bytes to %2 clients, per client").arg(size).arg(clients)))
+				<< size << clients << false;
+			QTest::newRow(qPrintable(QString("%1 bytes to %2 clients, once").arg(size).arg(clients)))
+				<< size << clients << true;
+		}
+	}
+}
+
+
+void BroadcastBenchmark::compress()
+{
+	QFETCH(int, size);
+	QFETCH(int, clients);
+	QFETCH(bool, once);
+
+	// Packed once per broadcast either way
+	QByteArray frame = MakeFrame(MsgPack::pack(consoleOutput(size)), false);
+
+	qint64 sent = 0;
+	QBENCHMARK
+	{
+		sent = 0;
+		QByteArray compressed;
+		for (int client = 0; client < clients; client++)
+		{
+			if (!once || compressed.isEmpty())
+				compressed = CompressFrame(frame);
+			sent += compressed.size();
+		}
+	}
+
+	QByteArray compressed = CompressFrame(frame);
+	QVERIFY(compressed.size() < frame.size());
+	QCOMPARE(sent, static_cast<qint64>(compressed.size()) * clients);
+	QCOMPARE(UncompressFrameData(compressed.mid(sizeof(quint32))), frame.mid(sizeof(quint32)));
+}
+
+
+QTEST_GUILESS_MAIN(BroadcastBenchmark)
+#include "BroadcastBenchmark.moc"
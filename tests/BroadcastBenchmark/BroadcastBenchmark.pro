@@ -0,0 +1,6 @@
+TARGET = BroadcastBenchmark
+include(../tests.pri)
+include(../utilities.pri)
+
+INCLUDEPATH += ../../common
+SOURCES += ./BroadcastBenchmark.cpp
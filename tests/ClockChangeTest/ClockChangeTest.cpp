@@ -0,0 +1,175 @@
+#include "ScheduleQueue.h"
+#include "TimePeriodCount.h"
+
+#include <QtTest>
+
+// Wall and monotonic clocks that only move when the test moves them. The wall
+// clock follows the monotonic clock plus however far the system clock was changed.
+struct FakeClock
+{
+	QDateTime start;
+	qint64 elapsed = 0;
+	qint64 change = 0;
+
+	QDateTime wallClock() const { return start.addMSecs(elapsed + change); }
+	MonotonicTime monotonicClock() const { return MonotonicTime::fromMSecs(elapsed); }
+};
+
+
+class ClockChangeTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void init();
+	void forwardJump();
+	void backwardJump();
+	void farForwardJump();
+	void timePeriodCount();
+
+private:
+	ScheduleQueue* newQueue();
+	void addEvent(const QString& name, const QString& frequency, int offset, const QString& cron = QString());
+	void run(qint64 msecs);
+
+	FakeClock m_clock;
+	ScheduleQueue::EventMap m_events;
+	QSharedPointer<ScheduleQueue> m_queue;
+};
+
+
+void ClockChangeTest::init()
+{
+	m_clock = FakeClock();
+	m_clock.start = QDateTime(QDate(2026, 6, 10), QTime(9, 55));
+	m_queue.clear();
+	m_events.clear();
+	addEvent("quarter", SCHED_FREQ_CRON, 0, "*/15 * * * *");
+	addEvent("hourly", SCHED_FREQ_HOURLY, 0);
+}
+
+
+ScheduleQueue* ClockChangeTest::newQueue()
+{
+	m_queue.reset(new ScheduleQueue(m_events,
+		[this]() { return m_clock.wallClock(); },
+		[this]() { return m_clock.monotonicClock(); }));
+	m_queue->scheduleAllEvents();
+	return m_queue.data();
+}
+
+
+void ClockChangeTest::addEvent(const QString& name, const QString& frequency, int offset, const QString& cron)
+{
+	QSharedPointer<ScheduleEvent> event = QSharedPointer<ScheduleEvent>::create(name);
+	event->setFrequency(frequency);
+	event->setOffset(offset);
+	event->setCron(cron);
+	m_events[name] = event;
+}
+
+
+// Moves both clocks on a second at a time, waking the queue the way its timer does
+void ClockChangeTest::run(qint64 msecs)
+{
+	for (qint64 step = 0; step < msecs; step += 1000)
+	{
+		m_clock.elapsed += 1000;
+		m_queue->triggerTimerCallback();
+	}
+}
+
+
+// Setting the clock forward an hour triggers each missed event once, not once for every time it missed
+void ClockChangeTest::forwardJump()
+{
+	newQueue();
+	QSignalSpy quarter(m_events["quarter"].data(), &ScheduleEvent::triggered);
+	QSignalSpy hourly(m_events["hourly"].data(), &ScheduleEvent::triggered);
+
+	run(20 * 60 * 1000);				// 10:00 and 10:15
+	QCOMPARE(quarter.count(), 2);
+	QCOMPARE(hourly.count(), 1);
+
+	m_clock.change += 60 * 60 * 1000;	// 11:15, 10:30 to 11:15 and 11:00 were missed
+	run(1000);
+	QCOMPARE(quarter.count(), 3);
+	QCOMPARE(hourly.count(), 2);
+
+	run(15 * 60 * 1000);				// 11:30
+	QCOMPARE(quarter.count(), 4);
+	QCOMPARE(hourly.count(), 2);
+}
+
+
+// Setting the clock back an hour doesn't trigger the times already triggered again
+void ClockChangeTest::backwardJump()
+{
+	newQueue();
+	QSignalSpy quarter(m_events["quarter"].data(), &ScheduleEvent::triggered);
+	QSignalSpy hourly(m_events["hourly"].data(), &ScheduleEvent::triggered);
+
+	run(20 * 60 * 1000);				// 10:00 and 10:15
+	QCOMPARE(quarter.count(), 2);
+	QCOMPARE(hourly.count(), 1);
+
+	m_clock.change -= 60 * 60 * 1000;	// 09:15
+	run(60 * 60 * 1000);				// Back to 10:15
+	QCOMPARE(quarter.count(), 2);
+	QCOMPARE(hourly.count(), 1);
+
+	run(15 * 60 * 1000);				// 10:30
+	QCOMPARE(quarter.count(), 3);
+	QCOMPARE(hourly.count(), 1);
+}
+
+
+// Events missed by the clock going forward further than INTERVAL_SCHEDULECATCHUP are skipped
+void ClockChangeTest::farForwardJump()
+{
+	newQueue();
+	QSignalSpy quarter(m_events["quarter"].data(), &ScheduleEvent::triggered);
+	QSignalSpy hourly(m_events["hourly"].data(), &ScheduleEvent::triggered);
+
+	run(20 * 60 * 1000);				// 10:00 and 10:15
+	QCOMPARE(quarter.count(), 2);
+
+	m_clock.change += 4 * 60 * 60 * 1000;	// 14:15
+	run(1000);
+	QCOMPARE(quarter.count(), 2);
+	QCOMPARE(hourly.count(), 1);
+
+	run(15 * 60 * 1000);				// 14:30
+	QCOMPARE(quarter.count(), 3);
+	QCOMPARE(hourly.count(), 1);
+}
+
+
+// Crash counting follows the monotonic clock, changing the system clock neither
+// empties the period nor stretches it
+void ClockChangeTest::timePeriodCount()
+{
+	TimePeriodCount count(5, [this]() { return m_clock.monotonicClock(); });
+	const qint64 period = 60 * 1000;
+
+	QCOMPARE(count.increment(period), 1);
+
+	m_clock.elapsed += 20 * 1000;
+	m_clock.change -= 60 * 60 * 1000;
+	QCOMPARE(count.increment(period), 2);
+
+	m_clock.elapsed += 20 * 1000;
+	m_clock.change += 2 * 60 * 60 * 1000;
+	QCOMPARE(count.increment(period), 3);
+
+	// The first is now more than a period ago
+	m_clock.elapsed += 21 * 1000;
+	QCOMPARE(count.increment(period), 3);
+
+	m_clock.elapsed += 69 * 1000;
+	QCOMPARE(count.increment(period), 1);
+}
+
+
+QTEST_GUILESS_MAIN(ClockChangeTest)
+#include "ClockChangeTest.moc"
@@ -0,0 +1,14 @@
+TARGET = ClockChangeTest
+include(../tests.pri)
+
+HEADERS += ../../PinholeServer/Logger.h \
+    ../../PinholeServer/CronExpression.h \
+    ../../PinholeServer/MonotonicTime.h \
+    ../../PinholeServer/ScheduleEvent.h \
+    ../../PinholeServer/ScheduleQueue.h \
+    ../../PinholeServer/TimePeriodCount.h
+SOURCES += ./ClockChangeTest.cpp \
+    ../common/LoggerStub.cpp \
+    ../../PinholeServer/CronExpression.cpp \
+    ../../PinholeServer/ScheduleEvent.cpp \
+    ../../PinholeServer/ScheduleQueue.cpp
@@ -0,0 +1,200 @@
+#include "DiscoveryPacket.h"
+#include "PinholeCommon.h"
+
+#include <QtTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// Compares the JSON and binary discovery encodings on the packets servers send
+// most: announcements, redirect batches from the backend and query detection.
+
+static QVariantMap announceValues()
+{
+	QVariantMap values;
+	values[TAG_COMMAND] = UDPCOMMAND_ANNOUNCE;
+	values[TAG_ID] = "{3f2504e0-4f89-11d3-9a0c-0305e82c3301}";
+	values[TAG_MAC] = "00:1a:2b:3c:4d:5e";
+	values[TAG_NAME] = "exhibit-kiosk-07";
+	values[TAG_ROLE] = "Kiosk";
+	values[TAG_VERSION] = "1.5.0";
+	values[TAG_OS] = "Ubuntu 18.04.5 LTS";
+	values[TAG_STATUS] = "3 apps running";
+	values[TAG_PLATFORM] = "UNI";
+	return values;
+}
+
+
+static QVariantMap redirectValues(int n)
+{
+	QVariantMap values;
+	values[TAG_COMMAND] = UDPCOMMAND_REDIRECT;
+	values[TAG_ID] = QString("{3f2504e0-4f89-11d3-9a0c-%1}").arg(n, 12, 10, QChar('0'));
+	values[TAG_ADDRESS] = QString("10.0.%1.%2").arg(n / 250).arg(n % 250 + 1);
+	values[TAG_NAME] = QString("exhibit-kiosk-%1").arg(n);
+	values[TAG_ROLE] = "Kiosk";
+	values[TAG_VERSION] = "1.5.0";
+	values[TAG_STATUS] = "Idle 2 minutes";
+	values[TAG_PLATFORM] = "UNI";
+	values[TAG_OS] = "Ubuntu 18.04.5 LTS";
+	values[TAG_PORT] = HOST_TCPPORT;
+	return values;
+}
+
+
+static QByteArray redirectBatch(int encoding)
+{
+	QList<QByteArray> records;
+	for (int n = 0; n < 50; n++)
+	{
+		records.append(EncodeDiscoveryPacket(redirectValues(n), encoding));
+	}
+
+	QVariantMap header;
+	header[TAG_SEQUENCE] = 1234;
+	header[TAG_FULL] = true;
+	header[TAG_PART] = 0;
+	return EncodeRedirectBatch(header, records, encoding);
+}
+
+
+class DiscoveryBenchmark : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void packetSize();
+	void encodeAnnounce_data();
+	void encodeAnnounce();
+	void decodeAnnounce_data();
+	void decodeAnnounce();
+	void decodeRedirectBatch_data();
+	void decodeRedirectBatch();
+	void detectQuery_data();
+	void detectQuery();
+
+private:
+	void addEncodingColumn();
+};
+
+
+void DiscoveryBenchmark::addEncodingColumn()
+{
+	QTest::addColumn<int>("encoding");
+
+	QTest::newRow("json") << DISCOVERY_ENCODING_JSON;
+	QTest::newRow("binary") << DISCOVERY_ENCODING_BINARY;
+}
+
+
+// The binary encoding leaves out the key names, so it has to be smaller
+void DiscoveryBenchmark::packetSize()
+{
+	QByteArray jsonAnnounce = EncodeDiscoveryPacket(announceValues(), DISCOVERY_ENCODING_JSON);
+	QByteArray binaryAnnounce = EncodeDiscoveryPacket(announceValues(), DISCOVERY_ENCODING_BINARY);
+	QByteArray jsonBatch = redirectBatch(DISCOVERY_ENCODING_JSON);
+	QByteArray binaryBatch = redirectBatch(DISCOVERY_ENCODING_BINARY);
+
+	qInfo("Announce: %d bytes as JSON, %d bytes binary", jsonAnnounce.size(), binaryAnnounce.size());
+	qInfo("Batch of 50 redirects: %d bytes as JSON, %d bytes binary", jsonBatch.size(), binaryBatch.size());
+
+	QVERIFY(binaryAnnounce.size() < jsonAnnounce.size());
+	QVERIFY(binaryBatch.size() < jsonBatch.size());
+	QCOMPARE(DecodeDiscoveryPacket(binaryAnnounce), DecodeDiscoveryPacket(jsonAnnounce));
+}
+
+
+void DiscoveryBenchmark::encodeAnnounce_data()
+{
+	addEncodingColumn();
+}
+
+
+void DiscoveryBenchmark::encodeAnnounce()
+{
+	QFETCH(int, encoding);
+	QVariantMap values = announceValues();
+
+	QByteArray packet;
+	QBENCHMARK
+	{
+		packet = EncodeDiscoveryPacket(values, encoding);
+	}
+	QVERIFY(!packet.isEmpty());
+}
+
+
+void DiscoveryBenchmark::decodeAnnounce_data()
+{
+	addEncodingColumn();
+}
+
+
+void DiscoveryBenchmark::decodeAnnounce()
+{
+	QFETCH(int, encoding);
+	QByteArray packet = EncodeDiscoveryPacket(announceValues(), encoding);
+
+	QVariantMap values;
+	QBENCHMARK
+	{
+		values = DecodeDiscoveryPacket(packet);
+	}
+	QCOMPARE(values[TAG_NAME].toString(), QString("exhibit-kiosk-07"));
+}
+
+
+void DiscoveryBenchmark::decodeRedirectBatch_data()
+{
+	addEncodingColumn();
+}
+
+
+// What a console does with each datagram of the backend's server list
+void DiscoveryBenchmark::decodeRedirectBatch()
+{
+	QFETCH(int, encoding);
+	QByteArray packet = redirectBatch(encoding);
+
+	QVariantMap values;
+	QBENCHMARK
+	{
+		values = DecodeDiscoveryPacket(packet);
+	}
+	QCOMPARE(values[TAG_SERVERS].toList().size(), 50);
+}
+
+
+void DiscoveryBenchmark::detectQuery_data()
+{
+	QTest::addColumn<bool>("tokenScan");
+
+	QTest::newRow("json document") << false;
+	QTest::newRow("token scan") << true;
+}
+
+
+// Every server answers every query broadcast on the network, the token scan
+// replaced parsing each one into a JSON document
+void DiscoveryBenchmark::detectQuery()
+{
+	QFETCH(bool, tokenScan);
+	QVariantMap query;
+	query[TAG_COMMAND] = UDPCOMMAND_QUERY;
+	query[TAG_BATCH] = true;
+	query[TAG_ENCODING] = DISCOVERY_ENCODING_LATEST;
+	QByteArray packet = EncodeDiscoveryPacket(query, DISCOVERY_ENCODING_JSON);
+
+	bool isQuery = false;
+	QBENCHMARK
+	{
+		if (tokenScan)
+			isQuery = IsDiscoveryQuery(packet);
+		else
+			isQuery = UDPCOMMAND_QUERY == QJsonDocument::fromJson(packet).object()[TAG_COMMAND].toString();
+	}
+	QVERIFY(isQuery);
+}
+
+
+QTEST_GUILESS_MAIN(DiscoveryBenchmark)
+#include "DiscoveryBenchmark.moc"
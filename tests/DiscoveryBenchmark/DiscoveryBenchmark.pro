@@ -0,0 +1,8 @@
+TARGET = DiscoveryBenchmark
+include(../tests.pri)
+
+INCLUDEPATH += ../../common
+HEADERS += ../../common/DiscoveryPacket.h
+SOURCES += ./DiscoveryBenchmark.cpp \
+    ../../common/DiscoveryPacket.cpp
+LIBS += ../../$${ConfigurationName}/libqmsgpack.a
@@ -0,0 +1,176 @@
+#include "PinholeCommon.h"
+
+#include <QtTest>
+#include <QTcpSocket>
+
+// Times fetching status pages from a running server with HTTP enabled, opening
+// a connection for every request as HTTP/1.0 clients do, keeping one connection
+// alive, and pipelining the requests on it. The server's HTTP handling needs the
+// managers behind it, so it's measured in place rather than built in here.
+//
+// The server is the local one on DEFAULT_HTTPPORT unless PINHOLE_HTTP gives
+// another host:port, the benchmark is skipped when there's none.
+
+#define BENCHMARK_REQUESTS		20			// Pages fetched per iteration
+#define BENCHMARK_TIMEOUT		5000
+
+
+// Blocking HTTP/1.1 client, just enough to read responses with a Content-Length
+class HttpClient
+{
+public:
+	bool connectToServer(const QString& host, quint16 port)
+	{
+		m_buffer.clear();
+		m_socket.abort();
+		m_socket.connectToHost(host, port);
+		return m_socket.waitForConnected(BENCHMARK_TIMEOUT);
+	}
+
+	void close()
+	{
+		m_socket.abort();
+	}
+
+	void sendRequest(const QByteArray& path, bool keepAlive)
+	{
+		m_socket.write("GET " + path + " HTTP/1.1\r\nHost: benchmark\r\nConnection: " +
+			(keepAlive ? "keep-alive" : "close") + "\r\n\r\n");
+	}
+
+	// Returns the body of the next response, empty if it doesn't arrive
+	QByteArray readResponse()
+	{
+		int headerEnd;
+		while ((headerEnd = m_buffer.indexOf("\r\n\r\n")) < 0)
+		{
+			if (!waitForData())
+				return QByteArray();
+		}
+
+		int length = 0;
+		for (const auto& line : m_buffer.left(headerEnd).split('\n'))
+		{
+			if (line.toLower().startsWith("content-length:"))
+				length = line.mid(15).trimmed().toInt();
+		}
+
+		int responseSize = headerEnd + 4 + length;
+		while (m_buffer.size() < responseSize)
+		{
+			if (!waitForData())
+				return QByteArray();
+		}
+
+		QByteArray body = m_buffer.mid(headerEnd + 4, length);
+		m_buffer.remove(0, responseSize);
+		return body;
+	}
+
+private:
+	bool waitForData()
+	{
+		if (0 == m_socket.bytesAvailable() && !m_socket.waitForReadyRead(BENCHMARK_TIMEOUT))
+			return false;
+		m_buffer += m_socket.readAll();
+		return true;
+	}
+
+	QTcpSocket m_socket;
+	QByteArray m_buffer;
+};
+
+
+class HttpBenchmark : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void fetchPages_data();
+	void fetchPages();
+
+private:
+	QString m_host = "127.0.0.1";
+	quint16 m_port = DEFAULT_HTTPPORT;
+};
+
+
+void HttpBenchmark::initTestCase()
+{
+	QString server = qEnvironmentVariable("PINHOLE_HTTP");
+	if (!server.isEmpty())
+	{
+		m_host = server.section(':', 0, 0);
+		if (server.contains(':'))
+			m_port = static_cast<quint16>(server.section(':', 1).toUInt());
+	}
+
+	HttpClient client;
+	if (!client.connectToServer(m_host, m_port))
+		QSKIP(qPrintable(QString("No Pinhole server with HTTP enabled at %1:%2, set PINHOLE_HTTP to its host:port")
+			.arg(m_host).arg(m_port)));
+}
+
+
+void HttpBenchmark::fetchPages_data()
+{
+	QTest::addColumn<QByteArray>("path");
+	QTest::addColumn<QString>("mode");
+
+	for (const QByteArray path : { "/apps.json", "/" })
+	{
+		for (const QString mode : { "connection per request", "keep-alive", "pipelined" })
+		{
+			QTest::newRow(qPrintable(mode + " " + path)) << path << mode;
+		}
+	}
+}
+
+
+void HttpBenchmark::fetchPages()
+{
+	QFETCH(QByteArray, path);
+	QFETCH(QString, mode);
+
+	HttpClient client;
+	bool reconnect = "connection per request" == mode;
+	if (!reconnect)
+		QVERIFY(client.connectToServer(m_host, m_port));
+
+	int fetched = 0;
+	QBENCHMARK
+	{
+		fetched = 0;
+		if ("pipelined" == mode)
+		{
+			for (int n = 0; n < BENCHMARK_REQUESTS; n++)
+			{
+				client.sendRequest(path, true);
+			}
+			for (int n = 0; n < BENCHMARK_REQUESTS; n++)
+			{
+				if (!client.readResponse().isEmpty())
+					fetched++;
+			}
+		}
+		else
+		{
+			for (int n = 0; n < BENCHMARK_REQUESTS; n++)
+			{
+				if (reconnect && !client.connectToServer(m_host, m_port))
+					break;
+				client.sendRequest(path, !reconnect);
+				if (!client.readResponse().isEmpty())
+					fetched++;
+				if (reconnect)
+					client.close();
+			}
+		}
+	}
+	QCOMPARE(fetched, BENCHMARK_REQUESTS);
+}
+
+
+QTEST_GUILESS_MAIN(HttpBenchmark)
+#include "HttpBenchmark.moc"
@@ -0,0 +1,5 @@
+TARGET = HttpBenchmark
+include(../tests.pri)
+
+INCLUDEPATH += ../../common
+SOURCES += ./HttpBenchmark.cpp
@@ -0,0 +1,153 @@
+#include "Utilities.h"
+
+#include <QtTest>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+
+// Times finding processes by executable path on Linux, with the QDir scanner
+// used before (and still on other Unix systems) against the native /proc scan
+// that lookups close together share.
+
+#define BENCHMARK_APPS			10			// Apps in a group started with terminate previous set
+#define BENCHMARK_SCANEXPIRY	1100		// Longer than a scan is reused for, so the next lookup scans
+
+
+// The scanner used before, as runningProcesses() still is on other Unix systems
+static QList<ProcessInfo> qdirScan()
+{
+	QList<ProcessInfo> processes;
+	QDir procDir(QLatin1String("/proc"));
+	const QFileInfoList procCont = procDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable);
+	QRegExp validator(QLatin1String("[0-9]+"));
+	for (const QFileInfo& info : procCont)
+	{
+		if (validator.exactMatch(info.fileName()))
+		{
+			const QString linkPath = QDir(info.absoluteFilePath()).absoluteFilePath(QLatin1String("exe"));
+			const QFileInfo linkInfo(linkPath);
+			if (linkInfo.exists())
+			{
+				ProcessInfo processInfo;
+				processInfo.name = linkInfo.symLinkTarget();
+				processInfo.id = info.fileName().toInt();
+				processes.append(processInfo);
+			}
+		}
+	}
+	return processes;
+}
+
+
+// The lookup used before, scanning every time and splitting every process name
+static quint32 findProcessBefore(const QString& name)
+{
+	for (const auto& proc : qdirScan())
+	{
+		if (proc.name == name)
+			return proc.id;
+		const QFileInfo fi(proc.name);
+		if (fi.fileName() == name || fi.baseName() == name)
+			return proc.id;
+	}
+	return 0;
+}
+
+
+class ProcessScanBenchmark : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void scan_data();
+	void scan();
+	void startGroup_data();
+	void startGroup();
+
+private:
+	void addScannerColumn();
+};
+
+
+void ProcessScanBenchmark::initTestCase()
+{
+#if !defined(Q_OS_LINUX)
+	QSKIP("The native process scan is only used on Linux");
+#endif
+}
+
+
+void ProcessScanBenchmark::addScannerColumn()
+{
+	QTest::addColumn<bool>("native");
+
+	QTest::newRow("qdir") << false;
+	QTest::newRow("native") << true;
+}
+
+
+void ProcessScanBenchmark::scan_data()
+{
+	addScannerColumn();
+}
+
+
+// One scan of /proc, a shared scan is left to expire first so it isn't reused
+void ProcessScanBenchmark::scan()
+{
+	QFETCH(bool, native);
+
+	QThread::msleep(BENCHMARK_SCANEXPIRY);
+	QList<ProcessInfo> processes;
+	QBENCHMARK_ONCE
+	{
+		processes = native ? runningProcesses() : qdirScan();
+	}
+
+	// This program is running, so it has to be found
+	QString self = QCoreApplication::applicationFilePath();
+	bool found = false;
+	for (const auto& process : processes)
+	{
+		if (process.name == self)
+			found = true;
+	}
+	QVERIFY(found);
+}
+
+
+void ProcessScanBenchmark::startGroup_data()
+{
+	addScannerColumn();
+}
+
+
+// Looking for the previous instance of each app in a group, none of which are
+// running, so every lookup goes through the whole list
+void ProcessScanBenchmark::startGroup()
+{
+	QFETCH(bool, native);
+
+	QStringList paths;
+	for (int n = 0; n < BENCHMARK_APPS; n++)
+	{
+		paths.append(QString("/opt/exhibit/app%1/app%1").arg(n));
+	}
+
+	QThread::msleep(BENCHMARK_SCANEXPIRY);
+	int found = 0;
+	QBENCHMARK_ONCE
+	{
+		for (const auto& path : paths)
+		{
+			if (0 != (native ? findProcessWithPath(path) : findProcessBefore(path)))
+				found++;
+		}
+	}
+	QCOMPARE(found, 0);
+}
+
+
+QTEST_GUILESS_MAIN(ProcessScanBenchmark)
+#include "ProcessScanBenchmark.moc"
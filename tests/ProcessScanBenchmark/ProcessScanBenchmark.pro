@@ -0,0 +1,6 @@
+TARGET = ProcessScanBenchmark
+include(../tests.pri)
+include(../utilities.pri)
+
+INCLUDEPATH += ../../common
+SOURCES += ./ProcessScanBenchmark.cpp
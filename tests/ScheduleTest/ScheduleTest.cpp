@@ -0,0 +1,220 @@
+#include "ScheduleEvent.h"
+
+#include <QtTest>
+#include <time.h>
+
+// Europe/Berlin's rules as a POSIX TZ string, so the test doesn't depend on the zone database
+static const char* s_timeZone = "CET-1CEST,M3.5.0,M10.5.0/3";
+static const QDate s_springForward(2026, 3, 29);	// 02:00 CET jumps to 03:00 CEST
+static const QDate s_fallBack(2026, 10, 25);		// 03:00 CEST goes back to 02:00 CET
+
+
+// Steps through 2026 the way ScheduleManager does, scheduling each trigger from the one before
+static QList<QDateTime> triggersInYear(const ScheduleEvent& event)
+{
+	QDateTime start(QDate(2026, 1, 1), QTime(0, 0));
+	QDateTime end(QDate(2027, 1, 1), QTime(0, 0));
+
+	QList<QDateTime> triggers;
+	QDateTime next = event.nextTrigger(start.addSecs(-1));
+	while (next.isValid() && next < end)
+	{
+		// A trigger that doesn't move forward would repeat forever, the counts show it
+		if (!triggers.isEmpty() && next <= triggers.last())
+			break;
+		triggers.append(next);
+		next = event.nextTrigger(next);
+	}
+	return triggers;
+}
+
+
+static QMap<QDate, int> triggersPerDay(const QList<QDateTime>& triggers)
+{
+	QMap<QDate, int> days;
+	for (const auto& trigger : triggers)
+	{
+		days[trigger.toLocalTime().date()]++;
+	}
+	return days;
+}
+
+
+class ScheduleTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void hourly();
+	void daily_data();
+	void daily();
+	void weekly();
+	void cronQuarterHour();
+	void once();
+};
+
+
+void ScheduleTest::initTestCase()
+{
+#ifdef Q_OS_WIN
+	QSKIP("The local time zone is set with a POSIX TZ string");
+#else
+	qputenv("TZ", s_timeZone);
+	tzset();
+	QCOMPARE(QDateTime(QDate(2026, 1, 15), QTime(12, 0)).offsetFromUtc(), 3600);
+	QCOMPARE(QDateTime(QDate(2026, 7, 15), QTime(12, 0)).offsetFromUtc(), 7200);
+#endif
+}
+
+
+// Hourly events follow real hours, the repeated hour triggers twice and the skipped hour never
+void ScheduleTest::hourly()
+{
+	ScheduleEvent event("hourly");
+	event.setFrequency(SCHED_FREQ_HOURLY);
+	event.setOffset(30);
+
+	QList<QDateTime> triggers = triggersInYear(event);
+	QCOMPARE(triggers.size(), 365 * 24);
+	for (int n = 1; n < triggers.size(); n++)
+	{
+		QCOMPARE(triggers[n - 1].secsTo(triggers[n]), Q_INT64_C(3600));
+	}
+
+	QMap<QDate, int> days = triggersPerDay(triggers);
+	QCOMPARE(days.value(s_springForward), 23);
+	QCOMPARE(days.value(s_fallBack), 25);
+
+	int springTwos = 0;
+	int fallTwos = 0;
+	for (const auto& trigger : triggers)
+	{
+		QDateTime local = trigger.toLocalTime();
+		QCOMPARE(local.time().minute(), 30);
+		if (2 == local.time().hour() && s_springForward == local.date())
+			springTwos++;
+		if (2 == local.time().hour() && s_fallBack == local.date())
+			fallTwos++;
+	}
+	QCOMPARE(springTwos, 0);
+	QCOMPARE(fallTwos, 2);
+}
+
+
+void ScheduleTest::daily_data()
+{
+	QTest::addColumn<QString>("frequency");
+	QTest::addColumn<int>("offset");
+	QTest::addColumn<QString>("cron");
+	QTest::addColumn<QTime>("time");
+
+	QTest::newRow("daily 01:30") << SCHED_FREQ_DAILY << 90 << "" << QTime(1, 30);
+	QTest::newRow("daily 02:00") << SCHED_FREQ_DAILY << 120 << "" << QTime(2, 0);
+	QTest::newRow("daily 02:30") << SCHED_FREQ_DAILY << 150 << "" << QTime(2, 30);
+	QTest::newRow("daily 03:00") << SCHED_FREQ_DAILY << 180 << "" << QTime(3, 0);
+	QTest::newRow("cron 02:30") << SCHED_FREQ_CRON << 0 << "30 2 * * *" << QTime(2, 30);
+	QTest::newRow("cron 02:59") << SCHED_FREQ_CRON << 0 << "59 2 * * *" << QTime(2, 59);
+	QTest::newRow("cron @daily") << SCHED_FREQ_CRON << 0 << "@daily" << QTime(0, 0);
+}
+
+
+// Daily events trigger once on every day, including both days daylight saving changes
+void ScheduleTest::daily()
+{
+	QFETCH(QString, frequency);
+	QFETCH(int, offset);
+	QFETCH(QString, cron);
+	QFETCH(QTime, time);
+
+	ScheduleEvent event("daily");
+	event.setFrequency(frequency);
+	event.setOffset(offset);
+	QVERIFY(event.setCron(cron));
+
+	QList<QDateTime> triggers = triggersInYear(event);
+	QCOMPARE(triggers.size(), 365);
+
+	QDate date(2026, 1, 1);
+	for (const auto& trigger : triggers)
+	{
+		QDateTime local = trigger.toLocalTime();
+		QCOMPARE(local.date(), date);
+
+		// Times skipped when daylight saving starts happen at the end of the gap
+		bool skipped = s_springForward == date && 2 == time.hour();
+		QCOMPARE(local.time(), skipped ? QTime(3, 0) : time);
+
+		date = date.addDays(1);
+	}
+}
+
+
+void ScheduleTest::weekly()
+{
+	ScheduleEvent event("weekly");
+	event.setFrequency(SCHED_FREQ_WEEKLY);
+	event.setOffset(6 * 1440 + 150);		// Sunday 02:30
+
+	QList<QDateTime> triggers = triggersInYear(event);
+	QCOMPARE(triggers.size(), 52);
+
+	QDate date(2026, 1, 4);
+	for (const auto& trigger : triggers)
+	{
+		QDateTime local = trigger.toLocalTime();
+		QCOMPARE(local.date(), date);
+		QCOMPARE(local.time(), s_springForward == date ? QTime(3, 0) : QTime(2, 30));
+		date = date.addDays(7);
+	}
+}
+
+
+// Every local time a cron expression matches triggers once, the skipped quarter
+// hours run together at the end of the gap and the repeated ones aren't repeated
+void ScheduleTest::cronQuarterHour()
+{
+	ScheduleEvent event("quarter");
+	event.setFrequency(SCHED_FREQ_CRON);
+	QVERIFY(event.setCron("*/15 * * * *"));
+
+	QList<QDateTime> triggers = triggersInYear(event);
+	QCOMPARE(triggers.size(), 365 * 96 - 4);
+
+	QMap<QDate, int> days = triggersPerDay(triggers);
+	QCOMPARE(days.size(), 365);
+	for (auto it = days.cbegin(); it != days.cend(); ++it)
+	{
+		QCOMPARE(it.value(), s_springForward == it.key() ? 92 : 96);
+	}
+
+	QSet<QString> localTimes;
+	for (const auto& trigger : triggers)
+	{
+		QDateTime local = trigger.toLocalTime();
+		localTimes.insert(local.date().toString(Qt::ISODate) + " " + local.time().toString(Qt::ISODate));
+	}
+	QCOMPARE(localTimes.size(), triggers.size());
+	QVERIFY(!localTimes.contains("2026-03-29 02:00:00"));
+	QVERIFY(localTimes.contains("2026-03-29 03:00:00"));
+	QVERIFY(localTimes.contains("2026-10-25 02:15:00"));
+}
+
+
+// Once is a point in time, daylight saving doesn't move or repeat it
+void ScheduleTest::once()
+{
+	QDateTime eventTime(s_fallBack, QTime(0, 30), Qt::UTC);		// 02:30 CEST, before the clocks go back
+
+	ScheduleEvent event("once");
+	event.setFrequency(SCHED_FREQ_ONCE);
+	event.setOffset(static_cast<int>(eventTime.toSecsSinceEpoch() / 60));
+
+	QList<QDateTime> triggers = triggersInYear(event);
+	QCOMPARE(triggers.size(), 1);
+	QCOMPARE(triggers[0], eventTime);
+}
+
+
+QTEST_GUILESS_MAIN(ScheduleTest)
+#include "ScheduleTest.moc"
@@ -0,0 +1,10 @@
+TARGET = ScheduleTest
+include(../tests.pri)
+
+HEADERS += ../../PinholeServer/Logger.h \
+    ../../PinholeServer/CronExpression.h \
+    ../../PinholeServer/ScheduleEvent.h
+SOURCES += ./ScheduleTest.cpp \
+    ../common/LoggerStub.cpp \
+    ../../PinholeServer/CronExpression.cpp \
+    ../../PinholeServer/ScheduleEvent.cpp
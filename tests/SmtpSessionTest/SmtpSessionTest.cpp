@@ -0,0 +1,364 @@
+#include "SmtpSession.h"
+
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+// Scripted SMTP server on the loopback interface. When it advertises PIPELINING
+// the replies to MAIL and RCPT are held back until DATA arrives, so a session
+// that waits for each reply before sending the next command stalls.
+class FakeSmtpServer : public QObject
+{
+	Q_OBJECT
+
+public:
+	FakeSmtpServer(QObject *parent = nullptr)
+		: QObject(parent)
+	{
+		connect(&m_server, &QTcpServer::newConnection,
+			this, &FakeSmtpServer::newConnection);
+		m_server.listen(QHostAddress::LocalHost);
+	}
+
+	quint16 port() const { return m_server.serverPort(); }
+
+	// Closes the connection the way a server's idle timeout does
+	void closeConnection()
+	{
+		if (!m_socket.isNull())
+			m_socket->disconnectFromHost();
+	}
+
+	bool pipelining = false;
+	bool startTls = false;
+	QByteArray authMethods;
+	QStringList rejectRecipients;
+	bool dropAtData = false;		// Drop the connection without replying the next time DATA arrives
+
+	QStringList commands;			// Every command received, message text left out
+	int connections = 0;
+	int messages = 0;
+
+private slots:
+	void newConnection()
+	{
+		m_socket = m_server.nextPendingConnection();
+		connections++;
+		m_inData = false;
+		m_accepted = 0;
+		m_held.clear();
+		connect(m_socket.data(), &QTcpSocket::readyRead,
+			this, &FakeSmtpServer::readyRead);
+		reply("220 fake.example ESMTP");
+	}
+
+	void readyRead()
+	{
+		while (!m_socket.isNull() && m_socket->canReadLine())
+		{
+			QByteArray line = m_socket->readLine();
+			while (line.endsWith('\n') || line.endsWith('\r'))
+				line.chop(1);
+
+			if (m_inData)
+			{
+				if ("." == line)
+				{
+					m_inData = false;
+					messages++;
+					reply("250 Queued");
+				}
+				continue;
+			}
+
+			commands.append(QString::fromUtf8(line));
+			QByteArray verb = line.left(4).toUpper();
+			if ("EHLO" == verb)
+			{
+				QByteArray extensions = "250-fake.example\r\n";
+				if (pipelining)
+					extensions += "250-PIPELINING\r\n";
+				if (startTls)
+					extensions += "250-STARTTLS\r\n";
+				if (!authMethods.isEmpty())
+					extensions += "250-AUTH " + authMethods + "\r\n";
+				reply(extensions + "250 8BITMIME");
+			}
+			else if ("MAIL" == verb)
+			{
+				m_accepted = 0;
+				hold("250 OK");
+			}
+			else if ("RCPT" == verb)
+			{
+				bool rejected = false;
+				for (const auto& recipient : rejectRecipients)
+				{
+					if (line.contains(recipient.toUtf8()))
+						rejected = true;
+				}
+				if (!rejected)
+					m_accepted++;
+				hold(rejected ? "550 No such user" : "250 OK");
+			}
+			else if ("DATA" == verb)
+			{
+				if (dropAtData)
+				{
+					dropAtData = false;
+					m_held.clear();
+					m_socket->abort();
+					return;
+				}
+				flush();
+				if (0 == m_accepted)
+				{
+					reply("554 No valid recipients");
+				}
+				else
+				{
+					m_inData = true;
+					reply("354 End data with <CR><LF>.<CR><LF>");
+				}
+			}
+			else if ("RSET" == verb)
+			{
+				reply("250 OK");
+			}
+			else if ("QUIT" == verb)
+			{
+				reply("221 Bye");
+				m_socket->disconnectFromHost();
+				return;
+			}
+			else
+			{
+				reply("502 Command not implemented");
+			}
+		}
+	}
+
+private:
+	void reply(const QByteArray& text)
+	{
+		m_socket->write(text + "\r\n");
+	}
+
+	void hold(const QByteArray& text)
+	{
+		if (pipelining)
+			m_held.append(text);
+		else
+			reply(text);
+	}
+
+	void flush()
+	{
+		for (const auto& text : m_held)
+		{
+			reply(text);
+		}
+		m_held.clear();
+	}
+
+	QTcpServer m_server;
+	QPointer<QTcpSocket> m_socket;
+	bool m_inData = false;
+	int m_accepted = 0;
+	QList<QByteArray> m_held;
+};
+
+
+class SmtpSessionTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void init();
+	void cleanup();
+	void pipelining();
+	void resetAfterFailedMessage_data();
+	void resetAfterFailedMessage();
+	void reconnectAfterIdleClose();
+	void resendUnsentMessage();
+	void noStartTls();
+	void noAuth();
+
+private:
+	SmtpSession* newSession(const QString& user = QString(), bool tls = false);
+
+	FakeSmtpServer* m_server = nullptr;
+	SmtpSession* m_session = nullptr;
+};
+
+
+void SmtpSessionTest::init()
+{
+	m_server = new FakeSmtpServer(this);
+}
+
+
+void SmtpSessionTest::cleanup()
+{
+	delete m_session;
+	m_session = nullptr;
+	delete m_server;
+	m_server = nullptr;
+}
+
+
+SmtpSession* SmtpSessionTest::newSession(const QString& user, bool tls)
+{
+	AlertSmtpConfig config;
+	config.server = "127.0.0.1";
+	config.port = m_server->port();
+	config.tls = tls;
+	config.user = user;
+	config.pass = "secret";
+	config.email = "pinhole@example.com";
+	config.idle = 60;
+	m_session = new SmtpSession(config);
+	return m_session;
+}
+
+
+// The server holds the MAIL and RCPT replies until DATA, so the message only
+// gets through if the session sends them all without waiting
+void SmtpSessionTest::pipelining()
+{
+	m_server->pipelining = true;
+	SmtpSession* session = newSession();
+	QSignalSpy finished(session, &SmtpSession::finished);
+
+	session->sendMail(1, { "a@example.com", "b@example.com" }, "Subject", "Body");
+
+	QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 5000);
+	QCOMPARE(finished[0][0].toULongLong(), Q_UINT64_C(1));
+	QVERIFY(finished[0][1].toBool());
+	QCOMPARE(m_server->messages, 1);
+
+	int mail = m_server->commands.indexOf("MAIL FROM:<pinhole@example.com>");
+	QVERIFY(mail >= 0);
+	QCOMPARE(m_server->commands.mid(mail, 4), QStringList({ "MAIL FROM:<pinhole@example.com>",
+		"RCPT TO:<a@example.com>", "RCPT TO:<b@example.com>", "DATA" }));
+}
+
+
+void SmtpSessionTest::resetAfterFailedMessage_data()
+{
+	QTest::addColumn<bool>("pipelining");
+
+	QTest::newRow("one command at a time") << false;
+	QTest::newRow("pipelining") << true;
+}
+
+
+// A message with every recipient rejected fails, the transaction is reset and
+// the next message still goes out on the same connection
+void SmtpSessionTest::resetAfterFailedMessage()
+{
+	QFETCH(bool, pipelining);
+	m_server->pipelining = pipelining;
+	m_server->rejectRecipients << "bad@example.com";
+	SmtpSession* session = newSession();
+	QSignalSpy finished(session, &SmtpSession::finished);
+
+	session->sendMail(1, { "bad@example.com" }, "First", "Body");
+	session->sendMail(2, { "good@example.com" }, "Second", "Body");
+
+	QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 2, 5000);
+	QCOMPARE(finished[0][0].toULongLong(), Q_UINT64_C(1));
+	QVERIFY(!finished[0][1].toBool());
+	QCOMPARE(finished[1][0].toULongLong(), Q_UINT64_C(2));
+	QVERIFY(finished[1][1].toBool());
+
+	int firstMail = m_server->commands.indexOf("MAIL FROM:<pinhole@example.com>");
+	int rset = m_server->commands.indexOf("RSET");
+	int secondMail = m_server->commands.lastIndexOf("MAIL FROM:<pinhole@example.com>");
+	QVERIFY(firstMail >= 0);
+	QVERIFY(rset > firstMail);
+	QVERIFY(secondMail > rset);
+	QCOMPARE(m_server->connections, 1);
+	QCOMPARE(m_server->messages, 1);
+}
+
+
+// The server closing the idle connection doesn't fail the next message, the session connects again
+void SmtpSessionTest::reconnectAfterIdleClose()
+{
+	SmtpSession* session = newSession();
+	QSignalSpy finished(session, &SmtpSession::finished);
+
+	session->sendMail(1, { "a@example.com" }, "First", "Body");
+	QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 5000);
+	QVERIFY(finished[0][1].toBool());
+
+	m_server->closeConnection();
+	QTest::qWait(100);
+
+	session->sendMail(2, { "a@example.com" }, "Second", "Body");
+	QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 2, 5000);
+	QCOMPARE(finished[1][0].toULongLong(), Q_UINT64_C(2));
+	QVERIFY(finished[1][1].toBool());
+	QCOMPARE(m_server->connections, 2);
+	QCOMPARE(m_server->messages, 2);
+}
+
+
+// A connection lost while a message is being sent gets it resent once on a new connection
+void SmtpSessionTest::resendUnsentMessage()
+{
+	SmtpSession* session = newSession();
+	QSignalSpy finished(session, &SmtpSession::finished);
+
+	// Log in first so the connection is established when it drops
+	session->sendMail(1, { "a@example.com" }, "First", "Body");
+	QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 5000);
+
+	m_server->dropAtData = true;
+	session->sendMail(2, { "a@example.com" }, "Second", "Body");
+
+	QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 2, 5000);
+	QCOMPARE(finished[1][0].toULongLong(), Q_UINT64_C(2));
+	QVERIFY(finished[1][1].toBool());
+	QCOMPARE(m_server->connections, 2);
+	QCOMPARE(m_server->messages, 2);
+
+	// Sent exactly once
+	QTest::qWait(200);
+	QCOMPARE(finished.count(), 2);
+}
+
+
+// TLS is configured, so a server without STARTTLS fails the message instead of getting it in cleartext
+void SmtpSessionTest::noStartTls()
+{
+	SmtpSession* session = newSession(QString(), true);
+	QSignalSpy finished(session, &SmtpSession::finished);
+
+	session->sendMail(1, { "a@example.com" }, "Subject", "Body");
+
+	QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 5000);
+	QVERIFY(!finished[0][1].toBool());
+	QVERIFY(!m_server->commands.contains("MAIL FROM:<pinhole@example.com>"));
+	QCOMPARE(m_server->messages, 0);
+}
+
+
+// A login is configured, so a server without AUTH fails the message instead of getting it unauthenticated
+void SmtpSessionTest::noAuth()
+{
+	SmtpSession* session = newSession("user");
+	QSignalSpy finished(session, &SmtpSession::finished);
+
+	session->sendMail(1, { "a@example.com" }, "Subject", "Body");
+
+	QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 5000);
+	QVERIFY(!finished[0][1].toBool());
+	QVERIFY(!m_server->commands.contains("MAIL FROM:<pinhole@example.com>"));
+	QCOMPARE(m_server->messages, 0);
+}
+
+
+QTEST_GUILESS_MAIN(SmtpSessionTest)
+#include "SmtpSessionTest.moc"
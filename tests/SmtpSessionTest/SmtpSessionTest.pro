@@ -0,0 +1,8 @@
+TARGET = SmtpSessionTest
+include(../tests.pri)
+
+HEADERS += ../../PinholeServer/Logger.h \
+    ../../PinholeServer/SmtpSession.h
+SOURCES += ./SmtpSessionTest.cpp \
+    ../common/LoggerStub.cpp \
+    ../../PinholeServer/SmtpSession.cpp
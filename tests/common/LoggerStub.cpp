@@ -0,0 +1,37 @@
+#include "Logger.h"
+
+#include <QDebug>
+
+// Stands in for the server's Logger, which writes to the log file and the
+// connected consoles. Tests only need the messages on the test output.
+
+QMutex Logger::s_mutex;
+int Logger::s_hostLogLevel = LOG_NORMAL;
+int Logger::s_remoteLogLevel = LOG_NORMAL;
+Settings* Logger::s_settings = nullptr;
+CommandInterface* Logger::s_commandInterface = nullptr;
+
+const QMap<QString, int> Logger::s_logLevelMap =
+{
+	{ LOG_LEVEL_ERROR, 5 },
+	{ LOG_LEVEL_WARNING, 4 },
+	{ LOG_LEVEL_NORMAL, 3 },
+	{ LOG_LEVEL_EXTRA, 2 },
+	{ LOG_LEVEL_DEBUG, 1 }
+};
+
+const QStringList Logger::s_LogLevelNames = { "", "Debug", "Extra", "", "Warning", "Error", "" };
+
+
+Logger::Logger(int level, QObject *parent)
+	: QObject(parent), m_level(level), m_message(&m_string)
+{
+}
+
+
+Logger::~Logger()
+{
+	m_message.flush();
+	if (m_level >= s_hostLogLevel)
+		qDebug().noquote() << s_LogLevelNames.value(m_level) << m_string;
+}
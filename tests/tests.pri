@@ -0,0 +1,25 @@
+# Settings shared by the test and benchmark programs, run them with make check
+
+CONFIG(debug, debug|release) {
+    ConfigurationName = Debug
+}
+CONFIG(release, debug|release) {
+    ConfigurationName = Release
+}
+
+TEMPLATE = app
+DESTDIR = ../../$${ConfigurationName}/tests
+QT += core network testlib
+QT -= gui
+CONFIG += console testcase
+CONFIG -= app_bundle
+INCLUDEPATH += ../../PinholeServer \
+    ../common \
+    .
+DEPENDPATH += .
+MOC_DIR += ./GeneratedFiles/$${ConfigurationName}
+OBJECTS_DIR += $${ConfigurationName}
+
+linux {
+DEFINES += _GLIBCXX_USE_CXX11_ABI=0
+}
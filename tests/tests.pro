@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+SUBDIRS += SmtpSessionTest \
+    ScheduleTest \
+    ClockChangeTest \
+    DiscoveryBenchmark \
+    HttpBenchmark \
+    BroadcastBenchmark \
+    ProcessScanBenchmark
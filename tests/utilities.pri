@@ -0,0 +1,12 @@
+# The common utilities and the libraries they need, for programs that use them
+
+SOURCES += ../../common/Utilities.cpp \
+    ../../common/Utilities_Linux.cpp \
+    ../../common/Utilities_Mac.cpp \
+    ../../common/Utilities_Win.cpp
+LIBS += ../../$${ConfigurationName}/libqmsgpack.a -lcrypto -ldl
+
+macx {
+INCLUDEPATH += /usr/local/opt/openssl/include
+LIBS += -L"/usr/local/opt/openssl/lib" -framework CoreServices
+}